@@ -0,0 +1,131 @@
+/*
+ * Certificate manager benchmark: NVS opens, CRC passes and time of the boot
+ * sequence in app_main (init, get_metadata, is_certificate_valid,
+ * get_metadata, get_ca_chain), then the same calls again with the metadata
+ * and checksum caches warm, and the X.509 parsing cost: PEM parsed at
+ * store/validate time, DER parsed in place from the mapped slot, and the
+ * cached chain handed to TLS.
+ *
+ * Links the mbedTLS 3.x the host build found or downloaded (see
+ * CMakeLists.txt). NVS and flash are the RAM stand-ins from host_test/stubs. The wall
+ * clock is pinned inside the validity of the development CA so the expiry
+ * check passes whatever the date of the run.
+ */
+#include "host_test.h"
+#include "certificate_manager.h"
+#include "ca_certificate.h"
+#include "esp_crc.h"
+#include "esp_partition.h"
+#include "nvs.h"
+#include <string.h>
+#include <time.h>
+
+#define CERTS_PARTITION_SIZE    0x10000     /* certs in partitions.csv */
+#define PARSE_ITERATIONS        2000
+#define CLOCK_PINNED            1767225600  /* 2026-01-01, the demo CA is valid until 2026-07-15 */
+
+time_t time(time_t* out)
+{
+    if (out) {
+        *out = CLOCK_PINNED;
+    }
+    return CLOCK_PINNED;
+}
+
+typedef struct {
+    uint32_t nvs_opens;
+    uint64_t crc_bytes;
+    double us;
+} boot_result_t;
+
+static double now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+/**
+ * @brief The certificate calls app_main makes from boot to the first TLS handshake
+ */
+static void run_boot_sequence(boot_result_t* result)
+{
+    host_nvs_stats_t nvs_before;
+    host_nvs_stats_t nvs_after;
+    host_nvs_get_stats(&nvs_before);
+    uint64_t crc_before = host_crc_bytes();
+    double start = now_us();
+
+    cert_metadata_t metadata;
+    CHECK_EQ(cert_manager_get_metadata(&metadata), ESP_OK);
+    CHECK(cert_manager_is_certificate_valid());
+    CHECK_EQ(cert_manager_get_metadata(&metadata), ESP_OK);
+    mbedtls_x509_crt* chain = NULL;
+    CHECK_EQ(cert_manager_get_ca_chain(&chain), ESP_OK);
+    CHECK(chain != NULL);
+
+    result->us = now_us() - start;
+    host_nvs_get_stats(&nvs_after);
+    result->nvs_opens = nvs_after.opens - nvs_before.opens;
+    result->crc_bytes = host_crc_bytes() - crc_before;
+}
+
+int main(void)
+{
+    CHECK(host_partition_create("certs", CERTS_PARTITION_SIZE) != NULL);
+    cert_manager_config_t config = CERT_MANAGER_DEFAULT_CONFIG();
+    CHECK_EQ(cert_manager_init(&config), ESP_OK);
+
+    // PEM parsing: what store, rotate and validate pay once per certificate
+    cert_validation_result_t validation;
+    double start = now_us();
+    for (int i = 0; i < PARSE_ITERATIONS; i++) {
+        CHECK_EQ(cert_manager_validate(DEMO_CA_CERTIFICATE_PEM, &validation), ESP_OK);
+        CHECK_EQ(validation, CERT_VALID);
+    }
+    double pem_us = (now_us() - start) / PARSE_ITERATIONS;
+    CHECK_EQ(cert_manager_store(DEMO_CA_CERTIFICATE_PEM, CERT_SOURCE_MANUFACTURING), ESP_OK);
+
+    // A reboot: the RAM caches start cold
+    CHECK_EQ(cert_manager_deinit(), ESP_OK);
+    CHECK_EQ(cert_manager_init(&config), ESP_OK);
+    boot_result_t cold;
+    boot_result_t warm;
+    run_boot_sequence(&cold);
+    run_boot_sequence(&warm);
+
+    // DER parsing in place from the mapped slot, checksum already verified
+    start = now_us();
+    for (int i = 0; i < PARSE_ITERATIONS; i++) {
+        CHECK(cert_manager_is_certificate_valid());
+    }
+    double der_us = (now_us() - start) / PARSE_ITERATIONS;
+
+    // The chain TLS gets on every connect
+    mbedtls_x509_crt* chain = NULL;
+    start = now_us();
+    for (int i = 0; i < PARSE_ITERATIONS; i++) {
+        CHECK_EQ(cert_manager_get_ca_chain(&chain), ESP_OK);
+    }
+    double cached_us = (now_us() - start) / PARSE_ITERATIONS;
+
+    cert_metadata_t metadata;
+    CHECK_EQ(cert_manager_get_metadata(&metadata), ESP_OK);
+    printf("%zu-byte DER certificate (%s)\n", metadata.cert_size, metadata.subject);
+    printf("  boot sequence, cold: %lu NVS opens, %llu bytes checksummed, %.1f us\n", (unsigned long)cold.nvs_opens,
+           (unsigned long long)cold.crc_bytes, cold.us);
+    printf("  boot sequence, warm: %lu NVS opens, %llu bytes checksummed, %.1f us\n", (unsigned long)warm.nvs_opens,
+           (unsigned long long)warm.crc_bytes, warm.us);
+    printf("  X.509 parse: %.1f us per PEM, %.1f us per DER in place, %.3f us for the cached chain\n", pem_us, der_us,
+           cached_us);
+
+    // One metadata read and one CRC pass per boot, none afterwards
+    CHECK_EQ(cold.nvs_opens, 1);
+    CHECK_EQ(cold.crc_bytes, metadata.cert_size);
+    CHECK_EQ(warm.nvs_opens, 0);
+    CHECK_EQ(warm.crc_bytes, 0);
+    CHECK(cached_us < der_us);
+
+    CHECK_EQ(cert_manager_deinit(), ESP_OK);
+    return 0;
+}
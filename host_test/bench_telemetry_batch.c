@@ -0,0 +1,108 @@
+/*
+ * Batch size benchmark: bytes on the wire and publishes per sample when the
+ * ring buffer is flushed every 1, 10 or 60 samples. Payloads are built by
+ * the firmware serializer into the same 4 KB buffer, so a flush that does
+ * not fit one payload is split exactly as publish_telemetry_batch does.
+ *
+ * MQTT bytes count the QoS 1 PUBLISH (fixed header, topic, packet id,
+ * payload) and its 4-byte PUBACK. The TLS column adds 29 bytes per MQTT
+ * packet (TLS 1.2 AES-GCM record: 5 header + 8 nonce + 16 tag), assuming
+ * one record per packet; it leaves out TCP/IP headers.
+ */
+#include "host_test.h"
+#include "telemetry_serializer.h"
+#include <string.h>
+
+#define SAMPLES             600
+#define SAMPLE_PERIOD_US    5000000LL
+#define PAYLOAD_MAX         4096    /* TELEMETRY_PAYLOAD_MAX in app_main.c */
+#define TOPIC               "v1/devices/me/telemetry"
+#define PUBACK_BYTES        4
+#define TLS_RECORD_OVERHEAD 29
+#define EPOCH_OFFSET_MS     1700000000000LL
+
+typedef struct {
+    size_t batch;
+    uint32_t publishes;
+    uint64_t payload_bytes;
+    uint64_t mqtt_bytes;
+    uint64_t tls_bytes;
+} batch_result_t;
+
+static telemetry_sample_t s_samples[SAMPLES];
+static char s_payload[PAYLOAD_MAX];
+
+static size_t varint_len(size_t value)
+{
+    size_t len = 1;
+    while (value >= 128) {
+        value /= 128;
+        len++;
+    }
+    return len;
+}
+
+static void count_publish(batch_result_t* result, size_t payload_len)
+{
+    size_t remaining = 2 + strlen(TOPIC) + 2 + payload_len;
+    size_t publish = 1 + varint_len(remaining) + remaining;
+    result->publishes++;
+    result->payload_bytes += payload_len;
+    result->mqtt_bytes += publish + PUBACK_BYTES;
+    result->tls_bytes += publish + PUBACK_BYTES + 2 * TLS_RECORD_OVERHEAD;
+}
+
+static void run_batch(size_t batch, batch_result_t* result)
+{
+    memset(result, 0, sizeof(*result));
+    result->batch = batch;
+    for (size_t flushed = 0; flushed < SAMPLES; flushed += batch) {
+        size_t count = SAMPLES - flushed < batch ? SAMPLES - flushed : batch;
+        size_t offset = 0;
+        while (offset < count) {
+            size_t payload_len = 0;
+            size_t serialized = telemetry_serialize_batch(&s_samples[flushed + offset], count - offset,
+                                                          EPOCH_OFFSET_MS, s_payload, sizeof(s_payload),
+                                                          &payload_len);
+            CHECK(serialized > 0);
+            count_publish(result, payload_len);
+            offset += serialized;
+        }
+    }
+}
+
+int main(void)
+{
+    for (int i = 0; i < SAMPLES; i++) {
+        telemetry_sample_t* sample = &s_samples[i];
+        sample->captured_us = i * SAMPLE_PERIOD_US;
+        sample->present = TELEMETRY_KEY_MASK_ALL;
+        sample->values[TELEMETRY_KEY_TEMPERATURE] = 2153 + i % 17;
+        sample->values[TELEMETRY_KEY_TEMPERATURE_MIN] = 2140 + i % 11;
+        sample->values[TELEMETRY_KEY_TEMPERATURE_MAX] = 2171 + i % 13;
+        sample->values[TELEMETRY_KEY_RSSI] = -61 - i % 9;
+        sample->values[TELEMETRY_KEY_HEAP] = 187000 - i * 8;
+        sample->values[TELEMETRY_KEY_UPTIME] = 5 * (i + 1);
+    }
+
+    static const size_t batches[] = { 1, 10, 60 };
+    batch_result_t results[3];
+    printf("%d samples, 6 keys each\n", SAMPLES);
+    printf("  batch  publishes/sample  payload B/sample  MQTT B/sample  +TLS B/sample\n");
+    for (size_t i = 0; i < sizeof(batches) / sizeof(batches[0]); i++) {
+        batch_result_t* r = &results[i];
+        run_batch(batches[i], r);
+        printf("  %5zu  %16.3f  %16.1f  %13.1f  %13.1f\n", r->batch, (double)r->publishes / SAMPLES,
+               (double)r->payload_bytes / SAMPLES, (double)r->mqtt_bytes / SAMPLES, (double)r->tls_bytes / SAMPLES);
+    }
+
+    CHECK_EQ(results[0].publishes, SAMPLES);
+    CHECK_EQ(results[1].publishes, SAMPLES / 10);
+    // A 60-sample flush needs more than one 4 KB payload, but far fewer than 60
+    CHECK(results[2].publishes > SAMPLES / 60 && results[2].publishes < SAMPLES / 10);
+    for (size_t i = 1; i < 3; i++) {
+        CHECK(results[i].mqtt_bytes < results[i - 1].mqtt_bytes);
+        CHECK(results[i].tls_bytes < results[i - 1].tls_bytes);
+    }
+    return 0;
+}
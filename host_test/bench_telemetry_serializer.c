@@ -0,0 +1,179 @@
+/*
+ * Serializer benchmark: the schema-driven serializer against the cJSON path
+ * it replaced (cJSON_CreateObject, one cJSON_AddNumberToObject per key,
+ * cJSON_Print), on ns per payload, bytes per payload, heap allocations per
+ * payload and the state of the heap after 1M payloads.
+ *
+ * cJSON is the host's own or the pinned release CMake downloads. The heap
+ * figures come from glibc's mallinfo2(), so they describe the host
+ * allocator, not the ESP-IDF heap.
+ */
+#include "host_test.h"
+#include "telemetry_serializer.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+#include <malloc.h>
+#define HOST_HAVE_MALLINFO2 1
+#endif
+#include "cJSON.h"
+
+#define ITERATIONS      1000000
+#define PAYLOAD_MAX     4096
+
+typedef struct {
+    const char* name;
+    double ns_per_payload;
+    size_t bytes_per_payload;
+    double allocs_per_payload;
+    long heap_in_use_delta;         /**< Bytes still allocated after the run */
+    long heap_free_in_arena;        /**< Free bytes held by the allocator after the run */
+} bench_result_t;
+
+static char s_payload[PAYLOAD_MAX];
+static volatile size_t s_sink;
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void heap_snapshot(long* in_use, long* free_in_arena)
+{
+#ifdef HOST_HAVE_MALLINFO2
+    struct mallinfo2 info = mallinfo2();
+    *in_use = (long)info.uordblks;
+    *free_in_arena = (long)info.fordblks;
+#else
+    *in_use = 0;
+    *free_in_arena = 0;
+#endif
+}
+
+static telemetry_sample_t make_sample(uint32_t i)
+{
+    telemetry_sample_t sample;
+    memset(&sample, 0, sizeof(sample));
+    sample.present = TELEMETRY_KEY_MASK_ALL;
+    sample.values[TELEMETRY_KEY_TEMPERATURE] = 2153 + (int32_t)(i % 17);
+    sample.values[TELEMETRY_KEY_TEMPERATURE_MIN] = 2140 + (int32_t)(i % 11);
+    sample.values[TELEMETRY_KEY_TEMPERATURE_MAX] = 2171 + (int32_t)(i % 13);
+    sample.values[TELEMETRY_KEY_RSSI] = -61 - (int32_t)(i % 9);
+    sample.values[TELEMETRY_KEY_HEAP] = 187000 - (int32_t)(i % 1000);
+    sample.values[TELEMETRY_KEY_UPTIME] = (int32_t)i;
+    return sample;
+}
+
+static void bench_serializer(bench_result_t* result)
+{
+    long in_use_before;
+    long free_before;
+    heap_snapshot(&in_use_before, &free_before);
+
+    size_t bytes = 0;
+    double start = now_ns();
+    for (uint32_t i = 0; i < ITERATIONS; i++) {
+        telemetry_sample_t sample = make_sample(i);
+        size_t len = telemetry_serialize_values(&sample, s_payload, sizeof(s_payload));
+        CHECK(len > 0);
+        bytes += len;
+        s_sink = len;
+    }
+    double elapsed = now_ns() - start;
+
+    long in_use_after;
+    long free_after;
+    heap_snapshot(&in_use_after, &free_after);
+    result->name = "telemetry_serialize_values";
+    result->ns_per_payload = elapsed / ITERATIONS;
+    result->bytes_per_payload = bytes / ITERATIONS;
+    result->allocs_per_payload = 0;
+    result->heap_in_use_delta = in_use_after - in_use_before;
+    result->heap_free_in_arena = free_after;
+}
+
+static uint64_t s_cjson_allocs = 0;
+
+static void* counting_malloc(size_t size)
+{
+    s_cjson_allocs++;
+    return malloc(size);
+}
+
+/**
+ * @brief The telemetry path before the serializer, with all schema keys
+ */
+static void bench_cjson(bench_result_t* result, bool formatted)
+{
+    cJSON_Hooks hooks = { .malloc_fn = counting_malloc, .free_fn = free };
+    cJSON_InitHooks(&hooks);
+    s_cjson_allocs = 0;
+
+    long in_use_before;
+    long free_before;
+    heap_snapshot(&in_use_before, &free_before);
+
+    size_t bytes = 0;
+    double start = now_ns();
+    for (uint32_t i = 0; i < ITERATIONS; i++) {
+        telemetry_sample_t sample = make_sample(i);
+        cJSON* root = cJSON_CreateObject();
+        for (int key = 0; key < TELEMETRY_KEY_COUNT; key++) {
+            const telemetry_field_t* field = &telemetry_schema[key];
+            double value = sample.values[key];
+            for (int d = 0; d < telemetry_signals[field->signal].precision; d++) {
+                value /= 10;
+            }
+            cJSON_AddNumberToObject(root, field->name, value);
+        }
+        char* json = formatted ? cJSON_Print(root) : cJSON_PrintUnformatted(root);
+        CHECK(json != NULL);
+        bytes += strlen(json);
+        s_sink = bytes;
+        cJSON_Delete(root);
+        free(json);
+    }
+    double elapsed = now_ns() - start;
+
+    long in_use_after;
+    long free_after;
+    heap_snapshot(&in_use_after, &free_after);
+    result->name = formatted ? "cJSON_Print" : "cJSON_PrintUnformatted";
+    result->ns_per_payload = elapsed / ITERATIONS;
+    result->bytes_per_payload = bytes / ITERATIONS;
+    result->allocs_per_payload = (double)s_cjson_allocs / ITERATIONS;
+    result->heap_in_use_delta = in_use_after - in_use_before;
+    result->heap_free_in_arena = free_after;
+    cJSON_InitHooks(NULL);
+}
+
+static void print_result(const bench_result_t* r)
+{
+    printf("  %-28s %8.1f %8zu %8.1f %12ld %14ld\n", r->name, r->ns_per_payload, r->bytes_per_payload,
+           r->allocs_per_payload, r->heap_in_use_delta, r->heap_free_in_arena);
+}
+
+int main(void)
+{
+    bench_result_t serializer;
+    bench_serializer(&serializer);
+
+    printf("%d payloads of %d keys\n", ITERATIONS, TELEMETRY_KEY_COUNT);
+    printf("  %-28s %8s %8s %8s %12s %14s\n", "path", "ns", "bytes", "allocs", "heap delta", "free in arena");
+    print_result(&serializer);
+    bench_result_t pretty;
+    bench_result_t compact;
+    bench_cjson(&pretty, true);
+    bench_cjson(&compact, false);
+    print_result(&pretty);
+    print_result(&compact);
+    CHECK(serializer.bytes_per_payload < pretty.bytes_per_payload);
+    CHECK(serializer.ns_per_payload < compact.ns_per_payload);
+
+    // The serializer must not touch the heap at all
+    CHECK_EQ(serializer.heap_in_use_delta, 0);
+    return 0;
+}
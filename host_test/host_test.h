@@ -0,0 +1,29 @@
+#pragma once
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/**
+ * @file host_test.h
+ * @brief Minimal checks for the host-built tests
+ *
+ * A failed CHECK prints the location and exits with status 1, which ctest
+ * reports as a failure.
+ */
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); \
+        exit(1); \
+    } \
+} while (0)
+
+#define CHECK_EQ(actual, expected) do { \
+    long long check_actual_ = (long long)(actual); \
+    long long check_expected_ = (long long)(expected); \
+    if (check_actual_ != check_expected_) { \
+        fprintf(stderr, "%s:%d: CHECK_EQ failed: %s == %lld, expected %lld\n", __FILE__, __LINE__, #actual, \
+                check_actual_, check_expected_); \
+        exit(1); \
+    } \
+} while (0)
@@ -0,0 +1,15 @@
+#pragma once
+
+/*
+ * Host stand-in for ESP-IDF's esp_attr.h. RTC_NOINIT_ATTR variables share a
+ * section that host_rtc_power_on() fills with random bytes, the way RTC
+ * memory comes up after a power cycle; across a simulated reset they keep
+ * their contents like everything else.
+ */
+
+#define RTC_NOINIT_ATTR         __attribute__((section("rtc_noinit")))
+
+/**
+ * @brief Fill all RTC_NOINIT_ATTR variables with random bytes
+ */
+void host_rtc_power_on(void);
@@ -0,0 +1,12 @@
+#pragma once
+
+#include <stdint.h>
+
+/* Host stand-in for ESP-IDF's esp_crc.h: the same chainable CRC32 as the ROM routine */
+
+uint32_t esp_crc32_le(uint32_t crc, const uint8_t* buf, uint32_t len);
+
+/**
+ * @brief Bytes checksummed so far
+ */
+uint64_t host_crc_bytes(void);
@@ -0,0 +1,12 @@
+#pragma once
+
+#include <stdio.h>
+
+/* Host stand-in for ESP-IDF's esp_log.h: arguments are type-checked, nothing is printed */
+
+#define ESP_HOST_LOG(tag, format, ...) do { if (0) { printf("%s" format, tag, ##__VA_ARGS__); } } while (0)
+#define ESP_LOGE(tag, format, ...) ESP_HOST_LOG(tag, format, ##__VA_ARGS__)
+#define ESP_LOGW(tag, format, ...) ESP_HOST_LOG(tag, format, ##__VA_ARGS__)
+#define ESP_LOGI(tag, format, ...) ESP_HOST_LOG(tag, format, ##__VA_ARGS__)
+#define ESP_LOGD(tag, format, ...) ESP_HOST_LOG(tag, format, ##__VA_ARGS__)
+#define ESP_LOGV(tag, format, ...) ESP_HOST_LOG(tag, format, ##__VA_ARGS__)
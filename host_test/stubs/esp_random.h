@@ -0,0 +1,12 @@
+#pragma once
+
+#include <stdint.h>
+
+/* Host stand-in for ESP-IDF's esp_random.h: a seeded xorshift, so runs are reproducible */
+
+uint32_t esp_random(void);
+
+/**
+ * @brief Restart the sequence esp_random() returns
+ */
+void host_set_random_seed(uint32_t seed);
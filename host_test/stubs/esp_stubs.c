@@ -0,0 +1,296 @@
+#include "esp_err.h"
+#include "esp_timer.h"
+#include "esp_event.h"
+#include "esp_random.h"
+#include "esp_system.h"
+#include "freertos/task.h"
+#include <setjmp.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define HOST_HEAP_SIZE      (320 * 1024)
+#define HOST_MAX_TIMERS     16
+#define HOST_MAX_HANDLERS   16
+#define HOST_MAX_TASKS      8
+
+static int64_t s_now_us = 0;
+
+int64_t esp_timer_get_time(void)
+{
+    return s_now_us;
+}
+
+void host_set_time_us(int64_t now_us)
+{
+    s_now_us = now_us;
+}
+
+#ifdef HOST_NEEDS_STRLCPY
+size_t strlcpy(char* dst, const char* src, size_t size)
+{
+    size_t len = strlen(src);
+    if (size > 0) {
+        size_t copy = len < size - 1 ? len : size - 1;
+        memcpy(dst, src, copy);
+        dst[copy] = '\0';
+    }
+    return len;
+}
+#endif
+
+const char* esp_err_to_name(esp_err_t code)
+{
+    switch (code) {
+    case ESP_OK:                return "ESP_OK";
+    case ESP_FAIL:              return "ESP_FAIL";
+    case ESP_ERR_NO_MEM:        return "ESP_ERR_NO_MEM";
+    case ESP_ERR_INVALID_ARG:   return "ESP_ERR_INVALID_ARG";
+    case ESP_ERR_INVALID_STATE: return "ESP_ERR_INVALID_STATE";
+    case ESP_ERR_INVALID_SIZE:  return "ESP_ERR_INVALID_SIZE";
+    case ESP_ERR_NOT_FOUND:     return "ESP_ERR_NOT_FOUND";
+    case ESP_ERR_TIMEOUT:       return "ESP_ERR_TIMEOUT";
+    default:                    return "ESP_ERR";
+    }
+}
+
+/* Heap: each block carries its size so frees can be accounted */
+
+static size_t s_heap_used = 0;
+
+void* host_heap_alloc(size_t size)
+{
+    size_t* block = malloc(sizeof(size_t) + size);
+    if (block == NULL) {
+        return NULL;
+    }
+    block[0] = size;
+    s_heap_used += size;
+    return memset(block + 1, 0, size);
+}
+
+void host_heap_free(void* ptr)
+{
+    if (ptr == NULL) {
+        return;
+    }
+    size_t* block = (size_t*)ptr - 1;
+    s_heap_used -= block[0];
+    free(block);
+}
+
+uint32_t esp_get_free_heap_size(void)
+{
+    return s_heap_used >= HOST_HEAP_SIZE ? 0 : (uint32_t)(HOST_HEAP_SIZE - s_heap_used);
+}
+
+/* Random */
+
+static uint32_t s_random_state = 0x12345678U;
+
+void host_set_random_seed(uint32_t seed)
+{
+    s_random_state = seed != 0 ? seed : 1;
+}
+
+uint32_t esp_random(void)
+{
+    uint32_t x = s_random_state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    s_random_state = x;
+    return x;
+}
+
+/* Timers */
+
+struct esp_timer {
+    esp_timer_cb_t callback;
+    void* arg;
+    bool armed;
+    int64_t deadline_us;
+};
+
+static struct esp_timer* s_timers[HOST_MAX_TIMERS];
+static size_t s_timer_count = 0;
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t* create_args, esp_timer_handle_t* out_handle)
+{
+    if (create_args == NULL || create_args->callback == NULL || out_handle == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_timer_count >= HOST_MAX_TIMERS) {
+        return ESP_ERR_NO_MEM;
+    }
+    struct esp_timer* timer = host_heap_alloc(sizeof(*timer));
+    if (timer == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    timer->callback = create_args->callback;
+    timer->arg = create_args->arg;
+    s_timers[s_timer_count++] = timer;
+    *out_handle = timer;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us)
+{
+    if (timer == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (timer->armed) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    timer->armed = true;
+    timer->deadline_us = s_now_us + (int64_t)timeout_us;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t timer)
+{
+    if (timer == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!timer->armed) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    timer->armed = false;
+    return ESP_OK;
+}
+
+bool host_timer_fire_next(void)
+{
+    struct esp_timer* next = NULL;
+    for (size_t i = 0; i < s_timer_count; i++) {
+        if (s_timers[i]->armed && (next == NULL || s_timers[i]->deadline_us < next->deadline_us)) {
+            next = s_timers[i];
+        }
+    }
+    if (next == NULL) {
+        return false;
+    }
+    next->armed = false;
+    if (next->deadline_us > s_now_us) {
+        s_now_us = next->deadline_us;
+    }
+    next->callback(next->arg);
+    return true;
+}
+
+/* Tasks: run on the caller of host_tasks_run(); a wait without a notification jumps back there */
+
+struct host_task {
+    TaskFunction_t code;
+    void* params;
+    uint32_t notifications;
+    jmp_buf wait;
+};
+
+static struct host_task* s_tasks[HOST_MAX_TASKS];
+static size_t s_task_count = 0;
+static struct host_task* s_running = NULL;
+
+BaseType_t xTaskCreate(TaskFunction_t task_code, const char* name, uint32_t stack_depth, void* params,
+                       UBaseType_t priority, TaskHandle_t* created_task)
+{
+    if (task_code == NULL || s_task_count >= HOST_MAX_TASKS) {
+        return pdFALSE;
+    }
+    // The stack is what FreeRTOS would take from the heap
+    struct host_task* task = host_heap_alloc(sizeof(*task) + stack_depth);
+    if (task == NULL) {
+        return pdFALSE;
+    }
+    task->code = task_code;
+    task->params = params;
+    s_tasks[s_task_count++] = task;
+    if (created_task != NULL) {
+        *created_task = task;
+    }
+    return pdPASS;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task)
+{
+    ((struct host_task*)task)->notifications++;
+    return pdPASS;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_count_on_exit, TickType_t ticks_to_wait)
+{
+    struct host_task* task = s_running;
+    if (task == NULL) {
+        return 0;
+    }
+    if (task->notifications == 0) {
+        longjmp(task->wait, 1);
+    }
+    uint32_t count = task->notifications;
+    task->notifications = clear_count_on_exit ? 0 : count - 1;
+    return count;
+}
+
+static void run_task(struct host_task* task)
+{
+    if (setjmp(task->wait) == 0) {
+        s_running = task;
+        task->code(task->params);
+    }
+    s_running = NULL;
+}
+
+uint32_t host_tasks_run(void)
+{
+    uint32_t runs = 0;
+    bool notified = true;
+    while (notified) {
+        notified = false;
+        for (size_t i = 0; i < s_task_count; i++) {
+            struct host_task* task = s_tasks[i];
+            if (task->notifications == 0) {
+                continue;
+            }
+            notified = true;
+            runs++;
+            run_task(task);
+        }
+    }
+    return runs;
+}
+
+/* Event loop */
+
+typedef struct {
+    esp_event_base_t base;
+    int32_t event_id;
+    esp_event_handler_t handler;
+    void* arg;
+} host_handler_t;
+
+static host_handler_t s_handlers[HOST_MAX_HANDLERS];
+static size_t s_handler_count = 0;
+
+esp_err_t esp_event_handler_register(esp_event_base_t base, int32_t event_id, esp_event_handler_t handler,
+                                     void* handler_arg)
+{
+    if (handler == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_handler_count >= HOST_MAX_HANDLERS) {
+        return ESP_ERR_NO_MEM;
+    }
+    s_handlers[s_handler_count++] = (host_handler_t){ base, event_id, handler, handler_arg };
+    return ESP_OK;
+}
+
+esp_err_t esp_event_post(esp_event_base_t base, int32_t event_id, const void* event_data, size_t event_data_size,
+                         TickType_t ticks_to_wait)
+{
+    for (size_t i = 0; i < s_handler_count; i++) {
+        const host_handler_t* entry = &s_handlers[i];
+        if (entry->base == base && (entry->event_id == ESP_EVENT_ANY_ID || entry->event_id == event_id)) {
+            entry->handler(entry->arg, base, event_id, (void*)event_data);
+        }
+    }
+    return ESP_OK;
+}
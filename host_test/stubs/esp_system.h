@@ -0,0 +1,18 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Host stand-in for ESP-IDF's esp_system.h: the heap is the memory the stubs allocate */
+
+uint32_t esp_get_free_heap_size(void);
+
+/**
+ * @brief Allocate from the tracked host heap (used by the stubs for what ESP-IDF would allocate)
+ */
+void* host_heap_alloc(size_t size);
+
+/**
+ * @brief Release memory from host_heap_alloc()
+ */
+void host_heap_free(void* ptr);
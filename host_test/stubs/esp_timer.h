@@ -0,0 +1,34 @@
+#pragma once
+
+#include "esp_err.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Host stand-in for ESP-IDF's esp_timer.h: time only moves when a test sets it */
+
+int64_t esp_timer_get_time(void);
+
+/**
+ * @brief Set the time esp_timer_get_time() returns
+ */
+void host_set_time_us(int64_t now_us);
+
+typedef struct esp_timer* esp_timer_handle_t;
+typedef void (*esp_timer_cb_t)(void* arg);
+
+typedef struct {
+    esp_timer_cb_t callback;
+    void* arg;
+    const char* name;
+} esp_timer_create_args_t;
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t* create_args, esp_timer_handle_t* out_handle);
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us);
+esp_err_t esp_timer_stop(esp_timer_handle_t timer);
+
+/**
+ * @brief Advance the time to the earliest armed timer and run its callback
+ *
+ * @return false if no timer is armed
+ */
+bool host_timer_fire_next(void);
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "esp_err.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Host stand-in for ESP-IDF's esp_wifi.h: counts association attempts and
+ * keeps the station configuration and the AP the station is associated
+ * with in RAM.
+ */
+
+#define ESP_ERR_WIFI_NOT_CONNECT    0x300f
+
+typedef enum {
+    WIFI_IF_STA,
+    WIFI_IF_AP,
+} wifi_interface_t;
+
+typedef struct {
+    uint8_t ssid[32];
+    uint8_t password[64];
+    bool bssid_set;
+    uint8_t bssid[6];
+    uint8_t channel;
+} wifi_sta_config_t;
+
+typedef union {
+    wifi_sta_config_t sta;
+} wifi_config_t;
+
+typedef struct {
+    uint8_t bssid[6];
+    uint8_t ssid[33];
+    uint8_t primary;
+    int8_t rssi;
+} wifi_ap_record_t;
+
+esp_err_t esp_wifi_connect(void);
+esp_err_t esp_wifi_set_config(wifi_interface_t interface, wifi_config_t* conf);
+esp_err_t esp_wifi_get_config(wifi_interface_t interface, wifi_config_t* conf);
+esp_err_t esp_wifi_sta_get_ap_info(wifi_ap_record_t* ap_info);
+
+/**
+ * @brief Number of esp_wifi_connect() calls so far
+ */
+uint32_t host_wifi_connect_calls(void);
+
+/**
+ * @brief Set the AP esp_wifi_sta_get_ap_info() reports (NULL: not associated)
+ */
+void host_wifi_set_ap(const uint8_t bssid[6], uint8_t channel);
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <stdint.h>
+
+/* Host stand-in for FreeRTOS.h: host tests are single-threaded, critical sections are no-ops */
+
+typedef int portMUX_TYPE;
+typedef uint32_t TickType_t;
+typedef unsigned int UBaseType_t;
+typedef int BaseType_t;
+typedef void* TaskHandle_t;
+
+#define portMUX_INITIALIZER_UNLOCKED    0
+#define portENTER_CRITICAL(mux)         ((void)(mux))
+#define portEXIT_CRITICAL(mux)          ((void)(mux))
+#define portMAX_DELAY                   ((TickType_t)0xFFFFFFFFU)
+#define pdTRUE                          1
+#define pdFALSE                         0
+#define pdPASS                          1
+#define pdMS_TO_TICKS(ms)               ((TickType_t)(ms))
@@ -0,0 +1,26 @@
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+#include <stdint.h>
+
+/*
+ * Host stand-in for FreeRTOS task.h. Tasks never run on their own: a test
+ * calls host_tasks_run(), and each notified task runs on the caller until it
+ * waits for a notification it has not been given. The task function is
+ * entered from the top every time, which suits the usual
+ * for (;;) { ulTaskNotifyTake(...); ... } loop that keeps its state in statics.
+ */
+
+typedef void (*TaskFunction_t)(void* arg);
+
+BaseType_t xTaskCreate(TaskFunction_t task_code, const char* name, uint32_t stack_depth, void* params,
+                       UBaseType_t priority, TaskHandle_t* created_task);
+BaseType_t xTaskNotifyGive(TaskHandle_t task);
+uint32_t ulTaskNotifyTake(BaseType_t clear_count_on_exit, TickType_t ticks_to_wait);
+
+/**
+ * @brief Run notified tasks until none has a notification left
+ *
+ * @return Number of times a task was run
+ */
+uint32_t host_tasks_run(void);
@@ -0,0 +1,10 @@
+#pragma once
+
+#include <string.h>
+
+/* Host stand-ins for newlib functions ESP-IDF code relies on; force-included into every host build */
+
+#if defined(__GLIBC__) && (__GLIBC__ < 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ < 38))
+#define HOST_NEEDS_STRLCPY 1
+size_t strlcpy(char* dst, const char* src, size_t size);
+#endif
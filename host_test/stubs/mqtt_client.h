@@ -0,0 +1,39 @@
+#pragma once
+
+#include "esp_err.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Host stand-in for esp-mqtt's mqtt_client.h: a client that only tracks its
+ * lifecycle. Like esp-mqtt, init allocates the client, start allocates the
+ * MQTT task and its buffers, stop releases them and destroy frees the rest.
+ */
+
+typedef struct esp_mqtt_client* esp_mqtt_client_handle_t;
+
+typedef struct {
+    struct {
+        bool disable_auto_reconnect;
+    } network;
+} esp_mqtt_client_config_t;
+
+esp_mqtt_client_handle_t esp_mqtt_client_init(const esp_mqtt_client_config_t* config);
+esp_err_t esp_mqtt_client_start(esp_mqtt_client_handle_t client);
+esp_err_t esp_mqtt_client_stop(esp_mqtt_client_handle_t client);
+esp_err_t esp_mqtt_client_reconnect(esp_mqtt_client_handle_t client);
+esp_err_t esp_mqtt_client_destroy(esp_mqtt_client_handle_t client);
+
+/**
+ * @brief Lifecycle counters of all stub clients
+ */
+typedef struct {
+    uint32_t clients;               /**< Clients allocated and not destroyed */
+    uint32_t tasks;                 /**< MQTT tasks running */
+    uint32_t starts;
+    uint32_t stops;
+    uint32_t reconnects;
+    uint32_t misuse;                /**< Start of a running or reconnect/stop of a stopped client */
+} host_mqtt_stats_t;
+
+void host_mqtt_get_stats(host_mqtt_stats_t* stats);
@@ -0,0 +1,86 @@
+#include "mqtt_client.h"
+#include "esp_system.h"
+
+/* Sizes of what esp-mqtt allocates: the client with its buffers, and the MQTT task stack */
+#define HOST_MQTT_CLIENT_SIZE   4096
+#define HOST_MQTT_TASK_SIZE     6144
+
+struct esp_mqtt_client {
+    void* task;                     /**< Stands in for the MQTT task, NULL when stopped */
+};
+
+static host_mqtt_stats_t s_mqtt_stats;
+
+esp_mqtt_client_handle_t esp_mqtt_client_init(const esp_mqtt_client_config_t* config)
+{
+    esp_mqtt_client_handle_t client = host_heap_alloc(HOST_MQTT_CLIENT_SIZE);
+    if (client != NULL) {
+        s_mqtt_stats.clients++;
+    }
+    return client;
+}
+
+esp_err_t esp_mqtt_client_start(esp_mqtt_client_handle_t client)
+{
+    if (client == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (client->task != NULL) {
+        s_mqtt_stats.misuse++;
+        return ESP_FAIL;
+    }
+    client->task = host_heap_alloc(HOST_MQTT_TASK_SIZE);
+    if (client->task == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    s_mqtt_stats.tasks++;
+    s_mqtt_stats.starts++;
+    return ESP_OK;
+}
+
+esp_err_t esp_mqtt_client_stop(esp_mqtt_client_handle_t client)
+{
+    if (client == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (client->task == NULL) {
+        s_mqtt_stats.misuse++;
+        return ESP_FAIL;
+    }
+    host_heap_free(client->task);
+    client->task = NULL;
+    s_mqtt_stats.tasks--;
+    s_mqtt_stats.stops++;
+    return ESP_OK;
+}
+
+esp_err_t esp_mqtt_client_reconnect(esp_mqtt_client_handle_t client)
+{
+    if (client == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (client->task == NULL) {
+        s_mqtt_stats.misuse++;
+        return ESP_FAIL;
+    }
+    s_mqtt_stats.reconnects++;
+    return ESP_OK;
+}
+
+esp_err_t esp_mqtt_client_destroy(esp_mqtt_client_handle_t client)
+{
+    if (client == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (client->task != NULL) {
+        esp_mqtt_client_stop(client);
+    }
+    host_heap_free(client);
+    s_mqtt_stats.clients--;
+    return ESP_OK;
+}
+
+void host_mqtt_get_stats(host_mqtt_stats_t* stats)
+{
+    *stats = s_mqtt_stats;
+}
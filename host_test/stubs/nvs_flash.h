@@ -0,0 +1,8 @@
+#pragma once
+
+#include "esp_err.h"
+
+/* Host stand-in for ESP-IDF's nvs_flash.h: the RAM table in nvs.h needs no initialization */
+
+esp_err_t nvs_flash_init(void);
+esp_err_t nvs_flash_erase(void);
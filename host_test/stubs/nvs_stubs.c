@@ -0,0 +1,217 @@
+#include "nvs.h"
+#include "nvs_flash.h"
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define HOST_NVS_MAX_ENTRIES    32
+#define HOST_NVS_MAX_HANDLES    8
+#define HOST_NVS_NAME_MAX       16      /* 15 characters, as in NVS */
+
+typedef struct {
+    bool used;
+    bool is_str;
+    char ns[HOST_NVS_NAME_MAX];
+    char key[HOST_NVS_NAME_MAX];
+    void* data;
+    size_t len;                     /**< Includes the terminator for strings */
+} host_nvs_entry_t;
+
+typedef struct {
+    bool open;
+    nvs_open_mode_t mode;
+    char ns[HOST_NVS_NAME_MAX];
+} host_nvs_handle_t;
+
+static host_nvs_entry_t s_entries[HOST_NVS_MAX_ENTRIES];
+static host_nvs_handle_t s_handles[HOST_NVS_MAX_HANDLES];
+static host_nvs_stats_t s_nvs_stats;
+
+static host_nvs_handle_t* get_handle(nvs_handle_t handle)
+{
+    if (handle == 0 || handle > HOST_NVS_MAX_HANDLES || !s_handles[handle - 1].open) {
+        return NULL;
+    }
+    return &s_handles[handle - 1];
+}
+
+static host_nvs_entry_t* find_entry(const char* ns, const char* key)
+{
+    for (size_t i = 0; i < HOST_NVS_MAX_ENTRIES; i++) {
+        host_nvs_entry_t* entry = &s_entries[i];
+        if (entry->used && strcmp(entry->ns, ns) == 0 && strcmp(entry->key, key) == 0) {
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+static bool namespace_exists(const char* ns)
+{
+    for (size_t i = 0; i < HOST_NVS_MAX_ENTRIES; i++) {
+        if (s_entries[i].used && strcmp(s_entries[i].ns, ns) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static esp_err_t set_entry(nvs_handle_t handle, const char* key, const void* value, size_t len, bool is_str)
+{
+    s_nvs_stats.writes++;
+    host_nvs_handle_t* h = get_handle(handle);
+    if (h == NULL) {
+        return ESP_ERR_NVS_INVALID_HANDLE;
+    }
+    if (h->mode != NVS_READWRITE) {
+        return ESP_ERR_NVS_READ_ONLY;
+    }
+    if (key == NULL || strlen(key) >= HOST_NVS_NAME_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    host_nvs_entry_t* entry = find_entry(h->ns, key);
+    for (size_t i = 0; entry == NULL && i < HOST_NVS_MAX_ENTRIES; i++) {
+        if (!s_entries[i].used) {
+            entry = &s_entries[i];
+            memset(entry, 0, sizeof(*entry));
+            entry->used = true;
+            strlcpy(entry->ns, h->ns, sizeof(entry->ns));
+            strlcpy(entry->key, key, sizeof(entry->key));
+        }
+    }
+    if (entry == NULL) {
+        return ESP_ERR_NVS_NOT_ENOUGH_SPACE;
+    }
+
+    void* data = malloc(len);
+    if (data == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    memcpy(data, value, len);
+    free(entry->data);
+    entry->data = data;
+    entry->len = len;
+    entry->is_str = is_str;
+    return ESP_OK;
+}
+
+static esp_err_t get_entry(nvs_handle_t handle, const char* key, void* out_value, size_t* length, bool is_str)
+{
+    s_nvs_stats.reads++;
+    host_nvs_handle_t* h = get_handle(handle);
+    if (h == NULL) {
+        return ESP_ERR_NVS_INVALID_HANDLE;
+    }
+    if (key == NULL || length == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    host_nvs_entry_t* entry = find_entry(h->ns, key);
+    if (entry == NULL || entry->is_str != is_str) {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+
+    // A NULL buffer asks for the required length
+    if (out_value == NULL) {
+        *length = entry->len;
+        return ESP_OK;
+    }
+    if (*length < entry->len) {
+        *length = entry->len;
+        return ESP_ERR_NVS_INVALID_LENGTH;
+    }
+    memcpy(out_value, entry->data, entry->len);
+    *length = entry->len;
+    return ESP_OK;
+}
+
+esp_err_t nvs_flash_init(void)
+{
+    return ESP_OK;
+}
+
+esp_err_t nvs_flash_erase(void)
+{
+    for (size_t i = 0; i < HOST_NVS_MAX_ENTRIES; i++) {
+        free(s_entries[i].data);
+    }
+    memset(s_entries, 0, sizeof(s_entries));
+    return ESP_OK;
+}
+
+esp_err_t nvs_open(const char* namespace_name, nvs_open_mode_t open_mode, nvs_handle_t* out_handle)
+{
+    s_nvs_stats.opens++;
+    if (namespace_name == NULL || out_handle == NULL || strlen(namespace_name) >= HOST_NVS_NAME_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    // As on the device, a read-only open of a namespace never written fails
+    if (open_mode == NVS_READONLY && !namespace_exists(namespace_name)) {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    for (size_t i = 0; i < HOST_NVS_MAX_HANDLES; i++) {
+        if (!s_handles[i].open) {
+            s_handles[i].open = true;
+            s_handles[i].mode = open_mode;
+            strlcpy(s_handles[i].ns, namespace_name, sizeof(s_handles[i].ns));
+            *out_handle = (nvs_handle_t)(i + 1);
+            return ESP_OK;
+        }
+    }
+    return ESP_ERR_NO_MEM;
+}
+
+void nvs_close(nvs_handle_t handle)
+{
+    host_nvs_handle_t* h = get_handle(handle);
+    if (h) {
+        h->open = false;
+    }
+}
+
+esp_err_t nvs_commit(nvs_handle_t handle)
+{
+    s_nvs_stats.commits++;
+    return get_handle(handle) ? ESP_OK : ESP_ERR_NVS_INVALID_HANDLE;
+}
+
+esp_err_t nvs_erase_key(nvs_handle_t handle, const char* key)
+{
+    s_nvs_stats.writes++;
+    host_nvs_handle_t* h = get_handle(handle);
+    if (h == NULL) {
+        return ESP_ERR_NVS_INVALID_HANDLE;
+    }
+    host_nvs_entry_t* entry = find_entry(h->ns, key);
+    if (entry == NULL) {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    free(entry->data);
+    memset(entry, 0, sizeof(*entry));
+    return ESP_OK;
+}
+
+esp_err_t nvs_set_blob(nvs_handle_t handle, const char* key, const void* value, size_t length)
+{
+    return set_entry(handle, key, value, length, false);
+}
+
+esp_err_t nvs_get_blob(nvs_handle_t handle, const char* key, void* out_value, size_t* length)
+{
+    return get_entry(handle, key, out_value, length, false);
+}
+
+esp_err_t nvs_set_str(nvs_handle_t handle, const char* key, const char* value)
+{
+    return set_entry(handle, key, value, strlen(value) + 1, true);
+}
+
+esp_err_t nvs_get_str(nvs_handle_t handle, const char* key, char* out_value, size_t* length)
+{
+    return get_entry(handle, key, out_value, length, true);
+}
+
+void host_nvs_get_stats(host_nvs_stats_t* stats)
+{
+    *stats = s_nvs_stats;
+}
@@ -0,0 +1,141 @@
+#include "esp_partition.h"
+#include "esp_crc.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define HOST_MAX_PARTITIONS     4
+#define HOST_SECTOR_SIZE        4096
+
+typedef struct {
+    esp_partition_t info;
+    uint8_t* data;
+} host_partition_t;
+
+static host_partition_t s_partitions[HOST_MAX_PARTITIONS];
+static size_t s_partition_count = 0;
+static host_flash_stats_t s_flash_stats;
+
+static uint8_t* partition_data(const esp_partition_t* partition)
+{
+    for (size_t i = 0; i < s_partition_count; i++) {
+        if (&s_partitions[i].info == partition) {
+            return s_partitions[i].data;
+        }
+    }
+    return NULL;
+}
+
+const esp_partition_t* host_partition_create(const char* label, uint32_t size)
+{
+    if (s_partition_count >= HOST_MAX_PARTITIONS || size == 0 || size % HOST_SECTOR_SIZE != 0) {
+        return NULL;
+    }
+    host_partition_t* partition = &s_partitions[s_partition_count];
+    partition->data = malloc(size);
+    if (partition->data == NULL) {
+        return NULL;
+    }
+    memset(partition->data, 0xFF, size);
+    partition->info.type = ESP_PARTITION_TYPE_DATA;
+    partition->info.subtype = ESP_PARTITION_SUBTYPE_ANY;
+    partition->info.size = size;
+    partition->info.erase_size = HOST_SECTOR_SIZE;
+    strncpy(partition->info.label, label, sizeof(partition->info.label) - 1);
+    s_partition_count++;
+    return &partition->info;
+}
+
+const esp_partition_t* esp_partition_find_first(esp_partition_type_t type, esp_partition_subtype_t subtype,
+                                                const char* label)
+{
+    for (size_t i = 0; i < s_partition_count; i++) {
+        const esp_partition_t* info = &s_partitions[i].info;
+        if (info->type == type && (label == NULL || strcmp(info->label, label) == 0)) {
+            return info;
+        }
+    }
+    return NULL;
+}
+
+esp_err_t esp_partition_read(const esp_partition_t* partition, size_t src_offset, void* dst, size_t size)
+{
+    uint8_t* data = partition_data(partition);
+    if (data == NULL || dst == NULL || src_offset + size > partition->size) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    memcpy(dst, data + src_offset, size);
+    s_flash_stats.reads++;
+    s_flash_stats.bytes_read += size;
+    return ESP_OK;
+}
+
+esp_err_t esp_partition_write(const esp_partition_t* partition, size_t dst_offset, const void* src, size_t size)
+{
+    uint8_t* data = partition_data(partition);
+    if (data == NULL || src == NULL || dst_offset + size > partition->size) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    // NOR flash: programming only clears bits
+    const uint8_t* bytes = src;
+    for (size_t i = 0; i < size; i++) {
+        data[dst_offset + i] &= bytes[i];
+    }
+    s_flash_stats.writes++;
+    s_flash_stats.bytes_written += size;
+    return ESP_OK;
+}
+
+esp_err_t esp_partition_erase_range(const esp_partition_t* partition, size_t offset, size_t size)
+{
+    uint8_t* data = partition_data(partition);
+    if (data == NULL || offset % HOST_SECTOR_SIZE != 0 || size % HOST_SECTOR_SIZE != 0 ||
+        offset + size > partition->size) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    memset(data + offset, 0xFF, size);
+    s_flash_stats.erases += size / HOST_SECTOR_SIZE;
+    return ESP_OK;
+}
+
+esp_err_t esp_partition_mmap(const esp_partition_t* partition, size_t offset, size_t size,
+                             esp_partition_mmap_memory_t memory, const void** out_ptr,
+                             esp_partition_mmap_handle_t* out_handle)
+{
+    uint8_t* data = partition_data(partition);
+    if (data == NULL || out_ptr == NULL || out_handle == NULL || offset + size > partition->size) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    // Mapped reads see later writes, as with the flash cache
+    *out_ptr = data + offset;
+    *out_handle = 1;
+    return ESP_OK;
+}
+
+void esp_partition_munmap(esp_partition_mmap_handle_t handle)
+{
+}
+
+void host_flash_get_stats(host_flash_stats_t* stats)
+{
+    *stats = s_flash_stats;
+}
+
+static uint64_t s_crc_bytes = 0;
+
+uint32_t esp_crc32_le(uint32_t crc, const uint8_t* buf, uint32_t len)
+{
+    s_crc_bytes += len;
+    crc = ~crc;
+    for (uint32_t i = 0; i < len; i++) {
+        crc ^= buf[i];
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc >> 1) ^ (0xEDB88320U & (0U - (crc & 1U)));
+        }
+    }
+    return ~crc;
+}
+
+uint64_t host_crc_bytes(void)
+{
+    return s_crc_bytes;
+}
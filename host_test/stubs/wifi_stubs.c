@@ -0,0 +1,129 @@
+#include "esp_wifi.h"
+#include "esp_netif.h"
+#include "esp_attr.h"
+#include "esp_random.h"
+#include <string.h>
+
+/* Wi-Fi station */
+
+static uint32_t s_wifi_connect_calls = 0;
+static wifi_config_t s_sta_config;
+static wifi_ap_record_t s_ap_info;
+static bool s_associated = false;
+
+esp_err_t esp_wifi_connect(void)
+{
+    s_wifi_connect_calls++;
+    return ESP_OK;
+}
+
+uint32_t host_wifi_connect_calls(void)
+{
+    return s_wifi_connect_calls;
+}
+
+esp_err_t esp_wifi_set_config(wifi_interface_t interface, wifi_config_t* conf)
+{
+    if (interface != WIFI_IF_STA || conf == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    s_sta_config = *conf;
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_get_config(wifi_interface_t interface, wifi_config_t* conf)
+{
+    if (interface != WIFI_IF_STA || conf == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    *conf = s_sta_config;
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_sta_get_ap_info(wifi_ap_record_t* ap_info)
+{
+    if (!s_associated) {
+        return ESP_ERR_WIFI_NOT_CONNECT;
+    }
+    *ap_info = s_ap_info;
+    return ESP_OK;
+}
+
+void host_wifi_set_ap(const uint8_t bssid[6], uint8_t channel)
+{
+    s_associated = bssid != NULL;
+    memset(&s_ap_info, 0, sizeof(s_ap_info));
+    if (s_associated) {
+        memcpy(s_ap_info.bssid, bssid, sizeof(s_ap_info.bssid));
+        memcpy(s_ap_info.ssid, s_sta_config.sta.ssid, sizeof(s_sta_config.sta.ssid));
+        s_ap_info.primary = channel;
+    }
+}
+
+/* Network interface */
+
+esp_err_t esp_netif_get_ip_info(esp_netif_t* esp_netif, esp_netif_ip_info_t* ip_info)
+{
+    if (esp_netif == NULL || ip_info == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    *ip_info = esp_netif->ip_info;
+    return ESP_OK;
+}
+
+esp_err_t esp_netif_set_ip_info(esp_netif_t* esp_netif, const esp_netif_ip_info_t* ip_info)
+{
+    if (esp_netif == NULL || ip_info == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    esp_netif->ip_info = *ip_info;
+    return ESP_OK;
+}
+
+esp_err_t esp_netif_get_dns_info(esp_netif_t* esp_netif, esp_netif_dns_type_t type, esp_netif_dns_info_t* dns)
+{
+    if (esp_netif == NULL || dns == NULL || type >= ESP_NETIF_DNS_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    *dns = esp_netif->dns[type];
+    return ESP_OK;
+}
+
+esp_err_t esp_netif_set_dns_info(esp_netif_t* esp_netif, esp_netif_dns_type_t type, esp_netif_dns_info_t* dns)
+{
+    if (esp_netif == NULL || dns == NULL || type >= ESP_NETIF_DNS_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    esp_netif->dns[type] = *dns;
+    return ESP_OK;
+}
+
+esp_err_t esp_netif_dhcpc_start(esp_netif_t* esp_netif)
+{
+    if (esp_netif == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    esp_netif->dhcpc_started = true;
+    return ESP_OK;
+}
+
+esp_err_t esp_netif_dhcpc_stop(esp_netif_t* esp_netif)
+{
+    if (esp_netif == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    esp_netif->dhcpc_started = false;
+    return ESP_OK;
+}
+
+/* RTC memory: the linker brackets the section only in programs that have RTC_NOINIT_ATTR variables */
+
+extern uint8_t __start_rtc_noinit[] __attribute__((weak));
+extern uint8_t __stop_rtc_noinit[] __attribute__((weak));
+
+void host_rtc_power_on(void)
+{
+    for (uint8_t* p = __start_rtc_noinit; p != NULL && p < __stop_rtc_noinit; p++) {
+        *p = (uint8_t)esp_random();
+    }
+}
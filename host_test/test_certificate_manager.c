@@ -0,0 +1,250 @@
+/*
+ * Certificate manager: the primary and backup flash slots, the fallback to
+ * the backup after a reboot finds the primary corrupted, streaming rotation
+ * in small chunks, and rotations that fail without touching the current
+ * certificate.
+ *
+ * Links the mbedTLS 3.x the host build found or downloaded (see
+ * CMakeLists.txt). NVS and flash are the RAM stand-ins from host_test/stubs.
+ * The wall clock is pinned inside the validity of all test certificates and
+ * moved past the development CA's for the expiry checks.
+ */
+#include "host_test.h"
+#include "certificate_manager.h"
+#include "ca_certificate.h"
+#include "test_certificates.h"
+#include "esp_partition.h"
+#include "mbedtls/sha256.h"
+#include <string.h>
+#include <time.h>
+
+#define CERTS_PARTITION_SIZE    0x10000     /* certs in partitions.csv */
+#define CHUNK_LEN               5
+#define CLOCK_PINNED            1767225600  /* 2026-01-01, the demo CA is valid until 2026-07-15 */
+#define CLOCK_DEMO_EXPIRED      1785542400  /* 2026-08-01 */
+
+static time_t s_now = CLOCK_PINNED;
+static const esp_partition_t* s_partition;
+static const uint8_t* s_flash;
+
+time_t time(time_t* out)
+{
+    if (out) {
+        *out = s_now;
+    }
+    return s_now;
+}
+
+static void reboot(void)
+{
+    cert_manager_config_t config = CERT_MANAGER_DEFAULT_CONFIG();
+    CHECK_EQ(cert_manager_deinit(), ESP_OK);
+    CHECK_EQ(cert_manager_init(&config), ESP_OK);
+}
+
+/**
+ * @brief Whether der holds exactly the certificates of pem, in order
+ */
+static bool der_matches(const uint8_t* der, size_t der_len, const char* pem)
+{
+    mbedtls_x509_crt chain;
+    mbedtls_x509_crt_init(&chain);
+    CHECK_EQ(mbedtls_x509_crt_parse(&chain, (const unsigned char*)pem, strlen(pem) + 1), 0);
+    size_t offset = 0;
+    bool match = true;
+    for (const mbedtls_x509_crt* crt = &chain; crt && crt->raw.len > 0 && match; crt = crt->next) {
+        match = offset + crt->raw.len <= der_len && memcmp(der + offset, crt->raw.p, crt->raw.len) == 0;
+        offset += crt->raw.len;
+    }
+    mbedtls_x509_crt_free(&chain);
+    return match && offset == der_len;
+}
+
+static bool loaded_is(const char* pem)
+{
+    const uint8_t* der = NULL;
+    size_t der_len = 0;
+    return cert_manager_load(&der, &der_len) == ESP_OK && der_matches(der, der_len, pem);
+}
+
+/**
+ * @brief Whether the chain handed to TLS starts with the certificate of pem
+ */
+static bool ca_chain_starts_with(const char* pem)
+{
+    mbedtls_x509_crt* chain = NULL;
+    CHECK_EQ(cert_manager_get_ca_chain(&chain), ESP_OK);
+    mbedtls_x509_crt first;
+    mbedtls_x509_crt_init(&first);
+    CHECK_EQ(mbedtls_x509_crt_parse(&first, (const unsigned char*)pem, strlen(pem) + 1), 0);
+    bool match = chain->raw.len == first.raw.len && memcmp(chain->raw.p, first.raw.p, first.raw.len) == 0;
+    mbedtls_x509_crt_free(&first);
+    return match;
+}
+
+/**
+ * @brief Rotate in CHUNK_LEN-byte writes, the way rotateCertificate passes RPC chunks
+ */
+static esp_err_t rotate_streamed(const char* pem, const uint8_t* sha256, cert_validation_result_t* result)
+{
+    size_t len = strlen(pem);
+    esp_err_t err = cert_manager_rotate_begin(len, sha256, CERT_SOURCE_OTA_UPDATE);
+    for (size_t offset = 0; err == ESP_OK && offset < len; offset += CHUNK_LEN) {
+        err = cert_manager_rotate_write(pem + offset, len - offset < CHUNK_LEN ? len - offset : CHUNK_LEN);
+    }
+    return err == ESP_OK ? cert_manager_rotate_finish(result) : err;
+}
+
+static void test_no_certificate(void)
+{
+    CHECK(!cert_manager_is_certificate_valid());
+    const uint8_t* der = NULL;
+    size_t der_len = 0;
+    CHECK_EQ(cert_manager_load(&der, &der_len), ESP_ERR_NOT_FOUND);
+
+    // Only the TLS chain falls back to the development certificate
+    CHECK(ca_chain_starts_with(DEMO_CA_CERTIFICATE_PEM));
+}
+
+static void test_slots(void)
+{
+    CHECK_EQ(cert_manager_store(TEST_ROOT_A_PEM, CERT_SOURCE_MANUFACTURING), ESP_OK);
+    CHECK(loaded_is(TEST_ROOT_A_PEM));
+    CHECK(ca_chain_starts_with(TEST_ROOT_A_PEM));
+
+    CHECK_EQ(cert_manager_store(TEST_ROOT_B_PEM, CERT_SOURCE_CONFIG_ENDPOINT), ESP_OK);
+    CHECK(loaded_is(TEST_ROOT_B_PEM));
+    CHECK(ca_chain_starts_with(TEST_ROOT_B_PEM));
+
+    cert_metadata_t metadata;
+    CHECK_EQ(cert_manager_get_metadata(&metadata), ESP_OK);
+    CHECK_EQ(metadata.source, CERT_SOURCE_CONFIG_ENDPOINT);
+    CHECK(strstr(metadata.subject, "Test Root B") != NULL);
+    const uint8_t* der = NULL;
+    size_t der_len = 0;
+    CHECK_EQ(cert_manager_load(&der, &der_len), ESP_OK);
+    CHECK_EQ(metadata.cert_size, der_len);
+
+    // An expired chain would only replace a working backup
+    s_now = CLOCK_DEMO_EXPIRED;
+    cert_validation_result_t validation;
+    CHECK_EQ(cert_manager_validate(DEMO_CA_CERTIFICATE_PEM, &validation), ESP_OK);
+    CHECK_EQ(validation, CERT_EXPIRED);
+    CHECK_EQ(cert_manager_store(DEMO_CA_CERTIFICATE_PEM, CERT_SOURCE_OTA_UPDATE), ESP_ERR_INVALID_ARG);
+    s_now = CLOCK_PINNED;
+    CHECK(loaded_is(TEST_ROOT_B_PEM));
+}
+
+static void test_backup_after_corruption(void)
+{
+    // Clear bits in the primary's DER; the checksum is verified again after a reboot
+    const uint8_t* der = NULL;
+    size_t der_len = 0;
+    CHECK_EQ(cert_manager_load(&der, &der_len), ESP_OK);
+    uint8_t zeros[8] = { 0 };
+    CHECK_EQ(esp_partition_write(s_partition, (size_t)(der - s_flash) + der_len / 2, zeros, sizeof(zeros)), ESP_OK);
+    reboot();
+
+    CHECK(cert_manager_is_certificate_valid());
+    CHECK(loaded_is(TEST_ROOT_A_PEM));
+    CHECK(ca_chain_starts_with(TEST_ROOT_A_PEM));
+}
+
+static void test_streaming_rotation(void)
+{
+    const char* pem = TEST_LEAF_A_PEM TEST_ROOT_A_PEM;
+    uint8_t sha256[CERT_FINGERPRINT_SIZE];
+    mbedtls_sha256((const unsigned char*)pem, strlen(pem), sha256, 0);
+
+    // Half streamed: the certificate in use is untouched
+    size_t len = strlen(pem);
+    CHECK_EQ(cert_manager_rotate_begin(len, sha256, CERT_SOURCE_OTA_UPDATE), ESP_OK);
+    for (size_t offset = 0; offset < len / 2; offset += CHUNK_LEN) {
+        CHECK_EQ(cert_manager_rotate_write(pem + offset, CHUNK_LEN), ESP_OK);
+    }
+    CHECK(loaded_is(TEST_ROOT_A_PEM));
+    cert_manager_rotate_abort();
+
+    // The staging slot is the corrupted one, never the slot the chain in use points into
+    cert_validation_result_t validation = CERT_NOT_FOUND;
+    CHECK_EQ(rotate_streamed(pem, sha256, &validation), ESP_OK);
+    CHECK_EQ(validation, CERT_VALID);
+    CHECK(loaded_is(pem));
+    CHECK(ca_chain_starts_with(TEST_LEAF_A_PEM));
+
+    cert_metadata_t metadata;
+    CHECK_EQ(cert_manager_get_metadata(&metadata), ESP_OK);
+    CHECK_EQ(metadata.source, CERT_SOURCE_OTA_UPDATE);
+    CHECK(strstr(metadata.subject, "device-a") != NULL);
+    CHECK(strstr(metadata.issuer, "Test Root A") != NULL);
+
+    reboot();
+    CHECK(loaded_is(pem));
+}
+
+static void test_failed_rotations(void)
+{
+    const char* pem = TEST_LEAF_B_PEM TEST_ROOT_B_PEM;
+    size_t len = strlen(pem);
+    cert_validation_result_t validation = CERT_VALID;
+
+    uint8_t wrong_sha256[CERT_FINGERPRINT_SIZE] = { 0 };
+    CHECK_EQ(rotate_streamed(pem, wrong_sha256, &validation), ESP_ERR_INVALID_CRC);
+    CHECK_EQ(validation, CERT_INTEGRITY_FAILED);
+
+    // Cut before the last END marker
+    char truncated[2048];
+    CHECK(len < sizeof(truncated));
+    size_t cut = (size_t)(strstr(pem + strlen(TEST_LEAF_B_PEM), "-----END") - pem);
+    memcpy(truncated, pem, cut);
+    truncated[cut] = '\0';
+    CHECK_EQ(rotate_streamed(truncated, NULL, &validation), ESP_ERR_INVALID_ARG);
+    CHECK_EQ(validation, CERT_INVALID_FORMAT);
+
+    // Not base64
+    memcpy(truncated, pem, len + 1);
+    truncated[strlen("-----BEGIN CERTIFICATE-----\n") + 10] = '*';
+    CHECK_EQ(rotate_streamed(truncated, NULL, NULL), ESP_ERR_INVALID_ARG);
+
+    // More bytes than announced, then writes after the abort
+    CHECK_EQ(cert_manager_rotate_begin(len - 1, NULL, CERT_SOURCE_OTA_UPDATE), ESP_OK);
+    CHECK_EQ(cert_manager_rotate_write(pem, len), ESP_ERR_INVALID_SIZE);
+    CHECK_EQ(cert_manager_rotate_write(pem, 1), ESP_ERR_INVALID_STATE);
+    CHECK_EQ(cert_manager_rotate_finish(NULL), ESP_ERR_INVALID_STATE);
+
+    // Expired
+    s_now = CLOCK_DEMO_EXPIRED;
+    CHECK_EQ(rotate_streamed(DEMO_CA_CERTIFICATE_PEM, NULL, &validation), ESP_ERR_INVALID_ARG);
+    CHECK_EQ(validation, CERT_EXPIRED);
+    s_now = CLOCK_PINNED;
+
+    const char* current = TEST_LEAF_A_PEM TEST_ROOT_A_PEM;
+    CHECK(loaded_is(current));
+    CHECK(ca_chain_starts_with(TEST_LEAF_A_PEM));
+    reboot();
+    CHECK(loaded_is(current));
+}
+
+int main(void)
+{
+    s_partition = host_partition_create("certs", CERTS_PARTITION_SIZE);
+    CHECK(s_partition != NULL);
+    esp_partition_mmap_handle_t handle;
+    const void* mapped = NULL;
+    CHECK_EQ(esp_partition_mmap(s_partition, 0, CERTS_PARTITION_SIZE, ESP_PARTITION_MMAP_DATA, &mapped, &handle),
+             ESP_OK);
+    s_flash = mapped;
+
+    cert_manager_config_t config = CERT_MANAGER_DEFAULT_CONFIG();
+    CHECK_EQ(cert_manager_init(&config), ESP_OK);
+
+    test_no_certificate();
+    test_slots();
+    test_backup_after_corruption();
+    test_streaming_rotation();
+    test_failed_rotations();
+
+    CHECK_EQ(cert_manager_deinit(), ESP_OK);
+    printf("Certificate manager tests passed\n");
+    return 0;
+}
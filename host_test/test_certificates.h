@@ -0,0 +1,93 @@
+#pragma once
+
+/**
+ * @file test_certificates.h
+ * @brief Certificates for the host tests of the certificate manager and trust store
+ *
+ * EC P-256 test certificates valid from 2025-01-01 to 2125-01-01 (openssl ca
+ * -startdate/-enddate). The keys were discarded; nothing here is trusted by
+ * the firmware.
+ */
+
+/** @brief Test Root A: self-signed CA, key A */
+#define TEST_ROOT_A_PEM \
+    "-----BEGIN CERTIFICATE-----\n" \
+    "MIIBiTCCAS6gAwIBAgICEAAwCgYIKoZIzj0EAwIwKjEUMBIGA1UEAwwLVGVzdCBS\n" \
+    "b290IEExEjAQBgNVBAoMCUhvc3QgVGVzdDAgFw0yNTAxMDEwMDAwMDBaGA8yMTI1\n" \
+    "MDEwMTAwMDAwMFowKjEUMBIGA1UEAwwLVGVzdCBSb290IEExEjAQBgNVBAoMCUhv\n" \
+    "c3QgVGVzdDBZMBMGByqGSM49AgEGCCqGSM49AwEHA0IABNYDfkBsW45w0xM7JpkV\n" \
+    "987arl/Wary5qQ2ENi1nuWt0XwYZRVBnh5uNNhXcB7TEwS9vM9/RJuLovVn1Vn9/\n" \
+    "3jmjQjBAMA8GA1UdEwEB/wQFMAMBAf8wDgYDVR0PAQH/BAQDAgEGMB0GA1UdDgQW\n" \
+    "BBSr3uKrPSoTg5Rvi6UUGLVcu9BF3DAKBggqhkjOPQQDAgNJADBGAiEAoeiYq3vl\n" \
+    "ZXVSefTQuI6o3UJ+06JcHNwZVaC5C2o3SOYCIQC9hPf5XtNy6QzZ33gvwsZtPyII\n" \
+    "UXbi0SDr9cRqwH7Meg==\n" \
+    "-----END CERTIFICATE-----\n"
+
+/** @brief Test Root A re-keyed: same subject, key A2 */
+#define TEST_ROOT_A2_PEM \
+    "-----BEGIN CERTIFICATE-----\n" \
+    "MIIBiDCCAS6gAwIBAgICEAEwCgYIKoZIzj0EAwIwKjEUMBIGA1UEAwwLVGVzdCBS\n" \
+    "b290IEExEjAQBgNVBAoMCUhvc3QgVGVzdDAgFw0yNTAxMDEwMDAwMDBaGA8yMTI1\n" \
+    "MDEwMTAwMDAwMFowKjEUMBIGA1UEAwwLVGVzdCBSb290IEExEjAQBgNVBAoMCUhv\n" \
+    "c3QgVGVzdDBZMBMGByqGSM49AgEGCCqGSM49AwEHA0IABAnnSikMLeLsKFsE8S8O\n" \
+    "+eh/++xSRk2M2Y0fKpl1wB4sdzccos+t/CWL1trmxjko4EbCIAeO/j/pcjotWY6h\n" \
+    "aTyjQjBAMA8GA1UdEwEB/wQFMAMBAf8wDgYDVR0PAQH/BAQDAgEGMB0GA1UdDgQW\n" \
+    "BBT4eAO3dt8E7lJYcSC9yFCKC3GwGzAKBggqhkjOPQQDAgNIADBFAiEA+hOxXHdB\n" \
+    "w/APC/wZBQ5g8uov/mVjEWC2QOuvsvCA7HUCIF3gD8BZiFAdgAN4kTrKsjxYikts\n" \
+    "nBNq7wbnwEb4WiGi\n" \
+    "-----END CERTIFICATE-----\n"
+
+/** @brief Test Root B: self-signed CA */
+#define TEST_ROOT_B_PEM \
+    "-----BEGIN CERTIFICATE-----\n" \
+    "MIIBiTCCAS6gAwIBAgICEAIwCgYIKoZIzj0EAwIwKjEUMBIGA1UEAwwLVGVzdCBS\n" \
+    "b290IEIxEjAQBgNVBAoMCUhvc3QgVGVzdDAgFw0yNTAxMDEwMDAwMDBaGA8yMTI1\n" \
+    "MDEwMTAwMDAwMFowKjEUMBIGA1UEAwwLVGVzdCBSb290IEIxEjAQBgNVBAoMCUhv\n" \
+    "c3QgVGVzdDBZMBMGByqGSM49AgEGCCqGSM49AwEHA0IABNtvs5xRozVGGqRz+cJn\n" \
+    "QGx0Wq7htzNKMZpce1flPu87LA1yAn6aNguTal52leq3yh27zRBCW5YXpVG0VyVW\n" \
+    "GkCjQjBAMA8GA1UdEwEB/wQFMAMBAf8wDgYDVR0PAQH/BAQDAgEGMB0GA1UdDgQW\n" \
+    "BBS24gnhG7/4zhsx8sVfSNLwyWhoTzAKBggqhkjOPQQDAgNJADBGAiEAhv5mCQ4Q\n" \
+    "VB6H8hjSb6DdrHxXB1OYfJoFRW8ZJckiCbECIQDEcCF5KZL+7q6KrCf/F3jTXNAK\n" \
+    "XooNoPqgwdTIx2Z8Fw==\n" \
+    "-----END CERTIFICATE-----\n"
+
+/** @brief device-a, issued by key A, with an authority key identifier (not a CA) */
+#define TEST_LEAF_A_PEM \
+    "-----BEGIN CERTIFICATE-----\n" \
+    "MIIBoTCCAUagAwIBAgICEAMwCgYIKoZIzj0EAwIwKjEUMBIGA1UEAwwLVGVzdCBS\n" \
+    "b290IEExEjAQBgNVBAoMCUhvc3QgVGVzdDAgFw0yNTAxMDEwMDAwMDBaGA8yMTI1\n" \
+    "MDEwMTAwMDAwMFowJzERMA8GA1UEAwwIZGV2aWNlLWExEjAQBgNVBAoMCUhvc3Qg\n" \
+    "VGVzdDBZMBMGByqGSM49AgEGCCqGSM49AwEHA0IABDUK53e/0vuqL0ikCQ9xSN7v\n" \
+    "qxIcbSbK9I+LSPaDO49a3NF3ZWLMXMEWnpM/kqRvR0/rvXv44odWEjzjGo+kpA2j\n" \
+    "XTBbMAkGA1UdEwQCMAAwDgYDVR0PAQH/BAQDAgeAMB0GA1UdDgQWBBSS4r/y3OoL\n" \
+    "CBsY1v9QgjV9V4ZaXTAfBgNVHSMEGDAWgBSr3uKrPSoTg5Rvi6UUGLVcu9BF3DAK\n" \
+    "BggqhkjOPQQDAgNJADBGAiEAuNMuAhc5KXO/lpua/eMdzQe5TFuVqNOFpvZq8qEP\n" \
+    "oj8CIQDuzCBTDWce90OReAbNhZZhV8GpIgOSwkq5g285xOvJzg==\n" \
+    "-----END CERTIFICATE-----\n"
+
+/** @brief device-a2, issued by key A2, without an authority key identifier */
+#define TEST_LEAF_A2_PEM \
+    "-----BEGIN CERTIFICATE-----\n" \
+    "MIIBYTCCAQegAwIBAgICEAYwCgYIKoZIzj0EAwIwKjEUMBIGA1UEAwwLVGVzdCBS\n" \
+    "b290IEExEjAQBgNVBAoMCUhvc3QgVGVzdDAgFw0yNTAxMDEwMDAwMDBaGA8yMTI1\n" \
+    "MDEwMTAwMDAwMFowKDESMBAGA1UEAwwJZGV2aWNlLWEyMRIwEAYDVQQKDAlIb3N0\n" \
+    "IFRlc3QwWTATBgcqhkjOPQIBBggqhkjOPQMBBwNCAAQP2T/Hetk+eatN49O/c2ev\n" \
+    "V60ruaxASPUg/uGQaj7kr5C9SF5ft/iSth0d5OBp4qseMTW7srN24kjir7gzzZO+\n" \
+    "ox0wGzAJBgNVHRMEAjAAMA4GA1UdDwEB/wQEAwIHgDAKBggqhkjOPQQDAgNIADBF\n" \
+    "AiArsYFYekV+OdCeTu4ksVrvOU4nF1Furru63n+nOuobbgIhAMdXo4Vg5j4SF+6x\n" \
+    "GDrfIMsNMgOqwu1YoNUilGgZtuv0\n" \
+    "-----END CERTIFICATE-----\n"
+
+/** @brief device-b, issued by Test Root B */
+#define TEST_LEAF_B_PEM \
+    "-----BEGIN CERTIFICATE-----\n" \
+    "MIIBoDCCAUagAwIBAgICEAUwCgYIKoZIzj0EAwIwKjEUMBIGA1UEAwwLVGVzdCBS\n" \
+    "b290IEIxEjAQBgNVBAoMCUhvc3QgVGVzdDAgFw0yNTAxMDEwMDAwMDBaGA8yMTI1\n" \
+    "MDEwMTAwMDAwMFowJzERMA8GA1UEAwwIZGV2aWNlLWIxEjAQBgNVBAoMCUhvc3Qg\n" \
+    "VGVzdDBZMBMGByqGSM49AgEGCCqGSM49AwEHA0IABML4SpI7Rbzcoi4utR6dI26i\n" \
+    "yLC2z2wZg0wXCgDXKVW5+bwUprDVqk0Z33UYMYbx72DrvsGblEirk47JYn8g24uj\n" \
+    "XTBbMAkGA1UdEwQCMAAwDgYDVR0PAQH/BAQDAgeAMB0GA1UdDgQWBBSll313904Q\n" \
+    "CVTAADd7SzdSejXsozAfBgNVHSMEGDAWgBS24gnhG7/4zhsx8sVfSNLwyWhoTzAK\n" \
+    "BggqhkjOPQQDAgNIADBFAiAIBfLze4J1AHCVGEilzDv18ui3EOfkndYOWceraInp\n" \
+    "SQIhAP91eL2WWcqHW8uVGndivlCAfHEjnciWum1XJKkaGa0z\n" \
+    "-----END CERTIFICATE-----\n"
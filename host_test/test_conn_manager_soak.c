@@ -0,0 +1,140 @@
+/*
+ * Connection manager soak: thousands of Wi-Fi drops, failed associations,
+ * broker refusals and broker drops against stub esp-mqtt, checking that the
+ * one client is reused, no second MQTT task is started and the heap stays flat.
+ */
+#include "host_test.h"
+#include "conn_manager.h"
+#include "esp_random.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+#include "esp_wifi.h"
+
+#define SOAK_CYCLES     5000
+
+static uint32_t s_create_calls = 0;
+static uint32_t s_resume_calls = 0;
+
+static esp_err_t create_client(esp_mqtt_client_handle_t* client, void* ctx)
+{
+    esp_mqtt_client_config_t config = { .network.disable_auto_reconnect = true };
+    s_create_calls++;
+    *client = esp_mqtt_client_init(&config);
+    return *client != NULL ? ESP_OK : ESP_ERR_NO_MEM;
+}
+
+static void on_resume(esp_mqtt_client_handle_t client, void* ctx)
+{
+    s_resume_calls++;
+}
+
+/**
+ * @brief Let the next retry timer run; it must be the one that calls esp_wifi_connect()
+ */
+static void expect_wifi_retry(void)
+{
+    uint32_t calls = host_wifi_connect_calls();
+    CHECK(host_timer_fire_next());
+    CHECK_EQ(host_wifi_connect_calls(), calls + 1);
+}
+
+/**
+ * @brief Bring the broker session up from BROKER_CONNECTING, refusing the first `refusals` attempts
+ */
+static void connect_broker(uint32_t refusals)
+{
+    for (uint32_t i = 0; i < refusals; i++) {
+        host_mqtt_stats_t before;
+        host_mqtt_get_stats(&before);
+        conn_manager_on_mqtt_disconnected();
+        CHECK_EQ(conn_manager_get_state(), CONN_STATE_BROKER_CONNECTING);
+        CHECK(host_timer_fire_next());
+        host_mqtt_stats_t after;
+        host_mqtt_get_stats(&after);
+        CHECK_EQ(after.reconnects, before.reconnects + 1);
+    }
+    conn_manager_on_mqtt_connected();
+    CHECK_EQ(conn_manager_get_state(), CONN_STATE_ONLINE);
+}
+
+int main(void)
+{
+    host_set_random_seed(2024);
+
+    conn_manager_config_t config = CONN_MANAGER_DEFAULT_CONFIG();
+    config.create_client = create_client;
+    config.on_resume = on_resume;
+    CHECK_EQ(conn_manager_init(&config), ESP_OK);
+
+    // First IP: the client is created and started at once
+    conn_manager_on_ip_up();
+    CHECK_EQ(conn_manager_get_state(), CONN_STATE_BROKER_CONNECTING);
+    connect_broker(0);
+    esp_mqtt_client_handle_t client = conn_manager_get_client();
+    CHECK(client != NULL);
+
+    uint32_t heap_baseline = 0;
+    for (int cycle = 0; cycle < SOAK_CYCLES; cycle++) {
+        // Broker drops with the link up only go back to BROKER_CONNECTING
+        if (cycle % 7 == 0) {
+            conn_manager_on_mqtt_disconnected();
+            CHECK_EQ(conn_manager_get_state(), CONN_STATE_BROKER_CONNECTING);
+            CHECK(host_timer_fire_next());
+            connect_broker(esp_random() % 3);
+        }
+
+        // Link drop; stopping the client reports one more disconnect, which must be ignored
+        conn_manager_on_wifi_down();
+        conn_manager_on_mqtt_disconnected();
+        CHECK_EQ(conn_manager_get_state(), CONN_STATE_WIFI_DOWN);
+
+        // A few failed associations, each reported as another disconnect
+        uint32_t failures = esp_random() % 4;
+        for (uint32_t i = 0; i < failures; i++) {
+            expect_wifi_retry();
+            conn_manager_on_wifi_down();
+        }
+        expect_wifi_retry();
+
+        // Recovery: the same client is resumed after the jitter
+        conn_manager_on_ip_up();
+        CHECK_EQ(conn_manager_get_state(), CONN_STATE_IP_UP);
+        CHECK(host_timer_fire_next());
+        CHECK_EQ(conn_manager_get_state(), CONN_STATE_BROKER_CONNECTING);
+        CHECK(conn_manager_get_client() == client);
+        connect_broker(esp_random() % 2);
+
+        // A lease renewal while online leaves the running client alone
+        if (cycle % 11 == 0) {
+            conn_manager_on_ip_up();
+            CHECK_EQ(conn_manager_get_state(), CONN_STATE_ONLINE);
+        }
+
+        if (cycle == 0) {
+            heap_baseline = esp_get_free_heap_size();
+        }
+        CHECK_EQ(esp_get_free_heap_size(), heap_baseline);
+    }
+
+    conn_manager_stats_t stats;
+    conn_manager_get_stats(&stats);
+    host_mqtt_stats_t mqtt;
+    host_mqtt_get_stats(&mqtt);
+
+    CHECK_EQ(s_create_calls, 1);
+    CHECK_EQ(stats.clients_created, 1);
+    CHECK_EQ(mqtt.clients, 1);
+    CHECK_EQ(mqtt.tasks, 1);
+    CHECK_EQ(mqtt.misuse, 0);
+    CHECK_EQ(stats.wifi_drops, SOAK_CYCLES);
+    CHECK_EQ(stats.client_starts, SOAK_CYCLES + 1);
+    CHECK_EQ(mqtt.starts, SOAK_CYCLES + 1);
+    CHECK_EQ(mqtt.stops, SOAK_CYCLES);
+    CHECK_EQ(s_resume_calls, SOAK_CYCLES);
+    CHECK_EQ(stats.online_count, mqtt.starts + (SOAK_CYCLES + 6) / 7);
+
+    printf("%d link cycles: %lu client starts, %lu broker reconnects, %lu Wi-Fi retries, free heap %lu bytes\n",
+           SOAK_CYCLES, (unsigned long)stats.client_starts, (unsigned long)mqtt.reconnects,
+           (unsigned long)stats.wifi_retries, (unsigned long)esp_get_free_heap_size());
+    return 0;
+}
@@ -0,0 +1,417 @@
+/*
+ * Broker DNS probe: answers through CNAME chains with the smallest TTL, TTL
+ * clamping and cache expiry, retries after a timeout, stray replies (late
+ * answers to an earlier query, other senders, malformed datagrams), error
+ * responses, and the requests that never reach the network.
+ *
+ * The probe task runs when the test calls host_tasks_run(). Its socket calls
+ * are wrapped at link time (see CMakeLists.txt) and answered by a scripted
+ * DNS server; delays and timeouts move the simulated clock, so latencies are
+ * exact.
+ */
+#include "host_test.h"
+#include "dns_probe.h"
+#include "esp_random.h"
+#include "esp_timer.h"
+#include "freertos/task.h"
+#include <errno.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#define HOST            "broker.example.com"
+#define SERVER          "10.0.0.1"
+#define FAKE_SOCKET     1000
+#define MAX_REPLIES     8
+#define TIMEOUT_MS      2000
+#define ATTEMPTS        2
+#define MIN_TTL_S       30
+#define MAX_TTL_S       3600
+
+/**
+ * @brief One datagram the scripted server sends, or the silence until the deadline
+ */
+typedef struct {
+    bool timeout;                   /**< Nothing arrives before the receive timeout */
+    uint32_t delay_ms;              /**< Time before the datagram arrives */
+    const char* from;               /**< Sender, NULL: the DNS server */
+    bool stale;                     /**< Answers the previous query instead of the current one */
+    uint16_t rcode;
+    uint32_t cname_ttl;             /**< 0: no CNAME before the A record */
+    uint32_t a_ttl;
+    const char* addr;               /**< NULL: no A record */
+    size_t cut;                     /**< Bytes cut off the end */
+} reply_t;
+
+static reply_t s_replies[MAX_REPLIES];
+static size_t s_reply_count = 0;
+static size_t s_next_reply = 0;
+
+static uint8_t s_query[512];
+static size_t s_query_len = 0;
+static uint16_t s_prev_query_id = 0;
+static uint32_t s_queries = 0;
+static int s_open_sockets = 0;
+static int64_t s_rcv_timeout_us = 0;
+static int64_t s_now_us = 0;
+
+static uint32_t s_results = 0;
+static bool s_last_ok = false;
+static uint32_t s_last_latency_ms = 0;
+
+static esp_netif_t s_netif;
+
+static void advance_us(int64_t us)
+{
+    s_now_us += us;
+    host_set_time_us(s_now_us);
+}
+
+/* Scripted DNS server behind the wrapped socket calls */
+
+int __real_close(int fd);
+
+int __wrap_socket(int domain, int type, int protocol)
+{
+    CHECK_EQ(domain, AF_INET);
+    CHECK_EQ(type, SOCK_DGRAM);
+    s_open_sockets++;
+    return FAKE_SOCKET;
+}
+
+int __wrap_close(int fd)
+{
+    if (fd != FAKE_SOCKET) {
+        return __real_close(fd);
+    }
+    s_open_sockets--;
+    return 0;
+}
+
+int __wrap_setsockopt(int fd, int level, int name, const void* value, socklen_t len)
+{
+    CHECK_EQ(fd, FAKE_SOCKET);
+    if (level == SOL_SOCKET && name == SO_RCVTIMEO) {
+        const struct timeval* timeout = value;
+        s_rcv_timeout_us = (int64_t)timeout->tv_sec * 1000000 + timeout->tv_usec;
+    }
+    return 0;
+}
+
+ssize_t __wrap_sendto(int fd, const void* buf, size_t len, int flags, const struct sockaddr* to, socklen_t to_len)
+{
+    const struct sockaddr_in* addr = (const struct sockaddr_in*)to;
+    CHECK_EQ(fd, FAKE_SOCKET);
+    CHECK_EQ(addr->sin_addr.s_addr, inet_addr(SERVER));
+    CHECK_EQ(ntohs(addr->sin_port), 53);
+    CHECK(len <= sizeof(s_query));
+    if (s_query_len > 0) {
+        s_prev_query_id = (uint16_t)((s_query[0] << 8) | s_query[1]);
+    }
+    memcpy(s_query, buf, len);
+    s_query_len = len;
+    s_queries++;
+    return (ssize_t)len;
+}
+
+static size_t put_record(uint8_t* p, uint16_t name_offset, uint16_t type, uint32_t ttl, const uint8_t* data,
+                         uint16_t data_len)
+{
+    const uint8_t header[10] = {
+        0xC0 | (name_offset >> 8), name_offset & 0xFF, type >> 8, type & 0xFF, 0, 1,
+        ttl >> 24, (ttl >> 16) & 0xFF, (ttl >> 8) & 0xFF, ttl & 0xFF,
+    };
+    memcpy(p, header, sizeof(header));
+    p[10] = data_len >> 8;
+    p[11] = data_len & 0xFF;
+    memcpy(p + 12, data, data_len);
+    return 12 + data_len;
+}
+
+/**
+ * @brief Answer the last query: its header and question, then a CNAME and/or an A record
+ */
+static size_t build_reply(const reply_t* reply, uint8_t* msg)
+{
+    static const uint8_t cname[] = "\x04" "edge" "\x03" "cdn" "\x03" "net";
+    memcpy(msg, s_query, s_query_len);
+    if (reply->stale) {
+        msg[0] = s_prev_query_id >> 8;
+        msg[1] = s_prev_query_id & 0xFF;
+    }
+    msg[2] = 0x81;
+    msg[3] = 0x80 | reply->rcode;
+    msg[7] = (reply->cname_ttl > 0) + (reply->addr != NULL);
+
+    size_t len = s_query_len;
+    uint16_t a_name = 12;
+    if (reply->cname_ttl > 0) {
+        a_name = (uint16_t)(len + 12);
+        len += put_record(msg + len, 12, 5, reply->cname_ttl, cname, sizeof(cname));
+    }
+    if (reply->addr) {
+        in_addr_t addr = inet_addr(reply->addr);
+        len += put_record(msg + len, a_name, 1, reply->a_ttl, (const uint8_t*)&addr, 4);
+    }
+    return len - reply->cut;
+}
+
+ssize_t __wrap_recvfrom(int fd, void* buf, size_t len, int flags, struct sockaddr* from, socklen_t* from_len)
+{
+    CHECK_EQ(fd, FAKE_SOCKET);
+    CHECK(s_rcv_timeout_us > 0);
+    if (s_next_reply == s_reply_count || s_replies[s_next_reply].timeout) {
+        s_next_reply += s_next_reply < s_reply_count;
+        advance_us(s_rcv_timeout_us);
+        errno = EAGAIN;
+        return -1;
+    }
+
+    const reply_t* reply = &s_replies[s_next_reply++];
+    CHECK((int64_t)reply->delay_ms * 1000 < s_rcv_timeout_us);
+    advance_us((int64_t)reply->delay_ms * 1000);
+    uint8_t msg[512];
+    size_t msg_len = build_reply(reply, msg);
+    CHECK(msg_len <= len);
+    memcpy(buf, msg, msg_len);
+
+    struct sockaddr_in sender = {
+        .sin_family = AF_INET,
+        .sin_port = htons(53),
+        .sin_addr.s_addr = inet_addr(reply->from ? reply->from : SERVER),
+    };
+    memcpy(from, &sender, sizeof(sender));
+    *from_len = sizeof(sender);
+    return (ssize_t)msg_len;
+}
+
+/* Probe helpers */
+
+static void on_result(bool ok, uint32_t latency_ms, void* ctx)
+{
+    s_results++;
+    s_last_ok = ok;
+    s_last_latency_ms = latency_ms;
+}
+
+static void script(const reply_t* replies, size_t count)
+{
+    CHECK(count <= MAX_REPLIES);
+    if (count > 0) {
+        memcpy(s_replies, replies, count * sizeof(*replies));
+    }
+    s_reply_count = count;
+    s_next_reply = 0;
+}
+
+/**
+ * @brief Probe host against the scripted replies; returns whether it resolved
+ */
+static bool probe(const char* host, const reply_t* replies, size_t count)
+{
+    script(replies, count);
+    uint32_t results = s_results;
+    CHECK_EQ(dns_probe_start(&s_netif, host), ESP_OK);
+    CHECK_EQ(host_tasks_run(), 1);
+    CHECK_EQ(s_results, results + 1);
+    CHECK_EQ(s_next_reply, s_reply_count);
+    CHECK_EQ(s_open_sockets, 0);
+    return s_last_ok;
+}
+
+static bool cached_is(const char* addr)
+{
+    char cached[INET_ADDRSTRLEN];
+    return dns_probe_lookup(HOST, cached, sizeof(cached)) && strcmp(cached, addr) == 0;
+}
+
+static bool cached(void)
+{
+    char addr[INET_ADDRSTRLEN];
+    return dns_probe_lookup(HOST, addr, sizeof(addr));
+}
+
+static void test_arguments(void)
+{
+    CHECK_EQ(dns_probe_start(&s_netif, HOST), ESP_ERR_INVALID_STATE);
+    dns_probe_config_t config = DNS_PROBE_DEFAULT_CONFIG();
+    config.attempts = 0;
+    CHECK_EQ(dns_probe_init(&config), ESP_ERR_INVALID_ARG);
+    config.attempts = 1;
+    config.min_ttl_s = config.max_ttl_s + 1;
+    CHECK_EQ(dns_probe_init(&config), ESP_ERR_INVALID_ARG);
+
+    config = (dns_probe_config_t)DNS_PROBE_DEFAULT_CONFIG();
+    config.timeout_ms = TIMEOUT_MS;
+    config.attempts = ATTEMPTS;
+    config.min_ttl_s = MIN_TTL_S;
+    config.max_ttl_s = MAX_TTL_S;
+    config.on_result = on_result;
+    CHECK_EQ(dns_probe_init(&config), ESP_OK);
+    CHECK_EQ(dns_probe_init(&config), ESP_ERR_INVALID_STATE);
+
+    char long_host[80];
+    memset(long_host, 'a', sizeof(long_host) - 1);
+    long_host[sizeof(long_host) - 1] = '\0';
+    CHECK_EQ(dns_probe_start(NULL, HOST), ESP_ERR_INVALID_ARG);
+    CHECK_EQ(dns_probe_start(&s_netif, long_host), ESP_ERR_INVALID_ARG);
+}
+
+static void test_cname_chain(void)
+{
+    // The address is only valid while every hop is
+    const reply_t replies[] = {
+        { .delay_ms = 35, .cname_ttl = 120, .a_ttl = 600, .addr = "93.184.216.34" },
+    };
+    CHECK(probe(HOST, replies, 1));
+    CHECK_EQ(s_last_latency_ms, 35);
+    CHECK_EQ(s_queries, 1);
+    CHECK(cached_is("93.184.216.34"));
+
+    dns_probe_stats_t stats;
+    dns_probe_get_stats(&stats);
+    CHECK_EQ(stats.probes, 1);
+    CHECK_EQ(stats.failures, 0);
+    CHECK_EQ(stats.last_ttl_s, 120);
+    CHECK_EQ(stats.last_latency_ms, 35);
+    CHECK_EQ(stats.cache_hits, 1);
+
+    advance_us(119 * 1000000LL);
+    CHECK(cached());
+    advance_us(1000000);
+    CHECK(!cached());
+}
+
+static void test_ttl_clamp(void)
+{
+    dns_probe_stats_t stats;
+    const reply_t short_ttl[] = { { .delay_ms = 10, .a_ttl = 0, .addr = "93.184.216.35" } };
+    CHECK(probe(HOST, short_ttl, 1));
+    dns_probe_get_stats(&stats);
+    CHECK_EQ(stats.last_ttl_s, MIN_TTL_S);
+    advance_us(MIN_TTL_S * 1000000LL - 1);
+    CHECK(cached_is("93.184.216.35"));
+    advance_us(1);
+    CHECK(!cached());
+
+    const reply_t long_ttl[] = { { .delay_ms = 10, .cname_ttl = 86400, .a_ttl = 86400, .addr = "93.184.216.36" } };
+    CHECK(probe(HOST, long_ttl, 1));
+    dns_probe_get_stats(&stats);
+    CHECK_EQ(stats.last_ttl_s, MAX_TTL_S);
+    advance_us(MAX_TTL_S * 1000000LL);
+    CHECK(!cached());
+}
+
+static void test_retry_and_stray_replies(void)
+{
+    // The first query goes unanswered until its answer turns up during the retry
+    uint32_t queries = s_queries;
+    const reply_t replies[] = {
+        { .timeout = true },
+        { .delay_ms = 10, .stale = true, .a_ttl = 300, .addr = "198.51.100.1" },
+        { .delay_ms = 5, .from = "10.0.0.2", .a_ttl = 300, .addr = "198.51.100.2" },
+        { .delay_ms = 5, .a_ttl = 300, .addr = "198.51.100.3", .cut = 3 },
+        { .delay_ms = 20, .cname_ttl = 300, .a_ttl = 300, .addr = "93.184.216.37" },
+    };
+    CHECK(probe(HOST, replies, 5));
+    CHECK_EQ(s_queries, queries + 2);
+    CHECK_EQ(s_last_latency_ms, TIMEOUT_MS + 40);
+    CHECK(cached_is("93.184.216.37"));
+
+    // A connect to the cached address failed
+    dns_probe_invalidate("other.example.com");
+    CHECK(cached());
+    dns_probe_invalidate(HOST);
+    CHECK(!cached());
+}
+
+static void test_failures(void)
+{
+    dns_probe_stats_t before;
+    dns_probe_get_stats(&before);
+    uint32_t queries = s_queries;
+
+    // Silence: every attempt waits out its timeout
+    CHECK(!probe(HOST, NULL, 0));
+    CHECK_EQ(s_last_latency_ms, ATTEMPTS * TIMEOUT_MS);
+    CHECK_EQ(s_queries, queries + ATTEMPTS);
+
+    // An error response, even one carrying a record, or an answer without an address is no answer;
+    // the next query is sent at the deadline
+    const reply_t errors[] = {
+        { .delay_ms = 15, .rcode = 3, .a_ttl = 300, .addr = "198.51.100.4" },
+        { .timeout = true },
+        { .delay_ms = 15, .cname_ttl = 300 },
+        { .timeout = true },
+    };
+    CHECK(!probe(HOST, errors, 4));
+    CHECK_EQ(s_last_latency_ms, ATTEMPTS * TIMEOUT_MS);
+    CHECK_EQ(s_queries, queries + 2 * ATTEMPTS);
+    CHECK(!cached());
+
+    dns_probe_stats_t stats;
+    dns_probe_get_stats(&stats);
+    CHECK_EQ(stats.probes, before.probes + 2);
+    CHECK_EQ(stats.failures, before.failures + 2);
+    CHECK(!stats.last_ok);
+}
+
+static void test_no_query(void)
+{
+    uint32_t queries = s_queries;
+
+    // Literals need no DNS and complete on the caller
+    uint32_t results = s_results;
+    CHECK_EQ(dns_probe_start(&s_netif, "192.0.2.10"), ESP_OK);
+    CHECK_EQ(s_results, results + 1);
+    CHECK(s_last_ok);
+    CHECK_EQ(host_tasks_run(), 0);
+
+    // Not a valid name
+    CHECK(!probe("broker..example.com", NULL, 0));
+
+    // No DNS server from DHCP
+    esp_netif_dns_info_t none = { .ip.type = ESP_IPADDR_TYPE_V4 };
+    esp_netif_dns_info_t server;
+    CHECK_EQ(esp_netif_get_dns_info(&s_netif, ESP_NETIF_DNS_MAIN, &server), ESP_OK);
+    esp_netif_set_dns_info(&s_netif, ESP_NETIF_DNS_MAIN, &none);
+    CHECK(!probe(HOST, NULL, 0));
+    CHECK_EQ(s_last_latency_ms, 0);
+    esp_netif_set_dns_info(&s_netif, ESP_NETIF_DNS_MAIN, &server);
+
+    CHECK_EQ(s_queries, queries);
+}
+
+static void test_latest_request(void)
+{
+    // Requests made before the task runs collapse into one probe of the last host
+    const reply_t replies[] = { { .delay_ms = 12, .a_ttl = 300, .addr = "93.184.216.38" } };
+    script(replies, 1);
+    uint32_t results = s_results;
+    CHECK_EQ(dns_probe_start(&s_netif, "old.example.com"), ESP_OK);
+    CHECK_EQ(dns_probe_start(&s_netif, HOST), ESP_OK);
+    CHECK_EQ(host_tasks_run(), 1);
+    CHECK_EQ(s_results, results + 1);
+    CHECK(cached_is("93.184.216.38"));
+    char addr[INET_ADDRSTRLEN];
+    CHECK(!dns_probe_lookup("old.example.com", addr, sizeof(addr)));
+}
+
+int main(void)
+{
+    esp_netif_dns_info_t dns = { .ip.type = ESP_IPADDR_TYPE_V4, .ip.u_addr.ip4.addr = inet_addr(SERVER) };
+    esp_netif_set_dns_info(&s_netif, ESP_NETIF_DNS_MAIN, &dns);
+    host_set_random_seed(53);
+
+    test_arguments();
+    test_cname_chain();
+    test_ttl_clamp();
+    test_retry_and_stray_replies();
+    test_failures();
+    test_no_query();
+    test_latest_request();
+    printf("DNS probe tests passed\n");
+    return 0;
+}
@@ -0,0 +1,194 @@
+/*
+ * Duty cycle schedule, retained buffer and upload tracking.
+ */
+#include "host_test.h"
+#include "duty_cycle.h"
+#include <string.h>
+
+static telemetry_sample_t make_sample(int64_t captured_us, int32_t temperature)
+{
+    telemetry_sample_t sample;
+    memset(&sample, 0, sizeof(sample));
+    sample.captured_us = captured_us;
+    sample.present = 1U << TELEMETRY_KEY_TEMPERATURE;
+    sample.values[TELEMETRY_KEY_TEMPERATURE] = temperature;
+    return sample;
+}
+
+static void test_record_and_upload_trigger(void)
+{
+    duty_cycle_state_t state;
+    duty_cycle_config_t config = { .period_ms = 60000, .upload_every = 3 };
+    duty_cycle_reset(&state);
+    CHECK(duty_cycle_valid(&state));
+
+    telemetry_sample_t sample = make_sample(1000, 2000);
+    CHECK(!duty_cycle_record(&state, &config, &sample));
+    CHECK(!duty_cycle_record(&state, &config, &sample));
+    CHECK(duty_cycle_record(&state, &config, &sample));
+    CHECK_EQ(state.count, 3);
+    CHECK_EQ(state.wakes, 3);
+
+    // A failed upload keeps the count, so the next wake tries again
+    duty_cycle_upload_done(&state, 1000, false);
+    CHECK(duty_cycle_record(&state, &config, &sample));
+    CHECK_EQ(state.upload_failures, 1);
+
+    duty_cycle_consume(&state, state.count);
+    duty_cycle_upload_done(&state, 3000, true);
+    CHECK_EQ(state.count, 0);
+    CHECK_EQ(state.wakes_since_upload, 0);
+    CHECK_EQ(state.samples_uploaded, 4);
+    CHECK_EQ(duty_cycle_radio_us_per_sample(&state), 1000);
+    CHECK(!duty_cycle_record(&state, &config, &sample));
+
+    // A layout change from other firmware is detected
+    state.magic ^= 1;
+    CHECK(!duty_cycle_valid(&state));
+}
+
+static void test_full_buffer_overwrites_oldest(void)
+{
+    duty_cycle_state_t state;
+    duty_cycle_config_t config = { .period_ms = 1000, .upload_every = 1000 };
+    duty_cycle_reset(&state);
+
+    bool upload = false;
+    for (int i = 0; i < DUTY_CYCLE_MAX_SAMPLES + 5; i++) {
+        telemetry_sample_t sample = make_sample(i + 1, i);
+        upload = duty_cycle_record(&state, &config, &sample);
+    }
+    // A full buffer forces an upload whatever upload_every says
+    CHECK(upload);
+    CHECK_EQ(state.count, DUTY_CYCLE_MAX_SAMPLES);
+    CHECK_EQ(state.samples_dropped, 5);
+
+    static telemetry_sample_t out[DUTY_CYCLE_MAX_SAMPLES];
+    CHECK_EQ(duty_cycle_peek(&state, out, DUTY_CYCLE_MAX_SAMPLES), DUTY_CYCLE_MAX_SAMPLES);
+    for (int i = 0; i < DUTY_CYCLE_MAX_SAMPLES; i++) {
+        CHECK_EQ(out[i].captured_us, i + 6);
+    }
+
+    // Consuming wraps the head; peeking stays in order
+    duty_cycle_consume(&state, 10);
+    CHECK_EQ(duty_cycle_peek(&state, out, 4), 4);
+    CHECK_EQ(out[0].captured_us, 16);
+    CHECK_EQ(out[3].captured_us, 19);
+    duty_cycle_consume(&state, 1000);
+    CHECK_EQ(state.count, 0);
+    CHECK_EQ(state.samples_uploaded, DUTY_CYCLE_MAX_SAMPLES);
+}
+
+static void test_next_sleep_absolute_deadlines(void)
+{
+    duty_cycle_state_t state;
+    duty_cycle_config_t config = { .period_ms = 60000, .upload_every = 1 };
+    duty_cycle_reset(&state);
+    const int64_t period_us = 60000000;
+
+    // First wake schedules one period ahead
+    CHECK_EQ(duty_cycle_next_sleep_us(&state, &config, 5000000), period_us);
+
+    // Time spent awake is taken off the sleep, so there is no drift
+    CHECK_EQ(duty_cycle_next_sleep_us(&state, &config, 65000000 + 250000), period_us - 250000);
+    CHECK_EQ(state.next_wake_us, 5000000 + 2 * period_us);
+
+    // An upload wake that overran two deadlines skips to the first one still ahead
+    CHECK_EQ(duty_cycle_next_sleep_us(&state, &config, 5000000 + 4 * period_us + 1000), period_us - 1000);
+    CHECK_EQ(state.next_wake_us, 5000000 + 5 * period_us);
+
+    // Landing exactly on a deadline sleeps a full period, never 0
+    CHECK_EQ(duty_cycle_next_sleep_us(&state, &config, 5000000 + 5 * period_us), period_us);
+
+    // The clock stepped backwards (SNTP): the schedule restarts from now
+    CHECK_EQ(duty_cycle_next_sleep_us(&state, &config, 1000), period_us);
+    CHECK_EQ(state.next_wake_us, 1000 + period_us);
+}
+
+static void test_upload_acked_prefix(void)
+{
+    duty_cycle_upload_t upload;
+    duty_cycle_upload_begin(&upload);
+    CHECK(duty_cycle_upload_settled(&upload));
+    CHECK_EQ(duty_cycle_upload_acked_samples(&upload), 0);
+
+    // Three publishes of 10, 5 and 7 samples
+    int ids[] = { 11, 12, 13 };
+    uint16_t samples[] = { 10, 5, 7 };
+    for (int i = 0; i < 3; i++) {
+        duty_cycle_chunk_t* chunk = duty_cycle_upload_reserve(&upload);
+        CHECK(chunk != NULL);
+        chunk->msg_id = ids[i];
+        duty_cycle_upload_commit(&upload, samples[i]);
+    }
+    CHECK(!duty_cycle_upload_settled(&upload));
+
+    // Out-of-order PUBACK: nothing can be consumed until the first publish is acknowledged
+    CHECK(duty_cycle_upload_ack(&upload, 12));
+    CHECK_EQ(duty_cycle_upload_acked_samples(&upload), 0);
+    CHECK(!duty_cycle_upload_ack(&upload, 99));
+    CHECK(!duty_cycle_upload_ack(&upload, 0));
+
+    CHECK(duty_cycle_upload_ack(&upload, 11));
+    CHECK_EQ(duty_cycle_upload_acked_samples(&upload), 15);
+    CHECK(!duty_cycle_upload_settled(&upload));
+
+    // Budget ran out before the third PUBACK: 15 samples are consumed, 7 stay buffered
+    duty_cycle_state_t state;
+    duty_cycle_config_t config = DUTY_CYCLE_DEFAULT_CONFIG();
+    duty_cycle_reset(&state);
+    for (int i = 0; i < 22; i++) {
+        telemetry_sample_t sample = make_sample(i + 1, 0);
+        duty_cycle_record(&state, &config, &sample);
+    }
+    duty_cycle_consume(&state, duty_cycle_upload_acked_samples(&upload));
+    CHECK_EQ(state.count, 7);
+    telemetry_sample_t first;
+    CHECK_EQ(duty_cycle_peek(&state, &first, 1), 1);
+    CHECK_EQ(first.captured_us, 16);
+
+    // A dropped publish settles the upload but stops the prefix
+    duty_cycle_upload_begin(&upload);
+    duty_cycle_chunk_t* chunk = duty_cycle_upload_reserve(&upload);
+    chunk->msg_id = -1;
+    duty_cycle_upload_commit(&upload, 4);
+    chunk = duty_cycle_upload_reserve(&upload);
+    chunk->msg_id = 21;
+    duty_cycle_upload_commit(&upload, 4);
+    CHECK(duty_cycle_upload_ack(&upload, 21));
+    CHECK(duty_cycle_upload_settled(&upload));
+    CHECK_EQ(duty_cycle_upload_acked_samples(&upload), 0);
+
+    // A PUBACK that arrives between the publish and its commit is kept
+    duty_cycle_upload_begin(&upload);
+    chunk = duty_cycle_upload_reserve(&upload);
+    chunk->msg_id = 31;
+    CHECK(duty_cycle_upload_ack(&upload, 31));
+    duty_cycle_upload_commit(&upload, 3);
+    CHECK_EQ(duty_cycle_upload_acked_samples(&upload), 3);
+
+    // A refused publish is reserved again without a commit
+    chunk = duty_cycle_upload_reserve(&upload);
+    chunk->acked = true;
+    chunk = duty_cycle_upload_reserve(&upload);
+    CHECK(!chunk->acked);
+    CHECK_EQ(upload.count, 1);
+
+    // Every slot in use
+    duty_cycle_upload_begin(&upload);
+    for (int i = 0; i < DUTY_CYCLE_MAX_SAMPLES; i++) {
+        CHECK(duty_cycle_upload_reserve(&upload) != NULL);
+        duty_cycle_upload_commit(&upload, 1);
+    }
+    CHECK(duty_cycle_upload_reserve(&upload) == NULL);
+}
+
+int main(void)
+{
+    test_record_and_upload_trigger();
+    test_full_buffer_overwrites_oldest();
+    test_next_sleep_absolute_deadlines();
+    test_upload_acked_prefix();
+    printf("duty cycle tests passed\n");
+    return 0;
+}
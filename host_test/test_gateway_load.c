@@ -0,0 +1,194 @@
+/*
+ * Gateway load: 256 virtual child devices (the gwChildren cap) recording one
+ * reading per 5 s upload window, flushed through a stand-in outbound queue
+ * that takes at most 8 telemetry messages per flush, with a 3-window stall.
+ * Prints messages/s, bytes per record and RAM per child, and checks every
+ * accepted record is delivered exactly once in payloads that fit the MQTT
+ * buffer, and that no record is refused while the queue keeps up.
+ */
+#include "host_test.h"
+#include "gateway.h"
+#include "mqtt_outbound.h"
+#include <string.h>
+#include <time.h>
+
+#define CHILDREN            256
+#define WINDOWS             120
+#define WINDOW_MS           5000
+#define QUEUE_PER_FLUSH     8       /* Telemetry class max_messages */
+#define PAYLOAD_MAX         4096
+#define STALL_FIRST         40      /* Windows in which the outbound queue is full */
+#define STALL_WINDOWS       3
+#define EPOCH_OFFSET_MS     1700000000000LL
+
+static bool s_queue_full = false;
+static int s_queued_this_flush = 0;
+static int s_next_msg_id = 1;
+static uint32_t s_telemetry_messages = 0;
+static uint32_t s_connect_messages = 0;
+static uint64_t s_telemetry_bytes = 0;
+static uint32_t s_records_seen = 0;
+static size_t s_largest_payload = 0;
+static uint32_t s_records_per_child[CHILDREN];
+static uint32_t s_records_accepted[CHILDREN];
+
+static size_t count_occurrences(const char* data, size_t len, const char* needle)
+{
+    size_t count = 0;
+    size_t needle_len = strlen(needle);
+    for (size_t i = 0; i + needle_len <= len; i++) {
+        if (memcmp(data + i, needle, needle_len) == 0) {
+            count++;
+        }
+    }
+    return count;
+}
+
+/**
+ * @brief Attribute the records of one payload to their children
+ */
+static void scan_payload(const char* data, size_t len)
+{
+    CHECK(len <= PAYLOAD_MAX);
+    CHECK(data[0] == '{' && data[len - 1] == '}');
+    const char* prefix = "\"sim-sensor-";
+    size_t prefix_len = strlen(prefix);
+    for (size_t i = 0; i + prefix_len + 3 < len; i++) {
+        if (memcmp(data + i, prefix, prefix_len) != 0) {
+            continue;
+        }
+        const char* digits = data + i + prefix_len;
+        int child = (digits[0] - '0') * 100 + (digits[1] - '0') * 10 + (digits[2] - '0');
+        CHECK(child >= 0 && child < CHILDREN);
+        // The entry runs up to the closing bracket of its record array
+        const char* end = memchr(digits, ']', len - (size_t)(digits - data));
+        CHECK(end != NULL);
+        s_records_per_child[child] += count_occurrences(digits, (size_t)(end - digits), "\"ts\":");
+    }
+}
+
+esp_err_t mqtt_outbound_publish(mqtt_outbound_class_t cls, const char* topic, const char* data, size_t len,
+                                mqtt_outbound_done_cb_t done, void* ctx)
+{
+    if (s_queue_full || (cls == MQTT_OUTBOUND_TELEMETRY && s_queued_this_flush >= QUEUE_PER_FLUSH)) {
+        return ESP_ERR_NO_MEM;
+    }
+    if (cls == MQTT_OUTBOUND_TELEMETRY) {
+        CHECK(strcmp(topic, "v1/gateway/telemetry") == 0);
+        s_queued_this_flush++;
+        s_telemetry_messages++;
+        s_telemetry_bytes += len;
+        s_records_seen += count_occurrences(data, len, "\"ts\":");
+        if (len > s_largest_payload) {
+            s_largest_payload = len;
+        }
+        scan_payload(data, len);
+    } else {
+        CHECK(strcmp(topic, "v1/gateway/connect") == 0);
+        s_connect_messages++;
+    }
+    if (done) {
+        done(s_next_msg_id++, ctx);
+    }
+    return ESP_OK;
+}
+
+static double elapsed_us(const struct timespec* start, const struct timespec* end)
+{
+    return (end->tv_sec - start->tv_sec) * 1e6 + (end->tv_nsec - start->tv_nsec) / 1e3;
+}
+
+int main(void)
+{
+    static char names[CHILDREN][GATEWAY_DEVICE_NAME_MAX];
+    gateway_config_t config = GATEWAY_DEFAULT_CONFIG();
+    config.max_devices = CHILDREN;
+    CHECK_EQ(gateway_init(&config), ESP_OK);
+
+    uint8_t key_temperature;
+    uint8_t key_sequence;
+    CHECK_EQ(gateway_register_key("temperature", 1, &key_temperature), ESP_OK);
+    CHECK_EQ(gateway_register_key("sequence", 0, &key_sequence), ESP_OK);
+    for (int i = 0; i < CHILDREN; i++) {
+        int device;
+        snprintf(names[i], sizeof(names[i]), "sim-sensor-%03d", i);
+        CHECK_EQ(gateway_add_device(names[i], "sim-sensor", &device), ESP_OK);
+        CHECK_EQ(device, i);
+    }
+    gateway_on_connected();
+
+    double flush_us = 0;
+    int all_connected_window = -1;
+    for (int window = 0; window < WINDOWS; window++) {
+        int64_t now_us = (int64_t)window * WINDOW_MS * 1000;
+        for (int i = 0; i < CHILDREN; i++) {
+            gateway_value_t values[] = {
+                { .key = key_temperature, .value = 215 + i % 50 },
+                { .key = key_sequence, .value = window },
+            };
+            esp_err_t err = gateway_record(i, now_us, values, 2);
+            // Only a stalled queue may fill the child rings
+            CHECK(err == ESP_OK || window >= STALL_FIRST);
+            if (err == ESP_OK) {
+                s_records_accepted[i]++;
+            }
+        }
+
+        s_queue_full = window >= STALL_FIRST && window < STALL_FIRST + STALL_WINDOWS;
+        s_queued_this_flush = 0;
+        struct timespec start;
+        struct timespec end;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        gateway_flush(EPOCH_OFFSET_MS);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        flush_us += elapsed_us(&start, &end);
+
+        gateway_stats_t stats;
+        gateway_get_stats(&stats);
+        if (all_connected_window < 0 && stats.devices_connected == CHILDREN) {
+            all_connected_window = window;
+        }
+    }
+
+    // Drain what the stall left behind
+    s_queue_full = false;
+    for (int extra = 0; extra < 4; extra++) {
+        s_queued_this_flush = 0;
+        gateway_flush(EPOCH_OFFSET_MS);
+    }
+
+    gateway_stats_t stats;
+    gateway_get_stats(&stats);
+    double seconds = WINDOWS * WINDOW_MS / 1000.0;
+    printf("%d children, %d windows of %d ms\n", CHILDREN, WINDOWS, WINDOW_MS);
+    printf("  telemetry messages: %lu (%.2f msg/s, %.1f children per message)\n", (unsigned long)s_telemetry_messages,
+           s_telemetry_messages / seconds, (double)s_records_seen / s_telemetry_messages);
+    printf("  records: %lu (%.1f records/s), %.1f bytes per record, largest payload %zu bytes\n",
+           (unsigned long)s_records_seen, s_records_seen / seconds, (double)s_telemetry_bytes / s_records_seen,
+           s_largest_payload);
+    printf("  connects: %lu, all children connected after %d windows\n", (unsigned long)s_connect_messages,
+           all_connected_window + 1);
+    printf("  RAM: %zu bytes per child, %zu bytes for %d children\n", stats.bytes_per_device,
+           stats.bytes_per_device * CHILDREN, CHILDREN);
+    printf("  records refused after the %d-window stall: %lu (%.1f%%)\n", STALL_WINDOWS,
+           (unsigned long)stats.records_dropped, 100.0 * stats.records_dropped / (CHILDREN * WINDOWS));
+    printf("  host CPU: %.1f us per flush\n", flush_us / WINDOWS);
+
+    // Every accepted record arrives once; the refused ones are counted
+    CHECK_EQ(stats.records_published + stats.records_dropped, CHILDREN * WINDOWS);
+    CHECK_EQ(s_records_seen, stats.records_published);
+    for (int i = 0; i < CHILDREN; i++) {
+        CHECK_EQ(s_records_per_child[i], s_records_accepted[i]);
+    }
+
+    // Connects go out a few per flush, the stall only delays them
+    CHECK_EQ(stats.devices_connected, CHILDREN);
+    CHECK_EQ(s_connect_messages, CHILDREN);
+    CHECK_EQ(all_connected_window + 1,
+             (CHILDREN + config.connects_per_flush - 1) / config.connects_per_flush + STALL_WINDOWS);
+
+    // Batching: many children share one message
+    CHECK(s_telemetry_messages * 20 < s_records_seen);
+    CHECK(stats.bytes_per_device <= 192);
+    return 0;
+}
@@ -0,0 +1,118 @@
+/*
+ * Status LED layers: error over override over flash over base, flash
+ * expiry and the time until the next change, and clearing each overlay.
+ */
+#include "host_test.h"
+#include "led_state.h"
+
+static const led_color_t RED = { 255, 0, 0 };
+static const led_color_t GREEN = { 0, 255, 0 };
+static const led_color_t BLUE = { 0, 0, 255 };
+static const led_color_t WHITE = { 255, 255, 255 };
+
+#define ERROR_WIFI      (1U << 0)
+#define ERROR_MQTT      (1U << 1)
+
+static led_layer_t resolve(led_state_t* state, int64_t now_ms, led_color_t expected, int64_t expected_next_ms)
+{
+    led_color_t color = { 1, 2, 3 };
+    int64_t next_ms = 0;
+    led_layer_t layer = led_state_resolve(state, now_ms, &color, &next_ms);
+    CHECK_EQ(color.red, expected.red);
+    CHECK_EQ(color.green, expected.green);
+    CHECK_EQ(color.blue, expected.blue);
+    CHECK_EQ(next_ms, expected_next_ms);
+    return layer;
+}
+
+static void test_priority(void)
+{
+    led_state_t state;
+    led_state_init(&state, RED);
+    led_color_t off = { 0, 0, 0 };
+    CHECK_EQ(resolve(&state, 0, off, -1), LED_LAYER_BASE);
+
+    led_state_set_base(&state, GREEN);
+    CHECK_EQ(resolve(&state, 0, GREEN, -1), LED_LAYER_BASE);
+
+    led_state_flash(&state, BLUE, 0, 100);
+    CHECK_EQ(resolve(&state, 0, BLUE, 100), LED_LAYER_FLASH);
+
+    led_state_set_override(&state, &WHITE);
+    CHECK_EQ(resolve(&state, 10, WHITE, 90), LED_LAYER_OVERRIDE);
+
+    led_state_set_error(&state, ERROR_WIFI, true);
+    CHECK_EQ(resolve(&state, 20, RED, 80), LED_LAYER_ERROR);
+
+    // Peeling the layers off from the top
+    led_state_set_error(&state, ERROR_WIFI, false);
+    CHECK_EQ(resolve(&state, 30, WHITE, 70), LED_LAYER_OVERRIDE);
+    led_state_set_override(&state, NULL);
+    CHECK_EQ(resolve(&state, 40, BLUE, 60), LED_LAYER_FLASH);
+}
+
+static void test_flash_expiry(void)
+{
+    led_state_t state;
+    led_state_init(&state, RED);
+    led_state_set_base(&state, GREEN);
+
+    led_state_flash(&state, BLUE, 1000, 50);
+    CHECK_EQ(resolve(&state, 1049, BLUE, 1), LED_LAYER_FLASH);
+    CHECK_EQ(resolve(&state, 1050, GREEN, -1), LED_LAYER_BASE);
+    CHECK_EQ(state.flash_until_ms, 0);
+
+    // A new flash replaces the one in progress
+    led_state_flash(&state, BLUE, 2000, 50);
+    led_state_flash(&state, WHITE, 2010, 100);
+    CHECK_EQ(resolve(&state, 2060, WHITE, 50), LED_LAYER_FLASH);
+
+    // A zero-length flash is ignored
+    led_state_flash(&state, BLUE, 2070, 0);
+    CHECK_EQ(resolve(&state, 2070, WHITE, 40), LED_LAYER_FLASH);
+
+    // The flash expires underneath the error overlay and is gone once the error clears
+    led_state_set_error(&state, ERROR_MQTT, true);
+    CHECK_EQ(resolve(&state, 2100, RED, 10), LED_LAYER_ERROR);
+    CHECK_EQ(resolve(&state, 2110, RED, -1), LED_LAYER_ERROR);
+    led_state_set_error(&state, ERROR_MQTT, false);
+    CHECK_EQ(resolve(&state, 2120, GREEN, -1), LED_LAYER_BASE);
+}
+
+static void test_clear_overlays(void)
+{
+    led_state_t state;
+    led_state_init(&state, RED);
+    led_state_set_base(&state, GREEN);
+
+    // The error overlay stays until every source has cleared
+    led_state_set_error(&state, ERROR_WIFI | ERROR_MQTT, true);
+    led_state_set_error(&state, ERROR_WIFI, false);
+    CHECK_EQ(resolve(&state, 0, RED, -1), LED_LAYER_ERROR);
+    led_state_set_error(&state, ERROR_WIFI, false);
+    CHECK_EQ(resolve(&state, 0, RED, -1), LED_LAYER_ERROR);
+    led_state_set_error(&state, ERROR_MQTT, false);
+    CHECK_EQ(resolve(&state, 0, GREEN, -1), LED_LAYER_BASE);
+
+    // The override holds until cleared, and a new one replaces it
+    led_state_set_override(&state, &BLUE);
+    led_state_set_override(&state, &WHITE);
+    CHECK_EQ(resolve(&state, 1000000, WHITE, -1), LED_LAYER_OVERRIDE);
+    led_state_set_override(&state, NULL);
+    CHECK_EQ(resolve(&state, 1000000, GREEN, -1), LED_LAYER_BASE);
+
+    // The base changes underneath the overlays
+    led_state_set_error(&state, ERROR_WIFI, true);
+    led_state_set_base(&state, BLUE);
+    led_state_set_error(&state, ERROR_WIFI, false);
+    CHECK_EQ(resolve(&state, 0, BLUE, -1), LED_LAYER_BASE);
+}
+
+int main(void)
+{
+    test_priority();
+    test_flash_expiry();
+    test_clear_overlays();
+    printf("LED state tests passed\n");
+    return 0;
+}
@@ -0,0 +1,141 @@
+/*
+ * Reconnect storm: 1,000 devices lose the broker at the same moment. The
+ * broker stays down for a while, then accepts a limited number of TLS
+ * handshakes per second; refused devices retry. Prints the reconnect-rate
+ * curve (attempts per second) with decorrelated-jitter backoff and with a
+ * fixed retry interval, and checks that the backoff flattens the peak.
+ */
+#include "host_test.h"
+#include "reconnect_backoff.h"
+#include <string.h>
+
+#define DEVICES             1000
+#define BROKER_DOWN_MS      30000
+#define HANDSHAKES_PER_S    100
+#define FIXED_RETRY_MS      10000   /* esp-mqtt's default reconnect timeout */
+#define SIM_END_MS          600000
+#define TICK_MS             10
+#define CURVE_SECONDS       (SIM_END_MS / 1000)
+
+typedef struct {
+    reconnect_backoff_t backoff;
+    int64_t next_attempt_ms;        /**< -1 once connected */
+    uint32_t random_state;
+} device_t;
+
+typedef struct {
+    uint32_t attempts[CURVE_SECONDS];
+    uint32_t connected[CURVE_SECONDS]; /**< Devices online at the end of each second */
+    uint32_t peak_attempts;
+    uint32_t recovery_peak;         /**< Peak attempts/s once the broker is back */
+    uint32_t total_attempts;
+    int64_t all_online_ms;          /**< -1 if some device never got back */
+} storm_result_t;
+
+static device_t s_devices[DEVICES];
+
+static uint32_t next_random(uint32_t* state)
+{
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+static uint32_t next_delay(device_t* device, bool jitter)
+{
+    if (!jitter) {
+        return FIXED_RETRY_MS;
+    }
+    return reconnect_backoff_next(&device->backoff, next_random(&device->random_state));
+}
+
+static void run_storm(bool jitter, storm_result_t* result)
+{
+    reconnect_backoff_config_t config = RECONNECT_BACKOFF_DEFAULT_CONFIG();
+    memset(result, 0, sizeof(*result));
+    result->all_online_ms = -1;
+
+    // All devices see the disconnect at t=0 and schedule their first attempt
+    for (int i = 0; i < DEVICES; i++) {
+        device_t* device = &s_devices[i];
+        reconnect_backoff_init(&device->backoff, &config);
+        device->random_state = 0x9E3779B9U * (uint32_t)(i + 1);
+        device->next_attempt_ms = next_delay(device, jitter);
+    }
+
+    uint32_t online = 0;
+    for (int64_t now_ms = 0; now_ms < SIM_END_MS && online < DEVICES; now_ms += TICK_MS) {
+        int second = (int)(now_ms / 1000);
+        for (int i = 0; i < DEVICES; i++) {
+            device_t* device = &s_devices[i];
+            if (device->next_attempt_ms < 0 || device->next_attempt_ms > now_ms) {
+                continue;
+            }
+            result->attempts[second]++;
+            result->total_attempts++;
+            // The front end handles a fixed number of handshakes per second and refuses the rest
+            bool accepted = now_ms >= BROKER_DOWN_MS && result->attempts[second] <= HANDSHAKES_PER_S;
+            if (accepted) {
+                device->next_attempt_ms = -1;
+                online++;
+                if (online == DEVICES) {
+                    result->all_online_ms = now_ms;
+                }
+            } else {
+                device->next_attempt_ms = now_ms + next_delay(device, jitter);
+            }
+        }
+        result->connected[second] = online;
+    }
+
+    for (int second = 0; second < CURVE_SECONDS; second++) {
+        if (result->attempts[second] > result->peak_attempts) {
+            result->peak_attempts = result->attempts[second];
+        }
+        if (second >= BROKER_DOWN_MS / 1000 && result->attempts[second] > result->recovery_peak) {
+            result->recovery_peak = result->attempts[second];
+        }
+    }
+}
+
+static void print_curve(const char* name, const storm_result_t* result)
+{
+    printf("%s: peak %lu attempts/s (%lu after the broker is back), %lu attempts in total, all online after %lld s\n",
+           name, (unsigned long)result->peak_attempts, (unsigned long)result->recovery_peak,
+           (unsigned long)result->total_attempts, (long long)(result->all_online_ms / 1000));
+    printf("  second  attempts  online\n");
+    int last = result->all_online_ms >= 0 ? (int)(result->all_online_ms / 1000) : CURVE_SECONDS - 1;
+    for (int second = 0; second <= last; second++) {
+        if (result->attempts[second] > 0) {
+            printf("  %6d  %8lu  %6lu\n", second, (unsigned long)result->attempts[second],
+                   (unsigned long)result->connected[second]);
+        }
+    }
+}
+
+int main(void)
+{
+    storm_result_t fixed;
+    storm_result_t jittered;
+    run_storm(false, &fixed);
+    run_storm(true, &jittered);
+    print_curve("fixed 10 s retry", &fixed);
+    print_curve("decorrelated jitter backoff", &jittered);
+
+    // A fixed interval keeps the whole fleet in lockstep, and it hits the recovered broker at once
+    CHECK_EQ(fixed.peak_attempts, DEVICES);
+    CHECK_EQ(fixed.recovery_peak, DEVICES);
+
+    // The first delays already spread the fleet over [base, 3 * base]; by the time the
+    // broker is back the attempts stay within what the front end can take
+    CHECK(jittered.peak_attempts <= DEVICES * 2 / 3);
+    CHECK(jittered.recovery_peak <= HANDSHAKES_PER_S);
+    CHECK(jittered.all_online_ms >= BROKER_DOWN_MS);
+
+    // Once the broker is back the fleet still recovers, within a few cap-length delays
+    CHECK(jittered.all_online_ms < BROKER_DOWN_MS + 4 * 60000);
+    return 0;
+}
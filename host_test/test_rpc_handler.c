@@ -0,0 +1,171 @@
+/*
+ * RPC latency: a call is timed from the request until the outbound task has
+ * published its response, not until the response is queued. The outbound
+ * queue is a stand-in that holds the responses until the test publishes,
+ * drops or refuses them.
+ */
+#include "host_test.h"
+#include "rpc_handler.h"
+#include "mqtt_outbound.h"
+#include "esp_timer.h"
+#include <string.h>
+
+#define QUEUE_MAX   32
+
+typedef struct {
+    mqtt_outbound_done_cb_t done;
+    void* ctx;
+} queued_t;
+
+static queued_t s_queue[QUEUE_MAX];
+static int s_queued = 0;
+static bool s_refuse = false;
+static int s_next_msg_id = 1;
+
+esp_err_t mqtt_outbound_publish(mqtt_outbound_class_t cls, const char* topic, const char* data, size_t len,
+                                mqtt_outbound_done_cb_t done, void* ctx)
+{
+    CHECK_EQ(cls, MQTT_OUTBOUND_CONTROL);
+    CHECK(strncmp(topic, "v1/devices/me/rpc/response/", 27) == 0);
+    if (s_refuse) {
+        return ESP_ERR_NO_MEM;
+    }
+    CHECK(s_queued < QUEUE_MAX);
+    s_queue[s_queued++] = (queued_t){ done, ctx };
+    return ESP_OK;
+}
+
+/**
+ * @brief Publish (or drop) the oldest queued response, as the outbound task would
+ */
+static void complete_oldest(bool published)
+{
+    CHECK(s_queued > 0);
+    queued_t msg = s_queue[0];
+    memmove(s_queue, s_queue + 1, (size_t)(s_queued - 1) * sizeof(queued_t));
+    s_queued--;
+    if (msg.done) {
+        msg.done(published ? s_next_msg_id++ : -1, msg.ctx);
+    }
+}
+
+static esp_err_t rpc_echo(const json_span_t* params, char* result, size_t result_size, size_t* result_len, void* ctx)
+{
+    *result_len = (size_t)snprintf(result, result_size, "true");
+    return ESP_OK;
+}
+
+static esp_err_t rpc_fail(const json_span_t* params, char* result, size_t result_size, size_t* result_len, void* ctx)
+{
+    return ESP_ERR_INVALID_STATE;
+}
+
+static void request(const char* method, int64_t received_us, int64_t handled_us)
+{
+    static const char* topic = "v1/devices/me/rpc/request/42";
+    char data[64];
+    int len = snprintf(data, sizeof(data), "{\"method\":\"%s\",\"params\":{}}", method);
+    host_set_time_us(handled_us);
+    esp_err_t expected = s_refuse ? ESP_ERR_NO_MEM : ESP_OK;
+    CHECK_EQ(rpc_handler_handle(topic, (int)strlen(topic), data, len, received_us), expected);
+}
+
+static rpc_method_stats_t stats_of(const char* method)
+{
+    rpc_method_stats_t stats[RPC_HANDLER_MAX_METHODS];
+    size_t count = rpc_handler_get_stats(stats, RPC_HANDLER_MAX_METHODS);
+    for (size_t i = 0; i < count; i++) {
+        if (strcmp(stats[i].method, method) == 0) {
+            return stats[i];
+        }
+    }
+    CHECK(false);
+    return stats[0];
+}
+
+static void test_latency_ends_at_publish(void)
+{
+    // Queued 500 us after the request, published 8 ms after it
+    request("echo", 1000, 1500);
+    CHECK_EQ(stats_of("echo").calls, 0);
+    host_set_time_us(9000);
+    complete_oldest(true);
+
+    rpc_method_stats_t stats = stats_of("echo");
+    CHECK_EQ(stats.calls, 1);
+    CHECK_EQ(stats.errors, 0);
+    CHECK_EQ(stats.p50_us, 8000);
+    CHECK_EQ(stats.max_us, 8000);
+
+    char payload[256];
+    CHECK(rpc_handler_serialize_stats(payload, sizeof(payload)) > 0);
+    CHECK(strstr(payload, "\"rpc_echo_p50_us\":8000") != NULL);
+}
+
+static void test_unpublished_responses(void)
+{
+    // Dropped from the queue: counted as an error, no latency sample
+    request("echo", 10000, 10100);
+    complete_oldest(false);
+    rpc_method_stats_t stats = stats_of("echo");
+    CHECK_EQ(stats.calls, 2);
+    CHECK_EQ(stats.errors, 1);
+    CHECK_EQ(stats.p50_us, 8000);
+
+    // Refused by the queue
+    s_refuse = true;
+    request("echo", 20000, 20100);
+    s_refuse = false;
+    stats = stats_of("echo");
+    CHECK_EQ(stats.calls, 3);
+    CHECK_EQ(stats.errors, 2);
+    CHECK_EQ(s_queued, 0);
+
+    // A failed handler's error reply is still timed
+    request("fail", 30000, 30050);
+    host_set_time_us(30300);
+    complete_oldest(true);
+    stats = stats_of("fail");
+    CHECK_EQ(stats.calls, 1);
+    CHECK_EQ(stats.errors, 1);
+    CHECK_EQ(stats.p50_us, 300);
+
+    // Unknown methods are answered but belong to no method
+    request("nope", 40000, 40000);
+    complete_oldest(true);
+}
+
+static void test_many_in_flight(void)
+{
+    // Past the pending timings the extra responses are counted untimed, and timing resumes afterwards
+    const int in_flight = 24;
+    for (int i = 0; i < in_flight; i++) {
+        request("echo", 50000, 50000);
+    }
+    CHECK_EQ(s_queued, in_flight);
+    host_set_time_us(50100);
+    while (s_queued > 0) {
+        complete_oldest(true);
+    }
+    rpc_method_stats_t stats = stats_of("echo");
+    CHECK_EQ(stats.calls, 3 + in_flight);
+    CHECK_EQ(stats.errors, 2);
+    CHECK_EQ(stats.max_us, 8000);
+
+    request("echo", 60000, 60000);
+    host_set_time_us(60200);
+    complete_oldest(true);
+    CHECK_EQ(stats_of("echo").calls, 4 + in_flight);
+}
+
+int main(void)
+{
+    CHECK_EQ(rpc_handler_register("echo", rpc_echo, NULL), ESP_OK);
+    CHECK_EQ(rpc_handler_register("fail", rpc_fail, NULL), ESP_OK);
+
+    test_latency_ends_at_publish();
+    test_unpublished_responses();
+    test_many_in_flight();
+    printf("RPC handler tests passed\n");
+    return 0;
+}
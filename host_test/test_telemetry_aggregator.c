@@ -0,0 +1,165 @@
+/*
+ * Window aggregation against a synthetic sampling trace: 10 Hz temperature,
+ * 1 Hz RSSI/heap/uptime 50 ms off the temperature deadlines, 5 s windows. Expected aggregates are recomputed
+ * from the raw trace and must match exactly.
+ */
+#include "host_test.h"
+#include "telemetry_aggregator.h"
+#include "esp_timer.h"
+#include <math.h>
+
+#define WINDOW_MS       5000
+#define WINDOWS         24
+
+static uint64_t s_rng = 0x2545F4914F6CDD1DULL;
+
+static int32_t trace_random(int32_t lo, int32_t hi)
+{
+    s_rng ^= s_rng << 13;
+    s_rng ^= s_rng >> 7;
+    s_rng ^= s_rng << 17;
+    return lo + (int32_t)((s_rng >> 33) % (uint64_t)(hi - lo + 1));
+}
+
+/**
+ * @brief Reference aggregates of one window of one signal
+ */
+typedef struct {
+    int64_t sum;
+    int32_t min;
+    int32_t max;
+    int32_t last;
+    uint32_t count;
+} reference_t;
+
+static void reference_add(reference_t* ref, int32_t value)
+{
+    if (ref->count == 0 || value < ref->min) {
+        ref->min = value;
+    }
+    if (ref->count == 0 || value > ref->max) {
+        ref->max = value;
+    }
+    ref->sum += value;
+    ref->last = value;
+    ref->count++;
+}
+
+static int32_t reference_mean(const reference_t* ref)
+{
+    // Half away from zero, computed independently of the integer implementation
+    return (int32_t)lround((double)ref->sum / (double)ref->count);
+}
+
+static void test_window_primitives(void)
+{
+    telemetry_window_t window = {0};
+    telemetry_window_reset(&window);
+    CHECK_EQ(telemetry_window_get(&window, TELEMETRY_AGG_COUNT), 0);
+
+    // Mean rounds half away from zero on both sides
+    telemetry_window_add(&window, 1);
+    telemetry_window_add(&window, 2);
+    CHECK_EQ(telemetry_window_get(&window, TELEMETRY_AGG_MEAN), 2);
+    telemetry_window_reset(&window);
+    telemetry_window_add(&window, -1);
+    telemetry_window_add(&window, -2);
+    CHECK_EQ(telemetry_window_get(&window, TELEMETRY_AGG_MEAN), -2);
+    CHECK_EQ(telemetry_window_get(&window, TELEMETRY_AGG_MIN), -2);
+    CHECK_EQ(telemetry_window_get(&window, TELEMETRY_AGG_MAX), -1);
+
+    // No overflow with extreme values: the sum is 64-bit
+    telemetry_window_reset(&window);
+    for (int i = 0; i < 1000; i++) {
+        telemetry_window_add(&window, INT32_MAX);
+    }
+    CHECK_EQ(telemetry_window_get(&window, TELEMETRY_AGG_MEAN), INT32_MAX);
+
+    // The last value survives a reset, the count does not
+    telemetry_window_reset(&window);
+    CHECK_EQ(telemetry_window_get(&window, TELEMETRY_AGG_LAST), INT32_MAX);
+    CHECK_EQ(telemetry_window_get(&window, TELEMETRY_AGG_COUNT), 0);
+}
+
+static void test_synthetic_trace(void)
+{
+    CHECK(telemetry_aggregator_init() == ESP_OK);
+
+    for (int w = 0; w < WINDOWS; w++) {
+        reference_t ref[TELEMETRY_SIGNAL_COUNT] = {{0}};
+        // Window 7 loses every RSSI reading (e.g. Wi-Fi down), window 13 every temperature reading
+        bool rssi_fails = w == 7;
+        bool temperature_fails = w == 13;
+
+        for (int ms = 0; ms < WINDOW_MS; ms += 50) {
+            int64_t now_ms = (int64_t)w * WINDOW_MS + ms;
+            if (ms % 100 == 0 && !temperature_fails) {
+                // 23.00 °C +- 1.50 with a spike now and then
+                int32_t temperature = 2300 + trace_random(-150, 150) + (trace_random(0, 99) == 0 ? 900 : 0);
+                telemetry_aggregator_add(TELEMETRY_SIGNAL_TEMPERATURE, temperature);
+                reference_add(&ref[TELEMETRY_SIGNAL_TEMPERATURE], temperature);
+            }
+            if (ms % 1000 == 50) {
+                if (!rssi_fails) {
+                    int32_t rssi = trace_random(-90, -40);
+                    telemetry_aggregator_add(TELEMETRY_SIGNAL_RSSI, rssi);
+                    reference_add(&ref[TELEMETRY_SIGNAL_RSSI], rssi);
+                }
+                int32_t heap = 200000 + trace_random(-30000, 30000);
+                telemetry_aggregator_add(TELEMETRY_SIGNAL_HEAP, heap);
+                reference_add(&ref[TELEMETRY_SIGNAL_HEAP], heap);
+                int32_t uptime = (int32_t)(now_ms / 1000);
+                telemetry_aggregator_add(TELEMETRY_SIGNAL_UPTIME, uptime);
+                reference_add(&ref[TELEMETRY_SIGNAL_UPTIME], uptime);
+            }
+        }
+
+        host_set_time_us((int64_t)(w + 1) * WINDOW_MS * 1000);
+        telemetry_sample_t sample;
+        telemetry_aggregator_close_window(&sample);
+        CHECK_EQ(sample.captured_us, (int64_t)(w + 1) * WINDOW_MS * 1000);
+
+        for (int key = 0; key < TELEMETRY_KEY_COUNT; key++) {
+            const telemetry_field_t* field = &telemetry_schema[key];
+            const reference_t* r = &ref[field->signal];
+            bool present = (sample.present & (1U << key)) != 0;
+            if (r->count == 0) {
+                // Empty window: the key is left out rather than repeating an old value
+                CHECK(!present);
+                continue;
+            }
+            CHECK(present);
+            int32_t expected = 0;
+            switch (field->aggregate) {
+            case TELEMETRY_AGG_MEAN:  expected = reference_mean(r); break;
+            case TELEMETRY_AGG_MIN:   expected = r->min; break;
+            case TELEMETRY_AGG_MAX:   expected = r->max; break;
+            case TELEMETRY_AGG_LAST:  expected = r->last; break;
+            case TELEMETRY_AGG_COUNT: expected = (int32_t)r->count; break;
+            }
+            CHECK_EQ(sample.values[key], expected);
+        }
+
+        if (rssi_fails) {
+            CHECK_EQ(sample.present, TELEMETRY_KEY_MASK_ALL & ~(1U << TELEMETRY_KEY_RSSI));
+        } else if (temperature_fails) {
+            CHECK_EQ(sample.present & ((1U << TELEMETRY_KEY_TEMPERATURE) | (1U << TELEMETRY_KEY_TEMPERATURE_MIN) |
+                                       (1U << TELEMETRY_KEY_TEMPERATURE_MAX)), 0);
+        } else {
+            CHECK_EQ(sample.present, TELEMETRY_KEY_MASK_ALL);
+        }
+    }
+
+    // Nothing sampled at all: an empty sample
+    telemetry_sample_t sample;
+    telemetry_aggregator_close_window(&sample);
+    CHECK_EQ(sample.present, 0);
+}
+
+int main(void)
+{
+    test_window_primitives();
+    test_synthetic_trace();
+    printf("telemetry aggregator tests passed\n");
+    return 0;
+}
@@ -0,0 +1,303 @@
+/*
+ * Backpressure simulation: drives telemetry_backpressure.c with synthetic
+ * link traces (bandwidth, RTT, loss, RSSI) and checks that the MQTT outbox
+ * never grows past the configured ceiling.
+ *
+ * The device side mirrors telemetry_upload_job() in app_main.c: one upload
+ * window every 5 s, window coalescing and publish stride from the current
+ * level, and every publish admitted against the ceiling first. The link
+ * sends outbox messages in order at the trace bandwidth; a transmission is
+ * lost with the trace's loss rate and retransmitted after esp-mqtt's
+ * retransmit timeout. A message leaves the outbox with its PUBACK, one RTT
+ * after its last byte was sent.
+ */
+#include "host_test.h"
+#include "telemetry_backpressure.h"
+#include <stdint.h>
+#include <string.h>
+
+#define WINDOW_MS           5000    // TELEMETRY_UPLOAD_PERIOD_MS
+#define STEP_MS             50      // Link simulation resolution
+#define RETRANSMIT_MS       5000    // Lost transmissions are sent again after this
+#define SAMPLE_BYTES        110     // Serialized size of one timestamped sample
+#define PUBLISH_OVERHEAD    (sizeof("v1/devices/me/telemetry") - 1 + 9)
+#define PAYLOAD_MAX         4096    // TELEMETRY_PAYLOAD_MAX
+#define RING_SAMPLES        60      // TELEMETRY_BUFFER_MAX_SAMPLES
+#define OUTBOX_MAX_MSGS     512
+
+/**
+ * @brief One segment of a link trace
+ */
+typedef struct {
+    uint32_t duration_s;
+    uint32_t bandwidth;             // Bytes per second, 0 = link down (nothing sent, no PUBACKs)
+    uint32_t rtt_ms;
+    uint32_t loss_pct;              // Per transmission
+    int8_t rssi;
+} trace_segment_t;
+
+typedef struct {
+    int msg_id;
+    size_t len;
+    size_t sent;                    // Bytes of the current transmission already on the link
+    int64_t retransmit_ms;          // Lost: wait until this time, then send again
+    int64_t ack_ms;                 // Sent: PUBACK arrives at this time (0 = not yet)
+} sim_msg_t;
+
+typedef struct {
+    sim_msg_t outbox[OUTBOX_MAX_MSGS];
+    int outbox_count;
+    size_t outbox_bytes;
+    size_t outbox_peak;
+    int next_msg_id;
+    uint32_t pending_samples;       // Ring samples waiting for a publish
+    uint32_t spooled_samples;       // Went to the flash store (ring full or BLOCKED)
+    uint32_t published_samples;
+    uint32_t publishes;
+    uint32_t windows;
+    uint32_t level_windows[TELEMETRY_BP_LEVEL_COUNT];
+    telemetry_bp_level_t max_level;
+    uint64_t rng;
+} sim_t;
+
+static uint32_t sim_random(sim_t* sim)
+{
+    // xorshift64: deterministic traces on every host
+    sim->rng ^= sim->rng << 13;
+    sim->rng ^= sim->rng >> 7;
+    sim->rng ^= sim->rng << 17;
+    return (uint32_t)(sim->rng >> 32);
+}
+
+static void outbox_remove(sim_t* sim, int index)
+{
+    sim->outbox_bytes -= sim->outbox[index].len;
+    memmove(&sim->outbox[index], &sim->outbox[index + 1], (sim->outbox_count - index - 1) * sizeof(sim->outbox[0]));
+    sim->outbox_count--;
+}
+
+/**
+ * @brief Advance the link by one step: send bytes in outbox order, deliver PUBACKs
+ */
+static void link_step(sim_t* sim, const trace_segment_t* seg, int64_t now_ms)
+{
+    for (int i = 0; i < sim->outbox_count;) {
+        sim_msg_t* msg = &sim->outbox[i];
+        if (msg->ack_ms != 0 && now_ms >= msg->ack_ms && seg->bandwidth > 0) {
+            telemetry_bp_on_ack(msg->msg_id, now_ms);
+            outbox_remove(sim, i);
+        } else {
+            i++;
+        }
+    }
+    if (seg->bandwidth == 0) {
+        // Link down: whatever was in flight is lost and goes out again after the outage
+        for (int i = 0; i < sim->outbox_count; i++) {
+            sim->outbox[i].ack_ms = 0;
+            sim->outbox[i].sent = 0;
+        }
+        return;
+    }
+
+    size_t budget = (size_t)seg->bandwidth * STEP_MS / 1000;
+    for (int i = 0; i < sim->outbox_count && budget > 0; i++) {
+        sim_msg_t* msg = &sim->outbox[i];
+        if (msg->ack_ms != 0 || now_ms < msg->retransmit_ms) {
+            continue;
+        }
+        size_t chunk = msg->len - msg->sent < budget ? msg->len - msg->sent : budget;
+        msg->sent += chunk;
+        budget -= chunk;
+        if (msg->sent == msg->len) {
+            msg->sent = 0;
+            if (sim_random(sim) % 100 < seg->loss_pct) {
+                msg->retransmit_ms = now_ms + RETRANSMIT_MS;
+            } else {
+                msg->ack_ms = now_ms + seg->rtt_ms;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Publish pending samples in batches while the ceiling admits them
+ */
+static void publish_pending(sim_t* sim, const telemetry_bp_config_t* config, int64_t now_ms)
+{
+    while (sim->pending_samples > 0) {
+        uint32_t batch = (PAYLOAD_MAX - 2) / SAMPLE_BYTES;
+        if (batch > sim->pending_samples) {
+            batch = sim->pending_samples;
+        }
+        size_t message_len = 2 + batch * SAMPLE_BYTES + PUBLISH_OVERHEAD;
+        if (!telemetry_bp_admit(message_len, sim->outbox_bytes)) {
+            return;
+        }
+        CHECK(sim->outbox_count < OUTBOX_MAX_MSGS);
+        sim_msg_t* msg = &sim->outbox[sim->outbox_count++];
+        memset(msg, 0, sizeof(*msg));
+        msg->msg_id = ++sim->next_msg_id;
+        msg->len = message_len;
+        sim->outbox_bytes += message_len;
+        telemetry_bp_on_publish(msg->msg_id, now_ms);
+
+        // The property under test
+        CHECK(sim->outbox_bytes <= config->outbox_ceiling);
+        if (sim->outbox_bytes > sim->outbox_peak) {
+            sim->outbox_peak = sim->outbox_bytes;
+        }
+        sim->pending_samples -= batch;
+        sim->published_samples += batch;
+        sim->publishes++;
+    }
+}
+
+/**
+ * @brief One upload window, as in telemetry_upload_job()
+ */
+static void upload_window(sim_t* sim, const telemetry_bp_config_t* config, const trace_segment_t* seg, int64_t now_ms)
+{
+    sim->windows++;
+    telemetry_bp_level_t level = telemetry_bp_update(sim->outbox_bytes, seg->rssi, now_ms);
+    sim->level_windows[level]++;
+    if (level > sim->max_level) {
+        sim->max_level = level;
+    }
+    if (sim->windows % telemetry_bp_coalesce_factor() != 0) {
+        return;
+    }
+
+    if (sim->pending_samples == RING_SAMPLES) {
+        sim->pending_samples--;
+        sim->spooled_samples++;
+    }
+    sim->pending_samples++;
+
+    uint32_t stride = telemetry_bp_publish_stride();
+    if (stride == 0) {
+        // BLOCKED: the ring is spooled to flash instead
+        sim->spooled_samples += sim->pending_samples;
+        sim->pending_samples = 0;
+    } else if (sim->windows % stride == 0) {
+        publish_pending(sim, config, now_ms);
+    }
+}
+
+static void run_trace(sim_t* sim, const telemetry_bp_config_t* config, const trace_segment_t* trace, size_t segments)
+{
+    memset(sim, 0, sizeof(*sim));
+    sim->rng = 0x9E3779B97F4A7C15ULL;
+    CHECK(telemetry_bp_init(config) == ESP_OK);
+
+    int64_t now_ms = 0;
+    for (size_t s = 0; s < segments; s++) {
+        int64_t end_ms = now_ms + (int64_t)trace[s].duration_s * 1000;
+        for (; now_ms < end_ms; now_ms += STEP_MS) {
+            link_step(sim, &trace[s], now_ms);
+            if (now_ms % WINDOW_MS == 0) {
+                upload_window(sim, config, &trace[s], now_ms);
+            }
+            CHECK(sim->outbox_bytes <= config->outbox_ceiling);
+        }
+    }
+}
+
+static void report(const char* name, const sim_t* sim)
+{
+    telemetry_bp_stats_t stats;
+    telemetry_bp_get_stats(&stats);
+    printf("%-10s windows %4u  published %4u in %4u publishes  spooled %4u  outbox peak %5zu  "
+           "rejected %3u  losses %3u  ack %4u ms  levels N/D/C/B %u/%u/%u/%u\n",
+           name, (unsigned)sim->windows, (unsigned)sim->published_samples, (unsigned)sim->publishes,
+           (unsigned)sim->spooled_samples, sim->outbox_peak, (unsigned)stats.rejected, (unsigned)stats.losses,
+           (unsigned)stats.ack_latency_ms, (unsigned)sim->level_windows[0], (unsigned)sim->level_windows[1],
+           (unsigned)sim->level_windows[2], (unsigned)sim->level_windows[3]);
+}
+
+#define SEGMENTS(trace) (sizeof(trace) / sizeof((trace)[0]))
+
+int main(void)
+{
+    const telemetry_bp_config_t config = TELEMETRY_BP_DEFAULT_CONFIG();
+    static sim_t sim;
+
+    // Healthy link: never leaves NORMAL, every sample goes out one window after it was taken
+    static const trace_segment_t healthy[] = {
+        { .duration_s = 3600, .bandwidth = 20000, .rtt_ms = 40, .loss_pct = 0, .rssi = -50 },
+    };
+    run_trace(&sim, &config, healthy, SEGMENTS(healthy));
+    report("healthy", &sim);
+    CHECK_EQ(sim.max_level, TELEMETRY_BP_NORMAL);
+    CHECK_EQ(sim.spooled_samples, 0);
+    CHECK(sim.pending_samples <= 1);
+
+    // Weak signal alone: DEGRADED halves the publish rate, nothing is lost
+    static const trace_segment_t weak[] = {
+        { .duration_s = 1800, .bandwidth = 20000, .rtt_ms = 60, .loss_pct = 0, .rssi = -80 },
+    };
+    run_trace(&sim, &config, weak, SEGMENTS(weak));
+    report("weak_rssi", &sim);
+    CHECK_EQ(sim.max_level, TELEMETRY_BP_DEGRADED);
+    CHECK(sim.publishes * 2 <= sim.windows + 1);
+    CHECK_EQ(sim.spooled_samples, 0);
+
+    // Slower than the offered load, long RTT and heavy loss: the outbox must stay under the ceiling
+    static const trace_segment_t congested[] = {
+        { .duration_s = 600,  .bandwidth = 20000, .rtt_ms = 40,   .loss_pct = 0,  .rssi = -55 },
+        { .duration_s = 3600, .bandwidth = 15,    .rtt_ms = 3000, .loss_pct = 30, .rssi = -78 },
+        { .duration_s = 1800, .bandwidth = 20000, .rtt_ms = 40,   .loss_pct = 0,  .rssi = -55 },
+    };
+    run_trace(&sim, &config, congested, SEGMENTS(congested));
+    report("congested", &sim);
+    CHECK(sim.max_level >= TELEMETRY_BP_CONGESTED);
+    CHECK(sim.outbox_peak <= config.outbox_ceiling);
+    // Recovered at the end of the trace
+    telemetry_bp_stats_t stats;
+    telemetry_bp_get_stats(&stats);
+    CHECK_EQ(stats.level, TELEMETRY_BP_NORMAL);
+    CHECK_EQ(sim.outbox_bytes, 0);
+
+    // Backhaul outage: nothing is acknowledged for 20 minutes
+    static const trace_segment_t outage[] = {
+        { .duration_s = 600,  .bandwidth = 20000, .rtt_ms = 40, .loss_pct = 0, .rssi = -55 },
+        { .duration_s = 1200, .bandwidth = 0,     .rtt_ms = 0,  .loss_pct = 0, .rssi = -55 },
+        { .duration_s = 1800, .bandwidth = 20000, .rtt_ms = 40, .loss_pct = 0, .rssi = -55 },
+    };
+    run_trace(&sim, &config, outage, SEGMENTS(outage));
+    report("outage", &sim);
+    CHECK(sim.max_level >= TELEMETRY_BP_CONGESTED);
+    telemetry_bp_get_stats(&stats);
+    CHECK(stats.losses > 0);
+    CHECK_EQ(stats.level, TELEMETRY_BP_NORMAL);
+    CHECK_EQ(sim.outbox_bytes, 0);
+
+    // Flapping link with bursts of loss: only the ceiling is asserted
+    static trace_segment_t flapping[60];
+    for (size_t i = 0; i < SEGMENTS(flapping); i++) {
+        flapping[i] = (trace_segment_t){
+            .duration_s = 60 + (uint32_t)(i * 37 % 90),
+            .bandwidth = (i % 3 == 0) ? 0 : (i % 3 == 1) ? 40 : 20000,
+            .rtt_ms = (i % 3 == 1) ? 2500 : 50,
+            .loss_pct = (i % 3 == 1) ? 50 : 0,
+            .rssi = (int8_t)(-60 - (int)(i * 7 % 35)),
+        };
+    }
+    run_trace(&sim, &config, flapping, SEGMENTS(flapping));
+    report("flapping", &sim);
+    CHECK(sim.outbox_peak <= config.outbox_ceiling);
+
+    // A tight ceiling is honoured exactly, including publish framing
+    telemetry_bp_config_t tight = config;
+    tight.outbox_degraded = 512;
+    tight.outbox_congested = 1024;
+    tight.outbox_blocked = 1536;
+    tight.outbox_ceiling = 1700;
+    run_trace(&sim, &tight, congested, SEGMENTS(congested));
+    report("tight", &sim);
+    CHECK(sim.outbox_peak <= tight.outbox_ceiling);
+    telemetry_bp_get_stats(&stats);
+    CHECK(stats.rejected > 0);
+
+    printf("telemetry backpressure simulation passed\n");
+    return 0;
+}
@@ -0,0 +1,171 @@
+/*
+ * Flash store drain: records leave the log only once the publishes carrying
+ * them were acknowledged, in order, with the publishes themselves tracked by
+ * telemetry_store_drain_t the way drain_telemetry_store uses it.
+ */
+#include "host_test.h"
+#include "telemetry_store.h"
+#include "esp_partition.h"
+#include <string.h>
+
+#define RECORDS_PER_SEGMENT     ((4096 - 16) / ((8 + sizeof(telemetry_sample_t) + 3) / 4 * 4))
+
+static telemetry_store_drain_t s_drain;
+static telemetry_sample_t s_batch[64];
+static int32_t s_next_value = 0;
+static int s_next_msg_id = 100;
+
+static void append(int records)
+{
+    for (int i = 0; i < records; i++) {
+        telemetry_sample_t sample;
+        memset(&sample, 0, sizeof(sample));
+        sample.captured_us = 1700000000000000LL + s_next_value;
+        sample.present = 1U << TELEMETRY_KEY_UPTIME;
+        sample.values[TELEMETRY_KEY_UPTIME] = s_next_value++;
+        CHECK_EQ(telemetry_store_append(&sample), ESP_OK);
+    }
+}
+
+/**
+ * @brief Queue one publish of the next records not in flight; returns its msg_id
+ */
+static int publish(size_t records, int32_t expected_first)
+{
+    CHECK_EQ(telemetry_store_peek(s_drain.records, s_batch, records), records);
+    CHECK_EQ(s_batch[0].values[TELEMETRY_KEY_UPTIME], expected_first);
+    uint32_t seq = telemetry_store_drain_reserve(&s_drain);
+    CHECK(seq != 0);
+    int msg_id = s_next_msg_id++;
+    telemetry_store_drain_sent(&s_drain, seq, msg_id);
+    telemetry_store_drain_commit(&s_drain, (uint16_t)records, false);
+    return msg_id;
+}
+
+static void release_acked(void)
+{
+    telemetry_store_consume(telemetry_store_drain_take_acked(&s_drain));
+}
+
+static void test_consume_only_acknowledged_prefix(void)
+{
+    append(150);
+    int first = publish(60, 0);
+    int second = publish(60, 60);
+    int third = publish(30, 120);
+    CHECK_EQ(s_drain.records, 150);
+    CHECK_EQ(telemetry_store_peek(s_drain.records, s_batch, 1), 0);
+
+    // Queued but unacknowledged: everything stays in flash, the first segment included
+    host_flash_stats_t flash_before;
+    host_flash_get_stats(&flash_before);
+    release_acked();
+    CHECK_EQ(telemetry_store_pending(), 150);
+
+    // A later PUBACK does not release anything past the gap
+    CHECK(telemetry_store_drain_ack(&s_drain, second));
+    release_acked();
+    CHECK_EQ(telemetry_store_pending(), 150);
+    host_flash_stats_t flash_after;
+    host_flash_get_stats(&flash_after);
+    CHECK_EQ(flash_after.erases, flash_before.erases);
+
+    // The oldest PUBACK releases both, and the drained first segment is erased
+    CHECK(telemetry_store_drain_ack(&s_drain, first));
+    release_acked();
+    CHECK_EQ(telemetry_store_pending(), 30);
+    CHECK_EQ(s_drain.records, 30);
+    host_flash_get_stats(&flash_after);
+    CHECK(120 > RECORDS_PER_SEGMENT);
+    CHECK(flash_after.erases > flash_before.erases);
+    CHECK_EQ(telemetry_store_peek(0, s_batch, 1), 1);
+    CHECK_EQ(s_batch[0].values[TELEMETRY_KEY_UPTIME], 120);
+
+    CHECK(!telemetry_store_drain_ack(&s_drain, 9999));
+    CHECK(telemetry_store_drain_ack(&s_drain, third));
+    release_acked();
+    CHECK_EQ(telemetry_store_pending(), 0);
+    CHECK_EQ(s_drain.count, 0);
+}
+
+static void test_dropped_publish_is_sent_again(void)
+{
+    append(40);
+    int first = publish(20, 150);
+    uint32_t seq = telemetry_store_drain_reserve(&s_drain);
+    telemetry_store_drain_sent(&s_drain, seq, -1);      // Dropped by the outbound queue
+    telemetry_store_drain_commit(&s_drain, 20, false);
+    CHECK(telemetry_store_drain_ack(&s_drain, first));
+
+    // The acknowledged prefix goes, the dropped publish resets what follows it
+    release_acked();
+    CHECK_EQ(telemetry_store_pending(), 20);
+    CHECK_EQ(s_drain.records, 0);
+    int again = publish(20, 170);
+    CHECK(telemetry_store_drain_ack(&s_drain, again));
+    release_acked();
+    CHECK_EQ(telemetry_store_pending(), 0);
+}
+
+static void test_reset_and_late_callbacks(void)
+{
+    append(10);
+    uint32_t seq = telemetry_store_drain_reserve(&s_drain);
+    telemetry_store_drain_commit(&s_drain, 10, false);
+
+    // Connection lost before the done callback ran
+    telemetry_store_drain_reset(&s_drain);
+    telemetry_store_drain_sent(&s_drain, seq, 555);
+    CHECK(!telemetry_store_drain_ack(&s_drain, 555));
+    CHECK_EQ(telemetry_store_pending(), 10);
+
+    int msg_id = publish(10, 190);
+    CHECK(telemetry_store_drain_ack(&s_drain, msg_id));
+    release_acked();
+    CHECK_EQ(telemetry_store_pending(), 0);
+}
+
+static void test_slots_and_unserializable_records(void)
+{
+    append(TELEMETRY_STORE_MAX_IN_FLIGHT + 1);
+    int msg_ids[TELEMETRY_STORE_MAX_IN_FLIGHT];
+    for (int i = 0; i < TELEMETRY_STORE_MAX_IN_FLIGHT; i++) {
+        msg_ids[i] = publish(1, 200 + i);
+    }
+    CHECK_EQ(telemetry_store_drain_reserve(&s_drain), 0);
+
+    for (int i = 0; i < TELEMETRY_STORE_MAX_IN_FLIGHT; i++) {
+        CHECK(telemetry_store_drain_ack(&s_drain, msg_ids[i]));
+    }
+    release_acked();
+
+    // The PUBACK of the reserved slot may arrive before its commit
+    uint32_t seq = telemetry_store_drain_reserve(&s_drain);
+    telemetry_store_drain_sent(&s_drain, seq, 777);
+    CHECK(telemetry_store_drain_ack(&s_drain, 777));
+    telemetry_store_drain_commit(&s_drain, 1, false);
+    release_acked();
+    CHECK_EQ(telemetry_store_pending(), 0);
+
+    // Records that cannot be serialized have nothing to wait for
+    append(1);
+    telemetry_store_drain_reserve(&s_drain);
+    telemetry_store_drain_commit(&s_drain, 1, true);
+    release_acked();
+    CHECK_EQ(telemetry_store_pending(), 0);
+}
+
+int main(void)
+{
+    CHECK(host_partition_create("tlm_store", 16 * 4096) != NULL);
+    telemetry_store_config_t config = TELEMETRY_STORE_DEFAULT_CONFIG();
+    CHECK_EQ(telemetry_store_init(&config), ESP_OK);
+    telemetry_store_drain_reset(&s_drain);
+
+    test_consume_only_acknowledged_prefix();
+    test_dropped_publish_is_sent_again();
+    test_reset_and_late_callbacks();
+    test_slots_and_unserializable_records();
+    printf("telemetry store tests passed\n");
+    return 0;
+}
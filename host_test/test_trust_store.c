@@ -0,0 +1,193 @@
+/*
+ * Trust store: anchors added in one piece and streamed in chunks, duplicates,
+ * rejected and aborted uploads, removal, and the issuer lookups TLS makes
+ * through the subject and key ID index.
+ *
+ * Links the mbedTLS 3.x the host build found or downloaded (see
+ * CMakeLists.txt). Flash is the RAM stand-in from host_test/stubs, four
+ * sectors so the store fills up.
+ */
+#include "host_test.h"
+#include "trust_store.h"
+#include "test_certificates.h"
+#include "ca_certificate.h"
+#include "esp_partition.h"
+#include "mbedtls/sha256.h"
+#include <string.h>
+
+#define TRUST_SECTORS   4
+
+static void parse_pem(const char* pem, mbedtls_x509_crt* crt)
+{
+    mbedtls_x509_crt_init(crt);
+    CHECK_EQ(mbedtls_x509_crt_parse(crt, (const unsigned char*)pem, strlen(pem) + 1), 0);
+}
+
+static void fingerprint(const char* pem, uint8_t out[TRUST_STORE_FINGERPRINT_SIZE])
+{
+    mbedtls_x509_crt crt;
+    parse_pem(pem, &crt);
+    mbedtls_sha256(crt.raw.p, crt.raw.len, out, 0);
+    mbedtls_x509_crt_free(&crt);
+}
+
+/**
+ * @brief Feed a PEM in chunks of chunk_len bytes, the way addTrustAnchor does
+ */
+static esp_err_t add_streamed(const char* pem, size_t chunk_len, size_t* added)
+{
+    size_t len = strlen(pem);
+    esp_err_t err = trust_store_add_begin(len);
+    for (size_t offset = 0; err == ESP_OK && offset < len; offset += chunk_len) {
+        err = trust_store_add_write(pem + offset, len - offset < chunk_len ? len - offset : chunk_len);
+    }
+    return err == ESP_OK ? trust_store_add_finish(added) : err;
+}
+
+/**
+ * @brief Number of issuer candidates for a certificate, and whether it verifies against them
+ */
+static size_t issuers_of(const char* child_pem, bool* verifies)
+{
+    mbedtls_x509_crt child;
+    mbedtls_x509_crt chain;
+    parse_pem(child_pem, &child);
+    mbedtls_x509_crt_init(&chain);
+    size_t count = trust_store_append_issuers(&child, &chain);
+    uint32_t flags = 0;
+    *verifies = count > 0 && mbedtls_x509_crt_verify(&child, &chain, NULL, NULL, &flags, NULL, NULL) == 0;
+    mbedtls_x509_crt_free(&chain);
+    mbedtls_x509_crt_free(&child);
+    return count;
+}
+
+static bool issuer_is(const char* child_pem, const char* anchor_pem)
+{
+    mbedtls_x509_crt child;
+    parse_pem(child_pem, &child);
+    trust_store_anchor_t anchor;
+    esp_err_t err = trust_store_find_issuer(&child, &anchor);
+    mbedtls_x509_crt_free(&child);
+    uint8_t expected[TRUST_STORE_FINGERPRINT_SIZE];
+    fingerprint(anchor_pem, expected);
+    return err == ESP_OK && memcmp(anchor.fingerprint, expected, sizeof(expected)) == 0;
+}
+
+static void test_add(void)
+{
+    size_t added = 0;
+    uint32_t generation = trust_store_generation();
+    CHECK_EQ(trust_store_add(TEST_ROOT_A_PEM, &added), ESP_OK);
+    CHECK_EQ(added, 1);
+    CHECK_EQ(trust_store_count(), 1);
+    CHECK(trust_store_generation() != generation);
+
+    // The anchor already stored is skipped, the new one added
+    CHECK_EQ(trust_store_add(TEST_ROOT_A_PEM TEST_ROOT_B_PEM, &added), ESP_OK);
+    CHECK_EQ(added, 1);
+    CHECK_EQ(trust_store_count(), 2);
+    CHECK(issuer_is(TEST_LEAF_A_PEM, TEST_ROOT_A_PEM));
+    CHECK(issuer_is(TEST_LEAF_B_PEM, TEST_ROOT_B_PEM));
+}
+
+static void test_rejected_uploads(void)
+{
+    size_t added = 1;
+    uint32_t generation = trust_store_generation();
+
+    // A certificate that may not sign certificates fails the whole bundle, the CA before it included
+    CHECK_EQ(trust_store_add(TEST_ROOT_A2_PEM TEST_LEAF_A_PEM, &added), ESP_ERR_INVALID_ARG);
+    CHECK_EQ(added, 0);
+    bool verifies = true;
+    CHECK_EQ(issuers_of(TEST_LEAF_A2_PEM, &verifies), 1);
+    CHECK(!verifies);
+
+    // Aborted halfway: nothing is trusted and the upload is closed
+    size_t len = strlen(TEST_ROOT_A2_PEM);
+    CHECK_EQ(trust_store_add_begin(len), ESP_OK);
+    CHECK_EQ(trust_store_add_write(TEST_ROOT_A2_PEM, len / 2), ESP_OK);
+    trust_store_add_abort();
+    CHECK_EQ(trust_store_add_write(TEST_ROOT_A2_PEM + len / 2, len - len / 2), ESP_ERR_INVALID_STATE);
+    CHECK_EQ(trust_store_add_finish(&added), ESP_ERR_INVALID_STATE);
+
+    // Truncated before the END marker
+    const char* end = strstr(TEST_ROOT_A2_PEM, "-----END");
+    CHECK_EQ(trust_store_add_begin(len), ESP_OK);
+    CHECK_EQ(trust_store_add_write(TEST_ROOT_A2_PEM, (size_t)(end - TEST_ROOT_A2_PEM)), ESP_OK);
+    CHECK_EQ(trust_store_add_finish(&added), ESP_ERR_INVALID_ARG);
+
+    // More bytes than announced
+    CHECK_EQ(trust_store_add_begin(len - 1), ESP_OK);
+    CHECK_EQ(trust_store_add_write(TEST_ROOT_A2_PEM, len), ESP_ERR_INVALID_SIZE);
+
+    CHECK_EQ(trust_store_count(), 2);
+    CHECK_EQ(trust_store_generation(), generation);
+}
+
+static void test_streamed_add(void)
+{
+    // The sector the failed uploads left behind is reused
+    size_t added = 0;
+    CHECK_EQ(add_streamed(TEST_ROOT_A2_PEM, 7, &added), ESP_OK);
+    CHECK_EQ(added, 1);
+    CHECK_EQ(trust_store_count(), 3);
+}
+
+static void test_issuer_lookup(void)
+{
+    // The authority key ID picks the one key; without it every anchor with the name is a candidate
+    bool verifies = false;
+    CHECK(issuer_is(TEST_LEAF_A_PEM, TEST_ROOT_A_PEM));
+    CHECK_EQ(issuers_of(TEST_LEAF_A_PEM, &verifies), 1);
+    CHECK(verifies);
+    CHECK_EQ(issuers_of(TEST_LEAF_A2_PEM, &verifies), 2);
+    CHECK(verifies);
+    CHECK_EQ(issuers_of(TEST_LEAF_B_PEM, &verifies), 1);
+    CHECK(verifies);
+
+    mbedtls_x509_crt chain;
+    mbedtls_x509_crt_init(&chain);
+    CHECK_EQ(trust_store_append_anchors(&chain), 3);
+    mbedtls_x509_crt_free(&chain);
+}
+
+static void test_remove(void)
+{
+    uint8_t root_b[TRUST_STORE_FINGERPRINT_SIZE];
+    fingerprint(TEST_ROOT_B_PEM, root_b);
+    uint32_t generation = trust_store_generation();
+    CHECK_EQ(trust_store_remove(root_b), ESP_OK);
+    CHECK_EQ(trust_store_count(), 2);
+    CHECK(trust_store_generation() != generation);
+    bool verifies = true;
+    CHECK_EQ(issuers_of(TEST_LEAF_B_PEM, &verifies), 0);
+    CHECK(!verifies);
+    CHECK_EQ(trust_store_remove(root_b), ESP_ERR_NOT_FOUND);
+
+    size_t added = 0;
+    CHECK_EQ(trust_store_add(DEMO_CA_CERTIFICATE_PEM, &added), ESP_OK);
+    CHECK_EQ(added, 1);
+
+    // Chains parsed before the removal may still point into its sector, so it is not reused until a reboot
+    CHECK_EQ(trust_store_add(TEST_ROOT_B_PEM, &added), ESP_ERR_NO_MEM);
+    CHECK_EQ(added, 0);
+    CHECK_EQ(trust_store_count(), 3);
+}
+
+int main(void)
+{
+    CHECK(host_partition_create("trust", TRUST_SECTORS * 4096) != NULL);
+    trust_store_config_t config = TRUST_STORE_DEFAULT_CONFIG();
+    CHECK_EQ(trust_store_init(&config), ESP_OK);
+    CHECK_EQ(trust_store_count(), 0);
+    bool verifies = true;
+    CHECK_EQ(issuers_of(TEST_LEAF_A_PEM, &verifies), 0);
+
+    test_add();
+    test_rejected_uploads();
+    test_streamed_add();
+    test_issuer_lookup();
+    test_remove();
+    printf("Trust store tests passed\n");
+    return 0;
+}
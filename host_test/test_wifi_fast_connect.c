@@ -0,0 +1,232 @@
+/*
+ * Wi-Fi fast connect: the cache filled by a full-scan join, reconnects and
+ * reboots that go to the cached AP, the NVS copy after a power cycle and its
+ * write avoidance, the fall back to a full scan when the cached AP is gone,
+ * and the static lease mode.
+ *
+ * The station, the interface and NVS are the RAM stand-ins from
+ * host_test/stubs; time only moves when the test sets it, so the time to IP
+ * checked here is the simulated one, not a radio measurement.
+ */
+#include "host_test.h"
+#include "wifi_fast_connect.h"
+#include "esp_attr.h"
+#include "esp_timer.h"
+#include "nvs.h"
+#include "nvs_flash.h"
+#include <string.h>
+
+#define SSID            "plant-floor"
+#define CHANNEL_A       6
+#define CHANNEL_B       11
+
+static const uint8_t BSSID_A[6] = { 0x24, 0x0a, 0xc4, 0x00, 0x00, 0x0a };
+static const uint8_t BSSID_B[6] = { 0x24, 0x0a, 0xc4, 0x00, 0x00, 0x0b };
+
+static esp_netif_t s_netif;
+static int64_t s_now_us = 0;
+
+static void advance_ms(uint32_t ms)
+{
+    s_now_us += (int64_t)ms * 1000;
+    host_set_time_us(s_now_us);
+}
+
+static wifi_fast_connect_config_t config_with(bool static_ip)
+{
+    wifi_fast_connect_config_t config = WIFI_FAST_CONNECT_DEFAULT_CONFIG();
+    config.static_ip = static_ip;
+    return config;
+}
+
+static void boot(bool static_ip)
+{
+    wifi_fast_connect_config_t config = config_with(static_ip);
+    s_netif.dhcpc_started = true;
+    CHECK_EQ(wifi_fast_connect_init(&config, &s_netif), ESP_OK);
+}
+
+/**
+ * @brief Configure the station the way app_main does; returns whether the cache was applied
+ */
+static bool start_station(const char* ssid)
+{
+    wifi_config_t wifi_config = { 0 };
+    strlcpy((char*)wifi_config.sta.ssid, ssid, sizeof(wifi_config.sta.ssid));
+    bool fast = wifi_fast_connect_apply(&wifi_config);
+    CHECK_EQ(esp_wifi_set_config(WIFI_IF_STA, &wifi_config), ESP_OK);
+    return fast;
+}
+
+static bool station_locked_to(const uint8_t bssid[6], uint8_t channel)
+{
+    wifi_config_t wifi_config;
+    CHECK_EQ(esp_wifi_get_config(WIFI_IF_STA, &wifi_config), ESP_OK);
+    return wifi_config.sta.bssid_set && memcmp(wifi_config.sta.bssid, bssid, 6) == 0 &&
+           wifi_config.sta.channel == channel;
+}
+
+static bool station_scans(void)
+{
+    wifi_config_t wifi_config;
+    CHECK_EQ(esp_wifi_get_config(WIFI_IF_STA, &wifi_config), ESP_OK);
+    return !wifi_config.sta.bssid_set && wifi_config.sta.channel == 0;
+}
+
+/**
+ * @brief Associate with an AP and get a lease after ms
+ */
+static void got_ip(const uint8_t bssid[6], uint8_t channel, uint32_t ms, uint32_t ip)
+{
+    advance_ms(ms);
+    host_wifi_set_ap(bssid, channel);
+    esp_netif_dns_info_t dns = { .ip.type = ESP_IPADDR_TYPE_V4, .ip.u_addr.ip4.addr = ip ^ 0xff000000 };
+    esp_netif_set_dns_info(&s_netif, ESP_NETIF_DNS_MAIN, &dns);
+    esp_netif_ip_info_t ip_info = { .ip.addr = ip, .netmask.addr = 0x00ffffff, .gw.addr = ip & 0x00ffffff };
+    wifi_fast_connect_on_got_ip(&ip_info);
+}
+
+static void disconnected(uint8_t reason)
+{
+    host_wifi_set_ap(NULL, 0);
+    wifi_fast_connect_on_disconnected(reason);
+}
+
+static uint32_t nvs_writes(void)
+{
+    host_nvs_stats_t stats;
+    host_nvs_get_stats(&stats);
+    return stats.writes;
+}
+
+static void test_first_connect(void)
+{
+    boot(false);
+    CHECK(!start_station(SSID));
+    CHECK(station_scans());
+
+    got_ip(BSSID_A, CHANNEL_A, 2400, 0x6401a8c0);
+    wifi_fast_connect_stats_t stats;
+    wifi_fast_connect_get_stats(&stats);
+    CHECK_EQ(stats.connects, 1);
+    CHECK_EQ(stats.fast_connects, 0);
+    CHECK(!stats.last_fast);
+    CHECK_EQ(stats.last_time_to_ip_ms, 2400);
+    CHECK_EQ(nvs_writes(), 1);
+}
+
+static void test_reconnect(void)
+{
+    // Joined by a full scan: the reconnect goes straight to the AP found
+    disconnected(8);
+    CHECK(station_locked_to(BSSID_A, CHANNEL_A));
+    got_ip(BSSID_A, CHANNEL_A, 300, 0x6401a8c0);
+
+    wifi_fast_connect_stats_t stats;
+    wifi_fast_connect_get_stats(&stats);
+    CHECK_EQ(stats.connects, 2);
+    CHECK_EQ(stats.fast_connects, 1);
+    CHECK(stats.last_fast);
+    CHECK_EQ(stats.last_time_to_ip_ms, 300);
+
+    // Same AP and lease: no flash write
+    CHECK_EQ(nvs_writes(), 1);
+}
+
+static void test_reboot(void)
+{
+    // A reset keeps RTC memory
+    boot(false);
+    CHECK(start_station(SSID));
+    CHECK(station_locked_to(BSSID_A, CHANNEL_A));
+    got_ip(BSSID_A, CHANNEL_A, 250, 0x6401a8c0);
+    CHECK_EQ(nvs_writes(), 1);
+
+    // Another network does not get this one's AP
+    boot(false);
+    CHECK(!start_station("guest"));
+    CHECK(station_scans());
+
+    // After a power cycle only the NVS copy is left
+    host_rtc_power_on();
+    boot(false);
+    CHECK(start_station(SSID));
+    CHECK(station_locked_to(BSSID_A, CHANNEL_A));
+    got_ip(BSSID_A, CHANNEL_A, 250, 0x6401a8c0);
+    CHECK_EQ(nvs_writes(), 1);
+}
+
+static void test_fallback(void)
+{
+    wifi_fast_connect_stats_t before;
+    wifi_fast_connect_get_stats(&before);
+
+    // The cached AP is gone: the station scans again and the cache is dropped
+    boot(false);
+    CHECK(start_station(SSID));
+    advance_ms(1000);
+    disconnected(201);
+    CHECK(station_scans());
+    wifi_fast_connect_stats_t stats;
+    wifi_fast_connect_get_stats(&stats);
+    CHECK_EQ(stats.fallbacks, before.fallbacks + 1);
+
+    // The scan finds another AP; its time to IP counts from the reconnect
+    got_ip(BSSID_B, CHANNEL_B, 2600, 0x6501a8c0);
+    wifi_fast_connect_get_stats(&stats);
+    CHECK(!stats.last_fast);
+    CHECK_EQ(stats.last_time_to_ip_ms, 2600);
+    CHECK_EQ(stats.fallbacks, before.fallbacks + 1);
+    CHECK_EQ(nvs_writes(), 2);
+
+    // A reboot before the lease is renewed uses the new AP, from RTC memory
+    boot(false);
+    CHECK(start_station(SSID));
+    CHECK(station_locked_to(BSSID_B, CHANNEL_B));
+    got_ip(BSSID_B, CHANNEL_B, 200, 0x6501a8c0);
+}
+
+static void test_static_ip(void)
+{
+    boot(true);
+    CHECK(start_station(SSID));
+    CHECK(!s_netif.dhcpc_started);
+    esp_netif_ip_info_t ip_info;
+    CHECK_EQ(esp_netif_get_ip_info(&s_netif, &ip_info), ESP_OK);
+    CHECK_EQ(ip_info.ip.addr, 0x6501a8c0);
+    CHECK_EQ(ip_info.gw.addr, 0x0001a8c0);
+    esp_netif_dns_info_t dns;
+    CHECK_EQ(esp_netif_get_dns_info(&s_netif, ESP_NETIF_DNS_MAIN, &dns), ESP_OK);
+    CHECK_EQ(dns.ip.u_addr.ip4.addr, 0x9a01a8c0);
+
+    // Falling back hands the interface back to DHCP
+    disconnected(201);
+    CHECK(s_netif.dhcpc_started);
+    CHECK(station_scans());
+}
+
+static void test_blank_device(void)
+{
+    CHECK(!start_station(SSID));
+    got_ip(BSSID_B, CHANNEL_B, 2500, 0x6501a8c0);
+
+    host_rtc_power_on();
+    CHECK_EQ(nvs_flash_erase(), ESP_OK);
+    boot(false);
+    CHECK(!start_station(SSID));
+    CHECK(station_scans());
+}
+
+int main(void)
+{
+    CHECK_EQ(nvs_flash_init(), ESP_OK);
+    host_rtc_power_on();
+    test_first_connect();
+    test_reconnect();
+    test_reboot();
+    test_fallback();
+    test_static_ip();
+    test_blank_device();
+    printf("Wi-Fi fast connect tests passed\n");
+    return 0;
+}
@@ -25,151 +25,1552 @@
 #include "sys/param.h"
 #include <math.h>
 #include "cJSON.h"
-#include "netdb.h"
 #include "driver/temperature_sensor.h"
 #include "esp_timer.h"
 #include "driver/gpio.h"
 #include "esp_tls.h"
-#include "led_strip.h"
+#include "led_engine.h"
+#include "rpc_handler.h"
+#include "device_attributes.h"
+#include "esp_app_desc.h"
 #include "ca_certificate.h"
 #include "certificate_manager.h"
+#include "trust_store.h"
+#include "boot_profile.h"
+#include "wifi_fast_connect.h"
+#include "dns_probe.h"
+#include "conn_manager.h"
+#include "duty_cycle.h"
+#include "telemetry_buffer.h"
+#include "telemetry_serializer.h"
+#include "telemetry_pb.h"
+#include "telemetry_store.h"
+#include "telemetry_aggregator.h"
+#include "telemetry_policy.h"
+#include "telemetry_scheduler.h"
+#include "telemetry_backpressure.h"
+#include "mqtt_outbound.h"
+#include "gateway.h"
+#include "tls_session.h"
+#include "esp_netif_sntp.h"
+#include "esp_sleep.h"
+#include "esp_attr.h"
+#include <time.h>
+#include <sys/time.h>
 
 #define ARGB_LED_GPIO 48
 #define DEFAULT_LED_BRIGHTNESS 25   // Default brightness level (0-255)
-#define MAX_LED_BRIGHTNESS 255       // Maximum possible brightness
 #define HTTP_CONTENT_BUFFER_SIZE 512 // HTTP POST content buffer
 #define MQTT_INSECURE_PORT 1883      // Standard unencrypted MQTT port
 #define MQTTS_SECURE_PORT 8883       // Standard encrypted MQTTS port
+#define TELEMETRY_TOPIC "v1/devices/me/telemetry"
+#define TELEMETRY_UPLOAD_PERIOD_MS 5000 // Aggregation window / upload period
+#define TELEMETRY_UPLOAD_PERIOD_MIN_MS 1000   // Bounds for the setInterval RPC
+#define TELEMETRY_UPLOAD_PERIOD_MAX_MS 600000
+#define RPC_STATS_PERIOD_MS 60000       // RPC latency percentiles publish interval
+#define RBE_STATS_PERIOD_MS 60000       // Report-by-exception counters publish interval
+#define CERT_ROTATION_CHUNK_MAX 768     // PEM bytes per rotateCertificate call (fits the MQTT buffer)
+#define SAMPLER_TEMPERATURE_PERIOD_MS 100 // 10 Hz temperature sampling for spike detection
+#define SAMPLER_SYSTEM_PERIOD_MS 1000   // RSSI, heap and uptime sampling
+#define SAMPLER_SYSTEM_PHASE_MS 50      // Keep system sampling off the temperature deadlines
+#define TELEMETRY_LED_BLINK_MS 500      // Publish indication blink
+#define TELEMETRY_PAYLOAD_MAX 4096      // Serialization buffer for one telemetry publish
+#define MQTT_PUBLISH_FRAMING_MAX 9      // QoS 1 PUBLISH header: type, remaining length, topic length, packet id
+#define TIME_SYNC_MIN_EPOCH 1609459200  // 2021-01-01: anything earlier means SNTP has not synced yet
+#define GATEWAY_CHILDREN_MAX 256        // Largest accepted gwChildren (about 170 bytes of RAM per child)
+#define RECONNECT_BASE_MIN_MS 100       // Bounds for the reconnect backoff attributes
+#define RECONNECT_CAP_MAX_MS 3600000
+#define DUTY_CYCLE_PERIOD_MIN_MS 1000   // Shortest accepted dutyPeriodMs
+#define DUTY_CYCLE_UPLOAD_TIMEOUT_MS 30000 // Radio-on budget of an upload wake; unacknowledged samples stay buffered
+#define DUTY_CYCLE_TEMPERATURE_READS 4  // Temperature readings aggregated per duty-cycle wake
+#define DUTY_CYCLE_POLL_MS 20           // Polling while an upload wake waits for queue space and PUBACKs
 
-static led_strip_handle_t s_led_strip;
+// LED color constants
+static const led_color_t LED_COLOR_RED     = {255, 0, 0};
+static const led_color_t LED_COLOR_GREEN   = {0, 255, 0};
+static const led_color_t LED_COLOR_BLUE    = {0, 0, 255};
+static const led_color_t LED_COLOR_WHITE   = {255, 255, 255};
+static const led_color_t LED_COLOR_YELLOW  = {255, 255, 0};
+static const led_color_t LED_COLOR_PROVISIONING = {50, 50, 50}; // Dim white for provisioning mode
+
+// LED error overlay sources (red while any is set)
+#define LED_ERROR_MQTT_CONFIG   (1U << 0)   // Missing credentials, bad port or certificate
+#define LED_ERROR_INTERNET      (1U << 1)   // Broker DNS probe failed
+
+static void init_led(void)
+{
+    led_engine_config_t led_config = LED_ENGINE_DEFAULT_CONFIG();
+    led_config.gpio_num = ARGB_LED_GPIO;
+    led_config.brightness = DEFAULT_LED_BRIGHTNESS;
+    led_config.error_color = LED_COLOR_RED;
+    ESP_ERROR_CHECK(led_engine_init(&led_config));
+}
+
+
+static const char *TAG = "PROVISIONING_EXAMPLE";
+
+
+static void log_error_if_nonzero(const char *message, int error_code)
+{
+    if (error_code != 0) {
+        ESP_LOGE(TAG, "Last error %s: 0x%x", message, error_code);
+    }
+}
+
+/**
+ * @brief Log full vs. resumed TLS connect times (MQTTS only)
+ */
+static void log_tls_session_stats(void)
+{
+    tls_session_stats_t stats;
+    tls_session_get_stats(&stats);
+    if (stats.full.count > 0) {
+        ESP_LOGI(TAG, "TLS full handshakes: %lu, avg %llu ms, max %lu ms", (unsigned long)stats.full.count,
+                 (unsigned long long)(stats.full.sum_ms / stats.full.count), (unsigned long)stats.full.max_ms);
+    }
+    if (stats.resumed.count > 0) {
+        ESP_LOGI(TAG, "TLS resumed handshakes: %lu, avg %llu ms, max %lu ms", (unsigned long)stats.resumed.count,
+                 (unsigned long long)(stats.resumed.sum_ms / stats.resumed.count), (unsigned long)stats.resumed.max_ms);
+    }
+    if (stats.refused > 0) {
+        ESP_LOGI(TAG, "TLS sessions refused by the broker: %lu", (unsigned long)stats.refused);
+    }
+}
+
+static bool wall_clock_synced(void)
+{
+    time_t now = 0;
+    time(&now);
+    return now >= TIME_SYNC_MIN_EPOCH;
+}
+
+static int64_t epoch_offset_ms(void)
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (int64_t)tv.tv_sec * 1000 + tv.tv_usec / 1000 - esp_timer_get_time() / 1000;
+}
+
+// Upload windows close on wall-clock multiples of the upload period once time is known
+static telemetry_scheduler_handle_t s_upload_scheduler = NULL;
+
+static void align_upload_windows(void)
+{
+    if (s_upload_scheduler && wall_clock_synced()) {
+        telemetry_scheduler_align(s_upload_scheduler, epoch_offset_ms() * 1000);
+    }
+}
+
+static void time_sync_cb(struct timeval *tv)
+{
+    // Called on every SNTP update, which also absorbs esp_timer drift against UTC
+    align_upload_windows();
+}
+
+static void start_time_sync(void)
+{
+    static bool s_sntp_started = false;
+    if (s_sntp_started) {
+        return;
+    }
+    // SNTP keeps the server name pointer, so it lives in a static buffer
+    static char s_ntp_server[DEVICE_ATTR_STRING_MAX];
+    device_attributes_get_string(DEVICE_SHARED_NTP_SERVER, s_ntp_server, sizeof(s_ntp_server));
+    esp_sntp_config_t sntp_config = ESP_NETIF_SNTP_DEFAULT_CONFIG(s_ntp_server);
+    sntp_config.sync_cb = time_sync_cb;
+    if (esp_netif_sntp_init(&sntp_config) == ESP_OK) {
+        s_sntp_started = true;
+        ESP_LOGI(TAG, "SNTP time synchronization started (%s)", s_ntp_server);
+    }
+}
+
+// Scratch buffers shared by the telemetry task's publish paths
+static telemetry_sample_t s_telemetry_batch[TELEMETRY_BUFFER_MAX_SAMPLES];
+static char s_telemetry_payload[TELEMETRY_PAYLOAD_MAX];
+static volatile bool s_mqtt_connected = false;
+static telemetry_format_t s_telemetry_format = TELEMETRY_FORMAT_JSON;
+
+/**
+ * @brief Bytes waiting to reach the broker: esp-mqtt outbox plus outbound queues
+ */
+static size_t pending_outbound_bytes(esp_mqtt_client_handle_t client)
+{
+    int outbox_bytes = esp_mqtt_client_get_outbox_size(client);
+    return (outbox_bytes > 0 ? (size_t)outbox_bytes : 0) + mqtt_outbound_queued_bytes();
+}
+
+// Publishes of the current duty-cycle upload wake, matched against PUBACKs
+static duty_cycle_upload_t s_duty_upload_tracking;
+static portMUX_TYPE s_duty_upload_lock = portMUX_INITIALIZER_UNLOCKED;
+
+/**
+ * @brief Outbound completion of a telemetry publish (runs before its PUBACK is reported)
+ *
+ * ctx is the duty-cycle chunk of the publish, NULL outside upload wakes.
+ */
+static void telemetry_publish_done(int msg_id, void *ctx)
+{
+    if (msg_id >= 0) {
+        telemetry_bp_on_publish(msg_id, esp_timer_get_time() / 1000);
+    }
+    duty_cycle_chunk_t *chunk = ctx;
+    if (chunk) {
+        portENTER_CRITICAL(&s_duty_upload_lock);
+        chunk->msg_id = msg_id > 0 ? msg_id : -1;
+        portEXIT_CRITICAL(&s_duty_upload_lock);
+    }
+}
+
+// Store drain publishes, matched against PUBACKs before their records leave the flash log
+static telemetry_store_drain_t s_store_drain;
+static bool s_store_drain_stale = false;        // Connection lost or log wrapped: in-flight PUBACKs no longer apply
+static portMUX_TYPE s_store_drain_lock = portMUX_INITIALIZER_UNLOCKED;
+
+/**
+ * @brief Outbound completion of a store drain publish (ctx is its drain sequence number)
+ */
+static void store_drain_publish_done(int msg_id, void *ctx)
+{
+    if (msg_id >= 0) {
+        telemetry_bp_on_publish(msg_id, esp_timer_get_time() / 1000);
+    }
+    portENTER_CRITICAL(&s_store_drain_lock);
+    telemetry_store_drain_sent(&s_store_drain, (uint32_t)(uintptr_t)ctx, msg_id);
+    portEXIT_CRITICAL(&s_store_drain_lock);
+}
+
+/**
+ * @brief Serialize and publish one chunk of samples
+ *
+ * Samples with an unknown timestamp (timestamped == false) go out one per
+ * publish as a flat values object; otherwise as many as fit the payload
+ * buffer are sent as one ThingsBoard timestamped array. In protobuf mode
+ * every timestamped publish carries one Telemetry message. A protobuf
+ * message without ts would not map to ThingsBoard's JSON form, so samples
+ * without a timestamp are sent as flat JSON values in both modes (protobuf
+ * device profiles need "Enable compatibility with other payload formats").
+ *
+ * @param done Outbound done callback that records the msg_id
+ * @param ctx Context of the done callback
+ * @return Number of samples queued, 0 on serialization failure, -1 if the publish was refused
+ */
+static int publish_telemetry_chunk(esp_mqtt_client_handle_t client, mqtt_outbound_class_t cls,
+                                   const telemetry_sample_t *samples, size_t count, bool timestamped,
+                                   int64_t ts_offset_ms, mqtt_outbound_done_cb_t done, void *ctx,
+                                   size_t *payload_len)
+{
+    size_t serialized = 0;
+    if (timestamped && s_telemetry_format == TELEMETRY_FORMAT_PROTOBUF) {
+        int64_t ts_ms = samples[0].captured_us / 1000 + ts_offset_ms;
+        *payload_len = telemetry_pb_encode(&samples[0], ts_ms, (uint8_t *)s_telemetry_payload,
+                                           sizeof(s_telemetry_payload));
+        serialized = *payload_len > 0 ? 1 : 0;
+    } else if (timestamped) {
+        serialized = telemetry_serialize_batch(samples, count, ts_offset_ms, s_telemetry_payload,
+                                               sizeof(s_telemetry_payload), payload_len);
+    } else {
+        *payload_len = telemetry_serialize_values(&samples[0], s_telemetry_payload, sizeof(s_telemetry_payload));
+        serialized = *payload_len > 0 ? 1 : 0;
+    }
+    if (serialized == 0) {
+        ESP_LOGE(TAG, "Failed to serialize telemetry sample");
+        return 0;
+    }
+
+    // Keep queued telemetry under its ceiling; refused samples stay buffered for a later window.
+    // The outbox holds the whole PUBLISH, so the topic and framing count as well.
+    size_t message_len = *payload_len + sizeof(TELEMETRY_TOPIC) - 1 + MQTT_PUBLISH_FRAMING_MAX;
+    if (!telemetry_bp_admit(message_len, pending_outbound_bytes(client))) {
+        return -1;
+    }
+    if (mqtt_outbound_publish(cls, TELEMETRY_TOPIC, s_telemetry_payload, *payload_len,
+                              done, ctx) != ESP_OK) {
+        return -1;
+    }
+    return (int)serialized;
+}
+
+/**
+ * @brief Publish pending samples from the ring buffer
+ *
+ * Once the wall clock is synced, pending samples go out as ThingsBoard
+ * timestamped arrays. Before that, sample timestamps cannot be expressed in
+ * epoch time, so each pending sample is published in its own message and
+ * the server assigns the arrival time. Protobuf messages always carry a
+ * timestamp, so in that mode samples stay buffered until the clock is synced.
+ */
+static void publish_telemetry_batch(esp_mqtt_client_handle_t client)
+{
+    bool timestamped = wall_clock_synced();
+    if (!timestamped && s_telemetry_format == TELEMETRY_FORMAT_PROTOBUF) {
+        ESP_LOGW(TAG, "Waiting for time sync before publishing protobuf telemetry");
+        return;
+    }
+    // Untimestamped samples go out one per message, but all of them: windows can
+    // push several samples per flush (e.g. under backpressure striding)
+    size_t count = telemetry_buffer_peek(s_telemetry_batch, TELEMETRY_BUFFER_MAX_SAMPLES);
+    size_t offset = 0;
+
+    while (offset < count) {
+        size_t payload_len = 0;
+        int published = publish_telemetry_chunk(client, MQTT_OUTBOUND_TELEMETRY, &s_telemetry_batch[offset],
+                                                count - offset, timestamped, epoch_offset_ms(), telemetry_publish_done,
+                                                NULL, &payload_len);
+        if (published < 0) {
+            ESP_LOGW(TAG, "Telemetry publish failed, keeping %u samples buffered", (unsigned)(count - offset));
+            return;
+        }
+        if (published == 0) {
+            // Unserializable sample: drop it rather than block the ring
+            telemetry_buffer_spill(1);
+            offset++;
+            continue;
+        }
+        telemetry_buffer_consume(published, payload_len);
+        offset += published;
+
+        ESP_LOGI(TAG, "Telemetry batch: %d samples, %u bytes", published, (unsigned)payload_len);
+    }
+
+    telemetry_buffer_stats_t stats;
+    telemetry_buffer_get_stats(&stats);
+    telemetry_policy_stats_t policy_stats;
+    telemetry_policy_get_stats(&policy_stats);
+    ESP_LOGI(TAG, "Telemetry totals: %lu samples / %lu publishes, %llu bytes, values sent %lu / suppressed %lu",
+             (unsigned long)stats.samples_published, (unsigned long)stats.publishes,
+             (unsigned long long)stats.payload_bytes, (unsigned long)policy_stats.sent_total,
+             (unsigned long)policy_stats.suppressed_total);
+}
+
+/**
+ * @brief Move pending ring samples into the flash store while MQTT is down
+ */
+static void spool_telemetry_to_store(void)
+{
+    size_t count = telemetry_buffer_peek(s_telemetry_batch, TELEMETRY_BUFFER_MAX_SAMPLES);
+    int64_t offset_ms = wall_clock_synced() ? epoch_offset_ms() : 0;
+    size_t stored = 0;
+    telemetry_store_stats_t before;
+    telemetry_store_get_stats(&before);
+
+    for (; stored < count; stored++) {
+        telemetry_sample_t record = s_telemetry_batch[stored];
+        // Stored samples carry epoch microseconds, 0 when the time is unknown
+        record.captured_us = offset_ms != 0 ? record.captured_us + offset_ms * 1000 : 0;
+        if (telemetry_store_append(&record) != ESP_OK) {
+            break;
+        }
+    }
+    telemetry_buffer_spill(stored);
+
+    // A wrap dropped the oldest records, possibly under drain publishes still in flight
+    telemetry_store_stats_t after;
+    telemetry_store_get_stats(&after);
+    if (after.records_dropped != before.records_dropped) {
+        portENTER_CRITICAL(&s_store_drain_lock);
+        s_store_drain_stale = true;
+        portEXIT_CRITICAL(&s_store_drain_lock);
+    }
+
+    if (stored > 0) {
+        ESP_LOGI(TAG, "MQTT offline, spooled %u samples to flash (%lu pending)",
+                 (unsigned)stored, (unsigned long)telemetry_store_pending());
+    }
+}
+
+/**
+ * @brief Replay stored samples at the configured drain rate while live data keeps flowing
+ *
+ * Records are consumed only after their PUBACK (outbound_acked), so a reboot
+ * never loses records still queued in mqtt_outbound or the esp-mqtt outbox.
+ */
+static void drain_telemetry_store(esp_mqtt_client_handle_t client)
+{
+    static int64_t s_last_drain_us = 0;
+    int64_t now_us = esp_timer_get_time();
+
+    // The store belongs to this task, so acknowledged records are released here
+    portENTER_CRITICAL(&s_store_drain_lock);
+    if (s_store_drain_stale) {
+        // Publishes lost with the connection are sent again (ThingsBoard dedups by ts)
+        telemetry_store_drain_reset(&s_store_drain);
+        s_store_drain_stale = false;
+    }
+    size_t acked = telemetry_store_drain_take_acked(&s_store_drain);
+    uint32_t in_flight = s_store_drain.records;
+    portEXIT_CRITICAL(&s_store_drain_lock);
+    telemetry_store_consume(acked);
+
+    if (telemetry_store_pending() <= in_flight) {
+        s_last_drain_us = now_us;
+        return;
+    }
+
+    uint64_t budget = (uint64_t)(now_us - s_last_drain_us) * telemetry_store_drain_rate() / 1000000;
+    if (budget == 0) {
+        return;
+    }
+    s_last_drain_us = now_us;
+    if (budget > TELEMETRY_BUFFER_MAX_SAMPLES) {
+        budget = TELEMETRY_BUFFER_MAX_SAMPLES;
+    }
+
+    size_t count = telemetry_store_peek(in_flight, s_telemetry_batch, budget);
+    size_t offset = 0;
+    while (offset < count) {
+        // Chunk consecutive records that share timestamp availability
+        bool timestamped = s_telemetry_batch[offset].captured_us != 0;
+        size_t run = 1;
+        while (offset + run < count && (s_telemetry_batch[offset + run].captured_us != 0) == timestamped) {
+            run++;
+        }
+
+        portENTER_CRITICAL(&s_store_drain_lock);
+        uint32_t seq = telemetry_store_drain_reserve(&s_store_drain);
+        portEXIT_CRITICAL(&s_store_drain_lock);
+        if (seq == 0) {
+            // Every slot awaits its PUBACK
+            break;
+        }
+        size_t payload_len = 0;
+        int published = publish_telemetry_chunk(client, MQTT_OUTBOUND_BULK, &s_telemetry_batch[offset], run,
+                                                timestamped, 0, store_drain_publish_done, (void *)(uintptr_t)seq,
+                                                &payload_len);
+        if (published < 0) {
+            break;
+        }
+        // Unserializable records are released as well so they cannot stall the drain
+        size_t sent = published > 0 ? (size_t)published : 1;
+        portENTER_CRITICAL(&s_store_drain_lock);
+        telemetry_store_drain_commit(&s_store_drain, (uint16_t)sent, published == 0);
+        portEXIT_CRITICAL(&s_store_drain_lock);
+        offset += sent;
+    }
+
+    if (offset > 0) {
+        telemetry_store_stats_t stats;
+        telemetry_store_get_stats(&stats);
+        ESP_LOGI(TAG, "Backfill: %u records replayed, %u acknowledged "
+                 "(%lu pending, %lu flash writes / %lu records stored)", (unsigned)offset, (unsigned)acked, (unsigned long)stats.records_pending,
+                 (unsigned long)stats.flash_writes, (unsigned long)stats.records_written);
+    }
+}
+
+/**
+ * @brief Publish a JSON stats object on the telemetry topic
+ *
+ * Stats objects are free-form JSON, while protobuf device profiles only
+ * accept the telemetry schema, so nothing is sent in protobuf mode.
+ *
+ * @return true if the message was queued
+ */
+static bool publish_json_stats(const char *payload, size_t len)
+{
+    if (s_telemetry_format != TELEMETRY_FORMAT_JSON || len == 0) {
+        return false;
+    }
+    return mqtt_outbound_publish(MQTT_OUTBOUND_TELEMETRY, TELEMETRY_TOPIC, payload, len, NULL, NULL) == ESP_OK;
+}
+
+/* Gateway mode: virtual child devices fed from the board's own readings */
+static int s_gateway_devices = 0;
+static uint8_t s_gateway_key_temperature;
+static uint8_t s_gateway_key_sequence;
+
+static void gateway_simulation_start(int children)
+{
+    gateway_config_t config = GATEWAY_DEFAULT_CONFIG();
+    config.max_devices = (uint16_t)children;
+    if (gateway_init(&config) != ESP_OK ||
+        gateway_register_key("temperature", telemetry_signals[TELEMETRY_SIGNAL_TEMPERATURE].precision,
+                             &s_gateway_key_temperature) != ESP_OK ||
+        gateway_register_key("sequence", 0, &s_gateway_key_sequence) != ESP_OK) {
+        return;
+    }
+
+    for (int i = 0; i < children; i++) {
+        char name[GATEWAY_DEVICE_NAME_MAX];
+        int device;
+        snprintf(name, sizeof(name), "sim-sensor-%03d", i);
+        if (gateway_add_device(name, "sim-sensor", &device) != ESP_OK) {
+            break;
+        }
+        s_gateway_devices++;
+    }
+    ESP_LOGI(TAG, "Gateway simulation: %d child devices", s_gateway_devices);
+}
+
+/**
+ * @brief Record one reading per virtual child and flush batched gateway telemetry
+ *
+ * Gateway counters are published as telemetry of the board itself once per
+ * RPC_STATS_PERIOD_MS, for load tests against a local broker.
+ */
+static void gateway_simulation_upload(const telemetry_sample_t *sample, bool publish)
+{
+    static uint32_t s_sequence = 0;
+    static int64_t s_last_report_us = 0;
+    static uint32_t s_last_publishes = 0;
+
+    if (s_gateway_devices == 0) {
+        return;
+    }
+    s_sequence++;
+    // A window without a temperature reading leaves the key out instead of reporting 0
+    bool has_temperature = (sample->present & (1U << TELEMETRY_KEY_TEMPERATURE)) != 0;
+    for (int i = 0; i < s_gateway_devices; i++) {
+        gateway_value_t values[2];
+        size_t count = 0;
+        if (has_temperature) {
+            values[count++] = (gateway_value_t){ .key = s_gateway_key_temperature,
+                                                 .value = sample->values[TELEMETRY_KEY_TEMPERATURE] + i };
+        }
+        values[count++] = (gateway_value_t){ .key = s_gateway_key_sequence, .value = (int32_t)s_sequence };
+        gateway_record(i, sample->captured_us, values, count);
+    }
+    // Gateway payloads always carry timestamps
+    if (!publish || !wall_clock_synced()) {
+        return;
+    }
+    gateway_flush(epoch_offset_ms());
+
+    int64_t now_us = esp_timer_get_time();
+    if (now_us - s_last_report_us >= (int64_t)RPC_STATS_PERIOD_MS * 1000) {
+        gateway_stats_t stats;
+        gateway_get_stats(&stats);
+        if (s_last_report_us != 0) {
+            ESP_LOGI(TAG, "Gateway: %u/%u children connected, %.1f msg/s, %lu records published / %lu dropped, "
+                     "%llu bytes, %u bytes RAM per child",
+                     stats.devices_connected, stats.devices,
+                     (stats.publishes - s_last_publishes) * 1e6 / (double)(now_us - s_last_report_us),
+                     (unsigned long)stats.records_published, (unsigned long)stats.records_dropped,
+                     (unsigned long long)stats.payload_bytes, (unsigned)stats.bytes_per_device);
+        }
+        int n = snprintf(s_telemetry_payload, sizeof(s_telemetry_payload),
+                         "{\"gw_children\":%u,\"gw_connected\":%u,\"gw_publishes\":%lu,\"gw_records\":%lu,"
+                         "\"gw_dropped\":%lu,\"gw_bytes\":%llu,\"gw_ram_per_child\":%u,\"gw_free_heap\":%lu}",
+                         stats.devices, stats.devices_connected, (unsigned long)stats.publishes,
+                         (unsigned long)stats.records_published, (unsigned long)stats.records_dropped,
+                         (unsigned long long)stats.payload_bytes, (unsigned)stats.bytes_per_device,
+                         (unsigned long)esp_get_free_heap_size());
+        if (n > 0 && (size_t)n < sizeof(s_telemetry_payload)) {
+            publish_json_stats(s_telemetry_payload, n);
+        }
+        s_last_report_us = now_us;
+        s_last_publishes = stats.publishes;
+    }
+}
+
+/**
+ * @brief Per-signal sampler definition
+ */
+typedef struct {
+    telemetry_signal_t signal;
+    uint32_t period_ms;
+    uint32_t phase_ms;
+    bool (*read)(int32_t *value);
+} signal_sampler_t;
+
+static temperature_sensor_handle_t s_temp_handle = NULL;
+
+static bool sample_temperature(int32_t *value)
+{
+    float temperature;
+    if (temperature_sensor_get_celsius(s_temp_handle, &temperature) != ESP_OK) {
+        return false;
+    }
+    *value = telemetry_to_fixed(TELEMETRY_SIGNAL_TEMPERATURE, temperature);
+    return true;
+}
+
+static bool sample_rssi(int32_t *value)
+{
+    wifi_ap_record_t ap_info;
+    if (esp_wifi_sta_get_ap_info(&ap_info) != ESP_OK) {
+        return false;
+    }
+    *value = ap_info.rssi;
+    return true;
+}
+
+static bool sample_heap(int32_t *value)
+{
+    *value = (int32_t)esp_get_free_heap_size();
+    return true;
+}
+
+static bool sample_uptime(int32_t *value)
+{
+    *value = (int32_t)(esp_timer_get_time() / 1000000); // seconds
+    return true;
+}
+
+static const signal_sampler_t s_samplers[] = {
+    { TELEMETRY_SIGNAL_TEMPERATURE, SAMPLER_TEMPERATURE_PERIOD_MS, 0,                       sample_temperature },
+    { TELEMETRY_SIGNAL_RSSI,        SAMPLER_SYSTEM_PERIOD_MS,      SAMPLER_SYSTEM_PHASE_MS, sample_rssi },
+    { TELEMETRY_SIGNAL_HEAP,        SAMPLER_SYSTEM_PERIOD_MS,      SAMPLER_SYSTEM_PHASE_MS, sample_heap },
+    { TELEMETRY_SIGNAL_UPTIME,      SAMPLER_SYSTEM_PERIOD_MS,      SAMPLER_SYSTEM_PHASE_MS, sample_uptime },
+};
+
+/**
+ * @brief Sampler job: read one signal into its aggregation window
+ */
+static void sample_signal_job(void *arg, int64_t deadline_us)
+{
+    const signal_sampler_t *sampler = (const signal_sampler_t *)arg;
+    int32_t value;
+    if (sampler->read(&value)) {
+        telemetry_aggregator_add(sampler->signal, value);
+    }
+}
+
+static bool s_store_available = false;
+static int s_upload_job_id = -1;
+static volatile uint32_t s_upload_period_ms = TELEMETRY_UPLOAD_PERIOD_MS;
+
+/**
+ * @brief Publish RPC latency percentiles as telemetry once per RPC_STATS_PERIOD_MS
+ *
+ * Outbound queue waiting times are logged at the same interval.
+ */
+static void publish_rpc_stats(void)
+{
+    static int64_t s_last_stats_us = 0;
+    static uint32_t s_last_calls = 0;
+    int64_t now_us = esp_timer_get_time();
+    if (now_us - s_last_stats_us < (int64_t)RPC_STATS_PERIOD_MS * 1000) {
+        return;
+    }
+    s_last_stats_us = now_us;
+
+    static const char *const class_names[MQTT_OUTBOUND_CLASS_COUNT] = { "control", "alarm", "telemetry", "bulk" };
+    for (int i = 0; i < MQTT_OUTBOUND_CLASS_COUNT; i++) {
+        mqtt_outbound_stats_t queue_stats;
+        if (mqtt_outbound_get_stats(i, &queue_stats) == ESP_OK && queue_stats.sent > 0) {
+            ESP_LOGI(TAG, "Outbound %s: %lu sent, %lu dropped, %lu rejected, wait avg %llu us / max %lu us",
+                     class_names[i], (unsigned long)queue_stats.sent, (unsigned long)queue_stats.dropped,
+                     (unsigned long)queue_stats.rejected, (unsigned long long)(queue_stats.wait_sum_us / queue_stats.sent),
+                     (unsigned long)queue_stats.wait_max_us);
+        }
+    }
+
+    rpc_method_stats_t stats[RPC_HANDLER_MAX_METHODS];
+    size_t count = rpc_handler_get_stats(stats, RPC_HANDLER_MAX_METHODS);
+    uint32_t calls = 0;
+    for (size_t i = 0; i < count; i++) {
+        calls += stats[i].calls;
+    }
+    if (calls == s_last_calls) {
+        return;
+    }
+
+    size_t len = rpc_handler_serialize_stats(s_telemetry_payload, sizeof(s_telemetry_payload));
+    if (publish_json_stats(s_telemetry_payload, len)) {
+        s_last_calls = calls;
+    }
+}
+
+/**
+ * @brief Publish the broker DNS probe latency as telemetry after each probe
+ */
+static void publish_dns_probe(void)
+{
+    static uint32_t s_last_probes = 0;
+    dns_probe_stats_t stats;
+    dns_probe_get_stats(&stats);
+    if (stats.probes == s_last_probes) {
+        return;
+    }
+
+    int n = snprintf(s_telemetry_payload, sizeof(s_telemetry_payload),
+                     "{\"dns_probe_ms\":%lu,\"dns_probe_ok\":%s,\"dns_ttl_s\":%lu,\"dns_cache_hits\":%lu}",
+                     (unsigned long)stats.last_latency_ms, stats.last_ok ? "true" : "false",
+                     (unsigned long)stats.last_ttl_s, (unsigned long)stats.cache_hits);
+    if (n > 0 && (size_t)n < sizeof(s_telemetry_payload) && publish_json_stats(s_telemetry_payload, n)) {
+        s_last_probes = stats.probes;
+    }
+}
+
+/**
+ * @brief Publish the reconnect backoff state as telemetry after each reconnect
+ *
+ * The attempt counts and delays describe the outage that just ended.
+ */
+static void publish_connection_stats(void)
+{
+    static uint32_t s_last_online = 0;
+    conn_manager_stats_t stats;
+    conn_manager_get_stats(&stats);
+    if (stats.online_count == s_last_online) {
+        return;
+    }
+
+    int n = snprintf(s_telemetry_payload, sizeof(s_telemetry_payload),
+                     "{\"conn_wifi_drops\":%lu,\"conn_broker_drops\":%lu,\"conn_wifi_attempts\":%lu,"
+                     "\"conn_wifi_backoff_ms\":%lu,\"conn_mqtt_attempts\":%lu,\"conn_mqtt_backoff_ms\":%lu}",
+                     (unsigned long)stats.wifi_drops, (unsigned long)stats.broker_drops,
+                     (unsigned long)stats.wifi_attempts, (unsigned long)stats.wifi_delay_ms,
+                     (unsigned long)stats.mqtt_attempts, (unsigned long)stats.mqtt_delay_ms);
+    if (n > 0 && (size_t)n < sizeof(s_telemetry_payload) && publish_json_stats(s_telemetry_payload, n)) {
+        s_last_online = stats.online_count;
+    }
+}
+
+/**
+ * @brief Publish the report-by-exception counters as telemetry once per RBE_STATS_PERIOD_MS
+ */
+static void publish_policy_stats(void)
+{
+    static int64_t s_last_stats_us = 0;
+    static uint32_t s_last_sent = 0;
+    static uint32_t s_last_suppressed = 0;
+    int64_t now_us = esp_timer_get_time();
+    if (now_us - s_last_stats_us < (int64_t)RBE_STATS_PERIOD_MS * 1000) {
+        return;
+    }
+    s_last_stats_us = now_us;
+
+    telemetry_policy_stats_t stats;
+    telemetry_policy_get_stats(&stats);
+    if (stats.sent_total == s_last_sent && stats.suppressed_total == s_last_suppressed) {
+        return;
+    }
+
+    int n = snprintf(s_telemetry_payload, sizeof(s_telemetry_payload), "{\"rbe_sent\":%lu,\"rbe_suppressed\":%lu}",
+                     (unsigned long)stats.sent_total, (unsigned long)stats.suppressed_total);
+    if (n > 0 && (size_t)n < sizeof(s_telemetry_payload) && publish_json_stats(s_telemetry_payload, n)) {
+        s_last_sent = stats.sent_total;
+        s_last_suppressed = stats.suppressed_total;
+    }
+}
+
+/**
+ * @brief Upload job: close the aggregation window, then publish or spool
+ *
+ * The window is stamped with its scheduled deadline rather than the time the
+ * job got to run, so samples land exactly on upload-period boundaries.
+ */
+static void telemetry_upload_job(void *arg, int64_t deadline_us)
+{
+    esp_mqtt_client_handle_t client = (esp_mqtt_client_handle_t)arg;
+    static uint32_t s_upload_window = 0;
+    s_upload_window++;
+
+    int32_t rssi = 0;
+    sample_rssi(&rssi);
+    telemetry_bp_update(pending_outbound_bytes(client), (int8_t)rssi, esp_timer_get_time() / 1000);
+
+    // Under backpressure, consecutive windows are merged by keeping the aggregation window open
+    if (s_upload_window % telemetry_bp_coalesce_factor() != 0) {
+        return;
+    }
+
+    telemetry_sample_t sample;
+    telemetry_aggregator_close_window(&sample);
+    sample.captured_us = deadline_us;
+    if (telemetry_policy_apply(&sample)) {
+        telemetry_buffer_push(&sample);
+    }
+
+    // Publish every Nth window under backpressure so pending samples leave in fewer, larger batches
+    uint32_t stride = telemetry_bp_publish_stride();
+    bool publish_window = s_mqtt_connected && stride != 0 && s_upload_window % stride == 0;
+
+    if (!s_mqtt_connected || stride == 0) {
+        if (s_store_available && telemetry_buffer_flush_due(esp_timer_get_time())) {
+            spool_telemetry_to_store();
+        }
+    } else if (publish_window && telemetry_buffer_count() > 0 &&
+               (!wall_clock_synced() || telemetry_buffer_flush_due(esp_timer_get_time()))) {
+        publish_telemetry_batch(client);
+
+        telemetry_job_stats_t sched_stats;
+        if (telemetry_scheduler_get_stats(s_upload_scheduler, s_upload_job_id, &sched_stats) == ESP_OK &&
+            sched_stats.runs > 0) {
+            ESP_LOGI(TAG, "Upload schedule: %lu runs, %lu overruns, jitter avg %lld us / max %lld us",
+                     (unsigned long)sched_stats.runs, (unsigned long)sched_stats.overruns,
+                     (long long)(sched_stats.jitter_sum_us / sched_stats.runs), (long long)sched_stats.jitter_max_us);
+        }
+
+        // Blink LED to indicate publish
+        led_engine_flash(&LED_COLOR_WHITE, TELEMETRY_LED_BLINK_MS);
+    }
+
+    gateway_simulation_upload(&sample, publish_window);
+
+    if (publish_window && s_store_available) {
+        drain_telemetry_store(client);
+    }
+    if (s_mqtt_connected) {
+        // Client attributes changed mid-session (e.g. a new lease) or a delta whose PUBACK was lost
+        device_attributes_publish_client();
+        publish_rpc_stats();
+        publish_dns_probe();
+        publish_connection_stats();
+        publish_policy_stats();
+    }
+}
+
+/**
+ * @brief Set up sampling and uploading; both keep running across MQTT disconnects
+ */
+static void telemetry_start(esp_mqtt_client_handle_t client)
+{
+    // Initialize temperature sensor
+    temperature_sensor_config_t temp_sensor_config = TEMPERATURE_SENSOR_CONFIG_DEFAULT(20, 50);
+    ESP_ERROR_CHECK(temperature_sensor_install(&temp_sensor_config, &s_temp_handle));
+    ESP_ERROR_CHECK(temperature_sensor_enable(s_temp_handle));
+
+    ESP_ERROR_CHECK(telemetry_aggregator_init());
+
+    telemetry_bp_config_t bp_config = TELEMETRY_BP_DEFAULT_CONFIG();
+    ESP_ERROR_CHECK(telemetry_bp_init(&bp_config));
+
+    telemetry_buffer_config_t buffer_config = TELEMETRY_BUFFER_DEFAULT_CONFIG();
+    ESP_ERROR_CHECK(telemetry_buffer_init(&buffer_config));
+
+    // Store-and-forward is optional: without the partition, samples stay in the RAM ring
+    telemetry_store_config_t store_config = TELEMETRY_STORE_DEFAULT_CONFIG();
+    s_store_available = (telemetry_store_init(&store_config) == ESP_OK);
+
+    // Signals are sampled at their own rates; only window aggregates are published.
+    // Sampling gets its own higher-priority scheduler so publishing cannot delay it.
+    telemetry_scheduler_config_t sampler_config = TELEMETRY_SCHEDULER_DEFAULT_CONFIG();
+    sampler_config.task_name = "sampler_task";
+    sampler_config.stack_size = 3072;
+    sampler_config.priority = 6;
+    telemetry_scheduler_handle_t sampler_scheduler;
+    ESP_ERROR_CHECK(telemetry_scheduler_create(&sampler_config, &sampler_scheduler));
+    for (size_t i = 0; i < sizeof(s_samplers) / sizeof(s_samplers[0]); i++) {
+        telemetry_job_config_t job = {
+            .name = "sample",
+            .period_ms = s_samplers[i].period_ms,
+            .phase_ms = s_samplers[i].phase_ms,
+            .fn = sample_signal_job,
+            .arg = (void *)&s_samplers[i],
+        };
+        ESP_ERROR_CHECK(telemetry_scheduler_add_job(sampler_scheduler, &job, NULL));
+    }
+    ESP_ERROR_CHECK(telemetry_scheduler_start(sampler_scheduler));
+
+    telemetry_scheduler_config_t upload_config = TELEMETRY_SCHEDULER_DEFAULT_CONFIG();
+    upload_config.task_name = "telemetry_task";
+    telemetry_scheduler_handle_t upload_scheduler;
+    ESP_ERROR_CHECK(telemetry_scheduler_create(&upload_config, &upload_scheduler));
+    telemetry_job_config_t upload_job = {
+        .name = "upload",
+        .period_ms = s_upload_period_ms,
+        .phase_ms = 0,
+        .fn = telemetry_upload_job,
+        .arg = client,
+    };
+    ESP_ERROR_CHECK(telemetry_scheduler_add_job(upload_scheduler, &upload_job, &s_upload_job_id));
+    ESP_ERROR_CHECK(telemetry_scheduler_start(upload_scheduler));
+    s_upload_scheduler = upload_scheduler;
+
+    // SNTP may have synced before MQTT connected
+    align_upload_windows();
+}
+
+/* Duty-cycled deep-sleep mode: sample on timer wakes, upload every Nth wake */
+static RTC_DATA_ATTR duty_cycle_state_t s_duty_state; // Zeroed on power-on, kept across deep sleep
+static duty_cycle_config_t s_duty_config = DUTY_CYCLE_DEFAULT_CONFIG();
+static bool s_duty_upload_wake = false; // This boot is an upload wake
+static TaskHandle_t s_duty_task = NULL;
+static int64_t s_radio_start_us = 0;
+
+// Signals that can be read without the radio, and how often per wake
+static const struct {
+    telemetry_signal_t signal;
+    uint8_t reads;
+    bool (*read)(int32_t *value);
+} s_duty_samplers[] = {
+    { TELEMETRY_SIGNAL_TEMPERATURE, DUTY_CYCLE_TEMPERATURE_READS, sample_temperature },
+    { TELEMETRY_SIGNAL_HEAP,        1,                            sample_heap },
+};
+
+static int64_t system_time_us(void)
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (int64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+/**
+ * @brief Read the radio-free signals into one sample
+ */
+static void duty_cycle_take_sample(telemetry_sample_t *sample)
+{
+    telemetry_window_t windows[TELEMETRY_SIGNAL_COUNT];
+    for (int i = 0; i < TELEMETRY_SIGNAL_COUNT; i++) {
+        memset(&windows[i], 0, sizeof(windows[i]));
+        telemetry_window_reset(&windows[i]);
+    }
+
+    temperature_sensor_config_t temp_sensor_config = TEMPERATURE_SENSOR_CONFIG_DEFAULT(20, 50);
+    if (temperature_sensor_install(&temp_sensor_config, &s_temp_handle) != ESP_OK ||
+        temperature_sensor_enable(s_temp_handle) != ESP_OK) {
+        ESP_LOGW(TAG, "Temperature sensor unavailable");
+    }
+    for (size_t i = 0; i < sizeof(s_duty_samplers) / sizeof(s_duty_samplers[0]); i++) {
+        for (int n = 0; n < s_duty_samplers[i].reads; n++) {
+            int32_t value;
+            if (s_duty_samplers[i].read(&value)) {
+                telemetry_window_add(&windows[s_duty_samplers[i].signal], value);
+            }
+        }
+    }
+
+    memset(sample, 0, sizeof(*sample));
+    // Stored as epoch microseconds like the flash store, 0 when the time is unknown
+    sample->captured_us = wall_clock_synced() ? system_time_us() : 0;
+    for (int k = 0; k < TELEMETRY_KEY_COUNT; k++) {
+        const telemetry_window_t *window = &windows[telemetry_schema[k].signal];
+        if (window->count > 0) {
+            sample->values[k] = telemetry_window_get(window, telemetry_schema[k].aggregate);
+            sample->present |= 1U << k;
+        }
+    }
+}
+
+/**
+ * @brief Sleep until the next wake deadline (does not return)
+ */
+static void duty_cycle_sleep(void)
+{
+    // The system time keeps counting in deep sleep, so deadlines hold across wakes
+    uint64_t sleep_us = duty_cycle_next_sleep_us(&s_duty_state, &s_duty_config, system_time_us());
+    ESP_LOGI(TAG, "Duty cycle: %u samples buffered, sleeping %llu ms", (unsigned)s_duty_state.count,
+             (unsigned long long)(sleep_us / 1000));
+    esp_deep_sleep(sleep_us);
+}
+
+/**
+ * @brief Duty-cycled wake: buffer one sample in RTC memory and go back to sleep
+ *
+ * Returns only on upload wakes, which continue the normal Wi-Fi and MQTT
+ * start-up and sleep again once the batch is acknowledged.
+ */
+static void duty_cycle_wake(void)
+{
+    if (!duty_cycle_valid(&s_duty_state)) {
+        duty_cycle_reset(&s_duty_state);
+    }
+    telemetry_sample_t sample;
+    duty_cycle_take_sample(&sample);
+    if (!duty_cycle_record(&s_duty_state, &s_duty_config, &sample)) {
+        duty_cycle_sleep();
+    }
+    s_duty_upload_wake = true;
+    ESP_LOGI(TAG, "Duty cycle wake %lu: uploading %u samples", (unsigned long)s_duty_state.wakes,
+             (unsigned)s_duty_state.count);
+}
+
+/**
+ * @brief Publish the radio-on cost of earlier upload wakes
+ */
+static void publish_duty_cycle_stats(void)
+{
+    if (s_duty_state.uploads == 0) {
+        return;
+    }
+    int n = snprintf(s_telemetry_payload, sizeof(s_telemetry_payload),
+                     "{\"duty_radio_us_per_sample\":%lu,\"duty_radio_on_ms\":%lu,\"duty_wakes\":%lu,"
+                     "\"duty_samples_dropped\":%lu,\"duty_upload_failures\":%lu}",
+                     (unsigned long)duty_cycle_radio_us_per_sample(&s_duty_state),
+                     (unsigned long)(s_duty_state.last_radio_on_us / 1000), (unsigned long)s_duty_state.wakes,
+                     (unsigned long)s_duty_state.samples_dropped, (unsigned long)s_duty_state.upload_failures);
+    if (n > 0 && (size_t)n < sizeof(s_telemetry_payload)) {
+        publish_json_stats(s_telemetry_payload, n);
+    }
+}
+
+/**
+ * @brief Publish the retained batch and wait for the broker's PUBACKs
+ *
+ * Every publish is matched to its PUBACK by msg_id. When the budget runs out,
+ * the samples of the leading acknowledged publishes still count as uploaded,
+ * so the next upload wake does not send them again.
+ *
+ * @return Samples acknowledged, counted from the oldest
+ */
+static size_t duty_cycle_publish_batch(esp_mqtt_client_handle_t client, int64_t deadline_us)
+{
+    publish_duty_cycle_stats();
+
+    size_t count = duty_cycle_peek(&s_duty_state, s_telemetry_batch, TELEMETRY_BUFFER_MAX_SAMPLES);
+    portENTER_CRITICAL(&s_duty_upload_lock);
+    duty_cycle_upload_begin(&s_duty_upload_tracking);
+    portEXIT_CRITICAL(&s_duty_upload_lock);
+
+    size_t offset = 0;
+    while (offset < count && esp_timer_get_time() < deadline_us) {
+        // Chunk consecutive samples that share timestamp availability
+        bool timestamped = s_telemetry_batch[offset].captured_us != 0;
+        size_t run = 1;
+        while (offset + run < count && (s_telemetry_batch[offset + run].captured_us != 0) == timestamped) {
+            run++;
+        }
+
+        portENTER_CRITICAL(&s_duty_upload_lock);
+        duty_cycle_chunk_t *chunk = duty_cycle_upload_reserve(&s_duty_upload_tracking);
+        portEXIT_CRITICAL(&s_duty_upload_lock);
+        size_t payload_len = 0;
+        int published = publish_telemetry_chunk(client, MQTT_OUTBOUND_TELEMETRY, &s_telemetry_batch[offset], run,
+                                                timestamped, 0, telemetry_publish_done, chunk, &payload_len);
+        if (published < 0) {
+            // Outbound queue full: let it drain
+            vTaskDelay(pdMS_TO_TICKS(DUTY_CYCLE_POLL_MS));
+            continue;
+        }
+
+        portENTER_CRITICAL(&s_duty_upload_lock);
+        if (published == 0) {
+            // Unserializable samples are consumed as well so they cannot block the buffer
+            chunk->acked = true;
+        }
+        duty_cycle_upload_commit(&s_duty_upload_tracking, published > 0 ? (uint16_t)published : 1);
+        portEXIT_CRITICAL(&s_duty_upload_lock);
+        offset += published > 0 ? (size_t)published : 1;
+    }
+
+    bool settled = false;
+    while (esp_timer_get_time() < deadline_us) {
+        portENTER_CRITICAL(&s_duty_upload_lock);
+        settled = duty_cycle_upload_settled(&s_duty_upload_tracking);
+        portEXIT_CRITICAL(&s_duty_upload_lock);
+        if (settled) {
+            break;
+        }
+        vTaskDelay(pdMS_TO_TICKS(DUTY_CYCLE_POLL_MS));
+    }
+
+    portENTER_CRITICAL(&s_duty_upload_lock);
+    size_t acked = duty_cycle_upload_acked_samples(&s_duty_upload_tracking);
+    portEXIT_CRITICAL(&s_duty_upload_lock);
+    if (acked < count) {
+        ESP_LOGW(TAG, "Duty cycle upload incomplete: %u of %u samples acknowledged, keeping the rest",
+                 (unsigned)acked, (unsigned)count);
+    }
+    return acked;
+}
+
+/**
+ * @brief Upload wake: publish the batch once MQTT is online, then sleep
+ */
+static void duty_cycle_upload_task(void *arg)
+{
+    // Started right before Wi-Fi, so the budget runs from (about) radio-on
+    int64_t deadline_us = esp_timer_get_time() + (int64_t)DUTY_CYCLE_UPLOAD_TIMEOUT_MS * 1000;
+    size_t buffered = s_duty_state.count;
+    size_t uploaded = 0;
+
+    if (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(DUTY_CYCLE_UPLOAD_TIMEOUT_MS)) > 0) {
+        esp_mqtt_client_handle_t client = conn_manager_get_client();
+        uploaded = duty_cycle_publish_batch(client, deadline_us);
+        esp_mqtt_client_disconnect(client);
+    }
+
+    esp_wifi_stop();
+    uint32_t radio_on_us = (uint32_t)(esp_timer_get_time() - s_radio_start_us);
+    duty_cycle_consume(&s_duty_state, uploaded);
+    duty_cycle_upload_done(&s_duty_state, radio_on_us, uploaded == buffered);
+    ESP_LOGI(TAG, "Duty cycle upload: %u samples, radio on %lu ms, %lu us radio per sample overall",
+             (unsigned)uploaded, (unsigned long)(radio_on_us / 1000),
+             (unsigned long)duty_cycle_radio_us_per_sample(&s_duty_state));
+    duty_cycle_sleep();
+}
+
+/**
+ * @brief Prepare an upload wake: backpressure accounting and the upload task (before Wi-Fi starts)
+ */
+static void duty_cycle_upload_start(void)
+{
+    telemetry_bp_config_t bp_config = TELEMETRY_BP_DEFAULT_CONFIG();
+    ESP_ERROR_CHECK(telemetry_bp_init(&bp_config));
+    if (xTaskCreate(duty_cycle_upload_task, "duty_upload", 4096, NULL, 5, &s_duty_task) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create duty cycle upload task");
+        duty_cycle_sleep();
+    }
+}
 
-// LED color management system
-typedef struct {
-    uint8_t red;
-    uint8_t green;
-    uint8_t blue;
-} led_color_t;
+/* RPC methods (called from the MQTT task, must not block) */
+static bool s_led_override = false;
 
-// LED color constants
-static const led_color_t LED_COLOR_RED     = {255, 0, 0};
-static const led_color_t LED_COLOR_GREEN   = {0, 255, 0};
-static const led_color_t LED_COLOR_BLUE    = {0, 0, 255};
-static const led_color_t LED_COLOR_WHITE   = {255, 255, 255};
-static const led_color_t LED_COLOR_YELLOW  = {255, 255, 0};
-static const led_color_t LED_COLOR_PROVISIONING = {50, 50, 50}; // Dim white for provisioning mode
+static esp_err_t rpc_set_led(const json_span_t *params, char *result, size_t result_size, size_t *result_len, void *ctx)
+{
+    bool on;
+    if (!json_span_to_bool(params, &on)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    led_engine_set_override(on ? &LED_COLOR_WHITE : NULL);
+    s_led_override = on;
+    *result_len = strlcpy(result, on ? "true" : "false", result_size);
+    return ESP_OK;
+}
 
-static void init_led(void)
+static esp_err_t rpc_get_led(const json_span_t *params, char *result, size_t result_size, size_t *result_len, void *ctx)
 {
-    led_strip_config_t strip_config = {
-        .strip_gpio_num = ARGB_LED_GPIO,
-        .max_leds = 1,
-    };
-    led_strip_rmt_config_t rmt_config = {
-        .resolution_hz = 10 * 1000 * 1000, // 10MHz
-    };
-    ESP_ERROR_CHECK(led_strip_new_rmt_device(&strip_config, &rmt_config, &s_led_strip));
-    led_strip_clear(s_led_strip);
+    *result_len = strlcpy(result, s_led_override ? "true" : "false", result_size);
+    return ESP_OK;
 }
 
-static void set_led_color(const led_color_t *color)
+static esp_err_t rpc_get_status(const json_span_t *params, char *result, size_t result_size, size_t *result_len, void *ctx)
 {
-    led_strip_set_pixel(s_led_strip, 0, 
-                        (color->red * DEFAULT_LED_BRIGHTNESS) / MAX_LED_BRIGHTNESS,
-                        (color->green * DEFAULT_LED_BRIGHTNESS) / MAX_LED_BRIGHTNESS,
-                        (color->blue * DEFAULT_LED_BRIGHTNESS) / MAX_LED_BRIGHTNESS);
-    led_strip_refresh(s_led_strip);
+    int32_t rssi = 0;
+    sample_rssi(&rssi);
+    telemetry_bp_stats_t bp_stats;
+    telemetry_bp_get_stats(&bp_stats);
+    tls_session_stats_t tls_stats;
+    tls_session_get_stats(&tls_stats);
+    wifi_fast_connect_stats_t wifi_stats;
+    wifi_fast_connect_get_stats(&wifi_stats);
+    conn_manager_stats_t conn_stats;
+    conn_manager_get_stats(&conn_stats);
+    int n = snprintf(result, result_size,
+                     "{\"uptime\":%lld,\"heap\":%lu,\"rssi\":%ld,\"upload_period_ms\":%lu,\"payload_format\":\"%s\","
+                     "\"store_pending\":%lu,\"backpressure\":%d,\"ack_latency_ms\":%lu,"
+                     "\"tls_full_ms\":%lu,\"tls_resumed_ms\":%lu,\"tls_refused\":%lu,"
+                     "\"time_to_ip_ms\":%lu,\"wifi_fast\":%s,\"conn_state\":\"%s\",\"wifi_drops\":%lu,\"mqtt_clients\":%lu}",
+                     (long long)(esp_timer_get_time() / 1000000), (unsigned long)esp_get_free_heap_size(), (long)rssi,
+                     (unsigned long)s_upload_period_ms,
+                     s_telemetry_format == TELEMETRY_FORMAT_PROTOBUF ? "protobuf" : "json",
+                     (unsigned long)(s_store_available ? telemetry_store_pending() : 0), (int)bp_stats.level,
+                     (unsigned long)bp_stats.ack_latency_ms, (unsigned long)tls_stats.full.last_ms,
+                     (unsigned long)tls_stats.resumed.last_ms, (unsigned long)tls_stats.refused,
+                     (unsigned long)wifi_stats.last_time_to_ip_ms,
+                     wifi_stats.last_fast ? "true" : "false", conn_manager_state_name(conn_manager_get_state()),
+                     (unsigned long)conn_stats.wifi_drops, (unsigned long)conn_stats.clients_created);
+    if (n < 0 || (size_t)n >= result_size) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    *result_len = n;
+    return ESP_OK;
 }
 
+/**
+ * @brief Change the upload period (applied at telemetry start if not running yet)
+ */
+static esp_err_t set_upload_period(int32_t period_ms)
+{
+    if (period_ms < TELEMETRY_UPLOAD_PERIOD_MIN_MS || period_ms > TELEMETRY_UPLOAD_PERIOD_MAX_MS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_upload_scheduler) {
+        esp_err_t err = telemetry_scheduler_set_period(s_upload_scheduler, s_upload_job_id, period_ms);
+        if (err != ESP_OK) {
+            return err;
+        }
+    }
+    s_upload_period_ms = period_ms;
+    align_upload_windows();
+    ESP_LOGI(TAG, "Upload period set to %ld ms", (long)period_ms);
+    return ESP_OK;
+}
 
-static const char *TAG = "PROVISIONING_EXAMPLE";
+static esp_err_t rpc_set_interval(const json_span_t *params, char *result, size_t result_size, size_t *result_len, void *ctx)
+{
+    int32_t period_ms;
+    if (!json_span_to_int(params, &period_ms)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    esp_err_t err = set_upload_period(period_ms);
+    if (err != ESP_OK) {
+        return err;
+    }
 
+    int n = snprintf(result, result_size, "{\"upload_period_ms\":%ld}", (long)period_ms);
+    if (n < 0 || (size_t)n >= result_size) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    *result_len = n;
+    return ESP_OK;
+}
 
-static void log_error_if_nonzero(const char *message, int error_code)
+static bool hex_to_bytes(const char *hex, uint8_t *out, size_t len)
 {
-    if (error_code != 0) {
-        ESP_LOGE(TAG, "Last error %s: 0x%x", message, error_code);
+    if (strlen(hex) != 2 * len) {
+        return false;
+    }
+    for (size_t i = 0; i < 2 * len; i++) {
+        char c = hex[i];
+        int nibble = (c >= '0' && c <= '9') ? c - '0' :
+                     (c >= 'a' && c <= 'f') ? c - 'a' + 10 :
+                     (c >= 'A' && c <= 'F') ? c - 'A' + 10 : -1;
+        if (nibble < 0) {
+            return false;
+        }
+        out[i / 2] = (i % 2) ? (out[i / 2] | nibble) : (uint8_t)(nibble << 4);
     }
+    return true;
 }
 
-/*
- * @brief Event handler registered to receive MQTT events
+static size_t s_cert_rotation_offset = 0;     // PEM bytes of the current rotation applied so far
+
+/**
+ * @brief Stream a new CA certificate in chunks
  *
- *  This function is called by the MQTT client event loop.
+ * params: {"offset":0,"size":1289,"sha256":"<hex>","data":"-----BEGIN CERTIFICATE-----\n..."}
+ * offset 0 starts a rotation (sha256 of the whole PEM is optional), the chunk
+ * reaching size finishes it. Chunks must arrive in order; after an error the
+ * server starts over at offset 0.
+ */
+static esp_err_t rpc_rotate_certificate(const json_span_t *params, char *result, size_t result_size, size_t *result_len, void *ctx)
+{
+    static char chunk[CERT_ROTATION_CHUNK_MAX + 1];
+    json_span_t value;
+    int32_t offset;
+    int32_t size;
+    if (params->type != JSON_SPAN_OBJECT ||
+        !json_scan_key(params, "offset", &value) || !json_span_to_int(&value, &offset) ||
+        !json_scan_key(params, "size", &value) || !json_span_to_int(&value, &size) || size <= 0 ||
+        !json_scan_key(params, "data", &value) || !json_span_copy_string(&value, chunk, sizeof(chunk))) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    esp_err_t err;
+    if (offset == 0) {
+        uint8_t sha256[CERT_FINGERPRINT_SIZE];
+        char hex[2 * CERT_FINGERPRINT_SIZE + 1];
+        bool has_sha256 = json_scan_key(params, "sha256", &value);
+        if (has_sha256 && (!json_span_copy_string(&value, hex, sizeof(hex)) ||
+                           !hex_to_bytes(hex, sha256, sizeof(sha256)))) {
+            return ESP_ERR_INVALID_ARG;
+        }
+        err = cert_manager_rotate_begin(size, has_sha256 ? sha256 : NULL, CERT_SOURCE_OTA_UPDATE);
+        if (err != ESP_OK) {
+            return err;
+        }
+        s_cert_rotation_offset = 0;
+    } else if ((size_t)offset != s_cert_rotation_offset) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    size_t len = strlen(chunk);
+    err = cert_manager_rotate_write(chunk, len);
+    if (err != ESP_OK) {
+        return err;
+    }
+    s_cert_rotation_offset += len;
+
+    bool done = s_cert_rotation_offset >= (size_t)size;
+    if (done) {
+        err = cert_manager_rotate_finish(NULL);
+        if (err != ESP_OK) {
+            return err;
+        }
+        // A resumed session would skip verifying the broker against the new chain
+        tls_session_clear();
+        device_attributes_set_client(DEVICE_CLIENT_CERT_SOURCE, cert_manager_get_source_name(CERT_SOURCE_OTA_UPDATE));
+    }
+
+    int n = snprintf(result, result_size, "{\"received\":%u,\"rotated\":%s}", (unsigned)s_cert_rotation_offset,
+                     done ? "true" : "false");
+    if (n < 0 || (size_t)n >= result_size) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    *result_len = n;
+    return ESP_OK;
+}
+
+static size_t s_anchor_offset = 0;           // PEM bytes of the current trust anchor upload applied so far
+
+/**
+ * @brief Stream a PEM bundle of additional CAs into the trust store in chunks
  *
- * @param handler_args user data registered to the event.
- * @param base Event base for the handler(always MQTT Base in this example).
- * @param event_id The id for the received event.
- * @param event_data The data for the event, esp_mqtt_event_handle_t.
+ * params: {"offset":0,"size":1289,"data":"-----BEGIN CERTIFICATE-----\n..."}
+ * Same chunking as rotateCertificate: every chunk is decoded straight into
+ * the trust partition, and the bundle is committed once the chunk reaching
+ * size arrives. The primary certificate is not touched, so old and new broker
+ * CAs are trusted side by side during a migration.
  */
+static esp_err_t rpc_add_trust_anchor(const json_span_t *params, char *result, size_t result_size, size_t *result_len, void *ctx)
+{
+    static char chunk[CERT_ROTATION_CHUNK_MAX + 1];
+    json_span_t value;
+    int32_t offset;
+    int32_t size;
+    if (params->type != JSON_SPAN_OBJECT ||
+        !json_scan_key(params, "offset", &value) || !json_span_to_int(&value, &offset) ||
+        !json_scan_key(params, "size", &value) || !json_span_to_int(&value, &size) || size <= 0 ||
+        !json_scan_key(params, "data", &value) || !json_span_copy_string(&value, chunk, sizeof(chunk))) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    esp_err_t err;
+    if (offset == 0) {
+        err = trust_store_add_begin(size);
+        if (err != ESP_OK) {
+            return err;
+        }
+        s_anchor_offset = 0;
+    } else if ((size_t)offset != s_anchor_offset) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    size_t len = strlen(chunk);
+    err = trust_store_add_write(chunk, len);
+    if (err != ESP_OK) {
+        return err;
+    }
+    s_anchor_offset += len;
+
+    size_t added = 0;
+    if (s_anchor_offset >= (size_t)size) {
+        err = trust_store_add_finish(&added);
+        if (err != ESP_OK) {
+            return err;
+        }
+    }
+
+    int n = snprintf(result, result_size, "{\"received\":%u,\"added\":%u,\"anchors\":%u}",
+                     (unsigned)s_anchor_offset, (unsigned)added, (unsigned)trust_store_count());
+    if (n < 0 || (size_t)n >= result_size) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    *result_len = n;
+    return ESP_OK;
+}
 
-static void telemetry_task(void *pvParameters)
+/**
+ * @brief Remove a trust anchor by SHA-256 fingerprint of its DER encoding
+ *
+ * params: {"sha256":"<hex>"}, colons as printed by openssl x509 -fingerprint
+ * -sha256 are accepted.
+ */
+static esp_err_t rpc_remove_trust_anchor(const json_span_t *params, char *result, size_t result_size, size_t *result_len, void *ctx)
 {
-    esp_mqtt_client_handle_t client = (esp_mqtt_client_handle_t)pvParameters;
+    char hex[3 * TRUST_STORE_FINGERPRINT_SIZE];
+    json_span_t value;
+    if (params->type != JSON_SPAN_OBJECT || !json_scan_key(params, "sha256", &value) ||
+        !json_span_copy_string(&value, hex, sizeof(hex))) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    size_t digits = 0;
+    for (size_t i = 0; hex[i] != '\0'; i++) {
+        if (hex[i] != ':') {
+            hex[digits++] = hex[i];
+        }
+    }
+    hex[digits] = '\0';
 
-    // Initialize temperature sensor
-    temperature_sensor_config_t temp_sensor_config = TEMPERATURE_SENSOR_CONFIG_DEFAULT(20, 50);
-    temperature_sensor_handle_t temp_handle = NULL;
-    ESP_ERROR_CHECK(temperature_sensor_install(&temp_sensor_config, &temp_handle));
-    ESP_ERROR_CHECK(temperature_sensor_enable(temp_handle));
-
-    while (1) {
-        float temperature;
-        wifi_ap_record_t ap_info;
-        int32_t rssi = 0;
-        uint32_t free_heap = esp_get_free_heap_size();
-        int64_t uptime = esp_timer_get_time() / 1000000; // seconds
-
-        // Get temperature and round to two decimal places
-        ESP_ERROR_CHECK(temperature_sensor_get_celsius(temp_handle, &temperature));
-        temperature = roundf(temperature * 100.0) / 100.0;
-
-        // Get RSSI
-        if (esp_wifi_sta_get_ap_info(&ap_info) == ESP_OK) {
-            rssi = ap_info.rssi;
-        }
-
-        // Create JSON payload
-        cJSON *root = cJSON_CreateObject();
-        cJSON_AddNumberToObject(root, "temperature", temperature);
-        cJSON_AddNumberToObject(root, "rssi", rssi);
-        cJSON_AddNumberToObject(root, "heap", free_heap);
-        cJSON_AddNumberToObject(root, "uptime", uptime);
-
-        char *json_payload = cJSON_Print(root);
-        esp_mqtt_client_publish(client, "v1/devices/me/telemetry", json_payload, 0, 1, 0);
-        cJSON_Delete(root);
-        free(json_payload);
+    uint8_t fingerprint[TRUST_STORE_FINGERPRINT_SIZE];
+    if (!hex_to_bytes(hex, fingerprint, sizeof(fingerprint))) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    esp_err_t err = trust_store_remove(fingerprint);
+    if (err != ESP_OK) {
+        return err;
+    }
+    // A resumed session would skip verifying the broker against the reduced set
+    tls_session_clear();
+
+    int n = snprintf(result, result_size, "{\"anchors\":%u}", (unsigned)trust_store_count());
+    if (n < 0 || (size_t)n >= result_size) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    *result_len = n;
+    return ESP_OK;
+}
+
+/**
+ * @brief Reconnect backoff limits from the shared attributes
+ *
+ * @return false (and a warning) if the attributes are out of range
+ */
+static bool reconnect_backoff_from_attributes(reconnect_backoff_config_t *backoff)
+{
+    int32_t base_ms = device_attributes_get_int(DEVICE_SHARED_RECONNECT_BASE);
+    int32_t cap_ms = device_attributes_get_int(DEVICE_SHARED_RECONNECT_CAP);
+    if (base_ms < RECONNECT_BASE_MIN_MS || cap_ms < base_ms || cap_ms > RECONNECT_CAP_MAX_MS) {
+        ESP_LOGW(TAG, "Rejected reconnect backoff %ld-%ld ms", (long)base_ms, (long)cap_ms);
+        return false;
+    }
+    backoff->base_ms = base_ms;
+    backoff->cap_ms = cap_ms;
+    return true;
+}
+
+/**
+ * @brief Report-by-exception shared attributes of each telemetry key
+ */
+static const struct {
+    device_shared_attr_t deadband;
+    device_shared_attr_t max_silence;
+} s_key_policy_attrs[TELEMETRY_KEY_COUNT] = {
+    [TELEMETRY_KEY_TEMPERATURE]     = { DEVICE_SHARED_RBE_TEMP_DB,     DEVICE_SHARED_RBE_TEMP_SILENCE },
+    [TELEMETRY_KEY_TEMPERATURE_MIN] = { DEVICE_SHARED_RBE_TEMP_MIN_DB, DEVICE_SHARED_RBE_TEMP_MIN_SILENCE },
+    [TELEMETRY_KEY_TEMPERATURE_MAX] = { DEVICE_SHARED_RBE_TEMP_MAX_DB, DEVICE_SHARED_RBE_TEMP_MAX_SILENCE },
+    [TELEMETRY_KEY_RSSI]            = { DEVICE_SHARED_RBE_RSSI_DB,     DEVICE_SHARED_RBE_RSSI_SILENCE },
+    [TELEMETRY_KEY_HEAP]            = { DEVICE_SHARED_RBE_HEAP_DB,     DEVICE_SHARED_RBE_HEAP_SILENCE },
+    [TELEMETRY_KEY_UPTIME]          = { DEVICE_SHARED_RBE_UPTIME_DB,   DEVICE_SHARED_RBE_UPTIME_SILENCE },
+};
+_Static_assert(TELEMETRY_KEY_COUNT == 6, "map the rbe attributes of new telemetry keys in s_key_policy_attrs");
+
+/**
+ * @brief Apply a key's deadband and heartbeat attributes (negative = firmware default)
+ */
+static void apply_key_policy(telemetry_key_t key)
+{
+    telemetry_key_policy_t policy;
+    telemetry_policy_get_default(key, &policy);
+    int32_t deadband = device_attributes_get_int(s_key_policy_attrs[key].deadband);
+    int32_t max_silence_ms = device_attributes_get_int(s_key_policy_attrs[key].max_silence);
+    if (deadband >= 0) {
+        policy.deadband = deadband;
+    }
+    if (max_silence_ms >= 0) {
+        policy.max_silence_ms = (uint32_t)max_silence_ms;
+    }
+
+    telemetry_key_policy_t current;
+    if (telemetry_policy_get(key, &current) == ESP_OK && current.deadband == policy.deadband &&
+        current.max_silence_ms == policy.max_silence_ms) {
+        return;
+    }
+    telemetry_policy_set(key, &policy);
+}
+
+/**
+ * @brief Apply a shared attribute pushed from ThingsBoard (called from the MQTT task)
+ */
+static void on_shared_attribute_changed(device_shared_attr_t attr, void *ctx)
+{
+    for (int key = 0; key < TELEMETRY_KEY_COUNT; key++) {
+        if (attr == s_key_policy_attrs[key].deadband || attr == s_key_policy_attrs[key].max_silence) {
+            apply_key_policy((telemetry_key_t)key);
+            return;
+        }
+    }
+
+    switch (attr) {
+    case DEVICE_SHARED_UPLOAD_PERIOD:
+        if (set_upload_period(device_attributes_get_int(attr)) != ESP_OK) {
+            ESP_LOGW(TAG, "Rejected uploadPeriodMs %ld", (long)device_attributes_get_int(attr));
+        }
+        break;
+    case DEVICE_SHARED_REPORT_BY_EXCEPTION:
+        telemetry_policy_set_enabled(device_attributes_get_bool(attr));
+        break;
+    case DEVICE_SHARED_NTP_SERVER:
+        ESP_LOGI(TAG, "NTP server change takes effect after reboot");
+        break;
+    case DEVICE_SHARED_DUTY_PERIOD:
+    case DEVICE_SHARED_DUTY_UPLOAD_EVERY:
+        ESP_LOGI(TAG, "Duty cycle change takes effect at the next boot or wake");
+        break;
+    case DEVICE_SHARED_GATEWAY_CHILDREN:
+        // The child table is sized once, at boot
+        ESP_LOGI(TAG, "Gateway child count change takes effect after reboot");
+        break;
+    case DEVICE_SHARED_RECONNECT_BASE:
+    case DEVICE_SHARED_RECONNECT_CAP: {
+        reconnect_backoff_config_t backoff;
+        if (reconnect_backoff_from_attributes(&backoff)) {
+            conn_manager_set_backoff(&backoff);
+        }
+        break;
+    }
+    default:
+        break;
+    }
+}
 
-        // Blink LED to indicate successful publish
-        set_led_color(&LED_COLOR_WHITE);
-        vTaskDelay(pdMS_TO_TICKS(500));
-        set_led_color(&LED_COLOR_GREEN);
+static void register_rpc_methods(void)
+{
+    ESP_ERROR_CHECK(rpc_handler_register("setLed", rpc_set_led, NULL));
+    ESP_ERROR_CHECK(rpc_handler_register("getLed", rpc_get_led, NULL));
+    ESP_ERROR_CHECK(rpc_handler_register("getStatus", rpc_get_status, NULL));
+    ESP_ERROR_CHECK(rpc_handler_register("setInterval", rpc_set_interval, NULL));
+    ESP_ERROR_CHECK(rpc_handler_register("rotateCertificate", rpc_rotate_certificate, NULL));
+    ESP_ERROR_CHECK(rpc_handler_register("addTrustAnchor", rpc_add_trust_anchor, NULL));
+    ESP_ERROR_CHECK(rpc_handler_register("removeTrustAnchor", rpc_remove_trust_anchor, NULL));
+}
+
+/**
+ * @brief Log the boot timeline and publish it once as telemetry
+ */
+static void publish_boot_profile(void)
+{
+    boot_profile_log();
+    char payload[512];
+    size_t len = boot_profile_serialize(payload, sizeof(payload));
+    publish_json_stats(payload, len);
+}
 
-        vTaskDelay(pdMS_TO_TICKS(4500)); // Adjust to make total delay 5 seconds
+/**
+ * @brief PUBACK of an outbound message (after its done callback recorded the msg_id)
+ */
+static void outbound_acked(int msg_id, int64_t acked_us)
+{
+    device_attributes_on_published(msg_id);
+    portENTER_CRITICAL(&s_duty_upload_lock);
+    duty_cycle_upload_ack(&s_duty_upload_tracking, msg_id);
+    portEXIT_CRITICAL(&s_duty_upload_lock);
+    portENTER_CRITICAL(&s_store_drain_lock);
+    telemetry_store_drain_ack(&s_store_drain, msg_id);
+    portEXIT_CRITICAL(&s_store_drain_lock);
+    // The first acknowledged telemetry publish completes the boot timeline
+    if (telemetry_bp_on_ack(msg_id, acked_us / 1000) && boot_profile_mark(BOOT_PHASE_FIRST_PUBLISH)) {
+        publish_boot_profile();
     }
 }
 
+/*
+ * @brief Event handler registered to receive MQTT events
+ *
+ *  This function is called by the MQTT client event loop.
+ *
+ * @param handler_args user data registered to the event.
+ * @param base Event base for the handler(always MQTT Base in this example).
+ * @param event_id The id for the received event.
+ * @param event_data The data for the event, esp_mqtt_event_handle_t.
+ */
 static void mqtt_event_handler(void *handler_args, esp_event_base_t base, int32_t event_id, void *event_data)
 {
     ESP_LOGD(TAG, "Event dispatched from event loop base=%s, event_id=%" PRIi32 "", base, event_id);
+    int64_t received_us = esp_timer_get_time();
     esp_mqtt_event_handle_t event = event_data;
     esp_mqtt_client_handle_t client = event->client;
     switch ((esp_mqtt_event_id_t)event_id) {
     case MQTT_EVENT_CONNECTED:
         ESP_LOGI(TAG, "MQTT_EVENT_CONNECTED");
-        set_led_color(&LED_COLOR_GREEN);
-        xTaskCreate(telemetry_task, "telemetry_task", 4096, client, 5, NULL);
+        boot_profile_mark(BOOT_PHASE_MQTT_CONNECTED);
+        log_tls_session_stats();
+        led_engine_set_base(&LED_COLOR_GREEN);
+        conn_manager_on_mqtt_connected();
+        esp_mqtt_client_subscribe(client, RPC_REQUEST_SUBSCRIBE_TOPIC, 1);
+        device_attributes_on_connected(client);
+        gateway_on_connected();
         break;
     case MQTT_EVENT_DISCONNECTED:
         ESP_LOGI(TAG, "MQTT_EVENT_DISCONNECTED");
-        set_led_color(&LED_COLOR_YELLOW);
+        led_engine_set_base(&LED_COLOR_YELLOW);
+        conn_manager_on_mqtt_disconnected();
+        portENTER_CRITICAL(&s_store_drain_lock);
+        s_store_drain_stale = true;
+        portEXIT_CRITICAL(&s_store_drain_lock);
         break;
     case MQTT_EVENT_PUBLISHED:
         ESP_LOGI(TAG, "MQTT_EVENT_PUBLISHED, msg_id=%d", event->msg_id);
+        // Reported to outbound_acked() once the publish that produced msg_id has completed
+        mqtt_outbound_on_published(event->msg_id, received_us);
+        break;
+    case MQTT_EVENT_DATA:
+        // Control messages are small; fragmented payloads are not reassembled
+        if (event->current_data_offset != 0 || event->data_len != event->total_data_len) {
+            ESP_LOGW(TAG, "Ignoring fragmented message (%d bytes)", event->total_data_len);
+            break;
+        }
+        if (rpc_handler_is_request(event->topic, event->topic_len)) {
+            rpc_handler_handle(event->topic, event->topic_len, event->data, event->data_len, received_us);
+        } else {
+            device_attributes_handle_data(event->topic, event->topic_len, event->data, event->data_len);
+        }
         break;
     case MQTT_EVENT_ERROR:
         ESP_LOGE(TAG, "MQTT_EVENT_ERROR");
-        set_led_color(&LED_COLOR_YELLOW);
+        led_engine_set_base(&LED_COLOR_YELLOW);
         if (event->error_handle->error_type == MQTT_ERROR_TYPE_TCP_TRANSPORT) {
             // Enhanced SSL error handling
             if (event->error_handle->esp_tls_last_esp_err != ESP_OK) {
@@ -208,14 +1609,32 @@ static bool wifi_credentials_exist(void) {
 }
 
 
+// Broker address of the long-lived client, kept to refresh a plain MQTT URI on resume
+static char s_mqtt_host[64];
+static char s_mqtt_port_str[8];
+static int s_mqtt_port = 0;
 
-static void mqtt_app_start(void)
+/**
+ * @brief Plain MQTT URI, with the cached broker address when there is one
+ *
+ * There is no certificate to match the name against, so the address can go
+ * straight into the URI.
+ */
+static void format_plain_uri(char *uri, size_t size)
+{
+    char broker_addr[16];
+    const char *broker = dns_probe_lookup(s_mqtt_host, broker_addr, sizeof(broker_addr)) ? broker_addr : s_mqtt_host;
+    snprintf(uri, size, "mqtt://%s:%s", broker, s_mqtt_port_str); // Unencrypted MQTT
+}
+
+/**
+ * @brief Create the one MQTT client from the NVS configuration (connection manager callback)
+ */
+static esp_err_t mqtt_client_create(esp_mqtt_client_handle_t *client_out, void *ctx)
 {
     nvs_handle_t nvs_handle;
     ESP_ERROR_CHECK(nvs_open("wifi_creds", NVS_READONLY, &nvs_handle));
 
-    char mqtt_host[64];
-    char mqtt_port_str[8];
     char device_token[64] = {0};
     char mqtt_user[32] = {0};
     char mqtt_pass[32] = {0};
@@ -223,10 +1642,10 @@ static void mqtt_app_start(void)
     esp_err_t err;
 
     // Read required MQTT configuration
-    len = sizeof(mqtt_host);
-    ESP_ERROR_CHECK(nvs_get_str(nvs_handle, "mqtt_host", mqtt_host, &len));
-    len = sizeof(mqtt_port_str);
-    ESP_ERROR_CHECK(nvs_get_str(nvs_handle, "mqtt_port", mqtt_port_str, &len));
+    len = sizeof(s_mqtt_host);
+    ESP_ERROR_CHECK(nvs_get_str(nvs_handle, "mqtt_host", s_mqtt_host, &len));
+    len = sizeof(s_mqtt_port_str);
+    ESP_ERROR_CHECK(nvs_get_str(nvs_handle, "mqtt_port", s_mqtt_port_str, &len));
     
     // Try to read new device_token format first
     len = sizeof(device_token);
@@ -255,33 +1674,47 @@ static void mqtt_app_start(void)
             ESP_LOGE(TAG, "1. ThingsBoard device token, OR");
             ESP_LOGE(TAG, "2. MQTT username/password");
             nvs_close(nvs_handle);
-            set_led_color(&LED_COLOR_RED);
-            return;
+            led_engine_set_error(LED_ERROR_MQTT_CONFIG, true);
+            return ESP_ERR_NOT_FOUND;
         }
     }
 
+    // Optional payload encoding, JSON unless the device profile expects protobuf
+    char payload_format[16] = {0};
+    len = sizeof(payload_format);
+    if (nvs_get_str(nvs_handle, "payload_format", payload_format, &len) == ESP_OK &&
+        strcmp(payload_format, "protobuf") == 0) {
+        s_telemetry_format = TELEMETRY_FORMAT_PROTOBUF;
+    } else {
+        s_telemetry_format = TELEMETRY_FORMAT_JSON;
+    }
+
     nvs_close(nvs_handle);
     
-    ESP_LOGI(TAG, "MQTT: %s:%s (%s)", mqtt_host, mqtt_port_str, using_device_token ? "Token" : "User/Pass");
+    ESP_LOGI(TAG, "MQTT: %s:%s (%s, %s payload)", s_mqtt_host, s_mqtt_port_str, using_device_token ? "Token" : "User/Pass",
+             s_telemetry_format == TELEMETRY_FORMAT_PROTOBUF ? "protobuf" : "JSON");
 
     char uri[128];
     char *endptr;
     errno = 0;
-    long port_long = strtol(mqtt_port_str, &endptr, 10);
+    long port_long = strtol(s_mqtt_port_str, &endptr, 10);
     if (errno != 0 || *endptr != '\0' || port_long < 1 || port_long > 65535) {
-        ESP_LOGE(TAG, "Invalid MQTT port number: %s (must be 1-65535)", mqtt_port_str);
-        set_led_color(&LED_COLOR_RED);
-        return;
+        ESP_LOGE(TAG, "Invalid MQTT port number: %s (must be 1-65535)", s_mqtt_port_str);
+        led_engine_set_error(LED_ERROR_MQTT_CONFIG, true);
+        return ESP_ERR_INVALID_ARG;
     }
     int port = (int)port_long;
+    s_mqtt_port = port;
     if (port == MQTT_INSECURE_PORT) {
-        snprintf(uri, sizeof(uri), "mqtt://%s:%s", mqtt_host, mqtt_port_str); // Unencrypted MQTT
+        format_plain_uri(uri, sizeof(uri));
     } else {
-        snprintf(uri, sizeof(uri), "mqtts://%s:%s", mqtt_host, mqtt_port_str); // Encrypted MQTTS
+        snprintf(uri, sizeof(uri), "mqtts://%s:%s", s_mqtt_host, s_mqtt_port_str); // Encrypted MQTTS
     }
 
     esp_mqtt_client_config_t mqtt_cfg = {
         .broker.address.uri = uri,
+        // Reconnects are paced by the connection manager's backoff, not esp-mqtt's fixed timer
+        .network.disable_auto_reconnect = true,
     };
     
     // Configure authentication based on available credentials
@@ -295,45 +1728,94 @@ static void mqtt_app_start(void)
 
     // Only load certificate for MQTTS connections
     if (port != MQTT_INSECURE_PORT) {
-        static char *ca_cert = NULL;
-        ca_cert = heap_caps_malloc(2048, MALLOC_CAP_8BIT);
-        if (!ca_cert) {
-            ESP_LOGE(TAG, "Failed to allocate memory for certificate");
-            set_led_color(&LED_COLOR_RED);
-            return;
-        }
-        
-        size_t cert_len = 2048;
-        esp_err_t cert_err = cert_manager_load(ca_cert, cert_len, &cert_len);
+        // Parsed once and cached by the certificate manager; every connect attaches the same chain
+        mbedtls_x509_crt* ca_chain = NULL;
+        esp_err_t cert_err = cert_manager_get_ca_chain(&ca_chain);
         if (cert_err != ESP_OK) {
             ESP_LOGE(TAG, "Failed to load CA certificate: %s", esp_err_to_name(cert_err));
-            free(ca_cert);
-            set_led_color(&LED_COLOR_RED);
-            return;
+            led_engine_set_error(LED_ERROR_MQTT_CONFIG, true);
+            return cert_err;
         }
 
-        mqtt_cfg.broker.verification.certificate = ca_cert;
-        
+        tls_session_config_t tls_config = {
+            .ca_attach = cert_manager_attach_ca_chain,
+            .resolve = dns_probe_lookup,
+            .resolve_failed = dns_probe_invalidate,
+        };
 #ifdef CONFIG_MQTT_DISABLE_CERT_VERIFICATION
-        mqtt_cfg.broker.verification.skip_cert_common_name_check = true;
+        tls_config.skip_common_name = true;
         ESP_LOGW(TAG, "Development mode: Certificate common name verification disabled");
         ESP_LOGW(TAG, "To enable full security, remove CONFIG_MQTT_DISABLE_CERT_VERIFICATION");
 #else
-        mqtt_cfg.broker.verification.skip_cert_common_name_check = false;
+        tls_config.skip_common_name = false;
         ESP_LOGI(TAG, "Production mode: Certificate common name verification enabled");
 #endif
-        
-        mqtt_cfg.broker.verification.use_global_ca_store = false;
-        ESP_LOGI(TAG, "MQTTS with certificate configured");
+
+        // Custom transport so reconnects can resume the previous TLS session
+        esp_transport_handle_t transport = NULL;
+        esp_err_t tls_err = tls_session_transport_create(&tls_config, &transport);
+        if (tls_err != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to create TLS transport: %s", esp_err_to_name(tls_err));
+            led_engine_set_error(LED_ERROR_MQTT_CONFIG, true);
+            return tls_err;
+        }
+        mqtt_cfg.network.transport = transport;
+        ESP_LOGI(TAG, "MQTTS with certificate configured (TLS session resumption enabled)");
     } else {
         ESP_LOGW(TAG, "WARNING: Using unencrypted MQTT connection on port %d", MQTT_INSECURE_PORT);
         ESP_LOGW(TAG, "This connection is NOT SECURE and should only be used for development");
         ESP_LOGI(TAG, "MQTT unencrypted");
     }
 
+    led_engine_set_error(LED_ERROR_MQTT_CONFIG, false);
+
     esp_mqtt_client_handle_t client = esp_mqtt_client_init(&mqtt_cfg);
+    if (client == NULL) {
+        ESP_LOGE(TAG, "Failed to create MQTT client");
+        return ESP_ERR_NO_MEM;
+    }
     esp_mqtt_client_register_event(client, ESP_EVENT_ANY_ID, mqtt_event_handler, NULL);
-    esp_mqtt_client_start(client);
+    *client_out = client;
+    return ESP_OK;
+}
+
+/**
+ * @brief Point a plain MQTT client at the currently cached broker address before it is restarted
+ */
+static void mqtt_client_resume(esp_mqtt_client_handle_t client, void *ctx)
+{
+    if (s_mqtt_port != MQTT_INSECURE_PORT) {
+        return; // The TLS transport looks the address up on every connect
+    }
+    char uri[128];
+    format_plain_uri(uri, sizeof(uri));
+    esp_mqtt_client_set_uri(client, uri);
+}
+
+/**
+ * @brief Follow the connection state (called from the event loop or the MQTT task)
+ */
+static void connection_state_changed(conn_state_t state, esp_mqtt_client_handle_t client, void *ctx)
+{
+    static bool s_telemetry_started = false;
+    bool online = state == CONN_STATE_ONLINE;
+
+    if (state == CONN_STATE_BROKER_CONNECTING) {
+        boot_profile_mark(BOOT_PHASE_MQTT_START);
+    }
+    s_mqtt_connected = online;
+    if (client) {
+        mqtt_outbound_set_connected(client, online);
+    }
+    if (online && s_duty_upload_wake) {
+        xTaskNotifyGive(s_duty_task);
+        return;
+    }
+    // One telemetry task for the life of the client; it keeps spooling samples to flash while offline
+    if (online && !s_telemetry_started) {
+        telemetry_start(client);
+        s_telemetry_started = true;
+    }
 }
 
 /* HTTP server handlers */
@@ -405,7 +1887,7 @@ static connection_status_t s_connection_status = STATUS_IDLE;
  */
 static void wifi_init_sta(void) {
     // Initialize Wi-Fi
-    esp_netif_create_default_wifi_sta();
+    esp_netif_t *sta_netif = esp_netif_create_default_wifi_sta();
     wifi_init_config_t cfg = WIFI_INIT_CONFIG_DEFAULT();
     ESP_ERROR_CHECK(esp_wifi_init(&cfg));
 
@@ -432,9 +1914,17 @@ static void wifi_init_sta(void) {
     strlcpy((char *)wifi_config.sta.ssid, ssid, sizeof(wifi_config.sta.ssid));
     strlcpy((char *)wifi_config.sta.password, password, sizeof(wifi_config.sta.password));
 
+    // Skip the channel scan when the last AP is cached
+    wifi_fast_connect_config_t fast_config = WIFI_FAST_CONNECT_DEFAULT_CONFIG();
+    if (wifi_fast_connect_init(&fast_config, sta_netif) == ESP_OK) {
+        wifi_fast_connect_apply(&wifi_config);
+    }
+
     ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_STA));
     ESP_ERROR_CHECK(esp_wifi_set_config(ESP_IF_WIFI_STA, &wifi_config));
+    s_radio_start_us = esp_timer_get_time();
     ESP_ERROR_CHECK(esp_wifi_start());
+    boot_profile_mark(BOOT_PHASE_WIFI_START);
 
     ESP_LOGI(TAG, "Connecting to stored Wi-Fi network: %s", ssid);
 }
@@ -494,6 +1984,7 @@ static esp_err_t connect_post_handler(httpd_req_t *req)
     char mqtt_host[64] = {0};
     char mqtt_port_str[8] = {0};
     char device_token[64] = {0};
+    char payload_format[16] = {0};
 
     if (httpd_query_key_value(buf, "ssid", ssid, sizeof(ssid)) != ESP_OK ||
         httpd_query_key_value(buf, "password", password, sizeof(password)) != ESP_OK ||
@@ -504,6 +1995,12 @@ static esp_err_t connect_post_handler(httpd_req_t *req)
         return ESP_FAIL;
     }
 
+    // Optional field: older provisioning clients do not send it
+    if (httpd_query_key_value(buf, "payload_format", payload_format, sizeof(payload_format)) != ESP_OK ||
+        strcmp(payload_format, "protobuf") != 0) {
+        strlcpy(payload_format, "json", sizeof(payload_format));
+    }
+
     ESP_LOGI(TAG, "Received SSID: %s", ssid);
     ESP_LOGI(TAG, "Received MQTT Host: %s", mqtt_host);
     ESP_LOGI(TAG, "Received ThingsBoard device token (length: %d)", strlen(device_token));
@@ -545,6 +2042,7 @@ static esp_err_t connect_post_handler(httpd_req_t *req)
     ESP_ERROR_CHECK(nvs_set_str(nvs_handle, "mqtt_host", mqtt_host));
     ESP_ERROR_CHECK(nvs_set_str(nvs_handle, "mqtt_port", mqtt_port_str));
     ESP_ERROR_CHECK(nvs_set_str(nvs_handle, "device_token", device_token));
+    ESP_ERROR_CHECK(nvs_set_str(nvs_handle, "payload_format", payload_format));
     ESP_ERROR_CHECK(nvs_commit(nvs_handle));
     nvs_close(nvs_handle);
 
@@ -617,7 +2115,7 @@ static httpd_handle_t start_webserver(void)
 static void start_provisioning_server(void)
 {
     ESP_LOGI(TAG, "Starting provisioning mode");
-    set_led_color(&LED_COLOR_PROVISIONING);
+    led_engine_set_base(&LED_COLOR_PROVISIONING);
 
     esp_netif_create_default_wifi_ap();
     esp_netif_create_default_wifi_sta();
@@ -653,22 +2151,65 @@ static void start_provisioning_server(void)
     start_webserver();
 }
 
+/**
+ * @brief Broker DNS probe result, doubles as the internet connectivity check
+ */
+static void broker_probe_done(bool ok, uint32_t latency_ms, void *ctx)
+{
+    if (ok) {
+        ESP_LOGI(TAG, "Internet connectivity check successful (%lu ms)", (unsigned long)latency_ms);
+    } else {
+        ESP_LOGE(TAG, "Internet connectivity check failed: broker DNS lookup failed");
+    }
+    led_engine_set_error(LED_ERROR_INTERNET, !ok);
+    boot_profile_mark(BOOT_PHASE_DNS);
+}
+
+/**
+ * @brief Resolve the configured broker host in the background
+ */
+static void start_broker_probe(esp_netif_t *netif)
+{
+    nvs_handle_t nvs_handle;
+    if (nvs_open("wifi_creds", NVS_READONLY, &nvs_handle) != ESP_OK) {
+        return;
+    }
+    char mqtt_host[64];
+    size_t len = sizeof(mqtt_host);
+    esp_err_t err = nvs_get_str(nvs_handle, "mqtt_host", mqtt_host, &len);
+    nvs_close(nvs_handle);
+    if (err != ESP_OK || dns_probe_start(netif, mqtt_host) != ESP_OK) {
+        ESP_LOGW(TAG, "Broker DNS probe not started");
+    }
+}
+
 static void event_handler(void* arg, esp_event_base_t event_base,
                                 int32_t event_id, void* event_data)
 {
     if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_START) {
-        set_led_color(&LED_COLOR_BLUE);
+        led_engine_set_base(&LED_COLOR_BLUE);
         esp_wifi_connect();
+    } else if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_CONNECTED) {
+        boot_profile_mark(BOOT_PHASE_WIFI_CONNECTED);
     } else if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_DISCONNECTED) {
         ESP_LOGI(TAG, "Disconnected from Wi-Fi, trying to reconnect...");
         s_connection_status = STATUS_CONNECT_FAILED;
-        set_led_color(&LED_COLOR_RED);
-        esp_wifi_connect();
+        led_engine_set_base(&LED_COLOR_RED);
+        wifi_event_sta_disconnected_t* disconnected = (wifi_event_sta_disconnected_t*) event_data;
+        wifi_fast_connect_on_disconnected(disconnected->reason);
+        // Stops MQTT and schedules the next association after a backoff delay
+        conn_manager_on_wifi_down();
     } else if (event_base == IP_EVENT && event_id == IP_EVENT_STA_GOT_IP) {
+        boot_profile_mark(BOOT_PHASE_GOT_IP);
         ip_event_got_ip_t* event = (ip_event_got_ip_t*) event_data;
+        wifi_fast_connect_on_got_ip(&event->ip_info);
         ESP_LOGI(TAG, "Got IP:" IPSTR, IP2STR(&event->ip_info.ip));
+        char ip_str[16];
+        snprintf(ip_str, sizeof(ip_str), IPSTR, IP2STR(&event->ip_info.ip));
+        device_attributes_set_client(DEVICE_CLIENT_IP_ADDRESS, ip_str);
         s_connection_status = STATUS_CONNECTED;
-        set_led_color(&LED_COLOR_GREEN);
+        led_engine_set_base(&LED_COLOR_GREEN);
+        start_time_sync();
 
         // Stop the provisioning AP and webserver
         esp_wifi_set_mode(WIFI_MODE_STA);
@@ -677,27 +2218,15 @@ static void event_handler(void* arg, esp_event_base_t event_base,
             server = NULL;
         }
 
-        ESP_LOGI(TAG, "Checking internet connectivity...");
-        const struct addrinfo hints = {
-            .ai_family = AF_INET,
-            .ai_socktype = SOCK_STREAM,
-        };
-        struct addrinfo *res;
-        int err = getaddrinfo("www.google.com", "80", &hints, &res);
-        if(err != 0 || res == NULL) {
-            ESP_LOGE(TAG, "Internet connectivity check failed. DNS lookup for google.com failed.");
-            set_led_color(&LED_COLOR_RED);
-        } else {
-            ESP_LOGI(TAG, "Internet connectivity check successful.");
-            freeaddrinfo(res);
-        }
-
-        mqtt_app_start();
+        // Resolved on the probe task while MQTT connects
+        start_broker_probe(event->esp_netif);
+        conn_manager_on_ip_up();
     }
 }
 
 void app_main(void)
 {
+    boot_profile_mark(BOOT_PHASE_APP_MAIN);
     ESP_LOGI(TAG, "[APP] Startup..");
     ESP_LOGI(TAG, "[APP] Free memory: %" PRIu32 " bytes", esp_get_free_heap_size());
     ESP_LOGI(TAG, "[APP] IDF version: %s", esp_get_idf_version());
@@ -713,6 +2242,29 @@ void app_main(void)
     ESP_ERROR_CHECK(nvs_flash_init());
     ESP_ERROR_CHECK(esp_netif_init());
     ESP_ERROR_CHECK(esp_event_loop_create_default());
+    boot_profile_mark(BOOT_PHASE_NVS);
+
+    // Shared attributes cached from ThingsBoard override the compiled-in defaults
+    device_attributes_config_t attr_config = DEVICE_ATTRIBUTES_DEFAULT_CONFIG();
+    attr_config.on_change = on_shared_attribute_changed;
+    ESP_ERROR_CHECK(device_attributes_init(&attr_config));
+    ESP_ERROR_CHECK(telemetry_policy_init(device_attributes_get_bool(DEVICE_SHARED_REPORT_BY_EXCEPTION)));
+    for (int key = 0; key < TELEMETRY_KEY_COUNT; key++) {
+        apply_key_policy((telemetry_key_t)key);
+    }
+    if (set_upload_period(device_attributes_get_int(DEVICE_SHARED_UPLOAD_PERIOD)) != ESP_OK) {
+        s_upload_period_ms = TELEMETRY_UPLOAD_PERIOD_MS;
+    }
+    device_attributes_set_client(DEVICE_CLIENT_FW_VERSION, esp_app_get_description()->version);
+
+    // Battery installations: most wakes only sample into RTC memory and sleep again
+    int32_t duty_period_ms = device_attributes_get_int(DEVICE_SHARED_DUTY_PERIOD);
+    if (duty_period_ms >= DUTY_CYCLE_PERIOD_MIN_MS && wifi_credentials_exist()) {
+        int32_t upload_every = device_attributes_get_int(DEVICE_SHARED_DUTY_UPLOAD_EVERY);
+        s_duty_config.period_ms = duty_period_ms;
+        s_duty_config.upload_every = upload_every > 0 ? upload_every : 1;
+        duty_cycle_wake();
+    }
 
     // Initialize certificate manager for secure certificate provisioning
     cert_manager_config_t cert_config = CERT_MANAGER_DEFAULT_CONFIG();
@@ -726,7 +2278,15 @@ void app_main(void)
     }
     
     // Check if certificate exists, if not, provision development certificate
-    if (!cert_manager_is_certificate_valid()) {
+    cert_metadata_t stored_cert;
+    bool dev_cert_stored = cert_manager_get_metadata(&stored_cert) == ESP_OK &&
+                           stored_cert.source == CERT_SOURCE_DEVELOPMENT;
+    if (cert_manager_is_certificate_valid()) {
+        ESP_LOGI(TAG, "Valid certificate already exists, skipping initialization");
+    } else if (dev_cert_stored) {
+        // Rewriting the same (expired) development CA every boot only wears the flash
+        ESP_LOGW(TAG, "Stored development certificate is no longer valid, provision a production CA");
+    } else {
         ESP_LOGI(TAG, "No valid certificate found, provisioning development certificate...");
         const char* dev_cert = DEMO_CA_CERTIFICATE_PEM;
         esp_err_t store_err = cert_manager_store(dev_cert, CERT_SOURCE_DEVELOPMENT);
@@ -735,11 +2295,49 @@ void app_main(void)
         } else {
             ESP_LOGI(TAG, "Development certificate provisioned successfully");
         }
-    } else {
-        ESP_LOGI(TAG, "Valid certificate already exists, skipping initialization");
     }
 
+    cert_metadata_t cert_metadata;
+    if (cert_manager_get_metadata(&cert_metadata) == ESP_OK) {
+        device_attributes_set_client(DEVICE_CLIENT_CERT_SOURCE, cert_manager_get_source_name(cert_metadata.source));
+        ESP_LOGI(TAG, "CA certificate: %s (issuer: %s, notAfter: %llu)", cert_metadata.subject, cert_metadata.issuer,
+                 (unsigned long long)cert_metadata.expiry_time);
+    }
+
+    // Additional broker CAs, trusted next to the certificate above
+    trust_store_config_t trust_config = TRUST_STORE_DEFAULT_CONFIG();
+    esp_err_t trust_err = trust_store_init(&trust_config);
+    if (trust_err != ESP_OK) {
+        ESP_LOGW(TAG, "Trust store unavailable: %s", esp_err_to_name(trust_err));
+    }
+    boot_profile_mark(BOOT_PHASE_CERT);
+
     init_led();
+    boot_profile_mark(BOOT_PHASE_LED);
+    register_rpc_methods();
+
+    // RPC responses and attributes are queued ahead of telemetry and backfill
+    mqtt_outbound_config_t outbound_config = MQTT_OUTBOUND_DEFAULT_CONFIG();
+    outbound_config.on_ack = outbound_acked;
+    ESP_ERROR_CHECK(mqtt_outbound_init(&outbound_config));
+    int32_t gateway_children = device_attributes_get_int(DEVICE_SHARED_GATEWAY_CHILDREN);
+    if (gateway_children > 0) {
+        gateway_simulation_start(gateway_children < GATEWAY_CHILDREN_MAX ? gateway_children : GATEWAY_CHILDREN_MAX);
+    }
+
+    dns_probe_config_t probe_config = DNS_PROBE_DEFAULT_CONFIG();
+    probe_config.on_result = broker_probe_done;
+    ESP_ERROR_CHECK(dns_probe_init(&probe_config));
+
+    // One MQTT client for the life of the firmware, stopped and resumed with the link
+    conn_manager_config_t conn_config = CONN_MANAGER_DEFAULT_CONFIG();
+    conn_config.create_client = mqtt_client_create;
+    conn_config.on_resume = mqtt_client_resume;
+    conn_config.on_state = connection_state_changed;
+    if (!reconnect_backoff_from_attributes(&conn_config.backoff)) {
+        ESP_LOGW(TAG, "Using the default reconnect backoff");
+    }
+    ESP_ERROR_CHECK(conn_manager_init(&conn_config));
 
     ESP_ERROR_CHECK(esp_event_handler_register(WIFI_EVENT, ESP_EVENT_ANY_ID, &event_handler, NULL));
     ESP_ERROR_CHECK(esp_event_handler_register(IP_EVENT, IP_EVENT_STA_GOT_IP, &event_handler, NULL));
@@ -750,6 +2348,9 @@ void app_main(void)
         start_provisioning_server();
     } else {
         ESP_LOGI(TAG, "Wi-Fi credentials found, connecting directly");
+        if (s_duty_upload_wake) {
+            duty_cycle_upload_start();
+        }
         wifi_init_sta();
     }
 }
@@ -0,0 +1,104 @@
+#include "boot_profile.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include <stdio.h>
+
+static const char* TAG = "BOOT_PROFILE";
+
+static const char* const s_phase_names[BOOT_PHASE_COUNT] = {
+    [BOOT_PHASE_APP_MAIN] = "app_main",
+    [BOOT_PHASE_NVS] = "nvs",
+    [BOOT_PHASE_CERT] = "cert",
+    [BOOT_PHASE_LED] = "led",
+    [BOOT_PHASE_WIFI_START] = "wifi_start",
+    [BOOT_PHASE_WIFI_CONNECTED] = "wifi_connected",
+    [BOOT_PHASE_GOT_IP] = "got_ip",
+    [BOOT_PHASE_DNS] = "dns",
+    [BOOT_PHASE_MQTT_START] = "mqtt_start",
+    [BOOT_PHASE_MQTT_CONNECTED] = "mqtt_connected",
+    [BOOT_PHASE_FIRST_PUBLISH] = "first_publish",
+};
+
+// Marks come from app_main, the event loop and the MQTT task
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static int64_t s_marks_us[BOOT_PHASE_COUNT];
+static uint32_t s_marked = 0;
+
+bool boot_profile_mark(boot_phase_t phase)
+{
+    if (phase >= BOOT_PHASE_COUNT) {
+        return false;
+    }
+
+    int64_t now_us = esp_timer_get_time();
+    bool first = false;
+    portENTER_CRITICAL(&s_lock);
+    if (!(s_marked & (1U << phase))) {
+        s_marks_us[phase] = now_us;
+        s_marked |= 1U << phase;
+        first = true;
+    }
+    portEXIT_CRITICAL(&s_lock);
+    return first;
+}
+
+int64_t boot_profile_get(boot_phase_t phase)
+{
+    if (phase >= BOOT_PHASE_COUNT) {
+        return -1;
+    }
+
+    portENTER_CRITICAL(&s_lock);
+    int64_t mark_us = (s_marked & (1U << phase)) ? s_marks_us[phase] : -1;
+    portEXIT_CRITICAL(&s_lock);
+    return mark_us;
+}
+
+const char* boot_profile_phase_name(boot_phase_t phase)
+{
+    return phase < BOOT_PHASE_COUNT ? s_phase_names[phase] : "unknown";
+}
+
+size_t boot_profile_serialize(char* buf, size_t size)
+{
+    if (!buf || size < 2) {
+        return 0;
+    }
+
+    size_t len = 0;
+    buf[len++] = '{';
+    for (int phase = 0; phase < BOOT_PHASE_COUNT; phase++) {
+        int64_t mark_us = boot_profile_get(phase);
+        if (mark_us < 0) {
+            continue;
+        }
+        int n = snprintf(buf + len, size - len, "%s\"boot_%s_ms\":%lu", len > 1 ? "," : "", s_phase_names[phase],
+                         (unsigned long)(mark_us / 1000));
+        if (n < 0 || (size_t)n >= size - len) {
+            return 0;
+        }
+        len += (size_t)n;
+    }
+    if (len == 1 || len + 2 > size) {
+        return 0;
+    }
+    buf[len++] = '}';
+    buf[len] = '\0';
+    return len;
+}
+
+void boot_profile_log(void)
+{
+    int64_t previous_us = 0;
+    for (int phase = 0; phase < BOOT_PHASE_COUNT; phase++) {
+        int64_t mark_us = boot_profile_get(phase);
+        if (mark_us < 0) {
+            continue;
+        }
+        // Phases reached out of order show a negative step
+        ESP_LOGI(TAG, "%-15s at %6lu ms (%+ld ms)", s_phase_names[phase], (unsigned long)(mark_us / 1000),
+                 (long)((mark_us - previous_us) / 1000));
+        previous_us = mark_us;
+    }
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * @file boot_profile.h
+ * @brief Boot phase timeline from power-on to the first acknowledged telemetry
+ *
+ * Each phase is stamped with esp_timer_get_time() the first time it is
+ * reached; later occurrences (Wi-Fi or MQTT reconnects) are ignored, so the
+ * timeline describes the cold start only. esp_timer starts shortly before
+ * app_main, so bootloader time is not included.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Boot phases in the order they are normally reached
+ */
+typedef enum {
+    BOOT_PHASE_APP_MAIN = 0,        /**< app_main entered */
+    BOOT_PHASE_NVS,                 /**< NVS, netif and event loop initialized */
+    BOOT_PHASE_CERT,                /**< Certificate manager initialized and certificate validated */
+    BOOT_PHASE_LED,                 /**< LED engine running */
+    BOOT_PHASE_WIFI_START,          /**< Wi-Fi station started */
+    BOOT_PHASE_WIFI_CONNECTED,      /**< Associated with the access point */
+    BOOT_PHASE_GOT_IP,              /**< DHCP lease obtained */
+    BOOT_PHASE_DNS,                 /**< Broker DNS probe done (runs alongside the MQTT connect) */
+    BOOT_PHASE_MQTT_START,          /**< MQTT client started */
+    BOOT_PHASE_MQTT_CONNECTED,      /**< MQTT session up (TCP, TLS and CONNACK) */
+    BOOT_PHASE_FIRST_PUBLISH,       /**< First telemetry publish acknowledged */
+    BOOT_PHASE_COUNT
+} boot_phase_t;
+
+/**
+ * @brief Stamp a phase (only its first occurrence is kept; callable from any task)
+ *
+ * @param phase Phase reached
+ * @return true if this call stamped the phase
+ */
+bool boot_profile_mark(boot_phase_t phase);
+
+/**
+ * @brief Time a phase was reached
+ *
+ * @param phase Phase
+ * @return int64_t esp_timer time in microseconds, -1 if not reached yet
+ */
+int64_t boot_profile_get(boot_phase_t phase);
+
+/**
+ * @brief Phase name as used in logs and telemetry keys
+ */
+const char* boot_profile_phase_name(boot_phase_t phase);
+
+/**
+ * @brief Render the timeline as a flat telemetry object
+ *
+ * Keys are boot_<phase>_ms (time since esp_timer start) for every phase
+ * reached.
+ *
+ * @param buf Output buffer
+ * @param size Size of the output buffer
+ * @return size_t Payload length, 0 if no phase was reached or the buffer is too small
+ */
+size_t boot_profile_serialize(char* buf, size_t size);
+
+/**
+ * @brief Log the timeline with the time spent in each phase
+ */
+void boot_profile_log(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -1,10 +1,19 @@
 #include "certificate_manager.h"
 #include "ca_certificate.h"
+#include "trust_store.h"
+#include "pem_decoder.h"
 #include "esp_log.h"
 #include "nvs_flash.h"
 #include "nvs.h"
 #include "esp_crc.h"
 #include "esp_timer.h"
+#include "esp_partition.h"
+#include "freertos/FreeRTOS.h"
+#include "mbedtls/ssl.h"
+#include "mbedtls/sha256.h"
+#include "mbedtls/platform.h"
+#include <stddef.h>
+#include <stdlib.h>
 #include <string.h>
 #include <time.h>
 
@@ -14,13 +23,92 @@ static const char* TAG = "CERT_MANAGER";
 static cert_manager_config_t s_config = {0};
 static bool s_initialized = false;
 
+// RAM copy of the metadata blob; NVS is read once and written through by store
+static cert_metadata_t s_metadata;
+static esp_err_t s_metadata_err = ESP_OK;
+static bool s_metadata_cached = false;
+
 // NVS keys
-#define NVS_KEY_PRIMARY_CERT    "primary_cert"
+#define NVS_KEY_PRIMARY_CERT    "primary_cert"  // PEM written by older firmware, migrated to flash
 #define NVS_KEY_BACKUP_CERT     "backup_cert"
 #define NVS_KEY_METADATA        "metadata"
 
-// Maximum certificate size (8KB should be sufficient for most certificates)
-#define MAX_CERT_SIZE           8192
+// Maximum PEM input size (room for a chain with several intermediates)
+#define MAX_CERT_SIZE           16384
+
+// Wall clock considered set (2024-01-01); expiry is not checked before SNTP sync
+#define CERT_CLOCK_VALID_MIN    1704067200
+
+/**
+ * @brief Certificate slot header, written after the DER data as the commit marker
+ *
+ * The partition holds two slots. A slot carries a certificate chain as
+ * concatenated DER certificates right after its header; the valid slot with
+ * the highest sequence number is the primary, the other one the backup.
+ */
+typedef struct {
+    uint32_t magic;                 /**< CERT_SLOT_MAGIC */
+    uint32_t seq;                   /**< Store sequence number */
+    uint32_t der_len;               /**< DER bytes following the header */
+    uint32_t der_crc;               /**< CRC32 of the DER bytes */
+    uint16_t cert_count;            /**< Certificates in the chain */
+    uint8_t source;                 /**< cert_source_t */
+    uint8_t reserved;
+    uint32_t header_crc;            /**< CRC32 of the fields above */
+} cert_slot_header_t;
+
+#define CERT_SLOT_MAGIC         0x43455254      // "CERT"
+#define CERT_SLOT_COUNT         2
+#define CERT_SLOT_NONE          (-1)
+
+// Flash slots, mapped once at init so parsed chains point straight into flash
+static const esp_partition_t* s_partition = NULL;
+static esp_partition_mmap_handle_t s_mmap_handle;
+static const uint8_t* s_mapped = NULL;
+static size_t s_slot_size = 0;
+static int s_primary_slot = CERT_SLOT_NONE;
+static int s_backup_slot = CERT_SLOT_NONE;
+
+// Slots whose DER checksum already matched their header this boot
+static uint8_t s_verified_slots = 0;
+
+// Parsed CA chain for the TLS layer; the replaced chain is kept until the next replacement
+static portMUX_TYPE s_chain_lock = portMUX_INITIALIZER_UNLOCKED;
+static mbedtls_x509_crt* s_ca_chain = NULL;
+static mbedtls_x509_crt* s_retired_chain = NULL;
+static int s_chain_slot = CERT_SLOT_NONE;      // Slot s_ca_chain points into (none for the fallback)
+static uint32_t s_chain_generation = 0;         // Trust store generation the anchors in s_ca_chain come from
+static size_t s_chain_primary_count = 0;        // Certificates of s_ca_chain ahead of the trust store anchors
+
+// Streaming rotation
+#define ROTATION_FLUSH_SIZE     64              // DER bytes buffered per flash write
+
+/**
+ * @brief Streaming rotation state; the PEM is decoded into the staging slot as it arrives
+ */
+typedef struct {
+    bool active;
+    cert_source_t source;
+    int slot;                       /**< Staging slot */
+    size_t pem_len;                 /**< Announced PEM length, 0 if unknown */
+    size_t received;                /**< PEM bytes received */
+    bool check_sha256;
+    uint8_t sha256[CERT_FINGERPRINT_SIZE]; /**< Expected SHA-256 of the PEM */
+    mbedtls_sha256_context sha_ctx;
+    
+    pem_decoder_t pem;
+    
+    // DER output
+    uint8_t pending[ROTATION_FLUSH_SIZE];
+    size_t pending_len;
+    size_t erased;                  /**< Slot bytes erased so far (erased sector by sector as data arrives) */
+    uint32_t der_len;               /**< DER bytes written to the slot */
+    uint32_t der_crc;
+    uint32_t cert_start;            /**< DER offset of the certificate being decoded */
+    uint16_t cert_count;
+} cert_rotation_t;
+
+static cert_rotation_t s_rotation;
 
 /**
  * @brief Certificate source name mapping
@@ -33,31 +121,21 @@ static const char* cert_source_names[] = {
     "NONE"
 };
 
-/**
- * @brief Calculate CRC32 checksum for certificate integrity
- */
-static uint32_t calculate_cert_checksum(const char* cert_pem)
-{
-    if (!cert_pem) return 0;
-    return esp_crc32_le(0, (const uint8_t*)cert_pem, strlen(cert_pem));
-}
-
 /**
  * @brief Validate PEM certificate format
  */
-static bool is_valid_pem_format(const char* cert_pem)
+static bool is_valid_pem_format(const char* cert_pem, size_t len)
 {
     if (!cert_pem) return false;
     
-    // Check for PEM header and footer
-    if (!strstr(cert_pem, "-----BEGIN CERTIFICATE-----") ||
-        !strstr(cert_pem, "-----END CERTIFICATE-----")) {
+    // Basic length check
+    if (len < 200 || len > MAX_CERT_SIZE) {
         return false;
     }
     
-    // Basic length check
-    size_t len = strlen(cert_pem);
-    if (len < 200 || len > MAX_CERT_SIZE) {
+    // Check for PEM header and footer (the footer search starts after the header)
+    const char* header = strstr(cert_pem, "-----BEGIN CERTIFICATE-----");
+    if (!header || !strstr(header, "-----END CERTIFICATE-----")) {
         return false;
     }
     
@@ -65,15 +143,99 @@ static bool is_valid_pem_format(const char* cert_pem)
 }
 
 /**
- * @brief Extract certificate expiry time (simplified implementation)
- * Note: This is a basic implementation. In production, use a proper
- * certificate parsing library like mbedTLS X.509 parser.
+ * @brief Convert an X.509 time (UTC) to Unix time in seconds
+ */
+static int64_t x509_time_to_unix(const mbedtls_x509_time* t)
+{
+    // Days from civil date (proleptic Gregorian calendar)
+    int year = t->year - (t->mon <= 2);
+    int era = (year >= 0 ? year : year - 399) / 400;
+    int year_of_era = year - era * 400;
+    int day_of_year = (153 * (t->mon + (t->mon > 2 ? -3 : 9)) + 2) / 5 + t->day - 1;
+    int day_of_era = year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + day_of_year;
+    int64_t days = (int64_t)era * 146097 + day_of_era - 719468;
+    return days * 86400 + t->hour * 3600 + t->min * 60 + t->sec;
+}
+
+/**
+ * @brief Fill in the X.509 fields of the metadata from a parsed certificate
+ */
+static void fill_cert_info(const mbedtls_x509_crt* crt, cert_metadata_t* metadata)
+{
+    metadata->expiry_time = (uint64_t)x509_time_to_unix(&crt->valid_to);
+    // Names that do not fit are truncated, which is fine for display
+    if (mbedtls_x509_dn_gets(metadata->subject, sizeof(metadata->subject), &crt->subject) < 0) {
+        metadata->subject[sizeof(metadata->subject) - 1] = '\0';
+    }
+    if (mbedtls_x509_dn_gets(metadata->issuer, sizeof(metadata->issuer), &crt->issuer) < 0) {
+        metadata->issuer[sizeof(metadata->issuer) - 1] = '\0';
+    }
+    mbedtls_sha256(crt->raw.p, crt->raw.len, metadata->fingerprint, 0);
+}
+
+/**
+ * @brief Parse a PEM chain (the certificates are copied to the heap)
+ *
+ * @param cert_pem PEM certificate(s), NUL-terminated
+ * @param len Length without the terminator
  */
-static uint64_t extract_cert_expiry(const char* cert_pem)
+static esp_err_t parse_pem_chain(const char* cert_pem, size_t len, mbedtls_x509_crt* chain)
 {
-    // TODO: Implement proper certificate parsing
-    // For now, return a future timestamp (certificate expires in 1 year)
-    return esp_timer_get_time() + (365ULL * 24 * 60 * 60 * 1000000); // 1 year in microseconds
+    mbedtls_x509_crt_init(chain);
+    int ret = mbedtls_x509_crt_parse(chain, (const unsigned char*)cert_pem, len + 1);
+    if (ret < 0) {
+        ESP_LOGE(TAG, "X.509 parsing failed: -0x%04x", -ret);
+        mbedtls_x509_crt_free(chain);
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (ret > 0) {
+        ESP_LOGW(TAG, "%d certificate(s) in the PEM could not be parsed", ret);
+    }
+    return ESP_OK;
+}
+
+/**
+ * @brief Check the notAfter of the first certificate against the wall clock
+ */
+static cert_validation_result_t check_expiry(const mbedtls_x509_crt* crt)
+{
+    time_t now = time(NULL);
+    if (now < CERT_CLOCK_VALID_MIN) {
+        return CERT_VALID;
+    }
+    int64_t expiry_time = x509_time_to_unix(&crt->valid_to);
+    if ((int64_t)now > expiry_time) {
+        ESP_LOGW(TAG, "Certificate has expired (current: %lld, expiry: %lld)", (long long)now, (long long)expiry_time);
+        return CERT_EXPIRED;
+    }
+    return CERT_VALID;
+}
+
+static void free_chain(mbedtls_x509_crt* chain)
+{
+    if (chain) {
+        mbedtls_x509_crt_free(chain);
+        free(chain);
+    }
+}
+
+/**
+ * @brief Drop the parsed CA chain, keeping it allocated until the next replacement
+ */
+static void retire_ca_chain(void)
+{
+    mbedtls_x509_crt* freed = NULL;
+    
+    portENTER_CRITICAL(&s_chain_lock);
+    if (s_ca_chain) {
+        freed = s_retired_chain;
+        s_retired_chain = s_ca_chain;
+        s_ca_chain = NULL;
+        s_chain_slot = CERT_SLOT_NONE;
+    }
+    portEXIT_CRITICAL(&s_chain_lock);
+    
+    free_chain(freed);
 }
 
 /**
@@ -91,9 +253,14 @@ static esp_err_t store_cert_metadata(const cert_metadata_t* metadata)
     err = nvs_set_blob(nvs_handle, NVS_KEY_METADATA, metadata, sizeof(cert_metadata_t));
     if (err != ESP_OK) {
         ESP_LOGE(TAG, "Failed to store certificate metadata: %s", esp_err_to_name(err));
+        // NVS content is unknown now, re-read on next use
+        s_metadata_cached = false;
     } else {
         ESP_LOGI(TAG, "Certificate metadata stored successfully");
         nvs_commit(nvs_handle);
+        s_metadata = *metadata;
+        s_metadata_err = ESP_OK;
+        s_metadata_cached = true;
     }
     
     nvs_close(nvs_handle);
@@ -101,77 +268,419 @@ static esp_err_t store_cert_metadata(const cert_metadata_t* metadata)
 }
 
 /**
- * @brief Load certificate metadata from NVS
+ * @brief Load certificate metadata (from NVS on first use, then from the RAM cache)
  */
 static esp_err_t load_cert_metadata(cert_metadata_t* metadata)
 {
-    nvs_handle_t nvs_handle;
-    esp_err_t err = nvs_open(s_config.nvs_namespace, NVS_READONLY, &nvs_handle);
-    if (err != ESP_OK) {
-        return err;
+    if (!s_metadata_cached) {
+        nvs_handle_t nvs_handle;
+        esp_err_t err = nvs_open(s_config.nvs_namespace, NVS_READONLY, &nvs_handle);
+        if (err == ESP_OK) {
+            size_t required_size = sizeof(cert_metadata_t);
+            err = nvs_get_blob(nvs_handle, NVS_KEY_METADATA, &s_metadata, &required_size);
+            nvs_close(nvs_handle);
+            // Blobs written by older firmware lack the X.509 fields
+            if (err == ESP_ERR_NVS_INVALID_LENGTH || (err == ESP_OK && required_size != sizeof(cert_metadata_t))) {
+                ESP_LOGW(TAG, "Ignoring certificate metadata in an outdated format");
+                err = ESP_ERR_NVS_NOT_FOUND;
+            }
+        }
+        // A missing namespace or key is cached too, other errors are retried
+        if (err == ESP_OK || err == ESP_ERR_NVS_NOT_FOUND) {
+            s_metadata_cached = true;
+            s_metadata_err = err;
+        } else {
+            return err;
+        }
     }
     
-    size_t required_size = sizeof(cert_metadata_t);
-    err = nvs_get_blob(nvs_handle, NVS_KEY_METADATA, metadata, &required_size);
-    nvs_close(nvs_handle);
+    if (s_metadata_err == ESP_OK) {
+        *metadata = s_metadata;
+    }
+    return s_metadata_err;
+}
+
+static const cert_slot_header_t* slot_header(int slot)
+{
+    return (const cert_slot_header_t*)(s_mapped + (size_t)slot * s_slot_size);
+}
+
+static const uint8_t* slot_der(int slot)
+{
+    return s_mapped + (size_t)slot * s_slot_size + sizeof(cert_slot_header_t);
+}
+
+static bool slot_header_valid(const cert_slot_header_t* header)
+{
+    return header->magic == CERT_SLOT_MAGIC &&
+           header->header_crc == esp_crc32_le(0, (const uint8_t*)header, offsetof(cert_slot_header_t, header_crc)) &&
+           header->cert_count > 0 &&
+           header->der_len > 0 && header->der_len <= s_slot_size - sizeof(cert_slot_header_t);
+}
+
+/**
+ * @brief Find the primary (newest) and backup slots from the slot headers
+ */
+static void scan_slots(void)
+{
+    s_primary_slot = CERT_SLOT_NONE;
+    s_backup_slot = CERT_SLOT_NONE;
+    for (int slot = 0; slot < CERT_SLOT_COUNT; slot++) {
+        if (!slot_header_valid(slot_header(slot))) {
+            continue;
+        }
+        if (s_primary_slot == CERT_SLOT_NONE || slot_header(slot)->seq > slot_header(s_primary_slot)->seq) {
+            s_backup_slot = s_primary_slot;
+            s_primary_slot = slot;
+        } else {
+            s_backup_slot = slot;
+        }
+    }
+}
+
+/**
+ * @brief Length of the DER element at p (tag + length + content), 0 if malformed
+ */
+static size_t der_element_length(const uint8_t* p, size_t avail)
+{
+    if (avail < 2 || p[0] != 0x30) {
+        return 0;
+    }
+    size_t len;
+    size_t header_len;
+    if (p[1] < 0x80) {
+        len = p[1];
+        header_len = 2;
+    } else {
+        size_t octets = p[1] & 0x7f;
+        if (octets == 0 || octets > 3 || avail < 2 + octets) {
+            return 0;
+        }
+        len = 0;
+        for (size_t i = 0; i < octets; i++) {
+            len = (len << 8) | p[2 + i];
+        }
+        header_len = 2 + octets;
+    }
+    return header_len + len <= avail ? header_len + len : 0;
+}
+
+/**
+ * @brief Parse a slot's chain in place (no copy, the chain references the mapped flash)
+ */
+static esp_err_t parse_der_chain(int slot, uint32_t der_len, uint16_t cert_count, mbedtls_x509_crt* chain)
+{
+    const uint8_t* der = slot_der(slot);
+    size_t offset = 0;
+    
+    mbedtls_x509_crt_init(chain);
+    for (uint16_t i = 0; i < cert_count; i++) {
+        size_t len = der_element_length(der + offset, der_len - offset);
+        int ret = len > 0 ? mbedtls_x509_crt_parse_der_nocopy(chain, der + offset, len) : -1;
+        if (ret != 0) {
+            ESP_LOGE(TAG, "Certificate %u of slot %d could not be parsed: -0x%04x", i, slot, -ret);
+            mbedtls_x509_crt_free(chain);
+            return ESP_ERR_INVALID_ARG;
+        }
+        offset += len;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t parse_slot_chain(int slot, mbedtls_x509_crt* chain)
+{
+    return parse_der_chain(slot, slot_header(slot)->der_len, slot_header(slot)->cert_count, chain);
+}
+
+/**
+ * @brief Validate a slot and parse its chain (checksum skipped if already verified this boot)
+ */
+static cert_validation_result_t validate_slot(int slot, mbedtls_x509_crt* chain)
+{
+    if (slot == CERT_SLOT_NONE) {
+        return CERT_NOT_FOUND;
+    }
+    
+    const cert_slot_header_t* header = slot_header(slot);
+    if (s_config.require_integrity_check && !(s_verified_slots & (1 << slot))) {
+        if (esp_crc32_le(0, slot_der(slot), header->der_len) != header->der_crc) {
+            ESP_LOGW(TAG, "Certificate integrity check failed (slot %d)", slot);
+            return CERT_INTEGRITY_FAILED;
+        }
+        s_verified_slots |= 1 << slot;
+    }
+    
+    if (parse_slot_chain(slot, chain) != ESP_OK) {
+        return CERT_INVALID_FORMAT;
+    }
+    cert_validation_result_t result = check_expiry(chain);
+    if (result != CERT_VALID) {
+        mbedtls_x509_crt_free(chain);
+    }
+    return result;
+}
+
+/**
+ * @brief Pick the best available certificate and parse it
+ *
+ * @param chain Parsed chain (output, initialized only on CERT_VALID)
+ * @param ret_slot Slot the chain points into, CERT_SLOT_NONE for the development fallback
+ * @param allow_fallback Fall back to the compiled-in development certificate
+ */
+static cert_validation_result_t select_certificate(mbedtls_x509_crt* chain, int* ret_slot, bool allow_fallback)
+{
+    cert_validation_result_t result = validate_slot(s_primary_slot, chain);
+    if (result == CERT_VALID) {
+        *ret_slot = s_primary_slot;
+        return CERT_VALID;
+    }
+    if (s_primary_slot != CERT_SLOT_NONE) {
+        ESP_LOGW(TAG, "Primary certificate validation failed: %d", result);
+    }
+    
+    result = validate_slot(s_backup_slot, chain);
+    if (result == CERT_VALID) {
+        ESP_LOGI(TAG, "Using backup certificate");
+        *ret_slot = s_backup_slot;
+        return CERT_VALID;
+    }
+    if (s_backup_slot != CERT_SLOT_NONE) {
+        ESP_LOGW(TAG, "Backup certificate validation failed: %d", result);
+    }
+    
+    // Fallback to development certificate if allowed
+    if (allow_fallback && s_config.allow_development_cert &&
+        parse_pem_chain(DEMO_CA_CERTIFICATE_PEM, strlen(DEMO_CA_CERTIFICATE_PEM), chain) == ESP_OK) {
+        ESP_LOGW(TAG, "Using development certificate fallback");
+        *ret_slot = CERT_SLOT_NONE;
+        return CERT_VALID;
+    }
     
+    ESP_LOGE(TAG, "No valid certificate found");
+    return CERT_NOT_FOUND;
+}
+
+/**
+ * @brief Slot a new chain goes into: the one the active chain does not point into
+ */
+static int staging_slot(void)
+{
+    portENTER_CRITICAL(&s_chain_lock);
+    int active_slot = s_chain_slot;
+    portEXIT_CRITICAL(&s_chain_lock);
+    int keep_slot = active_slot != CERT_SLOT_NONE ? active_slot : s_primary_slot;
+    return keep_slot != CERT_SLOT_NONE ? (keep_slot + 1) % CERT_SLOT_COUNT : 0;
+}
+
+static uint32_t next_slot_seq(void)
+{
+    uint32_t seq = 1;
+    for (int slot = 0; slot < CERT_SLOT_COUNT; slot++) {
+        if (slot_header_valid(slot_header(slot)) && slot_header(slot)->seq >= seq) {
+            seq = slot_header(slot)->seq + 1;
+        }
+    }
+    return seq;
+}
+
+/**
+ * @brief Write a slot header, which commits the DER data written before it
+ */
+static esp_err_t write_slot_header(int slot, cert_slot_header_t* header)
+{
+    header->header_crc = esp_crc32_le(0, (const uint8_t*)header, offsetof(cert_slot_header_t, header_crc));
+    esp_err_t err = esp_partition_write(s_partition, (size_t)slot * s_slot_size, header, sizeof(*header));
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to write certificate slot header: %s", esp_err_to_name(err));
+    }
     return err;
 }
 
 /**
- * @brief Store certificate in NVS with key
+ * @brief Write a parsed chain as DER into a slot; the header is written last
  */
-static esp_err_t store_cert_in_nvs(const char* key, const char* cert_pem)
+static esp_err_t write_slot(int slot, const mbedtls_x509_crt* chain, cert_source_t source, uint32_t seq,
+                            uint32_t* ret_crc, uint32_t* ret_len)
 {
-    nvs_handle_t nvs_handle;
-    esp_err_t err = nvs_open(s_config.nvs_namespace, NVS_READWRITE, &nvs_handle);
+    size_t base = (size_t)slot * s_slot_size;
+    esp_err_t err = esp_partition_erase_range(s_partition, base, s_slot_size);
     if (err != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to open NVS for certificate storage: %s", esp_err_to_name(err));
+        ESP_LOGE(TAG, "Failed to erase certificate slot %d: %s", slot, esp_err_to_name(err));
         return err;
     }
     
-    err = nvs_set_str(nvs_handle, key, cert_pem);
+    cert_slot_header_t header = {
+        .magic = CERT_SLOT_MAGIC,
+        .seq = seq,
+        .source = (uint8_t)source,
+    };
+    for (const mbedtls_x509_crt* crt = chain; crt && crt->raw.len > 0; crt = crt->next) {
+        if (header.der_len + crt->raw.len > s_slot_size - sizeof(header)) {
+            ESP_LOGE(TAG, "Certificate chain exceeds the %u byte slot", (unsigned)(s_slot_size - sizeof(header)));
+            return ESP_ERR_INVALID_SIZE;
+        }
+        err = esp_partition_write(s_partition, base + sizeof(header) + header.der_len, crt->raw.p, crt->raw.len);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to write certificate: %s", esp_err_to_name(err));
+            return err;
+        }
+        header.der_crc = esp_crc32_le(header.der_crc, crt->raw.p, crt->raw.len);
+        header.der_len += crt->raw.len;
+        header.cert_count++;
+    }
+    
+    err = write_slot_header(slot, &header);
     if (err != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to store certificate: %s", esp_err_to_name(err));
-    } else {
-        ESP_LOGI(TAG, "Certificate stored successfully with key: %s", key);
-        nvs_commit(nvs_handle);
+        return err;
     }
     
-    nvs_close(nvs_handle);
-    return err;
+    *ret_crc = header.der_crc;
+    *ret_len = header.der_len;
+    return ESP_OK;
 }
 
 /**
- * @brief Load certificate from NVS with key
+ * @brief Move a PEM certificate stored in NVS by older firmware to the flash slots
  */
-static esp_err_t load_cert_from_nvs(const char* key, char* cert_buffer, size_t buffer_size, size_t* actual_size)
+static void migrate_nvs_certificate(void)
 {
     nvs_handle_t nvs_handle;
-    esp_err_t err = nvs_open(s_config.nvs_namespace, NVS_READONLY, &nvs_handle);
-    if (err != ESP_OK) {
-        return err;
+    if (nvs_open(s_config.nvs_namespace, NVS_READWRITE, &nvs_handle) != ESP_OK) {
+        return;
     }
     
     size_t required_size = 0;
-    err = nvs_get_str(nvs_handle, key, NULL, &required_size);
-    if (err != ESP_OK) {
-        nvs_close(nvs_handle);
-        return err;
+    if (nvs_get_str(nvs_handle, NVS_KEY_PRIMARY_CERT, NULL, &required_size) == ESP_OK) {
+        char* cert_pem = malloc(required_size);
+        if (cert_pem && nvs_get_str(nvs_handle, NVS_KEY_PRIMARY_CERT, cert_pem, &required_size) == ESP_OK) {
+            cert_metadata_t metadata;
+            cert_source_t source = load_cert_metadata(&metadata) == ESP_OK ? metadata.source : CERT_SOURCE_NONE;
+            if (cert_manager_store(cert_pem, source) == ESP_OK) {
+                ESP_LOGI(TAG, "Migrated certificate from NVS to the '%s' partition", s_config.partition_label);
+            }
+        }
+        free(cert_pem);
     }
     
-    if (required_size > buffer_size) {
-        nvs_close(nvs_handle);
+    // The PEM copies are no longer read
+    nvs_erase_key(nvs_handle, NVS_KEY_PRIMARY_CERT);
+    nvs_erase_key(nvs_handle, NVS_KEY_BACKUP_CERT);
+    nvs_commit(nvs_handle);
+    nvs_close(nvs_handle);
+}
+
+/**
+ * @brief Write the buffered DER bytes of the rotation to the staging slot
+ */
+static esp_err_t rotation_flush(void)
+{
+    cert_rotation_t* r = &s_rotation;
+    if (r->pending_len == 0) {
+        return ESP_OK;
+    }
+    if (r->der_len + r->pending_len > s_slot_size - sizeof(cert_slot_header_t)) {
+        ESP_LOGE(TAG, "Certificate chain exceeds the %u byte slot", (unsigned)(s_slot_size - sizeof(cert_slot_header_t)));
         return ESP_ERR_INVALID_SIZE;
     }
     
-    err = nvs_get_str(nvs_handle, key, cert_buffer, &required_size);
-    if (actual_size) {
-        *actual_size = required_size;
+    size_t base = (size_t)r->slot * s_slot_size;
+    size_t end = sizeof(cert_slot_header_t) + r->der_len + r->pending_len;
+    esp_err_t err = ESP_OK;
+    while (err == ESP_OK && end > r->erased) {
+        err = esp_partition_erase_range(s_partition, base + r->erased, s_partition->erase_size);
+        r->erased += s_partition->erase_size;
     }
+    if (err == ESP_OK) {
+        err = esp_partition_write(s_partition, base + sizeof(cert_slot_header_t) + r->der_len, r->pending,
+                                  r->pending_len);
+    }
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to write certificate: %s", esp_err_to_name(err));
+        return err;
+    }
+    r->der_crc = esp_crc32_le(r->der_crc, r->pending, r->pending_len);
+    r->der_len += r->pending_len;
+    r->pending_len = 0;
+    return ESP_OK;
+}
+
+/**
+ * @brief Close the certificate the PEM decoder just finished
+ */
+static esp_err_t rotation_cert_end(void)
+{
+    cert_rotation_t* r = &s_rotation;
+    esp_err_t err = rotation_flush();
+    if (err != ESP_OK) {
+        return err;
+    }
+    // The decoded block must be exactly one DER element; X.509 parsing follows at the end
+    size_t len = r->der_len - r->cert_start;
+    if (len == 0 || der_element_length(slot_der(r->slot) + r->cert_start, len) != len) {
+        ESP_LOGE(TAG, "Certificate %u is not valid DER", r->cert_count);
+        return ESP_ERR_INVALID_ARG;
+    }
+    r->cert_count++;
+    return ESP_OK;
+}
+
+/**
+ * @brief Feed one PEM character to the decoder
+ */
+static esp_err_t rotation_decode(char c)
+{
+    cert_rotation_t* r = &s_rotation;
+    uint8_t byte;
+    switch (pem_decoder_feed(&r->pem, c, &byte)) {
+    case PEM_DECODER_BYTE:
+        r->pending[r->pending_len++] = byte;
+        return r->pending_len == sizeof(r->pending) ? rotation_flush() : ESP_OK;
+    case PEM_DECODER_BEGIN:
+        r->cert_start = r->der_len + r->pending_len;
+        return ESP_OK;
+    case PEM_DECODER_END:
+        return rotation_cert_end();
+    case PEM_DECODER_ERROR:
+        return ESP_ERR_INVALID_ARG;
+    default:
+        return ESP_OK;
+    }
+}
+
+/**
+ * @brief Check the received PEM and parse the staged chain in place
+ */
+static cert_validation_result_t validate_staged_chain(cert_metadata_t* metadata)
+{
+    cert_rotation_t* r = &s_rotation;
     
-    nvs_close(nvs_handle);
-    return err;
+    // The last line may lack a line break
+    esp_err_t err = rotation_decode('\n');
+    uint8_t digest[CERT_FINGERPRINT_SIZE];
+    mbedtls_sha256_finish(&r->sha_ctx, digest);
+    if (err != ESP_OK || r->pem.in_cert || r->cert_count == 0) {
+        ESP_LOGE(TAG, "Rotated certificate is not a complete PEM chain");
+        return CERT_INVALID_FORMAT;
+    }
+    if (r->pem_len > 0 && r->received != r->pem_len) {
+        ESP_LOGE(TAG, "Rotated certificate truncated (%u of %u bytes)", (unsigned)r->received, (unsigned)r->pem_len);
+        return CERT_INVALID_FORMAT;
+    }
+    if (r->check_sha256 && memcmp(digest, r->sha256, sizeof(digest)) != 0) {
+        ESP_LOGE(TAG, "Rotated certificate SHA-256 mismatch");
+        return CERT_INTEGRITY_FAILED;
+    }
+    
+    mbedtls_x509_crt chain;
+    if (parse_der_chain(r->slot, r->der_len, r->cert_count, &chain) != ESP_OK) {
+        return CERT_INVALID_FORMAT;
+    }
+    cert_validation_result_t result = check_expiry(&chain);
+    if (result == CERT_VALID) {
+        fill_cert_info(&chain, metadata);
+    }
+    mbedtls_x509_crt_free(&chain);
+    return result;
 }
 
 // Public API implementation
@@ -183,19 +692,50 @@ esp_err_t cert_manager_init(const cert_manager_config_t* config)
         return ESP_OK;
     }
     
-    if (!config) {
+    if (!config || !config->partition_label) {
         ESP_LOGE(TAG, "Invalid configuration");
         return ESP_ERR_INVALID_ARG;
     }
     
+    s_partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY,
+                                           config->partition_label);
+    if (!s_partition) {
+        ESP_LOGE(TAG, "Partition '%s' not found", config->partition_label);
+        return ESP_ERR_NOT_FOUND;
+    }
+    
+    s_slot_size = s_partition->size / CERT_SLOT_COUNT;
+    if (s_slot_size < 2 * s_partition->erase_size || s_slot_size % s_partition->erase_size != 0) {
+        ESP_LOGE(TAG, "Partition '%s' too small (%lu bytes)", config->partition_label,
+                 (unsigned long)s_partition->size);
+        return ESP_ERR_INVALID_SIZE;
+    }
+    
+    const void* mapped = NULL;
+    esp_err_t err = esp_partition_mmap(s_partition, 0, s_partition->size, ESP_PARTITION_MMAP_DATA, &mapped,
+                                       &s_mmap_handle);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to map partition '%s': %s", config->partition_label, esp_err_to_name(err));
+        return err;
+    }
+    s_mapped = mapped;
+    
     s_config = *config;
     s_initialized = true;
+    s_verified_slots = 0;
+    scan_slots();
+    
+    if (s_primary_slot == CERT_SLOT_NONE) {
+        migrate_nvs_certificate();
+    }
     
     ESP_LOGI(TAG, "Certificate manager initialized");
     ESP_LOGI(TAG, "  - Development cert allowed: %s", s_config.allow_development_cert ? "yes" : "no");
     ESP_LOGI(TAG, "  - Integrity check required: %s", s_config.require_integrity_check ? "yes" : "no");
     ESP_LOGI(TAG, "  - Auto-rotate expired: %s", s_config.auto_rotate_expired ? "yes" : "no");
     ESP_LOGI(TAG, "  - NVS namespace: %s", s_config.nvs_namespace);
+    ESP_LOGI(TAG, "  - Partition: %s (primary slot %d, backup slot %d)", s_config.partition_label,
+             s_primary_slot, s_backup_slot);
     
     return ESP_OK;
 }
@@ -213,96 +753,91 @@ esp_err_t cert_manager_store(const char* cert_pem, cert_source_t source)
     }
     
     // Validate certificate format
-    if (!is_valid_pem_format(cert_pem)) {
+    size_t cert_len = strlen(cert_pem);
+    if (!is_valid_pem_format(cert_pem, cert_len)) {
         ESP_LOGE(TAG, "Invalid PEM certificate format");
         return ESP_ERR_INVALID_ARG;
     }
     
+    mbedtls_x509_crt chain;
+    if (parse_pem_chain(cert_pem, cert_len, &chain) != ESP_OK) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    // Same rule as rotation: an expired chain would only replace a working backup
+    if (check_expiry(&chain) != CERT_VALID) {
+        ESP_LOGE(TAG, "Refusing to store an expired certificate");
+        mbedtls_x509_crt_free(&chain);
+        return ESP_ERR_INVALID_ARG;
+    }
+    
     // Create metadata
     cert_metadata_t metadata = {
         .source = source,
-        .checksum = calculate_cert_checksum(cert_pem),
         .stored_time = esp_timer_get_time(),
-        .expiry_time = extract_cert_expiry(cert_pem),
-        .cert_size = strlen(cert_pem),
         .is_valid = true
     };
+    fill_cert_info(&chain, &metadata);
+    
+    // A streaming rotation would write into the same slot
+    if (s_rotation.active) {
+        ESP_LOGW(TAG, "Certificate stored during a streaming rotation");
+        cert_manager_rotate_abort();
+    }
+    
+    // Overwrite the slot the active chain does not point into; the other one becomes the backup
+    int target_slot = staging_slot();
+    uint32_t seq = next_slot_seq();
     
     // Store certificate and metadata
-    esp_err_t err = store_cert_in_nvs(NVS_KEY_PRIMARY_CERT, cert_pem);
+    retire_ca_chain();
+    s_verified_slots &= ~(1 << target_slot);
+    uint32_t der_crc;
+    uint32_t der_len;
+    esp_err_t err = write_slot(target_slot, &chain, source, seq, &der_crc, &der_len);
+    mbedtls_x509_crt_free(&chain);
+    scan_slots();
     if (err != ESP_OK) {
         return err;
     }
+    s_verified_slots |= 1 << target_slot;
     
+    metadata.checksum = der_crc;
+    metadata.cert_size = der_len;
     err = store_cert_metadata(&metadata);
     if (err != ESP_OK) {
         ESP_LOGW(TAG, "Failed to store metadata, but certificate stored successfully");
     }
     
-    ESP_LOGI(TAG, "Certificate stored successfully (source: %s, size: %d bytes)", 
-             cert_manager_get_source_name(source), metadata.cert_size);
+    ESP_LOGI(TAG, "Certificate stored successfully (source: %s, slot %d, %u DER bytes)",
+             cert_manager_get_source_name(source), target_slot, (unsigned)metadata.cert_size);
+    ESP_LOGI(TAG, "  - Subject: %s, issuer: %s, notAfter: %llu", metadata.subject, metadata.issuer,
+             (unsigned long long)metadata.expiry_time);
     
     return ESP_OK;
 }
 
-esp_err_t cert_manager_load(char* cert_buffer, size_t buffer_size, size_t* actual_size)
+esp_err_t cert_manager_load(const uint8_t** der, size_t* der_len)
 {
     if (!s_initialized) {
         ESP_LOGE(TAG, "Certificate manager not initialized");
         return ESP_ERR_INVALID_STATE;
     }
     
-    if (!cert_buffer || buffer_size == 0) {
-        ESP_LOGE(TAG, "Invalid buffer arguments");
+    if (!der || !der_len) {
+        ESP_LOGE(TAG, "Invalid arguments");
         return ESP_ERR_INVALID_ARG;
     }
     
-    // Try to load primary certificate
-    esp_err_t err = load_cert_from_nvs(NVS_KEY_PRIMARY_CERT, cert_buffer, buffer_size, actual_size);
-    if (err == ESP_OK) {
-        // Validate loaded certificate
-        cert_validation_result_t validation_result;
-        esp_err_t validation_err = cert_manager_validate(cert_buffer, &validation_result);
-        
-        if (validation_err == ESP_OK && validation_result == CERT_VALID) {
-            ESP_LOGI(TAG, "Primary certificate loaded and validated successfully");
-            return ESP_OK;
-        } else {
-            ESP_LOGW(TAG, "Primary certificate validation failed: %d", validation_result);
-        }
-    }
-    
-    // Try backup certificate
-    err = load_cert_from_nvs(NVS_KEY_BACKUP_CERT, cert_buffer, buffer_size, actual_size);
-    if (err == ESP_OK) {
-        // Validate loaded backup certificate
-        cert_validation_result_t validation_result;
-        esp_err_t validation_err = cert_manager_validate(cert_buffer, &validation_result);
-        
-        if (validation_err == ESP_OK && validation_result == CERT_VALID) {
-            ESP_LOGI(TAG, "Backup certificate loaded and validated successfully");
-            return ESP_OK;
-        } else {
-            ESP_LOGW(TAG, "Backup certificate validation failed: %d", validation_result);
-        }
-    }
-    
-    // Fallback to development certificate if allowed
-    if (s_config.allow_development_cert) {
-        size_t dev_cert_len = strlen(DEMO_CA_CERTIFICATE_PEM);
-        if (dev_cert_len < buffer_size) {
-            strncpy(cert_buffer, DEMO_CA_CERTIFICATE_PEM, buffer_size - 1);
-            cert_buffer[buffer_size - 1] = '\0';
-            if (actual_size) {
-                *actual_size = dev_cert_len;
-            }
-            ESP_LOGW(TAG, "Using development certificate fallback");
-            return ESP_OK;
-        }
+    mbedtls_x509_crt chain;
+    int slot;
+    if (select_certificate(&chain, &slot, false) != CERT_VALID) {
+        return ESP_ERR_NOT_FOUND;
     }
+    mbedtls_x509_crt_free(&chain);
     
-    ESP_LOGE(TAG, "No valid certificate found");
-    return ESP_ERR_NOT_FOUND;
+    *der = slot_der(slot);
+    *der_len = slot_header(slot)->der_len;
+    return ESP_OK;
 }
 
 esp_err_t cert_manager_validate(const char* cert_pem, cert_validation_result_t* result)
@@ -317,49 +852,19 @@ esp_err_t cert_manager_validate(const char* cert_pem, cert_validation_result_t*
         return ESP_ERR_INVALID_ARG;
     }
     
-    // Check PEM format
-    if (!is_valid_pem_format(cert_pem)) {
+    size_t len = strlen(cert_pem);
+    if (!is_valid_pem_format(cert_pem, len)) {
         *result = CERT_INVALID_FORMAT;
         return ESP_OK;
     }
     
-    // Check integrity if required
-    if (s_config.require_integrity_check) {
-        cert_metadata_t metadata;
-        esp_err_t err = load_cert_metadata(&metadata);
-        if (err == ESP_OK) {
-            uint32_t current_checksum = calculate_cert_checksum(cert_pem);
-            if (current_checksum != metadata.checksum) {
-                *result = CERT_INTEGRITY_FAILED;
-                ESP_LOGW(TAG, "Certificate integrity check failed");
-                return ESP_OK;
-            }
-        }
-    }
-    
-    // Check expiry using stored metadata
-    uint64_t current_time = esp_timer_get_time();
-    uint64_t expiry_time = 0;
-    
-    // Try to load expiry time from stored metadata first
-    cert_metadata_t metadata;
-    esp_err_t metadata_err = load_cert_metadata(&metadata);
-    if (metadata_err == ESP_OK) {
-        expiry_time = metadata.expiry_time;
-        ESP_LOGD(TAG, "Using stored expiry time from metadata");
-    } else {
-        // Fallback to extracting from PEM if metadata not available
-        expiry_time = extract_cert_expiry(cert_pem);
-        ESP_LOGD(TAG, "Metadata not available, extracting expiry from PEM");
-    }
-    
-    if (current_time > expiry_time) {
-        *result = CERT_EXPIRED;
-        ESP_LOGW(TAG, "Certificate has expired (current: %llu, expiry: %llu)", current_time, expiry_time);
+    mbedtls_x509_crt chain;
+    if (parse_pem_chain(cert_pem, len, &chain) != ESP_OK) {
+        *result = CERT_INVALID_FORMAT;
         return ESP_OK;
     }
-    
-    *result = CERT_VALID;
+    *result = check_expiry(&chain);
+    mbedtls_x509_crt_free(&chain);
     return ESP_OK;
 }
 
@@ -384,63 +889,305 @@ bool cert_manager_is_certificate_valid(void)
         return false;
     }
     
-    static char cert_buffer[MAX_CERT_SIZE];
-    size_t actual_size;
-    
-    esp_err_t err = cert_manager_load(cert_buffer, sizeof(cert_buffer), &actual_size);
-    if (err != ESP_OK) {
+    mbedtls_x509_crt chain;
+    int slot;
+    if (select_certificate(&chain, &slot, false) != CERT_VALID) {
         return false;
     }
-    
-    cert_validation_result_t result;
-    err = cert_manager_validate(cert_buffer, &result);
-    
-    return (err == ESP_OK && result == CERT_VALID);
+    mbedtls_x509_crt_free(&chain);
+    return true;
 }
 
 esp_err_t cert_manager_rotate(const char* new_cert_pem, cert_source_t source)
+{
+    if (!new_cert_pem) {
+        ESP_LOGE(TAG, "Invalid arguments");
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    size_t len = strlen(new_cert_pem);
+    esp_err_t err = cert_manager_rotate_begin(len, NULL, source);
+    if (err == ESP_OK) {
+        err = cert_manager_rotate_write(new_cert_pem, len);
+    }
+    if (err == ESP_OK) {
+        err = cert_manager_rotate_finish(NULL);
+    }
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Certificate rotation failed: %s", esp_err_to_name(err));
+    }
+    return err;
+}
+
+esp_err_t cert_manager_rotate_begin(size_t pem_len, const uint8_t sha256[CERT_FINGERPRINT_SIZE], cert_source_t source)
 {
     if (!s_initialized) {
         ESP_LOGE(TAG, "Certificate manager not initialized");
         return ESP_ERR_INVALID_STATE;
     }
     
-    if (!new_cert_pem || source >= CERT_SOURCE_MAX) {
+    if (source >= CERT_SOURCE_MAX) {
         ESP_LOGE(TAG, "Invalid arguments");
         return ESP_ERR_INVALID_ARG;
     }
     
-    // Validate new certificate
-    cert_validation_result_t validation_result;
-    esp_err_t err = cert_manager_validate(new_cert_pem, &validation_result);
-    if (err != ESP_OK || validation_result != CERT_VALID) {
-        ESP_LOGE(TAG, "New certificate validation failed: %d", validation_result);
+    cert_manager_rotate_abort();
+    
+    int slot = staging_slot();
+    // A chain retired earlier may point into the staging slot
+    retire_ca_chain();
+    s_verified_slots &= ~(1 << slot);
+    // Erasing the header sector invalidates the slot; the rest is erased as the chain arrives,
+    // so no single call blocks for a whole slot erase
+    esp_err_t err = esp_partition_erase_range(s_partition, (size_t)slot * s_slot_size, s_partition->erase_size);
+    // The erased slot must not be used as the backup while the new chain streams in
+    scan_slots();
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to erase certificate slot %d: %s", slot, esp_err_to_name(err));
+        return err;
+    }
+    
+    memset(&s_rotation, 0, sizeof(s_rotation));
+    s_rotation.active = true;
+    s_rotation.source = source;
+    s_rotation.slot = slot;
+    s_rotation.pem_len = pem_len;
+    pem_decoder_init(&s_rotation.pem);
+    s_rotation.erased = s_partition->erase_size;
+    if (sha256) {
+        s_rotation.check_sha256 = true;
+        memcpy(s_rotation.sha256, sha256, CERT_FINGERPRINT_SIZE);
+    }
+    mbedtls_sha256_init(&s_rotation.sha_ctx);
+    mbedtls_sha256_starts(&s_rotation.sha_ctx, 0);
+    
+    ESP_LOGI(TAG, "Certificate rotation started (source: %s, slot %d, %u PEM bytes)",
+             cert_manager_get_source_name(source), slot, (unsigned)pem_len);
+    return ESP_OK;
+}
+
+esp_err_t cert_manager_rotate_write(const char* data, size_t len)
+{
+    if (!s_rotation.active) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    if (!data) {
         return ESP_ERR_INVALID_ARG;
     }
     
-    // Backup current certificate
-    static char current_cert[MAX_CERT_SIZE];
-    size_t current_size;
-    err = load_cert_from_nvs(NVS_KEY_PRIMARY_CERT, current_cert, sizeof(current_cert), &current_size);
-    if (err == ESP_OK) {
-        err = store_cert_in_nvs(NVS_KEY_BACKUP_CERT, current_cert);
-        if (err != ESP_OK) {
-            ESP_LOGE(TAG, "Failed to back up current certificate: %s", esp_err_to_name(err));
-        } else {
-            ESP_LOGI(TAG, "Current certificate backed up");
+    esp_err_t err = ESP_OK;
+    if (s_rotation.pem_len > 0 && s_rotation.received + len > s_rotation.pem_len) {
+        ESP_LOGE(TAG, "Rotated certificate exceeds the announced %u bytes", (unsigned)s_rotation.pem_len);
+        err = ESP_ERR_INVALID_SIZE;
+    } else {
+        mbedtls_sha256_update(&s_rotation.sha_ctx, (const unsigned char*)data, len);
+        for (size_t i = 0; i < len && err == ESP_OK; i++) {
+            err = rotation_decode(data[i]);
         }
+        s_rotation.received += len;
     }
     
-    // Store new certificate
-    err = cert_manager_store(new_cert_pem, source);
     if (err != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to store new certificate");
+        cert_manager_rotate_abort();
+    }
+    return err;
+}
+
+esp_err_t cert_manager_rotate_finish(cert_validation_result_t* result)
+{
+    if (!s_rotation.active) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    cert_metadata_t metadata = {
+        .source = s_rotation.source,
+        .stored_time = esp_timer_get_time(),
+        .is_valid = true
+    };
+    cert_validation_result_t validation = validate_staged_chain(&metadata);
+    if (result) {
+        *result = validation;
+    }
+    if (validation != CERT_VALID) {
+        ESP_LOGE(TAG, "New certificate validation failed: %d", validation);
+        cert_manager_rotate_abort();
+        return validation == CERT_INTEGRITY_FAILED ? ESP_ERR_INVALID_CRC : ESP_ERR_INVALID_ARG;
+    }
+    
+    // The header is the commit point: from here the staged chain is the primary
+    cert_slot_header_t header = {
+        .magic = CERT_SLOT_MAGIC,
+        .seq = next_slot_seq(),
+        .der_len = s_rotation.der_len,
+        .der_crc = s_rotation.der_crc,
+        .cert_count = s_rotation.cert_count,
+        .source = (uint8_t)s_rotation.source,
+    };
+    int slot = s_rotation.slot;
+    esp_err_t err = write_slot_header(slot, &header);
+    if (err != ESP_OK) {
+        if (result) {
+            *result = CERT_STORAGE_ERROR;
+        }
+        cert_manager_rotate_abort();
         return err;
     }
+    mbedtls_sha256_free(&s_rotation.sha_ctx);
+    s_rotation.active = false;
+    
+    s_verified_slots |= 1 << slot;
+    scan_slots();
+    retire_ca_chain();
+    
+    metadata.checksum = header.der_crc;
+    metadata.cert_size = header.der_len;
+    if (store_cert_metadata(&metadata) != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to store metadata, but certificate rotated successfully");
+    }
+    
+    ESP_LOGI(TAG, "Certificate rotated successfully (source: %s, slot %d, %u certificate(s), %lu DER bytes)",
+             cert_manager_get_source_name(metadata.source), slot, header.cert_count, (unsigned long)header.der_len);
+    ESP_LOGI(TAG, "  - Subject: %s, issuer: %s, notAfter: %llu", metadata.subject, metadata.issuer,
+             (unsigned long long)metadata.expiry_time);
+    return ESP_OK;
+}
+
+void cert_manager_rotate_abort(void)
+{
+    if (!s_rotation.active) {
+        return;
+    }
+    mbedtls_sha256_free(&s_rotation.sha_ctx);
+    s_rotation.active = false;
+    // The staging slot has no header and stays invalid; the current certificate is untouched
+    ESP_LOGW(TAG, "Certificate rotation aborted after %u PEM bytes", (unsigned)s_rotation.received);
+}
+
+esp_err_t cert_manager_get_ca_chain(mbedtls_x509_crt** chain)
+{
+    if (!s_initialized) {
+        ESP_LOGE(TAG, "Certificate manager not initialized");
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    if (!chain) {
+        ESP_LOGE(TAG, "Invalid chain pointer");
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    uint32_t generation = trust_store_generation();
+    portENTER_CRITICAL(&s_chain_lock);
+    mbedtls_x509_crt* cached = s_ca_chain;
+    bool stale = cached && s_chain_generation != generation;
+    portEXIT_CRITICAL(&s_chain_lock);
+    if (cached && !stale) {
+        *chain = cached;
+        return ESP_OK;
+    }
+    
+    // Connections already up keep the old chain; the next handshake uses the new anchors
+    if (stale) {
+        ESP_LOGI(TAG, "Trust store changed, rebuilding CA chain");
+        retire_ca_chain();
+    }
+    
+    // Parse outside the lock
+    mbedtls_x509_crt* parsed = malloc(sizeof(mbedtls_x509_crt));
+    if (!parsed) {
+        return ESP_ERR_NO_MEM;
+    }
+    int slot = CERT_SLOT_NONE;
+    bool has_primary = select_certificate(parsed, &slot, true) == CERT_VALID;
+    if (!has_primary) {
+        // The trust store anchors alone are enough
+        mbedtls_x509_crt_init(parsed);
+    }
+    size_t primary_count = 0;
+    for (const mbedtls_x509_crt* crt = parsed; crt && crt->raw.len > 0; crt = crt->next) {
+        primary_count++;
+    }
+    size_t anchors = trust_store_append_anchors(parsed);
+    if (parsed->raw.len == 0) {
+        free_chain(parsed);
+        return ESP_ERR_NOT_FOUND;
+    }
     
-    ESP_LOGI(TAG, "Certificate rotated successfully (source: %s)", 
-             cert_manager_get_source_name(source));
+    portENTER_CRITICAL(&s_chain_lock);
+    if (!s_ca_chain) {
+        s_ca_chain = parsed;
+        s_chain_slot = slot;
+        s_chain_generation = generation;
+        s_chain_primary_count = primary_count;
+        parsed = NULL;
+    }
+    cached = s_ca_chain;
+    portEXIT_CRITICAL(&s_chain_lock);
+    
+    // Another task parsed it first
+    free_chain(parsed);
     
+    ESP_LOGI(TAG, "CA chain parsed and cached (%s, %u trust store anchor(s))",
+             !has_primary ? "no primary certificate" : slot == CERT_SLOT_NONE ? "development fallback" : "from flash",
+             (unsigned)anchors);
+    *chain = cached;
+    return ESP_OK;
+}
+
+#if defined(MBEDTLS_X509_TRUSTED_CERTIFICATE_CALLBACK)
+/**
+ * @brief mbedtls_ssl_conf_ca_cb() hook: the trusted issuers of one certificate
+ *
+ * The primary chain holds a few certificates and is compared by name; the
+ * trust store anchors are found through its subject and key ID index instead
+ * of a scan of the whole chain. The candidates reference the cached chain and
+ * the mapped flash, and mbedTLS frees them after the check.
+ */
+static int ca_candidates(void* ctx, const mbedtls_x509_crt* child, mbedtls_x509_crt** candidates)
+{
+    portENTER_CRITICAL(&s_chain_lock);
+    const mbedtls_x509_crt* crt = s_ca_chain;
+    size_t primary_count = s_chain_primary_count;
+    portEXIT_CRITICAL(&s_chain_lock);
+
+    mbedtls_x509_crt* found = mbedtls_calloc(1, sizeof(mbedtls_x509_crt));
+    if (!found) {
+        return MBEDTLS_ERR_X509_ALLOC_FAILED;
+    }
+    mbedtls_x509_crt_init(found);
+    for (size_t i = 0; crt && i < primary_count; i++, crt = crt->next) {
+        if (crt->subject_raw.len == child->issuer_raw.len &&
+            memcmp(crt->subject_raw.p, child->issuer_raw.p, child->issuer_raw.len) == 0) {
+            mbedtls_x509_crt_parse_der_nocopy(found, crt->raw.p, crt->raw.len);
+        }
+    }
+    trust_store_append_issuers(child, found);
+
+    if (found->raw.len == 0) {
+        mbedtls_x509_crt_free(found);
+        mbedtls_free(found);
+        found = NULL;
+    }
+    *candidates = found;
+    return 0;
+}
+#endif
+
+esp_err_t cert_manager_attach_ca_chain(void* ssl_conf)
+{
+    mbedtls_x509_crt* chain;
+    esp_err_t err = cert_manager_get_ca_chain(&chain);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "No CA chain to attach: %s", esp_err_to_name(err));
+        return err;
+    }
+    
+    mbedtls_ssl_conf_authmode(ssl_conf, MBEDTLS_SSL_VERIFY_REQUIRED);
+#if defined(MBEDTLS_X509_TRUSTED_CERTIFICATE_CALLBACK)
+    mbedtls_ssl_conf_ca_cb(ssl_conf, ca_candidates, NULL);
+#else
+    mbedtls_ssl_conf_ca_chain(ssl_conf, chain, NULL);
+#endif
     return ESP_OK;
 }
 
@@ -459,9 +1206,28 @@ esp_err_t cert_manager_deinit(void)
         return ESP_OK;
     }
     
+    cert_manager_rotate_abort();
+    
+    // No TLS connection may be using the chains any more
+    portENTER_CRITICAL(&s_chain_lock);
+    mbedtls_x509_crt* chains[] = { s_ca_chain, s_retired_chain };
+    s_ca_chain = NULL;
+    s_retired_chain = NULL;
+    s_chain_slot = CERT_SLOT_NONE;
+    portEXIT_CRITICAL(&s_chain_lock);
+    for (size_t i = 0; i < sizeof(chains) / sizeof(chains[0]); i++) {
+        free_chain(chains[i]);
+    }
+    
+    esp_partition_munmap(s_mmap_handle);
+    s_mapped = NULL;
+    s_partition = NULL;
+    
     s_initialized = false;
     memset(&s_config, 0, sizeof(s_config));
+    s_metadata_cached = false;
+    s_verified_slots = 0;
     
     ESP_LOGI(TAG, "Certificate manager deinitialized");
     return ESP_OK;
-}
\ No newline at end of file
+}
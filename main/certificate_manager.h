@@ -1,6 +1,7 @@
 #pragma once
 
 #include "esp_err.h"
+#include "mbedtls/x509_crt.h"
 #include <stdint.h>
 #include <stdbool.h>
 
@@ -11,9 +12,17 @@
  * This module provides a comprehensive certificate management system with:
  * - Multi-tier certificate provisioning (secure → development fallback)
  * - Certificate validation and integrity checks
- * - Secure storage with corruption detection
+ * - DER storage in a dedicated flash partition ("certs"), two CRC-protected
+ *   slots (primary and backup) memory-mapped so parsed chains reference
+ *   flash instead of heap copies
+ * - Metadata cached in RAM; stored certificates are checksummed once per boot
+ * - X.509 parsing (notAfter, subject, issuer, SHA-256 fingerprint) at store time
+ * - Parsed CA chain cached for the TLS layer
  * - Certificate rotation without firmware updates
  * - Production-ready security standards
+ *
+ * Expiry is only checked once the wall clock is set (SNTP); before that a
+ * certificate is never reported as expired.
  */
 
 #ifdef __cplusplus
@@ -44,16 +53,24 @@ typedef enum {
     CERT_STORAGE_ERROR              /**< Storage operation failed */
 } cert_validation_result_t;
 
+#define CERT_DN_MAX             96      /**< Subject/issuer string size (longer names are truncated) */
+#define CERT_FINGERPRINT_SIZE   32      /**< SHA-256 fingerprint size */
+
 /**
  * @brief Certificate metadata structure
+ *
+ * X.509 fields describe the first certificate of the stored PEM.
  */
 typedef struct {
     cert_source_t source;           /**< Certificate source type */
-    uint32_t checksum;              /**< CRC32 checksum for integrity */
+    uint32_t checksum;              /**< CRC32 of the stored DER */
     uint64_t stored_time;           /**< Timestamp when stored */
-    uint64_t expiry_time;           /**< Certificate expiry timestamp */
-    size_t cert_size;               /**< Certificate size in bytes */
+    uint64_t expiry_time;           /**< Certificate notAfter (Unix time, seconds) */
+    size_t cert_size;               /**< Stored DER size in bytes */
     bool is_valid;                  /**< Validation status */
+    char subject[CERT_DN_MAX];      /**< Subject distinguished name */
+    char issuer[CERT_DN_MAX];       /**< Issuer distinguished name */
+    uint8_t fingerprint[CERT_FINGERPRINT_SIZE]; /**< SHA-256 of the DER certificate */
 } cert_metadata_t;
 
 /**
@@ -63,7 +80,8 @@ typedef struct {
     bool allow_development_cert;    /**< Allow development certificate fallback */
     bool require_integrity_check;   /**< Require integrity validation */
     bool auto_rotate_expired;       /**< Auto-rotate expired certificates */
-    const char* nvs_namespace;      /**< NVS namespace for storage */
+    const char* nvs_namespace;      /**< NVS namespace for metadata */
+    const char* partition_label;    /**< Data partition holding the certificate slots */
 } cert_manager_config_t;
 
 /**
@@ -73,7 +91,8 @@ typedef struct {
     .allow_development_cert = true, \
     .require_integrity_check = true, \
     .auto_rotate_expired = false, \
-    .nvs_namespace = "cert_mgr" \
+    .nvs_namespace = "cert_mgr", \
+    .partition_label = "certs" \
 }
 
 /**
@@ -87,24 +106,31 @@ esp_err_t cert_manager_init(const cert_manager_config_t* config);
 /**
  * @brief Store certificate with metadata
  * 
+ * The PEM (one certificate or a chain) is converted to DER and written to
+ * the slot not in use; the slot holding the current certificate becomes the
+ * backup. An expired chain is rejected.
+ * 
  * @param cert_pem PEM-formatted certificate string
  * @param source Certificate source type
- * @return esp_err_t ESP_OK on success
+ * @return esp_err_t ESP_OK on success, ESP_ERR_INVALID_ARG if the PEM is invalid or expired
  */
 esp_err_t cert_manager_store(const char* cert_pem, cert_source_t source);
 
 /**
- * @brief Load certificate with automatic validation
+ * @brief Map the stored certificate chain with automatic validation
  * 
- * @param cert_buffer Buffer to store certificate
- * @param buffer_size Size of buffer
- * @param actual_size Actual certificate size (output)
- * @return esp_err_t ESP_OK on success
+ * Returns the primary slot, or the backup if the primary does not validate.
+ * The development fallback is not stored in flash and only available
+ * through cert_manager_get_ca_chain().
+ * 
+ * @param der Concatenated DER certificates in mapped flash (output)
+ * @param der_len Length in bytes (output)
+ * @return esp_err_t ESP_OK on success, ESP_ERR_NOT_FOUND if no stored certificate validates
  */
-esp_err_t cert_manager_load(char* cert_buffer, size_t buffer_size, size_t* actual_size);
+esp_err_t cert_manager_load(const uint8_t** der, size_t* der_len);
 
 /**
- * @brief Validate certificate and update metadata
+ * @brief Validate a PEM certificate (format, X.509 parsing, expiry)
  * 
  * @param cert_pem PEM-formatted certificate string
  * @param result Validation result (output)
@@ -121,14 +147,16 @@ esp_err_t cert_manager_validate(const char* cert_pem, cert_validation_result_t*
 esp_err_t cert_manager_get_metadata(cert_metadata_t* metadata);
 
 /**
- * @brief Check if certificate exists and is valid
+ * @brief Check if a stored certificate exists and is valid
  * 
- * @return true if certificate exists and is valid
+ * @return true if the primary or backup slot holds a valid certificate
  */
 bool cert_manager_is_certificate_valid(void);
 
 /**
- * @brief Rotate certificate (backup current, store new)
+ * @brief Rotate certificate (validate, then store; the current one becomes the backup)
+ * 
+ * Runs a streaming rotation over the whole PEM.
  * 
  * @param new_cert_pem New PEM-formatted certificate
  * @param source Certificate source type
@@ -136,6 +164,78 @@ bool cert_manager_is_certificate_valid(void);
  */
 esp_err_t cert_manager_rotate(const char* new_cert_pem, cert_source_t source);
 
+/**
+ * @brief Start a streaming certificate rotation
+ * 
+ * The PEM is then passed in chunks of any size to
+ * cert_manager_rotate_write(), which decodes it straight into the slot not
+ * in use while hashing it, so no buffer holds the whole certificate. The
+ * primary slot is untouched until cert_manager_rotate_finish() validates
+ * the staged chain and writes its slot header, which makes it the primary
+ * and the current one the backup. A failed rotation leaves the current
+ * certificate in place and never falls back to the development certificate.
+ * 
+ * Starting a rotation aborts one in progress.
+ * 
+ * @param pem_len Total PEM length in bytes (0 if unknown)
+ * @param sha256 Expected SHA-256 of the PEM (NULL to skip the check)
+ * @param source Certificate source type
+ * @return esp_err_t ESP_OK on success
+ */
+esp_err_t cert_manager_rotate_begin(size_t pem_len, const uint8_t sha256[CERT_FINGERPRINT_SIZE], cert_source_t source);
+
+/**
+ * @brief Pass the next chunk of the PEM
+ * 
+ * @param data PEM chunk (need not be NUL-terminated or end on a line boundary)
+ * @param len Chunk length
+ * @return esp_err_t ESP_OK on success, ESP_ERR_INVALID_STATE if no rotation is in progress,
+ *         ESP_ERR_INVALID_SIZE if the chain exceeds the slot or the announced length;
+ *         the rotation is aborted on any error
+ */
+esp_err_t cert_manager_rotate_write(const char* data, size_t len);
+
+/**
+ * @brief Validate the staged chain and make it the primary certificate
+ * 
+ * @param result Validation result (output, may be NULL)
+ * @return esp_err_t ESP_OK if the certificate was rotated, ESP_ERR_INVALID_CRC on a
+ *         SHA-256 mismatch, ESP_ERR_INVALID_ARG if the chain does not validate
+ */
+esp_err_t cert_manager_rotate_finish(cert_validation_result_t* result);
+
+/**
+ * @brief Abort a streaming rotation in progress
+ */
+void cert_manager_rotate_abort(void);
+
+/**
+ * @brief Get the parsed CA chain of the certificate cert_manager_load() returns
+ *
+ * The anchors of the trust store (trust_store.h) are appended to the chain,
+ * which is then valid with the trust store alone. The chain is parsed on
+ * first use and cached until a certificate is stored or the trust store
+ * changes. A replaced chain stays allocated until the next replacement, so a TLS
+ * handshake that already picked it up can complete.
+ *
+ * @param chain Parsed chain (output, owned by the certificate manager)
+ * @return esp_err_t ESP_OK on success
+ */
+esp_err_t cert_manager_get_ca_chain(mbedtls_x509_crt** chain);
+
+/**
+ * @brief esp_tls_cfg_t.crt_bundle_attach hook that installs the cached CA chain
+ *
+ * Saves esp-tls from parsing the CA PEM on every connect. With
+ * CONFIG_MBEDTLS_X509_TRUSTED_CERT_CALLBACK the handshake instead asks a CA
+ * callback for the issuers of each certificate, which looks the trust store
+ * anchors up in its index.
+ *
+ * @param ssl_conf mbedtls_ssl_config of the connection
+ * @return esp_err_t ESP_OK on success
+ */
+esp_err_t cert_manager_attach_ca_chain(void* ssl_conf);
+
 /**
  * @brief Get certificate source name (for logging)
  * 
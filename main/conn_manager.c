@@ -0,0 +1,322 @@
+#include "conn_manager.h"
+#include "esp_log.h"
+#include "esp_event.h"
+#include "esp_timer.h"
+#include "esp_random.h"
+#include "esp_wifi.h"
+#include "freertos/FreeRTOS.h"
+
+static const char* TAG = "CONN_MGR";
+
+// Retry timers hand their work to the event loop, which owns the client
+ESP_EVENT_DEFINE_BASE(CONN_MANAGER_EVENT);
+
+enum {
+    CONN_EVENT_WIFI_RETRY,          /**< Wi-Fi delay elapsed: associate again */
+    CONN_EVENT_MQTT_RETRY,          /**< MQTT delay or resume jitter elapsed */
+};
+
+static conn_manager_config_t s_config;
+static bool s_initialized = false;
+static esp_timer_handle_t s_wifi_timer = NULL;
+static esp_timer_handle_t s_mqtt_timer = NULL;
+
+// The client and its running flag are only touched from the event loop task
+static esp_mqtt_client_handle_t s_client = NULL;
+static bool s_client_running = false;
+
+// State changes come from the event loop and the MQTT task
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static conn_state_t s_state = CONN_STATE_WIFI_DOWN;
+static reconnect_backoff_t s_wifi_backoff;
+static reconnect_backoff_t s_mqtt_backoff;
+static int64_t s_online_since_us = 0;
+static conn_manager_stats_t s_stats = {0};
+
+static const char* const s_state_names[] = {
+    [CONN_STATE_WIFI_DOWN] = "wifi_down",
+    [CONN_STATE_IP_UP] = "ip_up",
+    [CONN_STATE_BROKER_CONNECTING] = "broker_connecting",
+    [CONN_STATE_ONLINE] = "online",
+};
+
+/**
+ * @brief Move to state if the current state is one of allowed_mask (bit per state)
+ *
+ * @return true if the state changed
+ */
+static bool transition(conn_state_t state, uint32_t allowed_mask)
+{
+    portENTER_CRITICAL(&s_lock);
+    conn_state_t old = s_state;
+    bool changed = old != state && (allowed_mask & (1U << old)) != 0;
+    if (changed) {
+        s_state = state;
+        if (state == CONN_STATE_WIFI_DOWN) {
+            s_stats.wifi_drops++;
+        } else if (state == CONN_STATE_ONLINE) {
+            s_stats.online_count++;
+        } else if (state == CONN_STATE_BROKER_CONNECTING && old == CONN_STATE_ONLINE) {
+            s_stats.broker_drops++;
+        }
+    }
+    portEXIT_CRITICAL(&s_lock);
+
+    if (changed) {
+        ESP_LOGI(TAG, "%s -> %s", s_state_names[old], s_state_names[state]);
+        if (s_config.on_state) {
+            s_config.on_state(state, s_client, s_config.ctx);
+        }
+    }
+    return changed;
+}
+
+#define FROM(state)     (1U << (state))
+#define FROM_ANY        0xFFFFFFFFU
+
+/**
+ * @brief (Re)arm a one-shot retry timer
+ */
+static void arm_timer(esp_timer_handle_t timer, uint32_t delay_ms)
+{
+    esp_timer_stop(timer); // Not running is fine
+    esp_err_t err = esp_timer_start_once(timer, (uint64_t)delay_ms * 1000);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to arm retry timer: %s", esp_err_to_name(err));
+    }
+}
+
+static void retry_timer_cb(void* arg)
+{
+    int32_t event_id = (int32_t)(intptr_t)arg;
+    if (esp_event_post(CONN_MANAGER_EVENT, event_id, NULL, 0, 0) != ESP_OK) {
+        // Event queue full: try again shortly rather than lose the retry
+        esp_timer_start_once(event_id == CONN_EVENT_WIFI_RETRY ? s_wifi_timer : s_mqtt_timer, 100 * 1000);
+    }
+}
+
+static void start_client(void)
+{
+    // Enter BROKER_CONNECTING first so a fast CONNACK cannot arrive in IP_UP
+    transition(CONN_STATE_BROKER_CONNECTING, FROM(CONN_STATE_IP_UP));
+    esp_err_t err = esp_mqtt_client_start(s_client);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to start MQTT client: %s", esp_err_to_name(err));
+        transition(CONN_STATE_IP_UP, FROM(CONN_STATE_BROKER_CONNECTING));
+        return;
+    }
+    s_client_running = true;
+    portENTER_CRITICAL(&s_lock);
+    s_stats.client_starts++;
+    portEXIT_CRITICAL(&s_lock);
+}
+
+/**
+ * @brief Retry timer work, on the event loop task
+ */
+static void retry_event_handler(void* arg, esp_event_base_t base, int32_t event_id, void* event_data)
+{
+    conn_state_t state = conn_manager_get_state();
+    switch (event_id) {
+    case CONN_EVENT_WIFI_RETRY:
+        if (state == CONN_STATE_WIFI_DOWN) {
+            esp_wifi_connect();
+        }
+        break;
+    case CONN_EVENT_MQTT_RETRY:
+        if (state == CONN_STATE_BROKER_CONNECTING && s_client_running) {
+            esp_err_t err = esp_mqtt_client_reconnect(s_client);
+            if (err != ESP_OK) {
+                ESP_LOGW(TAG, "MQTT reconnect refused: %s", esp_err_to_name(err));
+            }
+        } else if (state == CONN_STATE_IP_UP && s_client && !s_client_running) {
+            // Resume jitter after Wi-Fi recovery elapsed
+            if (s_config.on_resume) {
+                s_config.on_resume(s_client, s_config.ctx);
+            }
+            start_client();
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+esp_err_t conn_manager_init(const conn_manager_config_t* config)
+{
+    if (config == NULL || config->create_client == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_initialized) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    s_config = *config;
+    reconnect_backoff_init(&s_wifi_backoff, &config->backoff);
+    reconnect_backoff_init(&s_mqtt_backoff, &config->backoff);
+
+    esp_timer_create_args_t timer_args = {
+        .callback = retry_timer_cb,
+        .arg = (void*)(intptr_t)CONN_EVENT_WIFI_RETRY,
+        .name = "wifi_retry",
+    };
+    esp_err_t err = esp_timer_create(&timer_args, &s_wifi_timer);
+    if (err == ESP_OK) {
+        timer_args.arg = (void*)(intptr_t)CONN_EVENT_MQTT_RETRY;
+        timer_args.name = "mqtt_retry";
+        err = esp_timer_create(&timer_args, &s_mqtt_timer);
+    }
+    if (err == ESP_OK) {
+        err = esp_event_handler_register(CONN_MANAGER_EVENT, ESP_EVENT_ANY_ID, retry_event_handler, NULL);
+    }
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to set up retry timers: %s", esp_err_to_name(err));
+        return err;
+    }
+
+    s_initialized = true;
+    ESP_LOGI(TAG, "Reconnect backoff %lu-%lu ms, resume jitter %lu ms", (unsigned long)s_wifi_backoff.config.base_ms,
+             (unsigned long)s_wifi_backoff.config.cap_ms, (unsigned long)s_config.resume_jitter_ms);
+    return ESP_OK;
+}
+
+void conn_manager_set_backoff(const reconnect_backoff_config_t* backoff)
+{
+    portENTER_CRITICAL(&s_lock);
+    s_config.backoff = *backoff;
+    reconnect_backoff_set_config(&s_wifi_backoff, backoff);
+    reconnect_backoff_set_config(&s_mqtt_backoff, backoff);
+    portEXIT_CRITICAL(&s_lock);
+}
+
+void conn_manager_on_ip_up(void)
+{
+    if (!s_initialized) {
+        return;
+    }
+    esp_timer_stop(s_wifi_timer);
+    portENTER_CRITICAL(&s_lock);
+    reconnect_backoff_reset(&s_wifi_backoff);
+    portEXIT_CRITICAL(&s_lock);
+
+    // A lease renewal without a disconnect leaves the running client alone
+    if (s_client_running) {
+        return;
+    }
+    transition(CONN_STATE_IP_UP, FROM(CONN_STATE_WIFI_DOWN));
+
+    if (s_client == NULL) {
+        esp_mqtt_client_handle_t client = NULL;
+        if (s_config.create_client(&client, s_config.ctx) != ESP_OK || client == NULL) {
+            ESP_LOGW(TAG, "MQTT client not created, retrying on the next IP event");
+            return;
+        }
+        s_client = client;
+        portENTER_CRITICAL(&s_lock);
+        s_stats.clients_created++;
+        portEXIT_CRITICAL(&s_lock);
+        start_client();
+        return;
+    }
+
+    // Devices behind a restarted AP all get their lease at once; spread the broker connects
+    uint32_t jitter_ms = s_config.resume_jitter_ms > 0 ? esp_random() % (s_config.resume_jitter_ms + 1) : 0;
+    ESP_LOGI(TAG, "Resuming MQTT in %lu ms", (unsigned long)jitter_ms);
+    arm_timer(s_mqtt_timer, jitter_ms);
+}
+
+void conn_manager_on_wifi_down(void)
+{
+    if (!s_initialized) {
+        return;
+    }
+    // Every failed association attempt reports a disconnect; only the first one stops the client
+    if (transition(CONN_STATE_WIFI_DOWN, FROM_ANY)) {
+        esp_timer_stop(s_mqtt_timer);
+        if (s_client_running) {
+            // Stopping ends the MQTT task; the client and its outbox are kept for the resume
+            esp_err_t err = esp_mqtt_client_stop(s_client);
+            if (err != ESP_OK) {
+                ESP_LOGW(TAG, "Failed to stop MQTT client: %s", esp_err_to_name(err));
+            }
+            s_client_running = false;
+        }
+    }
+
+    portENTER_CRITICAL(&s_lock);
+    uint32_t delay_ms = reconnect_backoff_next(&s_wifi_backoff, esp_random());
+    uint32_t attempts = s_wifi_backoff.attempts;
+    s_stats.wifi_retries++;
+    s_stats.wifi_attempts = attempts;
+    s_stats.wifi_delay_ms = delay_ms;
+    portEXIT_CRITICAL(&s_lock);
+
+    ESP_LOGI(TAG, "Wi-Fi retry %lu in %lu ms", (unsigned long)attempts, (unsigned long)delay_ms);
+    arm_timer(s_wifi_timer, delay_ms);
+}
+
+void conn_manager_on_mqtt_connected(void)
+{
+    if (transition(CONN_STATE_ONLINE, FROM(CONN_STATE_BROKER_CONNECTING))) {
+        portENTER_CRITICAL(&s_lock);
+        s_online_since_us = esp_timer_get_time();
+        portEXIT_CRITICAL(&s_lock);
+    }
+}
+
+void conn_manager_on_mqtt_disconnected(void)
+{
+    int64_t now_us = esp_timer_get_time();
+    bool schedule = false;
+    uint32_t delay_ms = 0;
+    uint32_t attempts = 0;
+
+    // After Wi-Fi loss the state stays WIFI_DOWN; the stop itself may report a disconnect
+    portENTER_CRITICAL(&s_lock);
+    if (s_state == CONN_STATE_ONLINE || s_state == CONN_STATE_BROKER_CONNECTING) {
+        if (s_state == CONN_STATE_ONLINE && now_us - s_online_since_us >= (int64_t)s_config.mqtt_stable_ms * 1000) {
+            reconnect_backoff_reset(&s_mqtt_backoff);
+        }
+        delay_ms = reconnect_backoff_next(&s_mqtt_backoff, esp_random());
+        s_stats.mqtt_retries++;
+        s_stats.mqtt_attempts = s_mqtt_backoff.attempts;
+        s_stats.mqtt_delay_ms = delay_ms;
+        attempts = s_mqtt_backoff.attempts;
+        schedule = true;
+    }
+    portEXIT_CRITICAL(&s_lock);
+
+    if (!schedule) {
+        return;
+    }
+    transition(CONN_STATE_BROKER_CONNECTING, FROM(CONN_STATE_ONLINE));
+    ESP_LOGI(TAG, "MQTT retry %lu in %lu ms", (unsigned long)attempts, (unsigned long)delay_ms);
+    arm_timer(s_mqtt_timer, delay_ms);
+}
+
+conn_state_t conn_manager_get_state(void)
+{
+    portENTER_CRITICAL(&s_lock);
+    conn_state_t state = s_state;
+    portEXIT_CRITICAL(&s_lock);
+    return state;
+}
+
+const char* conn_manager_state_name(conn_state_t state)
+{
+    if ((unsigned)state >= sizeof(s_state_names) / sizeof(s_state_names[0])) {
+        return "unknown";
+    }
+    return s_state_names[state];
+}
+
+esp_mqtt_client_handle_t conn_manager_get_client(void)
+{
+    return s_client;
+}
+
+void conn_manager_get_stats(conn_manager_stats_t* stats)
+{
+    portENTER_CRITICAL(&s_lock);
+    *stats = s_stats;
+    portEXIT_CRITICAL(&s_lock);
+}
@@ -0,0 +1,191 @@
+#pragma once
+
+#include "esp_err.h"
+#include "mqtt_client.h"
+#include "reconnect_backoff.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * @file conn_manager.h
+ * @brief Connection state machine owning the one long-lived MQTT client
+ *
+ * States follow the link: WIFI_DOWN -> IP_UP -> BROKER_CONNECTING -> ONLINE.
+ * The client is created once, on the first IP_UP, and is never destroyed:
+ * losing Wi-Fi stops it and the next IP_UP starts the same client again, so
+ * Wi-Fi flaps do not re-read the configuration, allocate a new client or
+ * spawn another MQTT task. A broker disconnect with the link still up only
+ * goes back to BROKER_CONNECTING.
+ *
+ * The manager also paces reconnects on both layers with decorrelated-jitter
+ * backoff (reconnect_backoff.h), so a fleet that lost its AP or broker at
+ * the same moment does not come back in lockstep:
+ * - Every failed Wi-Fi association waits for the next Wi-Fi delay before
+ *   esp_wifi_connect() is called again; the Wi-Fi backoff resets on GOT_IP.
+ * - Every failed or dropped broker connection waits for the next MQTT delay
+ *   before esp_mqtt_client_reconnect(). The client must be created with
+ *   network.disable_auto_reconnect set, so esp-mqtt's fixed timer stays out.
+ * - Losing Wi-Fi cancels pending MQTT retries. After Wi-Fi recovers, the
+ *   client is started again after a random delay of up to resume_jitter_ms,
+ *   because an AP restart hands out leases to all devices at once.
+ * - The MQTT backoff resets only after a session stayed up for
+ *   mqtt_stable_ms, so a broker that accepts and drops connections, or a
+ *   flapping link, keeps the delays growing.
+ *
+ * Wi-Fi and IP events are expected from the default event loop, MQTT events
+ * from the MQTT task. Retry timers post to the default event loop, which
+ * must exist before conn_manager_init().
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Connection states
+ */
+typedef enum {
+    CONN_STATE_WIFI_DOWN = 0,       /**< No IP; the client (if any) is stopped */
+    CONN_STATE_IP_UP,               /**< Got an IP, client not started yet */
+    CONN_STATE_BROKER_CONNECTING,   /**< Client running, waiting for CONNACK */
+    CONN_STATE_ONLINE,              /**< Connected to the broker */
+} conn_state_t;
+
+/**
+ * @brief Create and configure the client (first IP_UP only)
+ *
+ * Registers the MQTT event handler but does not start the client. Called
+ * again on the next IP_UP if it fails.
+ *
+ * @param client Created client (output)
+ * @param ctx Context pointer from the configuration
+ * @return esp_err_t ESP_OK on success
+ */
+typedef esp_err_t (*conn_create_client_cb_t)(esp_mqtt_client_handle_t* client, void* ctx);
+
+/**
+ * @brief Called before a stopped client is started again (e.g. to refresh the broker URI)
+ */
+typedef void (*conn_resume_cb_t)(esp_mqtt_client_handle_t client, void* ctx);
+
+/**
+ * @brief Called on every state change (must not block)
+ *
+ * @param state New state
+ * @param client The client, NULL before it is created
+ * @param ctx Context pointer from the configuration
+ */
+typedef void (*conn_state_cb_t)(conn_state_t state, esp_mqtt_client_handle_t client, void* ctx);
+
+/**
+ * @brief Connection manager configuration
+ */
+typedef struct {
+    conn_create_client_cb_t create_client; /**< Required */
+    conn_resume_cb_t on_resume;     /**< Optional */
+    conn_state_cb_t on_state;       /**< Optional */
+    void* ctx;                      /**< Passed to the callbacks */
+    reconnect_backoff_config_t backoff; /**< Reconnect delays, shared by the Wi-Fi and MQTT layers */
+    uint32_t mqtt_stable_ms;        /**< Session length that resets the MQTT backoff */
+    uint32_t resume_jitter_ms;      /**< Spread of the client restart after Wi-Fi recovery */
+} conn_manager_config_t;
+
+/**
+ * @brief Default connection manager configuration (create_client must be set)
+ */
+#define CONN_MANAGER_DEFAULT_CONFIG() { \
+    .create_client = NULL, \
+    .on_resume = NULL, \
+    .on_state = NULL, \
+    .ctx = NULL, \
+    .backoff = RECONNECT_BACKOFF_DEFAULT_CONFIG(), \
+    .mqtt_stable_ms = 30000, \
+    .resume_jitter_ms = 3000 \
+}
+
+/**
+ * @brief Connection statistics since boot
+ */
+typedef struct {
+    uint32_t clients_created;       /**< Stays at 1 once the client exists */
+    uint32_t client_starts;         /**< First start plus one resume per Wi-Fi recovery */
+    uint32_t wifi_drops;            /**< Transitions into WIFI_DOWN */
+    uint32_t broker_drops;          /**< ONLINE -> BROKER_CONNECTING with the link up */
+    uint32_t online_count;          /**< Transitions into ONLINE */
+    uint32_t wifi_retries;          /**< Delayed esp_wifi_connect() calls */
+    uint32_t mqtt_retries;          /**< Delayed broker reconnects */
+    uint32_t wifi_attempts;         /**< Wi-Fi delays in the current or last outage */
+    uint32_t mqtt_attempts;         /**< MQTT delays since the MQTT backoff last reset */
+    uint32_t wifi_delay_ms;         /**< Last Wi-Fi delay */
+    uint32_t mqtt_delay_ms;         /**< Last MQTT delay */
+} conn_manager_stats_t;
+
+/**
+ * @brief Initialize the state machine in WIFI_DOWN
+ *
+ * @param config Connection manager configuration
+ * @return esp_err_t ESP_OK on success
+ */
+esp_err_t conn_manager_init(const conn_manager_config_t* config);
+
+/**
+ * @brief Change the reconnect delays of both layers (from any task)
+ *
+ * Takes effect from the next delay; the attempt counts are kept.
+ */
+void conn_manager_set_backoff(const reconnect_backoff_config_t* backoff);
+
+/**
+ * @brief Handle IP_EVENT_STA_GOT_IP: create the client or start it again
+ *
+ * The first start is immediate; restarts after Wi-Fi recovery are jittered.
+ */
+void conn_manager_on_ip_up(void);
+
+/**
+ * @brief Handle WIFI_EVENT_STA_DISCONNECTED: stop the client and schedule the next association
+ *
+ * The first call of an outage stops the client, blocking until the MQTT task
+ * has stopped (at most for a connect attempt in progress). Every call,
+ * including each failed association, schedules esp_wifi_connect() after the
+ * next Wi-Fi delay.
+ */
+void conn_manager_on_wifi_down(void);
+
+/**
+ * @brief Handle MQTT_EVENT_CONNECTED
+ */
+void conn_manager_on_mqtt_connected(void);
+
+/**
+ * @brief Handle MQTT_EVENT_DISCONNECTED: schedule a reconnect after the next MQTT delay
+ *
+ * esp-mqtt reports failed connect attempts as disconnects as well.
+ */
+void conn_manager_on_mqtt_disconnected(void);
+
+/**
+ * @brief Current state
+ */
+conn_state_t conn_manager_get_state(void);
+
+/**
+ * @brief Short lowercase name of a state, for logs and telemetry
+ */
+const char* conn_manager_state_name(conn_state_t state);
+
+/**
+ * @brief The long-lived client, NULL before the first IP_UP
+ */
+esp_mqtt_client_handle_t conn_manager_get_client(void);
+
+/**
+ * @brief Get connection statistics
+ *
+ * @param stats Statistics (output)
+ */
+void conn_manager_get_stats(conn_manager_stats_t* stats);
+
+#ifdef __cplusplus
+}
+#endif
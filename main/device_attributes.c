@@ -0,0 +1,498 @@
+#include "device_attributes.h"
+#include "json_scan.h"
+#include "mqtt_outbound.h"
+#include "freertos/FreeRTOS.h"
+#include "esp_timer.h"
+#include "nvs.h"
+#include "esp_log.h"
+#include <stdio.h>
+#include <string.h>
+
+static const char* TAG = "DEVICE_ATTRIBUTES";
+
+#define ATTR_TOPIC              "v1/devices/me/attributes"
+#define ATTR_REQUEST_PREFIX     "v1/devices/me/attributes/request/"
+#define ATTR_RESPONSE_PREFIX    "v1/devices/me/attributes/response/"
+#define ATTR_RESPONSE_SUBSCRIBE ATTR_RESPONSE_PREFIX "+"
+#define ATTR_PAYLOAD_MAX        256
+#define ATTR_REQUEST_MAX        512     // Shared attribute request: every key name
+#define ATTR_PUBLISH_QUEUED     0       // Pending delta queued, message id not known yet
+#define ATTR_ACK_TIMEOUT_MS     30000   // An unacknowledged delta is given up and published again
+
+// Attribute names are used as NVS keys
+#define DEVICE_SHARED_NAME_CHECK(id, name, type, def_int, def_str) \
+    _Static_assert(sizeof(name) <= 16, "shared attribute name too long for an NVS key: " name);
+DEVICE_SHARED_ATTRIBUTES(DEVICE_SHARED_NAME_CHECK)
+#undef DEVICE_SHARED_NAME_CHECK
+#define DEVICE_CLIENT_NAME_CHECK(id, name) \
+    _Static_assert(sizeof(name) <= 16, "client attribute name too long for an NVS key: " name);
+DEVICE_CLIENT_ATTRIBUTES(DEVICE_CLIENT_NAME_CHECK)
+#undef DEVICE_CLIENT_NAME_CHECK
+
+/**
+ * @brief Shared attribute definition
+ */
+typedef struct {
+    const char* name;
+    device_attr_type_t type;
+    int32_t default_int;
+    const char* default_str;
+} shared_attr_info_t;
+
+static const shared_attr_info_t s_shared_info[DEVICE_SHARED_COUNT] = {
+#define DEVICE_SHARED_ATTR_INFO(id, key, attr_type, def_int, def_str) \
+    [DEVICE_SHARED_##id] = { .name = key, .type = DEVICE_ATTR_TYPE_##attr_type, .default_int = def_int, .default_str = def_str },
+    DEVICE_SHARED_ATTRIBUTES(DEVICE_SHARED_ATTR_INFO)
+#undef DEVICE_SHARED_ATTR_INFO
+};
+
+static const char* const s_client_names[DEVICE_CLIENT_COUNT] = {
+#define DEVICE_CLIENT_ATTR_NAME(id, key) [DEVICE_CLIENT_##id] = key,
+    DEVICE_CLIENT_ATTRIBUTES(DEVICE_CLIENT_ATTR_NAME)
+#undef DEVICE_CLIENT_ATTR_NAME
+};
+
+/**
+ * @brief Cached shared attribute value (BOOL is stored in int_value)
+ */
+typedef struct {
+    int32_t int_value;
+    char str_value[DEVICE_ATTR_STRING_MAX];
+} shared_attr_value_t;
+
+/**
+ * @brief Client attribute publish state
+ */
+typedef struct {
+    char value[DEVICE_ATTR_STRING_MAX];   /**< Current value */
+    char sent[DEVICE_ATTR_STRING_MAX];    /**< Value in the publish awaiting PUBACK */
+    char acked[DEVICE_ATTR_STRING_MAX];   /**< Last value acknowledged by the broker */
+} client_attr_state_t;
+
+// Cache is updated from the MQTT task and read by the application tasks
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static device_attributes_config_t s_config;
+static shared_attr_value_t s_shared[DEVICE_SHARED_COUNT];
+static client_attr_state_t s_client[DEVICE_CLIENT_COUNT];
+static int s_pending_msg_id = -1;
+static uint32_t s_pending_mask = 0;
+static int64_t s_pending_since_us = 0;
+static uint32_t s_request_id = 0;
+static bool s_initialized = false;
+
+static void load_shared_from_nvs(void)
+{
+    for (int i = 0; i < DEVICE_SHARED_COUNT; i++) {
+        s_shared[i].int_value = s_shared_info[i].default_int;
+        strlcpy(s_shared[i].str_value, s_shared_info[i].default_str, sizeof(s_shared[i].str_value));
+    }
+
+    nvs_handle_t nvs_handle;
+    if (nvs_open(s_config.shared_namespace, NVS_READONLY, &nvs_handle) != ESP_OK) {
+        return; // Nothing cached yet
+    }
+    for (int i = 0; i < DEVICE_SHARED_COUNT; i++) {
+        const shared_attr_info_t* info = &s_shared_info[i];
+        switch (info->type) {
+        case DEVICE_ATTR_TYPE_INT:
+            nvs_get_i32(nvs_handle, info->name, &s_shared[i].int_value);
+            break;
+        case DEVICE_ATTR_TYPE_BOOL: {
+            uint8_t flag;
+            if (nvs_get_u8(nvs_handle, info->name, &flag) == ESP_OK) {
+                s_shared[i].int_value = flag ? 1 : 0;
+            }
+            break;
+        }
+        case DEVICE_ATTR_TYPE_STRING: {
+            char value[DEVICE_ATTR_STRING_MAX];
+            size_t len = sizeof(value);
+            if (nvs_get_str(nvs_handle, info->name, value, &len) == ESP_OK) {
+                strlcpy(s_shared[i].str_value, value, sizeof(s_shared[i].str_value));
+            }
+            break;
+        }
+        }
+    }
+    nvs_close(nvs_handle);
+}
+
+static void load_client_acked_from_nvs(void)
+{
+    nvs_handle_t nvs_handle;
+    if (nvs_open(s_config.client_namespace, NVS_READONLY, &nvs_handle) != ESP_OK) {
+        return;
+    }
+    for (int i = 0; i < DEVICE_CLIENT_COUNT; i++) {
+        size_t len = sizeof(s_client[i].acked);
+        if (nvs_get_str(nvs_handle, s_client_names[i], s_client[i].acked, &len) != ESP_OK) {
+            s_client[i].acked[0] = '\0';
+        }
+    }
+    nvs_close(nvs_handle);
+}
+
+esp_err_t device_attributes_init(const device_attributes_config_t* config)
+{
+    if (s_initialized) {
+        ESP_LOGW(TAG, "Device attributes already initialized");
+        return ESP_OK;
+    }
+    if (!config || !config->shared_namespace || !config->client_namespace) {
+        ESP_LOGE(TAG, "Invalid configuration");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    s_config = *config;
+    memset(s_client, 0, sizeof(s_client));
+    load_shared_from_nvs();
+    load_client_acked_from_nvs();
+    s_initialized = true;
+
+    ESP_LOGI(TAG, "Attribute cache loaded (%d shared, %d client)", DEVICE_SHARED_COUNT, DEVICE_CLIENT_COUNT);
+    return ESP_OK;
+}
+
+int32_t device_attributes_get_int(device_shared_attr_t attr)
+{
+    if (attr >= DEVICE_SHARED_COUNT) {
+        return 0;
+    }
+    portENTER_CRITICAL(&s_lock);
+    int32_t value = s_shared[attr].int_value;
+    portEXIT_CRITICAL(&s_lock);
+    return value;
+}
+
+bool device_attributes_get_bool(device_shared_attr_t attr)
+{
+    return device_attributes_get_int(attr) != 0;
+}
+
+esp_err_t device_attributes_get_string(device_shared_attr_t attr, char* buf, size_t size)
+{
+    if (attr >= DEVICE_SHARED_COUNT || s_shared_info[attr].type != DEVICE_ATTR_TYPE_STRING || !buf || size == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    portENTER_CRITICAL(&s_lock);
+    strlcpy(buf, s_shared[attr].str_value, size);
+    portEXIT_CRITICAL(&s_lock);
+    return ESP_OK;
+}
+
+/**
+ * @brief Apply shared attribute values found in a JSON object
+ */
+static void apply_shared(const json_span_t* object)
+{
+    nvs_handle_t nvs_handle = 0;
+    bool nvs_opened = false;
+
+    for (int i = 0; i < DEVICE_SHARED_COUNT; i++) {
+        const shared_attr_info_t* info = &s_shared_info[i];
+        json_span_t span;
+        if (!json_scan_key(object, info->name, &span)) {
+            continue;
+        }
+
+        shared_attr_value_t value = {0};
+        bool parsed = false;
+        switch (info->type) {
+        case DEVICE_ATTR_TYPE_INT:
+            parsed = json_span_to_int(&span, &value.int_value);
+            break;
+        case DEVICE_ATTR_TYPE_BOOL: {
+            bool flag;
+            parsed = json_span_to_bool(&span, &flag);
+            value.int_value = flag ? 1 : 0;
+            break;
+        }
+        case DEVICE_ATTR_TYPE_STRING:
+            parsed = json_span_copy_string(&span, value.str_value, sizeof(value.str_value));
+            break;
+        }
+        if (!parsed) {
+            ESP_LOGW(TAG, "Ignoring malformed value for '%s'", info->name);
+            continue;
+        }
+
+        portENTER_CRITICAL(&s_lock);
+        bool changed = (info->type == DEVICE_ATTR_TYPE_STRING)
+                       ? strcmp(s_shared[i].str_value, value.str_value) != 0
+                       : s_shared[i].int_value != value.int_value;
+        if (changed) {
+            s_shared[i] = value;
+        }
+        portEXIT_CRITICAL(&s_lock);
+        if (!changed) {
+            continue;
+        }
+
+        // Persist only real changes to spare flash on every reconnect
+        if (!nvs_opened) {
+            nvs_opened = (nvs_open(s_config.shared_namespace, NVS_READWRITE, &nvs_handle) == ESP_OK);
+        }
+        if (nvs_opened) {
+            esp_err_t err = ESP_OK;
+            switch (info->type) {
+            case DEVICE_ATTR_TYPE_INT:
+                err = nvs_set_i32(nvs_handle, info->name, value.int_value);
+                break;
+            case DEVICE_ATTR_TYPE_BOOL:
+                err = nvs_set_u8(nvs_handle, info->name, (uint8_t)value.int_value);
+                break;
+            case DEVICE_ATTR_TYPE_STRING:
+                err = nvs_set_str(nvs_handle, info->name, value.str_value);
+                break;
+            }
+            if (err != ESP_OK) {
+                ESP_LOGE(TAG, "Failed to persist '%s': %s", info->name, esp_err_to_name(err));
+            }
+        }
+
+        ESP_LOGI(TAG, "Shared attribute '%s' changed", info->name);
+        if (s_config.on_change) {
+            s_config.on_change((device_shared_attr_t)i, s_config.ctx);
+        }
+    }
+
+    if (nvs_opened) {
+        nvs_commit(nvs_handle);
+        nvs_close(nvs_handle);
+    }
+}
+
+esp_err_t device_attributes_set_client(device_client_attr_t attr, const char* value)
+{
+    if (attr >= DEVICE_CLIENT_COUNT || !value) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    portENTER_CRITICAL(&s_lock);
+    strlcpy(s_client[attr].value, value, sizeof(s_client[attr].value));
+    portEXIT_CRITICAL(&s_lock);
+    return ESP_OK;
+}
+
+/**
+ * @brief Append a JSON string with minimal escaping
+ */
+static size_t append_json_string(char* buf, size_t size, size_t len, const char* str)
+{
+    if (len < size) {
+        buf[len] = '"';
+    }
+    len++;
+    for (; *str; str++) {
+        if ((*str == '"' || *str == '\\') && len < size) {
+            buf[len++] = '\\';
+        }
+        if ((unsigned char)*str < 0x20) {
+            continue;
+        }
+        if (len < size) {
+            buf[len] = *str;
+        }
+        len++;
+    }
+    if (len < size) {
+        buf[len] = '"';
+    }
+    return len + 1;
+}
+
+/**
+ * @brief Outbound completion: remember the message id to match its PUBACK
+ */
+static void client_publish_done(int msg_id, void* ctx)
+{
+    portENTER_CRITICAL(&s_lock);
+    if (msg_id < 0) {
+        // Dropped before it was sent: re-evaluated by the next publish
+        s_pending_msg_id = -1;
+        s_pending_mask = 0;
+    } else if (s_pending_msg_id == ATTR_PUBLISH_QUEUED) {
+        s_pending_msg_id = msg_id;
+    }
+    portEXIT_CRITICAL(&s_lock);
+}
+
+esp_err_t device_attributes_publish_client(void)
+{
+    if (!s_initialized) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    char payload[ATTR_PAYLOAD_MAX];
+    size_t len = 0;
+    uint32_t mask = 0;
+
+    int64_t now_us = esp_timer_get_time();
+    portENTER_CRITICAL(&s_lock);
+    bool expired = s_pending_msg_id >= 0 && now_us - s_pending_since_us >= (int64_t)ATTR_ACK_TIMEOUT_MS * 1000;
+    if (s_pending_msg_id >= 0 && !expired) {
+        // One delta in flight at a time; the PUBACK handler publishes what changed meanwhile
+        portEXIT_CRITICAL(&s_lock);
+        return ESP_OK;
+    }
+    if (expired) {
+        // Lost PUBACK or message: re-evaluate against the acknowledged values
+        s_pending_msg_id = -1;
+        s_pending_mask = 0;
+    }
+    payload[len++] = '{';
+    for (int i = 0; i < DEVICE_CLIENT_COUNT; i++) {
+        client_attr_state_t* attr = &s_client[i];
+        if (attr->value[0] == '\0' || strcmp(attr->value, attr->acked) == 0) {
+            continue;
+        }
+        size_t start = len;
+        if (mask) {
+            payload[len++] = ',';
+        }
+        len = append_json_string(payload, sizeof(payload), len, s_client_names[i]);
+        if (len < sizeof(payload)) {
+            payload[len] = ':';
+        }
+        len = append_json_string(payload, sizeof(payload), len + 1, attr->value);
+        if (len + 1 >= sizeof(payload)) {
+            len = start; // Does not fit: leave it for the next publish
+            break;
+        }
+        strlcpy(attr->sent, attr->value, sizeof(attr->sent));
+        mask |= 1U << i;
+    }
+    portEXIT_CRITICAL(&s_lock);
+
+    if (expired) {
+        ESP_LOGW(TAG, "Client attribute delta not acknowledged within %d ms", ATTR_ACK_TIMEOUT_MS);
+    }
+    if (mask == 0) {
+        return ESP_OK;
+    }
+    payload[len++] = '}';
+
+    // Mark the delta pending before queueing so the completion cannot race ahead of it
+    portENTER_CRITICAL(&s_lock);
+    s_pending_msg_id = ATTR_PUBLISH_QUEUED;
+    s_pending_mask = mask;
+    s_pending_since_us = now_us;
+    portEXIT_CRITICAL(&s_lock);
+
+    // QoS 1 so the PUBACK tells us the broker has the values
+    esp_err_t err = mqtt_outbound_publish(MQTT_OUTBOUND_CONTROL, ATTR_TOPIC, payload, len, client_publish_done, NULL);
+    if (err != ESP_OK) {
+        portENTER_CRITICAL(&s_lock);
+        s_pending_msg_id = -1;
+        s_pending_mask = 0;
+        portEXIT_CRITICAL(&s_lock);
+        ESP_LOGW(TAG, "Client attribute publish failed: %s", esp_err_to_name(err));
+        return err;
+    }
+
+    ESP_LOGI(TAG, "Published client attributes: %.*s", (int)len, payload);
+    return ESP_OK;
+}
+
+void device_attributes_on_published(int msg_id)
+{
+    uint32_t acked = 0;
+
+    portENTER_CRITICAL(&s_lock);
+    if (s_pending_msg_id > ATTR_PUBLISH_QUEUED && msg_id == s_pending_msg_id) {
+        acked = s_pending_mask;
+        for (int i = 0; i < DEVICE_CLIENT_COUNT; i++) {
+            if (acked & (1U << i)) {
+                strlcpy(s_client[i].acked, s_client[i].sent, sizeof(s_client[i].acked));
+            }
+        }
+        s_pending_msg_id = -1;
+        s_pending_mask = 0;
+    }
+    portEXIT_CRITICAL(&s_lock);
+
+    if (acked == 0) {
+        return;
+    }
+
+    nvs_handle_t nvs_handle;
+    if (nvs_open(s_config.client_namespace, NVS_READWRITE, &nvs_handle) == ESP_OK) {
+        for (int i = 0; i < DEVICE_CLIENT_COUNT; i++) {
+            if (acked & (1U << i)) {
+                nvs_set_str(nvs_handle, s_client_names[i], s_client[i].acked);
+            }
+        }
+        nvs_commit(nvs_handle);
+        nvs_close(nvs_handle);
+    }
+
+    // Publish anything that changed while the delta was in flight
+    device_attributes_publish_client();
+}
+
+void device_attributes_on_connected(esp_mqtt_client_handle_t client)
+{
+    if (!s_initialized || !client) {
+        return;
+    }
+
+    portENTER_CRITICAL(&s_lock);
+    // A delta still unacknowledged from the last session is re-evaluated from scratch
+    s_pending_msg_id = -1;
+    s_pending_mask = 0;
+    portEXIT_CRITICAL(&s_lock);
+
+    esp_mqtt_client_subscribe(client, ATTR_TOPIC, 1);
+    esp_mqtt_client_subscribe(client, ATTR_RESPONSE_SUBSCRIBE, 1);
+
+    // Request the full shared set once per connection
+    char topic[sizeof(ATTR_REQUEST_PREFIX) + 10];
+    char payload[ATTR_REQUEST_MAX];
+    size_t len = strlcpy(payload, "{\"sharedKeys\":\"", sizeof(payload));
+    for (int i = 0; i < DEVICE_SHARED_COUNT; i++) {
+        if (i > 0) {
+            len = strlcat(payload, ",", sizeof(payload));
+        }
+        len = strlcat(payload, s_shared_info[i].name, sizeof(payload));
+    }
+    len = strlcat(payload, "\"}", sizeof(payload));
+    if (len < sizeof(payload)) {
+        snprintf(topic, sizeof(topic), ATTR_REQUEST_PREFIX "%lu", (unsigned long)++s_request_id);
+        mqtt_outbound_publish(MQTT_OUTBOUND_CONTROL, topic, payload, len, NULL, NULL);
+    } else {
+        ESP_LOGE(TAG, "Shared attribute request does not fit %d bytes", ATTR_REQUEST_MAX);
+    }
+
+    device_attributes_publish_client();
+}
+
+bool device_attributes_handle_data(const char* topic, int topic_len, const char* data, int data_len)
+{
+    if (!s_initialized || !topic || !data) {
+        return false;
+    }
+
+    bool is_update = (topic_len == (int)sizeof(ATTR_TOPIC) - 1 && memcmp(topic, ATTR_TOPIC, topic_len) == 0);
+    bool is_response = (topic_len > (int)sizeof(ATTR_RESPONSE_PREFIX) - 1 &&
+                        memcmp(topic, ATTR_RESPONSE_PREFIX, sizeof(ATTR_RESPONSE_PREFIX) - 1) == 0);
+    if (!is_update && !is_response) {
+        return false;
+    }
+
+    json_span_t root;
+    if (!json_scan_root(data, (size_t)data_len, &root) || root.type != JSON_SPAN_OBJECT) {
+        ESP_LOGW(TAG, "Malformed attribute message");
+        return true;
+    }
+
+    if (is_response) {
+        // Response to our request: {"shared":{...}}
+        json_span_t shared;
+        if (json_scan_key(&root, "shared", &shared) && shared.type == JSON_SPAN_OBJECT) {
+            apply_shared(&shared);
+        }
+    } else {
+        // Pushed update: flat {"key":value,...}
+        apply_shared(&root);
+    }
+    return true;
+}
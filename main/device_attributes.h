@@ -0,0 +1,208 @@
+#pragma once
+
+#include "esp_err.h"
+#include "mqtt_client.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * @file device_attributes.h
+ * @brief ThingsBoard shared/client attribute synchronization
+ *
+ * Shared attributes (server → device configuration) are kept in a typed
+ * local cache. The cache is loaded from NVS at boot, refreshed by one
+ * attribute request per connection and by pushed updates, and written back
+ * to NVS only for values that actually changed.
+ *
+ * Client attributes (device → server facts such as the firmware version)
+ * are published only when they differ from the last value the broker
+ * acknowledged. Acknowledged values are persisted, so reconnects and
+ * reboots with unchanged values publish nothing.
+ *
+ * Attribute names double as NVS keys and must be at most 15 characters.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Maximum length of a string attribute value (including terminator)
+ */
+#define DEVICE_ATTR_STRING_MAX 48
+
+/**
+ * @brief Shared attributes: X(id, key name, type, default int/bool, default string)
+ *
+ * The rbe*Db / rbe*SilMs pairs set the report-by-exception deadband (in the
+ * key's fixed-point units) and heartbeat of each telemetry key; -1 keeps the
+ * firmware default.
+ *
+ * gwChildren > 0 runs gateway mode with that many simulated child devices
+ * (read at boot, capped by the firmware).
+ */
+#define DEVICE_SHARED_ATTRIBUTES(X) \
+    X(UPLOAD_PERIOD,       "uploadPeriodMs", INT,    5000, "") \
+    X(REPORT_BY_EXCEPTION, "rbeEnabled",     BOOL,   1,    "") \
+    X(NTP_SERVER,          "ntpServer",      STRING, 0,    "pool.ntp.org") \
+    X(RECONNECT_BASE,      "reconnBaseMs",   INT,    1000, "") \
+    X(RECONNECT_CAP,       "reconnCapMs",    INT,    60000, "") \
+    X(DUTY_PERIOD,         "dutyPeriodMs",   INT,    0,    "") \
+    X(DUTY_UPLOAD_EVERY,   "dutyUploadN",    INT,    10,   "") \
+    X(GATEWAY_CHILDREN,    "gwChildren",     INT,    0,    "") \
+    X(RBE_TEMP_DB,         "rbeTempDb",      INT,    -1,   "") \
+    X(RBE_TEMP_SILENCE,    "rbeTempSilMs",   INT,    -1,   "") \
+    X(RBE_TEMP_MIN_DB,     "rbeTempMinDb",   INT,    -1,   "") \
+    X(RBE_TEMP_MIN_SILENCE, "rbeTempMinSilMs", INT,  -1,   "") \
+    X(RBE_TEMP_MAX_DB,     "rbeTempMaxDb",   INT,    -1,   "") \
+    X(RBE_TEMP_MAX_SILENCE, "rbeTempMaxSilMs", INT,  -1,   "") \
+    X(RBE_RSSI_DB,         "rbeRssiDb",      INT,    -1,   "") \
+    X(RBE_RSSI_SILENCE,    "rbeRssiSilMs",   INT,    -1,   "") \
+    X(RBE_HEAP_DB,         "rbeHeapDb",      INT,    -1,   "") \
+    X(RBE_HEAP_SILENCE,    "rbeHeapSilMs",   INT,    -1,   "") \
+    X(RBE_UPTIME_DB,       "rbeUptimeDb",    INT,    -1,   "") \
+    X(RBE_UPTIME_SILENCE,  "rbeUptimeSilMs", INT,    -1,   "")
+
+/**
+ * @brief Client attributes: X(id, key name)
+ */
+#define DEVICE_CLIENT_ATTRIBUTES(X) \
+    X(FW_VERSION,  "fwVersion") \
+    X(IP_ADDRESS,  "ipAddress") \
+    X(CERT_SOURCE, "certSource")
+
+/**
+ * @brief Attribute value types
+ */
+typedef enum {
+    DEVICE_ATTR_TYPE_INT = 0,
+    DEVICE_ATTR_TYPE_BOOL,
+    DEVICE_ATTR_TYPE_STRING,
+} device_attr_type_t;
+
+/**
+ * @brief Shared attribute identifiers
+ */
+typedef enum {
+#define DEVICE_SHARED_ATTR_ENUM(id, name, type, def_int, def_str) DEVICE_SHARED_##id,
+    DEVICE_SHARED_ATTRIBUTES(DEVICE_SHARED_ATTR_ENUM)
+#undef DEVICE_SHARED_ATTR_ENUM
+    DEVICE_SHARED_COUNT
+} device_shared_attr_t;
+
+/**
+ * @brief Client attribute identifiers
+ */
+typedef enum {
+#define DEVICE_CLIENT_ATTR_ENUM(id, name) DEVICE_CLIENT_##id,
+    DEVICE_CLIENT_ATTRIBUTES(DEVICE_CLIENT_ATTR_ENUM)
+#undef DEVICE_CLIENT_ATTR_ENUM
+    DEVICE_CLIENT_COUNT
+} device_client_attr_t;
+
+/**
+ * @brief Called after a shared attribute changed (from the MQTT task)
+ *
+ * @param attr Attribute that changed
+ * @param ctx Context pointer from the configuration
+ */
+typedef void (*device_attr_change_cb_t)(device_shared_attr_t attr, void* ctx);
+
+/**
+ * @brief Attribute module configuration
+ */
+typedef struct {
+    const char* shared_namespace;   /**< NVS namespace for cached shared attributes */
+    const char* client_namespace;   /**< NVS namespace for acknowledged client attributes */
+    device_attr_change_cb_t on_change; /**< Shared attribute change callback (optional) */
+    void* ctx;                      /**< Context passed to on_change */
+} device_attributes_config_t;
+
+/**
+ * @brief Default attribute module configuration
+ */
+#define DEVICE_ATTRIBUTES_DEFAULT_CONFIG() { \
+    .shared_namespace = "attr_shared", \
+    .client_namespace = "attr_client", \
+    .on_change = NULL, \
+    .ctx = NULL \
+}
+
+/**
+ * @brief Load the cache from NVS (defaults for missing values)
+ *
+ * @param config Module configuration
+ * @return esp_err_t ESP_OK on success
+ */
+esp_err_t device_attributes_init(const device_attributes_config_t* config);
+
+/**
+ * @brief Get an INT shared attribute
+ */
+int32_t device_attributes_get_int(device_shared_attr_t attr);
+
+/**
+ * @brief Get a BOOL shared attribute
+ */
+bool device_attributes_get_bool(device_shared_attr_t attr);
+
+/**
+ * @brief Copy a STRING shared attribute
+ *
+ * @param attr Attribute
+ * @param buf Output buffer
+ * @param size Size of the output buffer
+ * @return esp_err_t ESP_OK on success, ESP_ERR_INVALID_ARG if the attribute is not a string
+ */
+esp_err_t device_attributes_get_string(device_shared_attr_t attr, char* buf, size_t size);
+
+/**
+ * @brief Set the current value of a client attribute
+ *
+ * The value is published by the next device_attributes_publish_client call
+ * if it differs from the last acknowledged value.
+ *
+ * @param attr Attribute
+ * @param value Value (truncated to DEVICE_ATTR_STRING_MAX - 1 characters)
+ * @return esp_err_t ESP_OK on success
+ */
+esp_err_t device_attributes_set_client(device_client_attr_t attr, const char* value);
+
+/**
+ * @brief Subscribe to attribute topics, request shared attributes and publish client deltas
+ *
+ * Call on every MQTT_EVENT_CONNECTED.
+ *
+ * @param client MQTT client
+ */
+void device_attributes_on_connected(esp_mqtt_client_handle_t client);
+
+/**
+ * @brief Publish client attributes that differ from their acknowledged values
+ *
+ * The delta is queued in the outbound CONTROL class. Only one delta is in
+ * flight at a time; one that is not acknowledged within 30 s is given up,
+ * so calling this periodically also recovers from a lost PUBACK.
+ *
+ * @return esp_err_t ESP_OK if nothing was pending or the publish was queued
+ */
+esp_err_t device_attributes_publish_client(void);
+
+/**
+ * @brief Handle an MQTT_EVENT_DATA payload if it is an attribute update or response
+ *
+ * @return true if the message was an attribute message
+ */
+bool device_attributes_handle_data(const char* topic, int topic_len, const char* data, int data_len);
+
+/**
+ * @brief Handle a PUBACK reported by the outbound queue (see mqtt_outbound_ack_cb_t)
+ *
+ * @param msg_id Acknowledged message id
+ */
+void device_attributes_on_published(int msg_id);
+
+#ifdef __cplusplus
+}
+#endif
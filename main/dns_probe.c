@@ -0,0 +1,395 @@
+#include "dns_probe.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_random.h"
+#include "freertos/task.h"
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+static const char* TAG = "DNS_PROBE";
+
+#define DNS_PORT                53
+#define DNS_HEADER_LEN          12
+#define DNS_MESSAGE_MAX         512
+#define DNS_FLAG_RESPONSE       0x8000
+#define DNS_FLAG_RECURSION      0x0100
+#define DNS_RCODE_MASK          0x000F
+#define DNS_TYPE_A              1
+#define DNS_TYPE_CNAME          5
+#define DNS_CLASS_IN            1
+#define DNS_HOST_MAX            64
+
+/**
+ * @brief Cached broker address
+ */
+typedef struct {
+    char host[DNS_HOST_MAX];
+    struct in_addr addr;
+    int64_t expires_us;             /**< 0 if empty */
+} dns_cache_entry_t;
+
+static dns_probe_config_t s_config;
+static TaskHandle_t s_task = NULL;
+
+// Requests come from the event loop, lookups from the MQTT task, results from the probe task
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static char s_request_host[DNS_HOST_MAX];
+static uint32_t s_request_server = 0;
+static bool s_request_pending = false;
+static dns_cache_entry_t s_cache = {0};
+static dns_probe_stats_t s_stats = {0};
+
+static void put_u16(uint8_t* p, uint16_t value)
+{
+    p[0] = value >> 8;
+    p[1] = value & 0xFF;
+}
+
+static uint16_t get_u16(const uint8_t* p)
+{
+    return (uint16_t)((p[0] << 8) | p[1]);
+}
+
+static uint32_t get_u32(const uint8_t* p)
+{
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+/**
+ * @brief Build a recursive A query for host
+ *
+ * @return size_t Query length, 0 if host is not a valid name or does not fit
+ */
+static size_t build_query(uint8_t* buf, size_t size, uint16_t id, const char* host)
+{
+    size_t host_len = strlen(host);
+    if (host_len == 0 || DNS_HEADER_LEN + host_len + 2 + 4 > size) {
+        return 0;
+    }
+
+    memset(buf, 0, DNS_HEADER_LEN);
+    put_u16(buf, id);
+    put_u16(buf + 2, DNS_FLAG_RECURSION);
+    put_u16(buf + 4, 1);
+
+    // www.example.com -> 3www7example3com0
+    size_t pos = DNS_HEADER_LEN;
+    const char* label = host;
+    while (*label) {
+        const char* dot = strchr(label, '.');
+        size_t label_len = dot ? (size_t)(dot - label) : strlen(label);
+        if (label_len == 0 || label_len > 63) {
+            return 0;
+        }
+        buf[pos++] = (uint8_t)label_len;
+        memcpy(buf + pos, label, label_len);
+        pos += label_len;
+        label += label_len + (dot ? 1 : 0);
+    }
+    buf[pos++] = 0;
+    put_u16(buf + pos, DNS_TYPE_A);
+    put_u16(buf + pos + 2, DNS_CLASS_IN);
+    return pos + 4;
+}
+
+/**
+ * @brief Skip an encoded (possibly compressed) name
+ *
+ * @return int Offset after the name, -1 if malformed
+ */
+static int skip_name(const uint8_t* msg, size_t len, size_t pos)
+{
+    while (pos < len) {
+        uint8_t label_len = msg[pos];
+        if (label_len == 0) {
+            return (int)pos + 1;
+        }
+        if ((label_len & 0xC0) == 0xC0) {
+            return pos + 2 <= len ? (int)pos + 2 : -1;
+        }
+        if (label_len & 0xC0) {
+            return -1;
+        }
+        pos += 1 + label_len;
+    }
+    return -1;
+}
+
+/**
+ * @brief Extract the first A record of a response to query id
+ *
+ * The TTL is the smallest along the answer chain (CNAMEs included), since the
+ * address is only valid while every hop is.
+ *
+ * @return true if an address was found
+ */
+static bool parse_response(const uint8_t* msg, size_t len, uint16_t id, struct in_addr* addr, uint32_t* ttl_s)
+{
+    if (len < DNS_HEADER_LEN || get_u16(msg) != id) {
+        return false;
+    }
+    uint16_t flags = get_u16(msg + 2);
+    if (!(flags & DNS_FLAG_RESPONSE) || (flags & DNS_RCODE_MASK) != 0) {
+        return false;
+    }
+    uint16_t questions = get_u16(msg + 4);
+    uint16_t answers = get_u16(msg + 6);
+
+    int pos = DNS_HEADER_LEN;
+    for (uint16_t i = 0; i < questions; i++) {
+        pos = skip_name(msg, len, pos);
+        if (pos < 0 || (size_t)pos + 4 > len) {
+            return false;
+        }
+        pos += 4;
+    }
+
+    uint32_t min_ttl = UINT32_MAX;
+    for (uint16_t i = 0; i < answers; i++) {
+        pos = skip_name(msg, len, pos);
+        if (pos < 0 || (size_t)pos + 10 > len) {
+            return false;
+        }
+        uint16_t type = get_u16(msg + pos);
+        uint16_t rr_class = get_u16(msg + pos + 2);
+        uint32_t ttl = get_u32(msg + pos + 4);
+        uint16_t rdlength = get_u16(msg + pos + 8);
+        pos += 10;
+        if ((size_t)pos + rdlength > len) {
+            return false;
+        }
+        if (rr_class == DNS_CLASS_IN && (type == DNS_TYPE_A || type == DNS_TYPE_CNAME) && ttl < min_ttl) {
+            min_ttl = ttl;
+        }
+        if (rr_class == DNS_CLASS_IN && type == DNS_TYPE_A && rdlength == 4) {
+            memcpy(&addr->s_addr, msg + pos, 4);
+            *ttl_s = min_ttl;
+            return true;
+        }
+        pos += rdlength;
+    }
+    return false;
+}
+
+/**
+ * @brief Query server for host, retrying on timeout
+ */
+static bool resolve(const char* host, uint32_t server, struct in_addr* addr, uint32_t* ttl_s)
+{
+    int sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (sock < 0) {
+        ESP_LOGE(TAG, "Failed to create socket");
+        return false;
+    }
+
+    struct sockaddr_in to = {
+        .sin_family = AF_INET,
+        .sin_port = htons(DNS_PORT),
+        .sin_addr.s_addr = server,
+    };
+    uint8_t msg[DNS_MESSAGE_MAX];
+    bool resolved = false;
+    for (uint8_t attempt = 0; attempt < s_config.attempts && !resolved; attempt++) {
+        uint16_t id = (uint16_t)esp_random();
+        size_t query_len = build_query(msg, sizeof(msg), id, host);
+        if (query_len == 0) {
+            ESP_LOGE(TAG, "Invalid host name: %s", host);
+            break;
+        }
+        if (sendto(sock, msg, query_len, 0, (struct sockaddr*)&to, sizeof(to)) < 0) {
+            break;
+        }
+
+        // Skip stray datagrams (late answers to an earlier attempt) until the deadline
+        int64_t deadline_us = esp_timer_get_time() + (int64_t)s_config.timeout_ms * 1000;
+        while (!resolved) {
+            int64_t remaining_us = deadline_us - esp_timer_get_time();
+            if (remaining_us <= 0) {
+                break;
+            }
+            struct timeval timeout = {
+                .tv_sec = remaining_us / 1000000,
+                .tv_usec = remaining_us % 1000000,
+            };
+            setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+            struct sockaddr_in from;
+            socklen_t from_len = sizeof(from);
+            int len = recvfrom(sock, msg, sizeof(msg), 0, (struct sockaddr*)&from, &from_len);
+            if (len < 0) {
+                break;
+            }
+            if (from.sin_addr.s_addr == server && from.sin_port == htons(DNS_PORT)) {
+                resolved = parse_response(msg, (size_t)len, id, addr, ttl_s);
+            }
+        }
+    }
+    close(sock);
+    return resolved;
+}
+
+static void record_result(bool ok, uint32_t latency_ms, uint32_t ttl_s)
+{
+    portENTER_CRITICAL(&s_lock);
+    s_stats.probes++;
+    if (!ok) {
+        s_stats.failures++;
+    }
+    s_stats.last_ok = ok;
+    s_stats.last_latency_ms = latency_ms;
+    if (ok) {
+        s_stats.last_ttl_s = ttl_s;
+    }
+    portEXIT_CRITICAL(&s_lock);
+
+    if (s_config.on_result) {
+        s_config.on_result(ok, latency_ms, s_config.ctx);
+    }
+}
+
+static void probe(const char* host, uint32_t server)
+{
+    if (server == 0) {
+        ESP_LOGW(TAG, "No DNS server, cannot resolve %s", host);
+        record_result(false, 0, 0);
+        return;
+    }
+
+    struct in_addr addr;
+    uint32_t ttl_s = 0;
+    int64_t start_us = esp_timer_get_time();
+    bool ok = resolve(host, server, &addr, &ttl_s);
+    uint32_t latency_ms = (uint32_t)((esp_timer_get_time() - start_us) / 1000);
+    if (!ok) {
+        ESP_LOGW(TAG, "%s did not resolve (%lu ms)", host, (unsigned long)latency_ms);
+        record_result(false, latency_ms, 0);
+        return;
+    }
+
+    // A zero TTL would send every reconnect back to DNS; a huge one would outlive a broker move
+    if (ttl_s < s_config.min_ttl_s) {
+        ttl_s = s_config.min_ttl_s;
+    } else if (ttl_s > s_config.max_ttl_s) {
+        ttl_s = s_config.max_ttl_s;
+    }
+    portENTER_CRITICAL(&s_lock);
+    strlcpy(s_cache.host, host, sizeof(s_cache.host));
+    s_cache.addr = addr;
+    s_cache.expires_us = esp_timer_get_time() + (int64_t)ttl_s * 1000000;
+    portEXIT_CRITICAL(&s_lock);
+
+    char addr_str[INET_ADDRSTRLEN];
+    inet_ntop(AF_INET, &addr, addr_str, sizeof(addr_str));
+    ESP_LOGI(TAG, "%s -> %s in %lu ms (cached for %lu s)", host, addr_str, (unsigned long)latency_ms,
+             (unsigned long)ttl_s);
+    record_result(true, latency_ms, ttl_s);
+}
+
+static void probe_task(void* arg)
+{
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        char host[DNS_HOST_MAX];
+        portENTER_CRITICAL(&s_lock);
+        bool pending = s_request_pending;
+        s_request_pending = false;
+        strlcpy(host, s_request_host, sizeof(host));
+        uint32_t server = s_request_server;
+        portEXIT_CRITICAL(&s_lock);
+
+        if (pending) {
+            probe(host, server);
+        }
+    }
+}
+
+esp_err_t dns_probe_init(const dns_probe_config_t* config)
+{
+    if (!config || config->attempts == 0 || config->timeout_ms == 0 || config->min_ttl_s > config->max_ttl_s) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_task) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    s_config = *config;
+    if (xTaskCreate(probe_task, "dns_probe", config->stack_size, NULL, config->priority, &s_task) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create probe task");
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+esp_err_t dns_probe_start(esp_netif_t* netif, const char* host)
+{
+    if (!netif || !host || strlen(host) >= DNS_HOST_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!s_task) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    struct in_addr literal;
+    if (inet_pton(AF_INET, host, &literal) == 1) {
+        record_result(true, 0, 0);
+        return ESP_OK;
+    }
+
+    uint32_t server = 0;
+    esp_netif_dns_info_t dns;
+    if (esp_netif_get_dns_info(netif, ESP_NETIF_DNS_MAIN, &dns) == ESP_OK && dns.ip.type == ESP_IPADDR_TYPE_V4) {
+        server = dns.ip.u_addr.ip4.addr;
+    }
+
+    portENTER_CRITICAL(&s_lock);
+    strlcpy(s_request_host, host, sizeof(s_request_host));
+    s_request_server = server;
+    s_request_pending = true;
+    portEXIT_CRITICAL(&s_lock);
+    xTaskNotifyGive(s_task);
+    return ESP_OK;
+}
+
+bool dns_probe_lookup(const char* host, char* addr, size_t size)
+{
+    if (!host || !addr || size < INET_ADDRSTRLEN) {
+        return false;
+    }
+
+    struct in_addr cached;
+    bool hit = false;
+    int64_t now_us = esp_timer_get_time();
+    portENTER_CRITICAL(&s_lock);
+    if (s_cache.expires_us > now_us && strcmp(s_cache.host, host) == 0) {
+        cached = s_cache.addr;
+        s_stats.cache_hits++;
+        hit = true;
+    }
+    portEXIT_CRITICAL(&s_lock);
+
+    return hit && inet_ntop(AF_INET, &cached, addr, size) != NULL;
+}
+
+void dns_probe_invalidate(const char* host)
+{
+    portENTER_CRITICAL(&s_lock);
+    if (!host || strcmp(s_cache.host, host) == 0) {
+        s_cache.expires_us = 0;
+    }
+    portEXIT_CRITICAL(&s_lock);
+}
+
+void dns_probe_get_stats(dns_probe_stats_t* stats)
+{
+    if (!stats) {
+        return;
+    }
+    portENTER_CRITICAL(&s_lock);
+    *stats = s_stats;
+    portEXIT_CRITICAL(&s_lock);
+}
@@ -0,0 +1,123 @@
+#pragma once
+
+#include "esp_err.h"
+#include "esp_netif.h"
+#include "freertos/FreeRTOS.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * @file dns_probe.h
+ * @brief Asynchronous broker DNS probe with a TTL-bounded address cache
+ *
+ * A probe resolves the broker host on its own task with a direct query to
+ * the interface's DNS server, so neither the event loop nor the MQTT connect
+ * waits for it. The answer's TTL (the smallest along a CNAME chain, clamped
+ * to min_ttl_s..max_ttl_s) bounds how long the address is cached. While the
+ * entry is fresh, connects use the cached address and skip DNS. The probe
+ * result doubles as the internet connectivity check and its latency is
+ * kept for telemetry.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Called when a probe completes (must not block)
+ *
+ * Runs in the probe task, or in the caller of dns_probe_start() for IPv4
+ * literals.
+ *
+ * @param ok true if the host resolved
+ * @param latency_ms Time from sending the first query to the answer or the last timeout
+ * @param ctx Context pointer from the configuration
+ */
+typedef void (*dns_probe_result_cb_t)(bool ok, uint32_t latency_ms, void* ctx);
+
+/**
+ * @brief Probe configuration
+ */
+typedef struct {
+    uint32_t timeout_ms;            /**< Wait for an answer per query */
+    uint8_t attempts;               /**< Queries sent before the probe fails */
+    uint32_t min_ttl_s;             /**< Lower bound on the cache lifetime */
+    uint32_t max_ttl_s;             /**< Upper bound on the cache lifetime */
+    uint32_t stack_size;            /**< Probe task stack size */
+    UBaseType_t priority;           /**< Probe task priority */
+    dns_probe_result_cb_t on_result; /**< Optional result callback */
+    void* ctx;                      /**< Passed to on_result */
+} dns_probe_config_t;
+
+/**
+ * @brief Default probe configuration
+ */
+#define DNS_PROBE_DEFAULT_CONFIG() { \
+    .timeout_ms = 2000, \
+    .attempts = 2, \
+    .min_ttl_s = 30, \
+    .max_ttl_s = 3600, \
+    .stack_size = 3072, \
+    .priority = 4, \
+    .on_result = NULL, \
+    .ctx = NULL \
+}
+
+/**
+ * @brief Probe statistics since boot
+ */
+typedef struct {
+    uint32_t probes;                /**< Completed probes */
+    uint32_t failures;              /**< ... of which did not resolve */
+    uint32_t cache_hits;            /**< Lookups answered from the cache */
+    uint32_t last_latency_ms;       /**< Latency of the last probe */
+    uint32_t last_ttl_s;            /**< Cache lifetime granted by the last successful probe */
+    bool last_ok;                   /**< Last probe resolved */
+} dns_probe_stats_t;
+
+/**
+ * @brief Create the probe task
+ *
+ * @param config Probe configuration
+ * @return esp_err_t ESP_OK on success
+ */
+esp_err_t dns_probe_init(const dns_probe_config_t* config);
+
+/**
+ * @brief Queue a probe of host through netif's DNS server (returns immediately)
+ *
+ * A request made while a probe is running replaces any request still waiting.
+ * IPv4 literals need no DNS and complete at once.
+ *
+ * @param netif Interface whose main DNS server is queried
+ * @param host Host name (copied)
+ * @return esp_err_t ESP_OK if the probe was queued
+ */
+esp_err_t dns_probe_start(esp_netif_t* netif, const char* host);
+
+/**
+ * @brief Cached address of host, if the cache entry is still fresh
+ *
+ * @param host Host name
+ * @param addr Dotted-quad address (output)
+ * @param size Size of addr (at least 16)
+ * @return true if addr was filled from the cache
+ */
+bool dns_probe_lookup(const char* host, char* addr, size_t size);
+
+/**
+ * @brief Drop the cached address of host, e.g. after connecting to it failed
+ */
+void dns_probe_invalidate(const char* host);
+
+/**
+ * @brief Get probe statistics
+ *
+ * @param stats Statistics (output)
+ */
+void dns_probe_get_stats(dns_probe_stats_t* stats);
+
+#ifdef __cplusplus
+}
+#endif
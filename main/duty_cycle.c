@@ -0,0 +1,149 @@
+#include "duty_cycle.h"
+#include <string.h>
+
+// Changes whenever duty_cycle_state_t changes layout, so retained state from older firmware is discarded
+#define DUTY_CYCLE_MAGIC        (0x44430000U | (uint32_t)sizeof(duty_cycle_state_t))
+
+void duty_cycle_reset(duty_cycle_state_t* state)
+{
+    memset(state, 0, sizeof(*state));
+    state->magic = DUTY_CYCLE_MAGIC;
+}
+
+bool duty_cycle_valid(const duty_cycle_state_t* state)
+{
+    return state->magic == DUTY_CYCLE_MAGIC && state->count <= DUTY_CYCLE_MAX_SAMPLES &&
+           state->head < DUTY_CYCLE_MAX_SAMPLES;
+}
+
+bool duty_cycle_record(duty_cycle_state_t* state, const duty_cycle_config_t* config,
+                       const telemetry_sample_t* sample)
+{
+    if (state->count == DUTY_CYCLE_MAX_SAMPLES) {
+        state->head = (state->head + 1) % DUTY_CYCLE_MAX_SAMPLES;
+        state->count--;
+        state->samples_dropped++;
+    }
+    state->samples[(state->head + state->count) % DUTY_CYCLE_MAX_SAMPLES] = *sample;
+    state->count++;
+    state->wakes++;
+    state->wakes_since_upload++;
+
+    uint32_t upload_every = config->upload_every > 0 ? config->upload_every : 1;
+    return state->wakes_since_upload >= upload_every || state->count == DUTY_CYCLE_MAX_SAMPLES;
+}
+
+size_t duty_cycle_peek(const duty_cycle_state_t* state, telemetry_sample_t* out, size_t max_samples)
+{
+    size_t count = state->count < max_samples ? state->count : max_samples;
+    for (size_t i = 0; i < count; i++) {
+        out[i] = state->samples[(state->head + i) % DUTY_CYCLE_MAX_SAMPLES];
+    }
+    return count;
+}
+
+void duty_cycle_consume(duty_cycle_state_t* state, size_t count)
+{
+    if (count > state->count) {
+        count = state->count;
+    }
+    state->head = (state->head + count) % DUTY_CYCLE_MAX_SAMPLES;
+    state->count -= count;
+    state->samples_uploaded += count;
+}
+
+void duty_cycle_upload_done(duty_cycle_state_t* state, uint32_t radio_on_us, bool ok)
+{
+    state->radio_on_us += radio_on_us;
+    state->last_radio_on_us = radio_on_us;
+    if (ok) {
+        state->uploads++;
+        state->wakes_since_upload = 0;
+    } else {
+        // Keep the count: the next wake tries again instead of waiting another full cycle
+        state->upload_failures++;
+    }
+}
+
+void duty_cycle_upload_begin(duty_cycle_upload_t* upload)
+{
+    memset(upload, 0, sizeof(*upload));
+}
+
+duty_cycle_chunk_t* duty_cycle_upload_reserve(duty_cycle_upload_t* upload)
+{
+    if (upload->count == DUTY_CYCLE_MAX_SAMPLES) {
+        return NULL;
+    }
+    duty_cycle_chunk_t* chunk = &upload->chunks[upload->count];
+    memset(chunk, 0, sizeof(*chunk));
+    return chunk;
+}
+
+void duty_cycle_upload_commit(duty_cycle_upload_t* upload, uint16_t samples)
+{
+    if (upload->count < DUTY_CYCLE_MAX_SAMPLES) {
+        upload->chunks[upload->count].samples = samples;
+        upload->count++;
+    }
+}
+
+bool duty_cycle_upload_ack(duty_cycle_upload_t* upload, int msg_id)
+{
+    if (msg_id <= 0) {
+        return false;
+    }
+    // The reserved slot is searched too: its PUBACK may arrive before the commit
+    size_t slots = upload->count < DUTY_CYCLE_MAX_SAMPLES ? upload->count + 1 : DUTY_CYCLE_MAX_SAMPLES;
+    for (size_t i = 0; i < slots; i++) {
+        if (upload->chunks[i].msg_id == msg_id) {
+            upload->chunks[i].acked = true;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool duty_cycle_upload_settled(const duty_cycle_upload_t* upload)
+{
+    for (size_t i = 0; i < upload->count; i++) {
+        if (!upload->chunks[i].acked && upload->chunks[i].msg_id >= 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+size_t duty_cycle_upload_acked_samples(const duty_cycle_upload_t* upload)
+{
+    size_t samples = 0;
+    for (size_t i = 0; i < upload->count && upload->chunks[i].acked; i++) {
+        samples += upload->chunks[i].samples;
+    }
+    return samples;
+}
+
+uint64_t duty_cycle_next_sleep_us(duty_cycle_state_t* state, const duty_cycle_config_t* config, int64_t now_us)
+{
+    int64_t period_us = (int64_t)(config->period_ms > 0 ? config->period_ms : 1) * 1000;
+
+    // First wake, or the clock moved backwards (e.g. SNTP stepped it): restart the schedule here
+    if (state->next_wake_us == 0 || state->next_wake_us - now_us > period_us) {
+        state->next_wake_us = now_us;
+    }
+    state->next_wake_us += period_us;
+    if (state->next_wake_us <= now_us) {
+        // Overran one or more deadlines: skip to the first one still ahead
+        int64_t missed = (now_us - state->next_wake_us) / period_us + 1;
+        state->next_wake_us += missed * period_us;
+    }
+    return (uint64_t)(state->next_wake_us - now_us);
+}
+
+uint32_t duty_cycle_radio_us_per_sample(const duty_cycle_state_t* state)
+{
+    if (state->samples_uploaded == 0) {
+        return 0;
+    }
+    return (uint32_t)(state->radio_on_us / state->samples_uploaded);
+}
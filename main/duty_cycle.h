@@ -0,0 +1,201 @@
+#pragma once
+
+#include "telemetry_buffer.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * @file duty_cycle.h
+ * @brief Deep-sleep duty cycling: wake schedule and retained sample buffer
+ *
+ * In duty-cycled mode the device wakes from deep sleep once per period,
+ * records one sample and sleeps again. Only every upload_every-th wake (or
+ * when the buffer is full) brings up Wi-Fi and MQTT to publish the buffered
+ * batch. Wakes are scheduled on absolute deadlines, so time spent awake does
+ * not accumulate as drift; deadlines missed during a long upload are skipped.
+ *
+ * The state is plain data meant to live in RTC memory (RTC_DATA_ATTR) and
+ * takes all times as arguments, so the schedule and buffering can be run on
+ * the host. It also accumulates the radio-on time of upload wakes, giving
+ * the radio cost per uploaded sample.
+ *
+ * An upload wake tracks each publish of the batch by MQTT message id
+ * (duty_cycle_upload_t), so when the radio budget runs out the samples of
+ * the acknowledged leading publishes are still consumed and only the rest is
+ * sent again on the next upload wake.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Retained samples (RTC memory is small: about 40 bytes per sample)
+ */
+#define DUTY_CYCLE_MAX_SAMPLES 32
+
+/**
+ * @brief Duty cycle configuration
+ */
+typedef struct {
+    uint32_t period_ms;             /**< Wake (sampling) period */
+    uint32_t upload_every;          /**< Upload on every Nth wake (1 = every wake) */
+} duty_cycle_config_t;
+
+/**
+ * @brief Default duty cycle configuration
+ */
+#define DUTY_CYCLE_DEFAULT_CONFIG() { \
+    .period_ms = 60000, \
+    .upload_every = 10 \
+}
+
+/**
+ * @brief Retained duty cycle state
+ *
+ * Sample timestamps are epoch microseconds, 0 when the time was unknown
+ * (same convention as the telemetry store).
+ */
+typedef struct {
+    uint32_t magic;                 /**< Set by duty_cycle_reset() */
+    uint32_t wakes;                 /**< Wakes since the state was reset */
+    uint32_t wakes_since_upload;    /**< Wakes since the last successful upload */
+    int64_t next_wake_us;           /**< Next deadline on the caller's clock, 0 = not scheduled */
+    uint16_t head;                  /**< Index of the oldest sample */
+    uint16_t count;                 /**< Samples held */
+    telemetry_sample_t samples[DUTY_CYCLE_MAX_SAMPLES];
+    uint64_t radio_on_us;           /**< Radio-on time of all upload wakes */
+    uint32_t last_radio_on_us;      /**< Radio-on time of the last upload wake */
+    uint32_t samples_uploaded;      /**< Samples acknowledged by the broker */
+    uint32_t samples_dropped;       /**< Oldest samples overwritten while the buffer was full */
+    uint32_t uploads;               /**< Upload wakes that published the batch */
+    uint32_t upload_failures;       /**< Upload wakes that gave up (samples kept) */
+} duty_cycle_state_t;
+
+/**
+ * @brief One publish of an upload wake
+ */
+typedef struct {
+    int msg_id;                     /**< MQTT message id, 0 while queued, -1 if the publish was dropped */
+    uint16_t samples;               /**< Samples carried by the publish */
+    bool acked;                     /**< PUBACK received (or nothing to acknowledge) */
+} duty_cycle_chunk_t;
+
+/**
+ * @brief Publishes of one upload wake, oldest samples first
+ *
+ * Plain data: the caller serializes access when message ids and PUBACKs are
+ * recorded from other tasks.
+ */
+typedef struct {
+    duty_cycle_chunk_t chunks[DUTY_CYCLE_MAX_SAMPLES]; /**< Every publish carries at least one sample */
+    size_t count;                   /**< Committed publishes */
+} duty_cycle_upload_t;
+
+/**
+ * @brief Clear the state (power-on, or a layout from another firmware)
+ */
+void duty_cycle_reset(duty_cycle_state_t* state);
+
+/**
+ * @brief True if the state was initialized by duty_cycle_reset() of this firmware
+ */
+bool duty_cycle_valid(const duty_cycle_state_t* state);
+
+/**
+ * @brief Record one wake and its sample
+ *
+ * When the buffer is full the oldest sample is overwritten.
+ *
+ * @param state Retained state
+ * @param config Duty cycle configuration
+ * @param sample Sample taken on this wake
+ * @return true if this wake must upload the buffer
+ */
+bool duty_cycle_record(duty_cycle_state_t* state, const duty_cycle_config_t* config,
+                       const telemetry_sample_t* sample);
+
+/**
+ * @brief Copy buffered samples, oldest first, without removing them
+ *
+ * @return Number of samples copied
+ */
+size_t duty_cycle_peek(const duty_cycle_state_t* state, telemetry_sample_t* out, size_t max_samples);
+
+/**
+ * @brief Remove the oldest count samples after the broker acknowledged them
+ */
+void duty_cycle_consume(duty_cycle_state_t* state, size_t count);
+
+/**
+ * @brief Close an upload wake
+ *
+ * @param state Retained state
+ * @param radio_on_us Time the radio was on during this wake
+ * @param ok true if the whole batch was acknowledged (restarts the upload count)
+ */
+void duty_cycle_upload_done(duty_cycle_state_t* state, uint32_t radio_on_us, bool ok);
+
+/**
+ * @brief Start tracking the publishes of an upload wake
+ */
+void duty_cycle_upload_begin(duty_cycle_upload_t* upload);
+
+/**
+ * @brief Clear the slot for the next publish and return it
+ *
+ * The slot is passed to the publish before it is known to be queued, so its
+ * message id can be recorded as soon as the publish goes out. Reserving again
+ * without a commit reuses the slot.
+ *
+ * @return Slot of the next publish, NULL when every slot is committed
+ */
+duty_cycle_chunk_t* duty_cycle_upload_reserve(duty_cycle_upload_t* upload);
+
+/**
+ * @brief Commit the reserved slot once its publish was queued
+ *
+ * @param upload Upload tracking
+ * @param samples Samples carried by the publish
+ */
+void duty_cycle_upload_commit(duty_cycle_upload_t* upload, uint16_t samples);
+
+/**
+ * @brief Record a PUBACK
+ *
+ * @return true if msg_id belongs to a publish of this upload
+ */
+bool duty_cycle_upload_ack(duty_cycle_upload_t* upload, int msg_id);
+
+/**
+ * @brief True once every committed publish was acknowledged or dropped
+ */
+bool duty_cycle_upload_settled(const duty_cycle_upload_t* upload);
+
+/**
+ * @brief Samples of the leading acknowledged publishes (safe to consume)
+ *
+ * Counting stops at the first publish without a PUBACK, so later
+ * acknowledged publishes are sent again rather than leaving a gap.
+ */
+size_t duty_cycle_upload_acked_samples(const duty_cycle_upload_t* upload);
+
+/**
+ * @brief Advance to the next wake deadline and return the time to sleep
+ *
+ * @param state Retained state
+ * @param config Duty cycle configuration
+ * @param now_us Current time on a clock that keeps running in deep sleep
+ * @return Sleep duration in microseconds (at least 1)
+ */
+uint64_t duty_cycle_next_sleep_us(duty_cycle_state_t* state, const duty_cycle_config_t* config, int64_t now_us);
+
+/**
+ * @brief Average radio-on time per uploaded sample in microseconds (0 before the first upload)
+ */
+uint32_t duty_cycle_radio_us_per_sample(const duty_cycle_state_t* state);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,415 @@
+#include "gateway.h"
+#include "mqtt_outbound.h"
+#include "telemetry_serializer.h"
+#include "freertos/FreeRTOS.h"
+#include "esp_log.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char* TAG = "GATEWAY";
+
+#define GATEWAY_CONNECT_TOPIC       "v1/gateway/connect"
+#define GATEWAY_TELEMETRY_TOPIC     "v1/gateway/telemetry"
+#define GATEWAY_ATTRIBUTES_TOPIC    "v1/gateway/attributes"
+#define GATEWAY_PAYLOAD_MAX         4096    // One multi-device telemetry payload
+#define GATEWAY_CONTROL_MAX         256     // Connect and attribute payloads
+
+/**
+ * @brief Timestamped values of one child reading
+ */
+typedef struct {
+    int64_t captured_us;
+    int32_t values[GATEWAY_RECORD_VALUES];
+    uint8_t keys[GATEWAY_RECORD_VALUES];
+    uint8_t count;
+} gateway_record_t;
+
+/**
+ * @brief Child device with its pending records
+ */
+typedef struct {
+    char name[GATEWAY_DEVICE_NAME_MAX];
+    const char* type;
+    gateway_record_t records[GATEWAY_DEVICE_RECORDS];
+    uint8_t head;                   /**< Oldest pending record */
+    uint8_t pending;                /**< Pending records */
+    uint8_t serialized;             /**< Records in the payload being built */
+    bool connected;                 /**< Connect published in this MQTT session */
+    bool connect_queued;            /**< Connect waiting in the outbound queue */
+} gateway_device_t;
+
+typedef struct {
+    const char* name;
+    uint8_t decimals;
+} gateway_key_t;
+
+// Records are added from sampling tasks, flushed by the telemetry task;
+// connect completions arrive from the outbound task
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static gateway_config_t s_config;
+static gateway_device_t* s_devices = NULL;
+static uint16_t s_device_count = 0;
+static gateway_key_t s_keys[GATEWAY_MAX_KEYS];
+static uint8_t s_key_count = 0;
+static gateway_stats_t s_stats = {0};
+
+// Payload scratch space, only used by gateway_flush
+static char s_payload[GATEWAY_PAYLOAD_MAX];
+
+/**
+ * @brief Names are embedded in JSON without escaping
+ */
+static bool valid_name(const char* name, size_t max_len)
+{
+    size_t len = name ? strnlen(name, max_len) : 0;
+    if (len == 0 || len >= max_len) {
+        return false;
+    }
+    return strpbrk(name, "\"\\") == NULL;
+}
+
+/**
+ * @brief Bounded append; returns false (leaving len unchanged) if it does not fit
+ */
+static bool append(char* buf, size_t size, size_t* len, const char* data, size_t data_len)
+{
+    if (*len + data_len >= size) {
+        return false;
+    }
+    memcpy(buf + *len, data, data_len);
+    *len += data_len;
+    return true;
+}
+
+static bool append_str(char* buf, size_t size, size_t* len, const char* str)
+{
+    return append(buf, size, len, str, strlen(str));
+}
+
+/**
+ * @brief Append a JSON string literal, escaping quotes and backslashes
+ */
+static bool append_quoted(char* buf, size_t size, size_t* len, const char* str)
+{
+    size_t start = *len;
+    bool ok = append(buf, size, len, "\"", 1);
+    for (const char* c = str; ok && *c; c++) {
+        if (*c == '"' || *c == '\\') {
+            ok = append(buf, size, len, "\\", 1);
+        }
+        ok = ok && append(buf, size, len, c, 1);
+    }
+    ok = ok && append(buf, size, len, "\"", 1);
+    if (!ok) {
+        *len = start;
+    }
+    return ok;
+}
+
+/**
+ * @brief Append "name":[{"ts":...,"values":{...}},...] for a snapshot of records
+ */
+static bool append_device_entry(size_t* len, const char* name, const gateway_record_t* records, int count,
+                                int64_t epoch_offset_ms)
+{
+    char number[24];
+    bool ok = append_quoted(s_payload, sizeof(s_payload), len, name) &&
+              append_str(s_payload, sizeof(s_payload), len, ":[");
+
+    for (int r = 0; ok && r < count; r++) {
+        const gateway_record_t* record = &records[r];
+        int n = snprintf(number, sizeof(number), "%lld", (long long)(record->captured_us / 1000 + epoch_offset_ms));
+        ok = append_str(s_payload, sizeof(s_payload), len, r > 0 ? ",{\"ts\":" : "{\"ts\":") &&
+             append(s_payload, sizeof(s_payload), len, number, (size_t)n) &&
+             append_str(s_payload, sizeof(s_payload), len, ",\"values\":{");
+        for (int v = 0; ok && v < record->count; v++) {
+            const gateway_key_t* key = &s_keys[record->keys[v]];
+            size_t number_len = telemetry_serialize_fixed(record->values[v], key->decimals, number, sizeof(number));
+            ok = (v == 0 || append(s_payload, sizeof(s_payload), len, ",", 1)) &&
+                 append_quoted(s_payload, sizeof(s_payload), len, key->name) &&
+                 append(s_payload, sizeof(s_payload), len, ":", 1) &&
+                 number_len > 0 && append(s_payload, sizeof(s_payload), len, number, number_len);
+        }
+        ok = ok && append_str(s_payload, sizeof(s_payload), len, "}}");
+    }
+    return ok && append(s_payload, sizeof(s_payload), len, "]", 1);
+}
+
+/**
+ * @brief Queue one telemetry payload and release the records it carries
+ */
+static bool publish_payload(size_t len)
+{
+    s_payload[len++] = '}';
+    bool queued = mqtt_outbound_publish(MQTT_OUTBOUND_TELEMETRY, GATEWAY_TELEMETRY_TOPIC, s_payload, len,
+                                        NULL, NULL) == ESP_OK;
+
+    portENTER_CRITICAL(&s_lock);
+    for (int i = 0; i < s_device_count; i++) {
+        gateway_device_t* device = &s_devices[i];
+        if (device->serialized == 0) {
+            continue;
+        }
+        if (queued) {
+            device->head = (device->head + device->serialized) % GATEWAY_DEVICE_RECORDS;
+            device->pending -= device->serialized;
+            s_stats.records_published += device->serialized;
+        }
+        device->serialized = 0;
+    }
+    if (queued) {
+        s_stats.publishes++;
+        s_stats.payload_bytes += len;
+    }
+    portEXIT_CRITICAL(&s_lock);
+    return queued;
+}
+
+static void connect_done(int msg_id, void* ctx)
+{
+    int index = (int)(intptr_t)ctx;
+    portENTER_CRITICAL(&s_lock);
+    s_devices[index].connect_queued = false;
+    s_devices[index].connected = msg_id >= 0;
+    portEXIT_CRITICAL(&s_lock);
+}
+
+/**
+ * @brief Announce a few not-yet-connected children per flush so the control queue never floods
+ */
+static void queue_connects(void)
+{
+    char payload[GATEWAY_CONTROL_MAX];
+    int budget = s_config.connects_per_flush;
+
+    for (int i = 0; i < s_device_count && budget > 0; i++) {
+        gateway_device_t* device = &s_devices[i];
+        portENTER_CRITICAL(&s_lock);
+        bool needed = !device->connected && !device->connect_queued;
+        device->connect_queued |= needed;
+        portEXIT_CRITICAL(&s_lock);
+        if (!needed) {
+            continue;
+        }
+
+        int len = snprintf(payload, sizeof(payload), "{\"device\":\"%s\",\"type\":\"%s\"}", device->name, device->type);
+        if (mqtt_outbound_publish(MQTT_OUTBOUND_CONTROL, GATEWAY_CONNECT_TOPIC, payload, len, connect_done,
+                                  (void*)(intptr_t)i) != ESP_OK) {
+            portENTER_CRITICAL(&s_lock);
+            device->connect_queued = false;
+            portEXIT_CRITICAL(&s_lock);
+            return;
+        }
+        budget--;
+    }
+}
+
+esp_err_t gateway_init(const gateway_config_t* config)
+{
+    if (!config || config->max_devices == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_devices) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    s_devices = calloc(config->max_devices, sizeof(gateway_device_t));
+    if (!s_devices) {
+        ESP_LOGE(TAG, "Failed to allocate %u child devices", config->max_devices);
+        return ESP_ERR_NO_MEM;
+    }
+    s_config = *config;
+    s_device_count = 0;
+    s_key_count = 0;
+    memset(&s_stats, 0, sizeof(s_stats));
+    s_stats.bytes_per_device = sizeof(gateway_device_t);
+
+    ESP_LOGI(TAG, "Gateway ready for %u child devices (%u bytes each)", config->max_devices,
+             (unsigned)sizeof(gateway_device_t));
+    return ESP_OK;
+}
+
+esp_err_t gateway_register_key(const char* name, uint8_t decimals, uint8_t* ret_key)
+{
+    if (!valid_name(name, GATEWAY_DEVICE_NAME_MAX) || decimals > 9 || !ret_key) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    portENTER_CRITICAL(&s_lock);
+    for (int i = 0; i < s_key_count; i++) {
+        if (strcmp(s_keys[i].name, name) == 0) {
+            *ret_key = (uint8_t)i;
+            portEXIT_CRITICAL(&s_lock);
+            return ESP_OK;
+        }
+    }
+    if (s_key_count >= GATEWAY_MAX_KEYS) {
+        portEXIT_CRITICAL(&s_lock);
+        return ESP_ERR_NO_MEM;
+    }
+    s_keys[s_key_count].name = name;
+    s_keys[s_key_count].decimals = decimals;
+    *ret_key = s_key_count++;
+    portEXIT_CRITICAL(&s_lock);
+    return ESP_OK;
+}
+
+esp_err_t gateway_add_device(const char* name, const char* type, int* ret_device)
+{
+    if (!valid_name(name, GATEWAY_DEVICE_NAME_MAX) || !valid_name(type, GATEWAY_DEVICE_NAME_MAX) || !ret_device) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!s_devices) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    portENTER_CRITICAL(&s_lock);
+    if (s_device_count >= s_config.max_devices) {
+        portEXIT_CRITICAL(&s_lock);
+        return ESP_ERR_NO_MEM;
+    }
+    gateway_device_t* device = &s_devices[s_device_count];
+    memset(device, 0, sizeof(*device));
+    strlcpy(device->name, name, sizeof(device->name));
+    device->type = type;
+    *ret_device = s_device_count++;
+    s_stats.devices = s_device_count;
+    portEXIT_CRITICAL(&s_lock);
+    return ESP_OK;
+}
+
+esp_err_t gateway_record(int device_index, int64_t captured_us, const gateway_value_t* values, size_t count)
+{
+    if (!values || count == 0 || count > GATEWAY_RECORD_VALUES) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    esp_err_t err = ESP_OK;
+    portENTER_CRITICAL(&s_lock);
+    if (device_index < 0 || device_index >= s_device_count) {
+        err = ESP_ERR_INVALID_ARG;
+    } else if (s_devices[device_index].pending >= GATEWAY_DEVICE_RECORDS) {
+        s_stats.records_dropped++;
+        err = ESP_ERR_NO_MEM;
+    } else {
+        gateway_device_t* device = &s_devices[device_index];
+        gateway_record_t* record = &device->records[(device->head + device->pending) % GATEWAY_DEVICE_RECORDS];
+        record->captured_us = captured_us;
+        record->count = 0;
+        for (size_t i = 0; i < count; i++) {
+            if (values[i].key < s_key_count) {
+                record->keys[record->count] = values[i].key;
+                record->values[record->count] = values[i].value;
+                record->count++;
+            }
+        }
+        device->pending++;
+        s_stats.records++;
+    }
+    portEXIT_CRITICAL(&s_lock);
+    return err;
+}
+
+esp_err_t gateway_set_attribute(int device_index, const char* key, const char* value)
+{
+    if (device_index < 0 || device_index >= s_device_count || !key || !value) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    char payload[GATEWAY_CONTROL_MAX];
+    size_t len = 0;
+    bool ok = append(payload, sizeof(payload), &len, "{", 1) &&
+              append_quoted(payload, sizeof(payload), &len, s_devices[device_index].name) &&
+              append(payload, sizeof(payload), &len, ":{", 2) &&
+              append_quoted(payload, sizeof(payload), &len, key) &&
+              append(payload, sizeof(payload), &len, ":", 1) &&
+              append_quoted(payload, sizeof(payload), &len, value) &&
+              append(payload, sizeof(payload), &len, "}}", 2);
+    if (!ok) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    return mqtt_outbound_publish(MQTT_OUTBOUND_CONTROL, GATEWAY_ATTRIBUTES_TOPIC, payload, len, NULL, NULL);
+}
+
+void gateway_on_connected(void)
+{
+    portENTER_CRITICAL(&s_lock);
+    for (int i = 0; i < s_device_count; i++) {
+        s_devices[i].connected = false;
+    }
+    portEXIT_CRITICAL(&s_lock);
+}
+
+size_t gateway_flush(int64_t epoch_offset_ms)
+{
+    if (!s_devices) {
+        return 0;
+    }
+    queue_connects();
+
+    uint32_t published_before = s_stats.records_published;
+    size_t len = 1;
+    int devices_in_payload = 0;
+    s_payload[0] = '{';
+
+    for (int i = 0; i < s_device_count; i++) {
+        gateway_device_t* device = &s_devices[i];
+        gateway_record_t records[GATEWAY_DEVICE_RECORDS];
+
+        // Snapshot under the lock, serialize outside of it
+        portENTER_CRITICAL(&s_lock);
+        int count = device->pending;
+        for (int r = 0; r < count; r++) {
+            records[r] = device->records[(device->head + r) % GATEWAY_DEVICE_RECORDS];
+        }
+        portEXIT_CRITICAL(&s_lock);
+        if (count == 0) {
+            continue;
+        }
+
+        size_t start = len;
+        // Leave room for the closing brace
+        bool ok = (devices_in_payload == 0 || append(s_payload, sizeof(s_payload) - 1, &len, ",", 1)) &&
+                  append_device_entry(&len, device->name, records, count, epoch_offset_ms) &&
+                  len < sizeof(s_payload) - 1;
+        if (!ok) {
+            len = start;
+            if (devices_in_payload == 0) {
+                ESP_LOGW(TAG, "Records of '%s' do not fit one payload", device->name);
+                continue;
+            }
+            if (!publish_payload(len)) {
+                return s_stats.records_published - published_before;
+            }
+            len = 1;
+            devices_in_payload = 0;
+            i--;    // Retry this device in the next payload
+            continue;
+        }
+
+        portENTER_CRITICAL(&s_lock);
+        device->serialized = (uint8_t)count;
+        portEXIT_CRITICAL(&s_lock);
+        devices_in_payload++;
+    }
+
+    if (devices_in_payload > 0) {
+        publish_payload(len);
+    }
+    return s_stats.records_published - published_before;
+}
+
+void gateway_get_stats(gateway_stats_t* stats)
+{
+    if (!stats) {
+        return;
+    }
+    portENTER_CRITICAL(&s_lock);
+    *stats = s_stats;
+    stats->devices_connected = 0;
+    for (int i = 0; i < s_device_count; i++) {
+        stats->devices_connected += s_devices[i].connected ? 1 : 0;
+    }
+    portEXIT_CRITICAL(&s_lock);
+}
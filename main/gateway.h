@@ -0,0 +1,152 @@
+#pragma once
+
+#include "esp_err.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * @file gateway.h
+ * @brief ThingsBoard gateway API for downstream child devices
+ *
+ * The board can publish on behalf of local sensors that have no network
+ * connection of their own. Each child device is registered by name and gets
+ * a small ring of timestamped records. gateway_flush() batches the pending
+ * records of many children into multi-device payloads on
+ * v1/gateway/telemetry:
+ *
+ *     {"Sensor A":[{"ts":...,"values":{"temperature":21.5}}],"Sensor B":[...]}
+ *
+ * so dozens of sensors share the single TLS connection. Children are
+ * announced on v1/gateway/connect after every (re)connect, a few per flush,
+ * and client attributes go out on v1/gateway/attributes. All publishes are
+ * queued through mqtt_outbound (telemetry class for data, control class for
+ * connects and attributes).
+ *
+ * Key names are registered once and referenced by index, so a record costs
+ * 32 bytes and a child device about 170 bytes of RAM. The ThingsBoard device
+ * behind the access token must have "Is gateway" enabled.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define GATEWAY_DEVICE_NAME_MAX 32      /**< Child name length including terminator */
+#define GATEWAY_MAX_KEYS        16      /**< Registered telemetry key names */
+#define GATEWAY_RECORD_VALUES   4       /**< Values per record */
+#define GATEWAY_DEVICE_RECORDS  4       /**< Pending records per child (newer records are dropped when full) */
+
+/**
+ * @brief One telemetry value of a child record
+ */
+typedef struct {
+    uint8_t key;                    /**< Key index from gateway_register_key */
+    int32_t value;                  /**< Fixed-point value (scaled by 10^decimals of the key) */
+} gateway_value_t;
+
+/**
+ * @brief Gateway configuration
+ */
+typedef struct {
+    uint16_t max_devices;           /**< Child device table size (allocated at init) */
+    uint8_t connects_per_flush;     /**< Connect messages queued per flush */
+} gateway_config_t;
+
+/**
+ * @brief Default gateway configuration
+ */
+#define GATEWAY_DEFAULT_CONFIG() { \
+    .max_devices = 128, \
+    .connects_per_flush = 4 \
+}
+
+/**
+ * @brief Gateway statistics
+ */
+typedef struct {
+    uint16_t devices;               /**< Registered child devices */
+    uint16_t devices_connected;     /**< Children announced in this MQTT session */
+    uint32_t records;               /**< Records accepted */
+    uint32_t records_dropped;       /**< Records refused because a child's ring was full */
+    uint32_t records_published;     /**< Records queued for publishing */
+    uint32_t publishes;             /**< Telemetry payloads queued */
+    uint64_t payload_bytes;         /**< Telemetry payload bytes queued */
+    size_t bytes_per_device;        /**< RAM per child device */
+} gateway_stats_t;
+
+/**
+ * @brief Allocate the child device table
+ *
+ * @param config Gateway configuration
+ * @return esp_err_t ESP_OK on success, ESP_ERR_NO_MEM if the table cannot be allocated
+ */
+esp_err_t gateway_init(const gateway_config_t* config);
+
+/**
+ * @brief Register a telemetry key name
+ *
+ * @param name Key name (must stay valid; no quotes or backslashes)
+ * @param decimals Fixed-point decimals of values for this key (0-9)
+ * @param ret_key Key index (output)
+ * @return esp_err_t ESP_OK on success, ESP_ERR_NO_MEM if the key table is full
+ */
+esp_err_t gateway_register_key(const char* name, uint8_t decimals, uint8_t* ret_key);
+
+/**
+ * @brief Register a child device
+ *
+ * @param name ThingsBoard device name (no quotes or backslashes)
+ * @param type ThingsBoard device profile (must stay valid)
+ * @param ret_device Device index (output)
+ * @return esp_err_t ESP_OK on success, ESP_ERR_NO_MEM if the table is full
+ */
+esp_err_t gateway_add_device(const char* name, const char* type, int* ret_device);
+
+/**
+ * @brief Record one set of values for a child device (safe to call from any task)
+ *
+ * @param device Device index
+ * @param captured_us esp_timer time of the reading
+ * @param values Values
+ * @param count Number of values (at most GATEWAY_RECORD_VALUES)
+ * @return esp_err_t ESP_OK on success, ESP_ERR_NO_MEM if the child's ring is full
+ */
+esp_err_t gateway_record(int device, int64_t captured_us, const gateway_value_t* values, size_t count);
+
+/**
+ * @brief Publish a client attribute of a child device on v1/gateway/attributes
+ *
+ * @param device Device index
+ * @param key Attribute name
+ * @param value String value
+ * @return esp_err_t ESP_OK if queued
+ */
+esp_err_t gateway_set_attribute(int device, const char* key, const char* value);
+
+/**
+ * @brief Forget which children were announced (call on every MQTT_EVENT_CONNECTED)
+ */
+void gateway_on_connected(void);
+
+/**
+ * @brief Queue pending connects and batched telemetry
+ *
+ * Records leave their ring only once the payload carrying them has been
+ * accepted by the outbound queue, so a full queue just delays them.
+ *
+ * @param epoch_offset_ms Offset added to captured_us / 1000 to get the Unix epoch in ms
+ * @return size_t Number of records queued
+ */
+size_t gateway_flush(int64_t epoch_offset_ms);
+
+/**
+ * @brief Get gateway statistics
+ *
+ * @param stats Statistics (output)
+ */
+void gateway_get_stats(gateway_stats_t* stats);
+
+#ifdef __cplusplus
+}
+#endif
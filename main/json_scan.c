@@ -0,0 +1,287 @@
+#include "json_scan.h"
+#include <string.h>
+
+#define JSON_SCAN_MAX_DEPTH 16
+
+static const char* skip_ws(const char* p, const char* end)
+{
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r')) {
+        p++;
+    }
+    return p;
+}
+
+// p points at the opening quote; returns the position after the closing quote
+static const char* skip_string(const char* p, const char* end)
+{
+    for (p++; p < end; p++) {
+        if (*p == '\\') {
+            p++;
+        } else if (*p == '"') {
+            return p + 1;
+        } else if ((unsigned char)*p < 0x20) {
+            return NULL;
+        }
+    }
+    return NULL;
+}
+
+static const char* skip_number(const char* p, const char* end)
+{
+    if (p < end && *p == '-') {
+        p++;
+    }
+    const char* digits = p;
+    while (p < end && ((*p >= '0' && *p <= '9') || *p == '.' || *p == 'e' || *p == 'E' || *p == '+' || *p == '-')) {
+        p++;
+    }
+    return (p > digits && *digits >= '0' && *digits <= '9') ? p : NULL;
+}
+
+static const char* skip_literal(const char* p, const char* end, const char* literal)
+{
+    size_t n = strlen(literal);
+    if ((size_t)(end - p) < n || memcmp(p, literal, n) != 0) {
+        return NULL;
+    }
+    return p + n;
+}
+
+/**
+ * @brief Parse one value starting at p (no leading whitespace)
+ */
+static const char* scan_value(const char* p, const char* end, json_span_t* span, int depth)
+{
+    if (p >= end || depth > JSON_SCAN_MAX_DEPTH) {
+        return NULL;
+    }
+
+    const char* next = NULL;
+    json_span_type_t type = JSON_SPAN_INVALID;
+
+    switch (*p) {
+    case '{':
+    case '[': {
+        char close = (*p == '{') ? '}' : ']';
+        bool is_object = (*p == '{');
+        type = is_object ? JSON_SPAN_OBJECT : JSON_SPAN_ARRAY;
+        const char* q = skip_ws(p + 1, end);
+        if (q < end && *q == close) {
+            next = q + 1;
+            break;
+        }
+        while (q < end) {
+            if (is_object) {
+                if (*q != '"' || !(q = skip_string(q, end))) {
+                    return NULL;
+                }
+                q = skip_ws(q, end);
+                if (q >= end || *q != ':') {
+                    return NULL;
+                }
+                q = skip_ws(q + 1, end);
+            }
+            json_span_t member;
+            if (!(q = scan_value(q, end, &member, depth + 1))) {
+                return NULL;
+            }
+            q = skip_ws(q, end);
+            if (q < end && *q == ',') {
+                q = skip_ws(q + 1, end);
+                continue;
+            }
+            if (q < end && *q == close) {
+                next = q + 1;
+            }
+            break;
+        }
+        break;
+    }
+    case '"':
+        next = skip_string(p, end);
+        if (next) {
+            span->ptr = p + 1;
+            span->len = (size_t)(next - p) - 2;
+            span->type = JSON_SPAN_STRING;
+            return next;
+        }
+        break;
+    case 't':
+        type = JSON_SPAN_TRUE;
+        next = skip_literal(p, end, "true");
+        break;
+    case 'f':
+        type = JSON_SPAN_FALSE;
+        next = skip_literal(p, end, "false");
+        break;
+    case 'n':
+        type = JSON_SPAN_NULL;
+        next = skip_literal(p, end, "null");
+        break;
+    default:
+        type = JSON_SPAN_NUMBER;
+        next = skip_number(p, end);
+        break;
+    }
+
+    if (!next) {
+        return NULL;
+    }
+    span->ptr = p;
+    span->len = (size_t)(next - p);
+    span->type = type;
+    return next;
+}
+
+bool json_scan_root(const char* json, size_t len, json_span_t* root)
+{
+    if (!json || !root) {
+        return false;
+    }
+    const char* end = json + len;
+    const char* p = scan_value(skip_ws(json, end), end, root, 0);
+    return p && skip_ws(p, end) == end;
+}
+
+bool json_scan_key(const json_span_t* object, const char* key, json_span_t* value)
+{
+    if (!object || object->type != JSON_SPAN_OBJECT || !key || !value) {
+        return false;
+    }
+
+    // The object was validated when it was scanned, so members can be walked directly
+    const char* end = object->ptr + object->len - 1;
+    const char* p = skip_ws(object->ptr + 1, end);
+    size_t key_len = strlen(key);
+
+    while (p < end && *p == '"') {
+        const char* key_end = skip_string(p, end);
+        if (!key_end) {
+            return false;
+        }
+        bool match = ((size_t)(key_end - p) - 2 == key_len) && memcmp(p + 1, key, key_len) == 0;
+
+        p = skip_ws(key_end, end);
+        p = skip_ws(p + 1, end); // ':'
+        json_span_t member;
+        if (!(p = scan_value(p, end, &member, 1))) {
+            return false;
+        }
+        if (match) {
+            *value = member;
+            return true;
+        }
+        p = skip_ws(p, end);
+        if (p < end && *p == ',') {
+            p = skip_ws(p + 1, end);
+        }
+    }
+    return false;
+}
+
+bool json_span_equals(const json_span_t* span, const char* str)
+{
+    size_t n = strlen(str);
+    return span && span->type == JSON_SPAN_STRING && span->len == n && memcmp(span->ptr, str, n) == 0;
+}
+
+bool json_span_to_bool(const json_span_t* span, bool* value)
+{
+    if (!span || !value) {
+        return false;
+    }
+    switch (span->type) {
+    case JSON_SPAN_TRUE:
+        *value = true;
+        return true;
+    case JSON_SPAN_FALSE:
+        *value = false;
+        return true;
+    case JSON_SPAN_NUMBER: {
+        int32_t number;
+        if (!json_span_to_int(span, &number)) {
+            return false;
+        }
+        *value = number != 0;
+        return true;
+    }
+    case JSON_SPAN_STRING:
+        if (json_span_equals(span, "true")) {
+            *value = true;
+            return true;
+        }
+        if (json_span_equals(span, "false")) {
+            *value = false;
+            return true;
+        }
+        return false;
+    default:
+        return false;
+    }
+}
+
+bool json_span_to_int(const json_span_t* span, int32_t* value)
+{
+    if (!span || !value || (span->type != JSON_SPAN_NUMBER && span->type != JSON_SPAN_STRING)) {
+        return false;
+    }
+
+    const char* p = span->ptr;
+    const char* end = span->ptr + span->len;
+    bool negative = (p < end && *p == '-');
+    if (negative) {
+        p++;
+    }
+    if (p >= end || *p < '0' || *p > '9') {
+        return false;
+    }
+
+    int64_t result = 0;
+    for (; p < end && *p >= '0' && *p <= '9'; p++) {
+        result = result * 10 + (*p - '0');
+        if (result > (int64_t)INT32_MAX + 1) {
+            return false;
+        }
+    }
+    // Numbers may carry a fraction (truncated); strings must be plain integers
+    if (p < end && (span->type == JSON_SPAN_STRING || *p != '.')) {
+        return false;
+    }
+    if (negative) {
+        result = -result;
+    }
+    if (result > INT32_MAX || result < INT32_MIN) {
+        return false;
+    }
+    *value = (int32_t)result;
+    return true;
+}
+
+bool json_span_copy_string(const json_span_t* span, char* buf, size_t size)
+{
+    if (!span || span->type != JSON_SPAN_STRING || !buf || size == 0) {
+        return false;
+    }
+
+    size_t out = 0;
+    for (size_t i = 0; i < span->len; i++) {
+        char c = span->ptr[i];
+        if (c == '\\' && ++i < span->len) {
+            switch (span->ptr[i]) {
+            case 'n': c = '\n'; break;
+            case 't': c = '\t'; break;
+            case 'r': c = '\r'; break;
+            case 'b': c = '\b'; break;
+            case 'f': c = '\f'; break;
+            case '"': case '\\': case '/': c = span->ptr[i]; break;
+            default: return false;
+            }
+        }
+        if (out + 1 >= size) {
+            return false;
+        }
+        buf[out++] = c;
+    }
+    buf[out] = '\0';
+    return true;
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * @file json_scan.h
+ * @brief Allocation-free JSON scanner
+ *
+ * Locates values inside a JSON document without building a tree: a span
+ * points into the caller's buffer, so lookups cost no heap and no copies.
+ * Meant for small control messages (RPC requests, attribute updates) where
+ * only a few known keys are read.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief JSON value types
+ */
+typedef enum {
+    JSON_SPAN_INVALID = 0,
+    JSON_SPAN_OBJECT,
+    JSON_SPAN_ARRAY,
+    JSON_SPAN_STRING,
+    JSON_SPAN_NUMBER,
+    JSON_SPAN_TRUE,
+    JSON_SPAN_FALSE,
+    JSON_SPAN_NULL,
+} json_span_type_t;
+
+/**
+ * @brief Reference to one JSON value inside a document
+ *
+ * For strings the span excludes the quotes and escapes are left as-is.
+ */
+typedef struct {
+    const char* ptr;                /**< First character of the value */
+    size_t len;                     /**< Length of the value in bytes */
+    json_span_type_t type;          /**< Value type */
+} json_span_t;
+
+/**
+ * @brief Validate the top-level value of a document
+ *
+ * @param json Document (need not be NUL-terminated)
+ * @param len Document length
+ * @param root Top-level value (output)
+ * @return true if the document holds exactly one well-formed value
+ */
+bool json_scan_root(const char* json, size_t len, json_span_t* root);
+
+/**
+ * @brief Find a member of an object by key (not recursive)
+ *
+ * @param object Object span
+ * @param key Key to look up (compared without unescaping)
+ * @param value Member value (output)
+ * @return true if the key was found
+ */
+bool json_scan_key(const json_span_t* object, const char* key, json_span_t* value);
+
+/**
+ * @brief Compare a string span with a C string
+ */
+bool json_span_equals(const json_span_t* span, const char* str);
+
+/**
+ * @brief Read a boolean: true/false, a number (non-zero = true) or "true"/"false"
+ *
+ * @return true if the span could be interpreted as a boolean
+ */
+bool json_span_to_bool(const json_span_t* span, bool* value);
+
+/**
+ * @brief Read an integer from a number (fraction truncated) or a numeric string
+ *
+ * @return true if the span held an integer in int32_t range
+ */
+bool json_span_to_int(const json_span_t* span, int32_t* value);
+
+/**
+ * @brief Copy a string value into a NUL-terminated buffer
+ *
+ * Simple escapes are decoded; \u escapes are rejected.
+ *
+ * @return true if the string fit into the buffer
+ */
+bool json_span_copy_string(const json_span_t* span, char* buf, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
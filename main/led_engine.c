@@ -0,0 +1,184 @@
+#include "led_engine.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+#include "led_strip.h"
+
+static const char* TAG = "LED_ENGINE";
+
+#define LED_MAX_BRIGHTNESS      255
+#define LED_RMT_RESOLUTION_HZ   (10 * 1000 * 1000) // 10MHz
+
+typedef enum {
+    LED_EVENT_BASE = 0,
+    LED_EVENT_FLASH,
+    LED_EVENT_ERROR_SET,
+    LED_EVENT_ERROR_CLEAR,
+    LED_EVENT_OVERRIDE_SET,
+    LED_EVENT_OVERRIDE_CLEAR,
+} led_event_type_t;
+
+typedef struct {
+    led_event_type_t type;
+    led_color_t color;
+    uint32_t value;                 /**< Flash duration (ms) or error mask */
+} led_event_t;
+
+static led_engine_config_t s_config;
+static led_strip_handle_t s_led_strip = NULL;
+static QueueHandle_t s_queue = NULL;
+static volatile uint32_t s_dropped = 0;
+static bool s_initialized = false;
+
+static void render(const led_color_t* color)
+{
+    led_strip_set_pixel(s_led_strip, 0,
+                        (color->red * s_config.brightness) / LED_MAX_BRIGHTNESS,
+                        (color->green * s_config.brightness) / LED_MAX_BRIGHTNESS,
+                        (color->blue * s_config.brightness) / LED_MAX_BRIGHTNESS);
+    led_strip_refresh(s_led_strip);
+}
+
+static void led_engine_task(void* pvParameters)
+{
+    led_state_t state;
+    led_state_init(&state, s_config.error_color);
+
+    led_color_t shown = {0};
+    bool rendered = false;
+    TickType_t wait = portMAX_DELAY;
+
+    while (1) {
+        led_event_t event;
+        if (xQueueReceive(s_queue, &event, wait) == pdTRUE) {
+            int64_t now_ms = esp_timer_get_time() / 1000;
+            switch (event.type) {
+            case LED_EVENT_BASE:
+                led_state_set_base(&state, event.color);
+                break;
+            case LED_EVENT_FLASH:
+                led_state_flash(&state, event.color, now_ms, event.value);
+                break;
+            case LED_EVENT_ERROR_SET:
+                led_state_set_error(&state, event.value, true);
+                break;
+            case LED_EVENT_ERROR_CLEAR:
+                led_state_set_error(&state, event.value, false);
+                break;
+            case LED_EVENT_OVERRIDE_SET:
+                led_state_set_override(&state, &event.color);
+                break;
+            case LED_EVENT_OVERRIDE_CLEAR:
+                led_state_set_override(&state, NULL);
+                break;
+            }
+            // Apply queued bursts before touching the strip
+            if (uxQueueMessagesWaiting(s_queue) > 0) {
+                wait = 0;
+                continue;
+            }
+        }
+
+        led_color_t color;
+        int64_t next_change_ms;
+        led_state_resolve(&state, esp_timer_get_time() / 1000, &color, &next_change_ms);
+        if (!rendered || color.red != shown.red || color.green != shown.green || color.blue != shown.blue) {
+            render(&color);
+            shown = color;
+            rendered = true;
+        }
+
+        if (next_change_ms < 0) {
+            wait = portMAX_DELAY;
+        } else {
+            // Round up so the flash has expired when the task wakes
+            wait = pdMS_TO_TICKS(next_change_ms) + 1;
+        }
+    }
+}
+
+static esp_err_t post_event(const led_event_t* event)
+{
+    if (!s_initialized) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (xQueueSend(s_queue, event, 0) != pdTRUE) {
+        s_dropped++;
+        return ESP_ERR_TIMEOUT;
+    }
+    return ESP_OK;
+}
+
+esp_err_t led_engine_init(const led_engine_config_t* config)
+{
+    if (s_initialized) {
+        ESP_LOGW(TAG, "LED engine already initialized");
+        return ESP_OK;
+    }
+    if (!config || config->queue_length == 0) {
+        ESP_LOGE(TAG, "Invalid configuration");
+        return ESP_ERR_INVALID_ARG;
+    }
+    s_config = *config;
+
+    led_strip_config_t strip_config = {
+        .strip_gpio_num = config->gpio_num,
+        .max_leds = 1,
+    };
+    led_strip_rmt_config_t rmt_config = {
+        .resolution_hz = LED_RMT_RESOLUTION_HZ,
+    };
+    esp_err_t err = led_strip_new_rmt_device(&strip_config, &rmt_config, &s_led_strip);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to create LED strip: %s", esp_err_to_name(err));
+        return err;
+    }
+    led_strip_clear(s_led_strip);
+
+    s_queue = xQueueCreate(config->queue_length, sizeof(led_event_t));
+    if (!s_queue) {
+        return ESP_ERR_NO_MEM;
+    }
+    if (xTaskCreate(led_engine_task, "led_engine", 2048, NULL, 3, NULL) != pdPASS) {
+        vQueueDelete(s_queue);
+        s_queue = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+
+    s_initialized = true;
+    return ESP_OK;
+}
+
+esp_err_t led_engine_set_base(const led_color_t* color)
+{
+    led_event_t event = { .type = LED_EVENT_BASE, .color = *color };
+    return post_event(&event);
+}
+
+esp_err_t led_engine_flash(const led_color_t* color, uint32_t duration_ms)
+{
+    led_event_t event = { .type = LED_EVENT_FLASH, .color = *color, .value = duration_ms };
+    return post_event(&event);
+}
+
+esp_err_t led_engine_set_error(uint32_t mask, bool active)
+{
+    led_event_t event = { .type = active ? LED_EVENT_ERROR_SET : LED_EVENT_ERROR_CLEAR, .value = mask };
+    return post_event(&event);
+}
+
+esp_err_t led_engine_set_override(const led_color_t* color)
+{
+    led_event_t event = { .type = color ? LED_EVENT_OVERRIDE_SET : LED_EVENT_OVERRIDE_CLEAR };
+    if (color) {
+        event.color = *color;
+    }
+    return post_event(&event);
+}
+
+uint32_t led_engine_get_dropped(void)
+{
+    return s_dropped;
+}
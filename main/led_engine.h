@@ -0,0 +1,91 @@
+#pragma once
+
+#include "esp_err.h"
+#include "led_state.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * @file led_engine.h
+ * @brief Non-blocking status LED engine
+ *
+ * Callers post status events to a queue and return immediately; a dedicated
+ * task owns the LED strip, resolves the layered state (see led_state.h) and
+ * only refreshes the strip when the displayed color changes. Events are
+ * dropped, never waited for, if the queue is full.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief LED engine configuration
+ */
+typedef struct {
+    int gpio_num;                   /**< Addressable LED data GPIO */
+    uint8_t brightness;             /**< Brightness scale (0-255) */
+    uint32_t queue_length;          /**< Pending event capacity */
+    led_color_t error_color;        /**< Color of the error overlay */
+} led_engine_config_t;
+
+/**
+ * @brief Default LED engine configuration
+ */
+#define LED_ENGINE_DEFAULT_CONFIG() { \
+    .gpio_num = 48, \
+    .brightness = 25, \
+    .queue_length = 16, \
+    .error_color = { 255, 0, 0 } \
+}
+
+/**
+ * @brief Initialize the LED strip and start the engine task
+ *
+ * @param config Engine configuration
+ * @return esp_err_t ESP_OK on success
+ */
+esp_err_t led_engine_init(const led_engine_config_t* config);
+
+/**
+ * @brief Set the steady state color
+ *
+ * @param color Color at full brightness
+ * @return esp_err_t ESP_OK if queued, ESP_ERR_TIMEOUT if the queue is full
+ */
+esp_err_t led_engine_set_base(const led_color_t* color);
+
+/**
+ * @brief Show a transient flash on top of the steady state
+ *
+ * @param color Flash color
+ * @param duration_ms Flash duration
+ * @return esp_err_t ESP_OK if queued, ESP_ERR_TIMEOUT if the queue is full
+ */
+esp_err_t led_engine_flash(const led_color_t* color, uint32_t duration_ms);
+
+/**
+ * @brief Set or clear error sources; the error overlay wins while any is set
+ *
+ * @param mask Error source bits (assigned by the caller)
+ * @param active true to set, false to clear
+ * @return esp_err_t ESP_OK if queued, ESP_ERR_TIMEOUT if the queue is full
+ */
+esp_err_t led_engine_set_error(uint32_t mask, bool active);
+
+/**
+ * @brief Force a color on top of the status layers (below the error overlay)
+ *
+ * @param color Override color, NULL to return to status indication
+ * @return esp_err_t ESP_OK if queued, ESP_ERR_TIMEOUT if the queue is full
+ */
+esp_err_t led_engine_set_override(const led_color_t* color);
+
+/**
+ * @brief Number of events dropped because the queue was full
+ */
+uint32_t led_engine_get_dropped(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,65 @@
+#include "led_state.h"
+#include <string.h>
+
+void led_state_init(led_state_t* state, led_color_t error_color)
+{
+    memset(state, 0, sizeof(*state));
+    state->error = error_color;
+}
+
+void led_state_set_base(led_state_t* state, led_color_t color)
+{
+    state->base = color;
+}
+
+void led_state_flash(led_state_t* state, led_color_t color, int64_t now_ms, uint32_t duration_ms)
+{
+    if (duration_ms == 0) {
+        return;
+    }
+    state->flash = color;
+    state->flash_until_ms = now_ms + duration_ms;
+}
+
+void led_state_set_error(led_state_t* state, uint32_t mask, bool active)
+{
+    if (active) {
+        state->error_mask |= mask;
+    } else {
+        state->error_mask &= ~mask;
+    }
+}
+
+void led_state_set_override(led_state_t* state, const led_color_t* color)
+{
+    state->override_active = (color != NULL);
+    if (color) {
+        state->override = *color;
+    }
+}
+
+led_layer_t led_state_resolve(led_state_t* state, int64_t now_ms, led_color_t* color, int64_t* next_change_ms)
+{
+    if (state->flash_until_ms != 0 && now_ms >= state->flash_until_ms) {
+        state->flash_until_ms = 0;
+    }
+    // An active flash still has to expire underneath an error overlay
+    if (next_change_ms) {
+        *next_change_ms = state->flash_until_ms != 0 ? state->flash_until_ms - now_ms : -1;
+    }
+
+    if (state->error_mask != 0) {
+        *color = state->error;
+        return LED_LAYER_ERROR;
+    }
+    if (state->override_active) {
+        *color = state->override;
+        return LED_LAYER_OVERRIDE;
+    }
+    if (state->flash_until_ms != 0) {
+        *color = state->flash;
+        return LED_LAYER_FLASH;
+    }
+    *color = state->base;
+    return LED_LAYER_BASE;
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * @file led_state.h
+ * @brief Layered status LED state machine (no hardware dependencies)
+ *
+ * The displayed color is resolved from four layers, highest priority first:
+ * - error overlay: shown while any error bit is set
+ * - manual override: set remotely (e.g. the setLed RPC) until cleared
+ * - transient flash: shown until it expires (e.g. publish indication)
+ * - base: the steady connection state
+ *
+ * This module only decides which color wins; led_engine renders it.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief RGB color at full brightness
+ */
+typedef struct {
+    uint8_t red;
+    uint8_t green;
+    uint8_t blue;
+} led_color_t;
+
+/**
+ * @brief Layer state
+ */
+typedef struct {
+    led_color_t base;               /**< Steady state color */
+    led_color_t flash;              /**< Transient flash color */
+    int64_t flash_until_ms;         /**< Flash expiry, 0 when no flash is active */
+    led_color_t error;              /**< Error overlay color */
+    uint32_t error_mask;            /**< Active error sources (overlay shown while non-zero) */
+    led_color_t override;           /**< Manual override color */
+    bool override_active;           /**< Manual override in effect */
+} led_state_t;
+
+/**
+ * @brief Layer whose color is displayed
+ */
+typedef enum {
+    LED_LAYER_BASE = 0,
+    LED_LAYER_FLASH,
+    LED_LAYER_OVERRIDE,
+    LED_LAYER_ERROR,
+} led_layer_t;
+
+/**
+ * @brief Reset to an unlit base with no flash and no errors
+ *
+ * @param state State to initialize
+ * @param error_color Color of the error overlay
+ */
+void led_state_init(led_state_t* state, led_color_t error_color);
+
+/**
+ * @brief Set the steady state color
+ */
+void led_state_set_base(led_state_t* state, led_color_t color);
+
+/**
+ * @brief Start a transient flash, replacing any flash in progress
+ *
+ * @param state Layer state
+ * @param color Flash color
+ * @param now_ms Current time in ms
+ * @param duration_ms Flash duration in ms
+ */
+void led_state_flash(led_state_t* state, led_color_t color, int64_t now_ms, uint32_t duration_ms);
+
+/**
+ * @brief Set or clear error sources
+ *
+ * @param state Layer state
+ * @param mask Error source bits
+ * @param active true to set the bits, false to clear them
+ */
+void led_state_set_error(led_state_t* state, uint32_t mask, bool active);
+
+/**
+ * @brief Set or clear the manual override
+ *
+ * @param state Layer state
+ * @param color Override color, NULL to clear the override
+ */
+void led_state_set_override(led_state_t* state, const led_color_t* color);
+
+/**
+ * @brief Resolve the color to display
+ *
+ * Expired flashes are cleared as a side effect.
+ *
+ * @param state Layer state
+ * @param now_ms Current time in ms
+ * @param color Winning color (output)
+ * @param next_change_ms Time until the result may change on its own, -1 if never (output, optional)
+ * @return led_layer_t Layer the color was taken from
+ */
+led_layer_t led_state_resolve(led_state_t* state, int64_t now_ms, led_color_t* color, int64_t* next_change_ms);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,425 @@
+#include "mqtt_outbound.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+#include <stdlib.h>
+#include <string.h>
+
+static const char* TAG = "MQTT_OUTBOUND";
+
+#define OUTBOUND_QUANTUM_BYTES  512     // Bytes per round per unit of weight
+#define OUTBOUND_RETRY_MS       100     // Re-check interval while held back by the outbox or a failed publish
+#define OUTBOUND_HELD_ACKS      8       // PUBACKs held while a publish is being completed
+
+/**
+ * @brief Queued message; topic and payload follow the header in one allocation
+ */
+typedef struct outbound_msg {
+    struct outbound_msg* next;
+    mqtt_outbound_done_cb_t done;
+    void* ctx;
+    int64_t enqueued_us;
+    size_t len;
+    char* topic;
+    char data[];
+} outbound_msg_t;
+
+/**
+ * @brief PUBACK received while a publish was being completed
+ */
+typedef struct {
+    int msg_id;
+    int64_t acked_us;
+} held_ack_t;
+
+typedef struct {
+    outbound_msg_t* head;
+    outbound_msg_t* tail;
+    size_t deficit;                 /**< Deficit round robin credit in bytes */
+    mqtt_outbound_stats_t stats;
+} outbound_class_t;
+
+// Producers run in the MQTT and telemetry tasks, the outbound task consumes
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static mqtt_outbound_config_t s_config;
+static outbound_class_t s_classes[MQTT_OUTBOUND_CLASS_COUNT];
+static int s_turn = 0;                  // Class whose round robin turn it is
+static bool s_turn_started = false;     // Its quantum has been added for this turn
+static esp_mqtt_client_handle_t s_client = NULL;
+static bool s_connected = false;
+static TaskHandle_t s_task = NULL;
+static bool s_publishing = false;       // Outbound task is between a publish and its done callback
+static held_ack_t s_held_acks[OUTBOUND_HELD_ACKS];
+static int s_held_count = 0;
+
+static void class_push_back(outbound_class_t* cls, outbound_msg_t* msg)
+{
+    msg->next = NULL;
+    if (cls->tail) {
+        cls->tail->next = msg;
+    } else {
+        cls->head = msg;
+    }
+    cls->tail = msg;
+    cls->stats.queued++;
+    cls->stats.queued_bytes += msg->len;
+}
+
+static void class_push_front(outbound_class_t* cls, outbound_msg_t* msg)
+{
+    msg->next = cls->head;
+    cls->head = msg;
+    if (!cls->tail) {
+        cls->tail = msg;
+    }
+    cls->stats.queued++;
+    cls->stats.queued_bytes += msg->len;
+}
+
+static outbound_msg_t* class_pop(outbound_class_t* cls)
+{
+    outbound_msg_t* msg = cls->head;
+    if (msg) {
+        cls->head = msg->next;
+        if (!cls->head) {
+            cls->tail = NULL;
+        }
+        cls->stats.queued--;
+        cls->stats.queued_bytes -= msg->len;
+    }
+    return msg;
+}
+
+/**
+ * @brief Call the completion callbacks of dropped messages and free them
+ */
+static void release_dropped(outbound_msg_t* list)
+{
+    while (list) {
+        outbound_msg_t* next = list->next;
+        if (list->done) {
+            list->done(-1, list->ctx);
+        }
+        free(list);
+        list = next;
+    }
+}
+
+/**
+ * @brief Pick the next message by deficit round robin (called with the lock held)
+ *
+ * Each class's turn adds weight * quantum bytes of credit; the class sends
+ * while its head message fits the credit. Empty classes lose their credit,
+ * classes held back by the outbox keep it.
+ */
+static outbound_msg_t* dequeue_next(bool outbox_full, mqtt_outbound_class_t* ret_cls)
+{
+    bool eligible = false;
+    for (int i = 0; i < MQTT_OUTBOUND_CLASS_COUNT; i++) {
+        if (s_classes[i].head && !(outbox_full && s_config.classes[i].outbox_limited)) {
+            eligible = true;
+        }
+    }
+    if (!eligible) {
+        return NULL;
+    }
+
+    // Terminates: every full round adds credit to at least one eligible class
+    while (1) {
+        outbound_class_t* cls = &s_classes[s_turn];
+        const mqtt_outbound_class_config_t* cfg = &s_config.classes[s_turn];
+
+        if (!cls->head || (outbox_full && cfg->outbox_limited)) {
+            if (!cls->head) {
+                cls->deficit = 0;
+            }
+        } else {
+            if (!s_turn_started) {
+                cls->deficit += (size_t)cfg->weight * OUTBOUND_QUANTUM_BYTES;
+                s_turn_started = true;
+            }
+            if (cls->head->len <= cls->deficit) {
+                cls->deficit -= cls->head->len;
+                *ret_cls = (mqtt_outbound_class_t)s_turn;
+                return class_pop(cls);
+            }
+        }
+        s_turn = (s_turn + 1) % MQTT_OUTBOUND_CLASS_COUNT;
+        s_turn_started = false;
+    }
+}
+
+/**
+ * @brief Hold PUBACKs from now on, until complete_publish()
+ */
+static void begin_publish(void)
+{
+    portENTER_CRITICAL(&s_lock);
+    s_publishing = true;
+    portEXIT_CRITICAL(&s_lock);
+}
+
+/**
+ * @brief Stop holding PUBACKs and report the held ones (after the done callback ran)
+ */
+static void complete_publish(void)
+{
+    held_ack_t held[OUTBOUND_HELD_ACKS];
+
+    portENTER_CRITICAL(&s_lock);
+    int count = s_held_count;
+    memcpy(held, s_held_acks, count * sizeof(held[0]));
+    s_held_count = 0;
+    s_publishing = false;
+    portEXIT_CRITICAL(&s_lock);
+
+    for (int i = 0; i < count; i++) {
+        s_config.on_ack(held[i].msg_id, held[i].acked_us);
+    }
+}
+
+static void outbound_task(void* pvParameters)
+{
+    TickType_t wait = portMAX_DELAY;
+
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, wait);
+        wait = portMAX_DELAY;
+
+        while (1) {
+            portENTER_CRITICAL(&s_lock);
+            esp_mqtt_client_handle_t client = s_client;
+            bool connected = s_connected;
+            portEXIT_CRITICAL(&s_lock);
+            if (!connected || !client) {
+                break;
+            }
+
+            int outbox = esp_mqtt_client_get_outbox_size(client);
+            mqtt_outbound_class_t cls_id = MQTT_OUTBOUND_CONTROL;
+            bool held_back = false;
+
+            portENTER_CRITICAL(&s_lock);
+            bool outbox_full = outbox > 0 && (size_t)outbox >= s_config.outbox_budget;
+            outbound_msg_t* msg = dequeue_next(outbox_full, &cls_id);
+            if (!msg && outbox_full) {
+                for (int i = 0; i < MQTT_OUTBOUND_CLASS_COUNT; i++) {
+                    held_back |= s_classes[i].head != NULL;
+                }
+            }
+            portEXIT_CRITICAL(&s_lock);
+
+            if (!msg) {
+                // Outbox shrinkage is not signalled; poll while traffic is held back
+                if (held_back) {
+                    wait = pdMS_TO_TICKS(OUTBOUND_RETRY_MS);
+                }
+                break;
+            }
+
+            outbound_class_t* cls = &s_classes[cls_id];
+            begin_publish();
+            int msg_id = esp_mqtt_client_publish(client, msg->topic, msg->data, msg->len,
+                                                 s_config.classes[cls_id].qos, 0);
+            if (msg_id < 0) {
+                // Disconnected or outbox full: keep the message first in line and retry later
+                portENTER_CRITICAL(&s_lock);
+                class_push_front(cls, msg);
+                cls->deficit += msg->len;
+                portEXIT_CRITICAL(&s_lock);
+                complete_publish();
+                wait = pdMS_TO_TICKS(OUTBOUND_RETRY_MS);
+                break;
+            }
+
+            uint32_t wait_us = (uint32_t)(esp_timer_get_time() - msg->enqueued_us);
+            portENTER_CRITICAL(&s_lock);
+            cls->stats.sent++;
+            cls->stats.wait_sum_us += wait_us;
+            if (wait_us > cls->stats.wait_max_us) {
+                cls->stats.wait_max_us = wait_us;
+            }
+            portEXIT_CRITICAL(&s_lock);
+
+            if (msg->done) {
+                msg->done(msg_id, msg->ctx);
+            }
+            free(msg);
+            complete_publish();
+        }
+    }
+}
+
+esp_err_t mqtt_outbound_init(const mqtt_outbound_config_t* config)
+{
+    if (!config) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_task) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    for (int i = 0; i < MQTT_OUTBOUND_CLASS_COUNT; i++) {
+        if (config->classes[i].weight == 0 || config->classes[i].max_messages == 0 || config->classes[i].qos > 2) {
+            return ESP_ERR_INVALID_ARG;
+        }
+    }
+
+    s_config = *config;
+    memset(s_classes, 0, sizeof(s_classes));
+    s_turn = 0;
+    s_turn_started = false;
+
+    if (xTaskCreate(outbound_task, "mqtt_outbound", config->stack_size, NULL, config->priority, &s_task) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create outbound task");
+        return ESP_ERR_NO_MEM;
+    }
+
+    ESP_LOGI(TAG, "Outbound queues ready (outbox budget %u bytes)", (unsigned)config->outbox_budget);
+    return ESP_OK;
+}
+
+void mqtt_outbound_set_connected(esp_mqtt_client_handle_t client, bool connected)
+{
+    outbound_msg_t* dropped = NULL;
+
+    portENTER_CRITICAL(&s_lock);
+    s_client = client;
+    s_connected = connected;
+    if (!connected) {
+        for (int i = 0; i < MQTT_OUTBOUND_CLASS_COUNT; i++) {
+            if (!s_config.classes[i].flush_on_disconnect) {
+                continue;
+            }
+            outbound_msg_t* msg;
+            while ((msg = class_pop(&s_classes[i])) != NULL) {
+                s_classes[i].stats.dropped++;
+                msg->next = dropped;
+                dropped = msg;
+            }
+            s_classes[i].deficit = 0;
+        }
+    }
+    portEXIT_CRITICAL(&s_lock);
+
+    release_dropped(dropped);
+    if (connected && s_task) {
+        xTaskNotifyGive(s_task);
+    }
+}
+
+esp_err_t mqtt_outbound_publish(mqtt_outbound_class_t cls_id, const char* topic, const char* data, size_t len,
+                                mqtt_outbound_done_cb_t done, void* ctx)
+{
+    if (cls_id >= MQTT_OUTBOUND_CLASS_COUNT || !topic || (!data && len > 0)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!s_task) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    const mqtt_outbound_class_config_t* cfg = &s_config.classes[cls_id];
+    outbound_class_t* cls = &s_classes[cls_id];
+    if (len > cfg->max_bytes) {
+        portENTER_CRITICAL(&s_lock);
+        cls->stats.rejected++;
+        portEXIT_CRITICAL(&s_lock);
+        return ESP_ERR_NO_MEM;
+    }
+
+    // Allocate outside the critical section
+    size_t topic_size = strlen(topic) + 1;
+    outbound_msg_t* msg = malloc(sizeof(outbound_msg_t) + len + topic_size);
+    if (!msg) {
+        return ESP_ERR_NO_MEM;
+    }
+    memcpy(msg->data, data, len);
+    msg->topic = msg->data + len;
+    memcpy(msg->topic, topic, topic_size);
+    msg->len = len;
+    msg->done = done;
+    msg->ctx = ctx;
+    msg->enqueued_us = esp_timer_get_time();
+
+    outbound_msg_t* dropped = NULL;
+    bool accepted = true;
+
+    portENTER_CRITICAL(&s_lock);
+    while (cls->stats.queued >= cfg->max_messages || cls->stats.queued_bytes + len > cfg->max_bytes) {
+        if (cfg->drop == MQTT_OUTBOUND_REJECT_NEW) {
+            accepted = false;
+            cls->stats.rejected++;
+            break;
+        }
+        outbound_msg_t* oldest = class_pop(cls);
+        cls->stats.dropped++;
+        oldest->next = dropped;
+        dropped = oldest;
+    }
+    if (accepted) {
+        class_push_back(cls, msg);
+        cls->stats.enqueued++;
+    }
+    portEXIT_CRITICAL(&s_lock);
+
+    release_dropped(dropped);
+    if (!accepted) {
+        free(msg);
+        return ESP_ERR_NO_MEM;
+    }
+
+    xTaskNotifyGive(s_task);
+    return ESP_OK;
+}
+
+void mqtt_outbound_on_published(int msg_id, int64_t acked_us)
+{
+    if (!s_config.on_ack) {
+        return;
+    }
+
+    held_ack_t evicted = { .msg_id = -1 };
+    portENTER_CRITICAL(&s_lock);
+    bool hold = s_publishing;
+    if (hold) {
+        if (s_held_count == OUTBOUND_HELD_ACKS) {
+            // A long blocking publish: the oldest held PUBACK belongs to an earlier, completed message
+            evicted = s_held_acks[0];
+            memmove(&s_held_acks[0], &s_held_acks[1], (OUTBOUND_HELD_ACKS - 1) * sizeof(s_held_acks[0]));
+            s_held_count--;
+        }
+        s_held_acks[s_held_count].msg_id = msg_id;
+        s_held_acks[s_held_count].acked_us = acked_us;
+        s_held_count++;
+    }
+    portEXIT_CRITICAL(&s_lock);
+
+    if (evicted.msg_id >= 0) {
+        s_config.on_ack(evicted.msg_id, evicted.acked_us);
+    }
+    if (!hold) {
+        s_config.on_ack(msg_id, acked_us);
+    }
+}
+
+size_t mqtt_outbound_queued_bytes(void)
+{
+    size_t total = 0;
+    portENTER_CRITICAL(&s_lock);
+    for (int i = 0; i < MQTT_OUTBOUND_CLASS_COUNT; i++) {
+        total += s_classes[i].stats.queued_bytes;
+    }
+    portEXIT_CRITICAL(&s_lock);
+    return total;
+}
+
+esp_err_t mqtt_outbound_get_stats(mqtt_outbound_class_t cls_id, mqtt_outbound_stats_t* stats)
+{
+    if (cls_id >= MQTT_OUTBOUND_CLASS_COUNT || !stats) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    portENTER_CRITICAL(&s_lock);
+    *stats = s_classes[cls_id].stats;
+    portEXIT_CRITICAL(&s_lock);
+    return ESP_OK;
+}
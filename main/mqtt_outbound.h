@@ -0,0 +1,195 @@
+#pragma once
+
+#include "esp_err.h"
+#include "mqtt_client.h"
+#include "freertos/FreeRTOS.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * @file mqtt_outbound.h
+ * @brief Prioritized outbound MQTT publishing
+ *
+ * Publishes are queued per traffic class instead of being written to the
+ * client directly. Each class has its own bounded queue, QoS and drop
+ * policy. A single task dequeues with deficit round robin weighted by class,
+ * so a long store-and-forward backfill only gets its share of the link and a
+ * queued alarm waits for at most one round of the other classes.
+ *
+ * Classes marked outbox_limited are additionally held back while the esp-mqtt
+ * outbox (unacknowledged QoS 1 messages) exceeds a byte budget, so bulk
+ * traffic waits in its own queue where it cannot delay control messages.
+ *
+ * PUBACKs are routed through mqtt_outbound_on_published() so that a
+ * message's done callback (which learns its msg_id) always runs before its
+ * PUBACK is reported. esp_mqtt_client_publish() returns the msg_id only
+ * after the message was written, and the MQTT task can process the PUBACK
+ * before the outbound task gets to run the callback; such PUBACKs are held
+ * until the callback has run.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Traffic classes
+ */
+typedef enum {
+    MQTT_OUTBOUND_CONTROL = 0,      /**< RPC responses, attribute updates and requests */
+    MQTT_OUTBOUND_ALARM,            /**< Alarms and other urgent events */
+    MQTT_OUTBOUND_TELEMETRY,        /**< Live telemetry */
+    MQTT_OUTBOUND_BULK,             /**< Store-and-forward backfill */
+    MQTT_OUTBOUND_CLASS_COUNT
+} mqtt_outbound_class_t;
+
+/**
+ * @brief What to do when a class queue is full
+ */
+typedef enum {
+    MQTT_OUTBOUND_DROP_OLDEST = 0,  /**< Discard the oldest queued message to make room */
+    MQTT_OUTBOUND_REJECT_NEW,       /**< Refuse the new message (the caller keeps its data) */
+} mqtt_outbound_drop_t;
+
+/**
+ * @brief Per-class configuration
+ */
+typedef struct {
+    uint8_t qos;                    /**< MQTT QoS for the class */
+    uint8_t weight;                 /**< Dequeue weight (share of bytes when classes compete) */
+    uint16_t max_messages;          /**< Queue limit in messages */
+    size_t max_bytes;               /**< Queue limit in payload bytes */
+    mqtt_outbound_drop_t drop;      /**< Policy when a limit is reached */
+    bool outbox_limited;            /**< Hold back while the outbox exceeds outbox_budget */
+    bool flush_on_disconnect;       /**< Discard queued messages when the connection drops */
+} mqtt_outbound_class_config_t;
+
+/**
+ * @brief Called once per message: with its msg_id after the publish, or -1 if it was dropped
+ *
+ * Runs in the outbound task (or the caller of a function that dropped the
+ * message) and must not block. Always runs before on_ack reports the
+ * message's PUBACK.
+ *
+ * @param msg_id MQTT message id, or -1 if the message was dropped
+ * @param ctx Context pointer given with the message
+ */
+typedef void (*mqtt_outbound_done_cb_t)(int msg_id, void* ctx);
+
+/**
+ * @brief Called for every PUBACK passed to mqtt_outbound_on_published()
+ *
+ * Runs in the MQTT task, or in the outbound task for a PUBACK that was held
+ * while a publish completed. Must not block.
+ *
+ * @param msg_id Acknowledged message id
+ * @param acked_us Time the PUBACK was received (esp_timer_get_time)
+ */
+typedef void (*mqtt_outbound_ack_cb_t)(int msg_id, int64_t acked_us);
+
+/**
+ * @brief Outbound scheduler configuration
+ */
+typedef struct {
+    mqtt_outbound_class_config_t classes[MQTT_OUTBOUND_CLASS_COUNT];
+    size_t outbox_budget;           /**< Outbox bytes above which outbox_limited classes wait */
+    mqtt_outbound_ack_cb_t on_ack;  /**< PUBACK callback (optional) */
+    uint32_t stack_size;            /**< Outbound task stack size */
+    UBaseType_t priority;           /**< Outbound task priority */
+} mqtt_outbound_config_t;
+
+/**
+ * @brief Default outbound configuration
+ */
+#define MQTT_OUTBOUND_DEFAULT_CONFIG() { \
+    .classes = { \
+        [MQTT_OUTBOUND_CONTROL]   = { .qos = 1, .weight = 8, .max_messages = 8,  .max_bytes = 4096, \
+                                      .drop = MQTT_OUTBOUND_DROP_OLDEST, .outbox_limited = false, .flush_on_disconnect = true }, \
+        [MQTT_OUTBOUND_ALARM]     = { .qos = 1, .weight = 8, .max_messages = 8,  .max_bytes = 2048, \
+                                      .drop = MQTT_OUTBOUND_REJECT_NEW, .outbox_limited = false, .flush_on_disconnect = false }, \
+        [MQTT_OUTBOUND_TELEMETRY] = { .qos = 1, .weight = 2, .max_messages = 8,  .max_bytes = 8192, \
+                                      .drop = MQTT_OUTBOUND_REJECT_NEW, .outbox_limited = true, .flush_on_disconnect = false }, \
+        [MQTT_OUTBOUND_BULK]      = { .qos = 1, .weight = 1, .max_messages = 4,  .max_bytes = 8192, \
+                                      .drop = MQTT_OUTBOUND_REJECT_NEW, .outbox_limited = true, .flush_on_disconnect = false }, \
+    }, \
+    .outbox_budget = 8 * 1024, \
+    .on_ack = NULL, \
+    .stack_size = 4096, \
+    .priority = 5 \
+}
+
+/**
+ * @brief Per-class statistics
+ */
+typedef struct {
+    uint32_t enqueued;              /**< Messages accepted */
+    uint32_t sent;                  /**< Messages handed to the MQTT client */
+    uint32_t dropped;               /**< Messages discarded (drop-oldest or flush on disconnect) */
+    uint32_t rejected;              /**< Messages refused because the queue was full */
+    uint16_t queued;                /**< Messages currently queued */
+    size_t queued_bytes;            /**< Payload bytes currently queued */
+    uint32_t wait_max_us;           /**< Longest time from enqueue to publish */
+    uint64_t wait_sum_us;           /**< Sum of queue times (divide by sent for the mean) */
+} mqtt_outbound_stats_t;
+
+/**
+ * @brief Initialize the queues and start the outbound task
+ *
+ * @param config Outbound configuration
+ * @return esp_err_t ESP_OK on success
+ */
+esp_err_t mqtt_outbound_init(const mqtt_outbound_config_t* config);
+
+/**
+ * @brief Report the connection state (call on MQTT_EVENT_CONNECTED / DISCONNECTED)
+ *
+ * Messages are only dequeued while connected.
+ *
+ * @param client MQTT client
+ * @param connected True once the client is connected
+ */
+void mqtt_outbound_set_connected(esp_mqtt_client_handle_t client, bool connected);
+
+/**
+ * @brief Queue a publish (never blocks; payload and topic are copied)
+ *
+ * @param cls Traffic class
+ * @param topic Topic
+ * @param data Payload
+ * @param len Payload length
+ * @param done Completion callback (optional)
+ * @param ctx Context passed to done
+ * @return esp_err_t ESP_OK if queued, ESP_ERR_NO_MEM if the queue is full or allocation failed
+ */
+esp_err_t mqtt_outbound_publish(mqtt_outbound_class_t cls, const char* topic, const char* data, size_t len,
+                                mqtt_outbound_done_cb_t done, void* ctx);
+
+/**
+ * @brief Handle MQTT_EVENT_PUBLISHED: report the PUBACK to on_ack
+ *
+ * A PUBACK arriving while the outbound task is between a publish and its
+ * done callback is held and reported right after that callback.
+ *
+ * @param msg_id Acknowledged message id
+ * @param acked_us Time the PUBACK was received (esp_timer_get_time)
+ */
+void mqtt_outbound_on_published(int msg_id, int64_t acked_us);
+
+/**
+ * @brief Payload bytes queued across all classes
+ */
+size_t mqtt_outbound_queued_bytes(void);
+
+/**
+ * @brief Get statistics for one class
+ *
+ * @param cls Traffic class
+ * @param stats Statistics (output)
+ * @return esp_err_t ESP_OK on success
+ */
+esp_err_t mqtt_outbound_get_stats(mqtt_outbound_class_t cls, mqtt_outbound_stats_t* stats);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,88 @@
+#include "pem_decoder.h"
+#include <string.h>
+
+#define PEM_BEGIN_CERT          "-----BEGIN CERTIFICATE-----"
+#define PEM_END_CERT            "-----END CERTIFICATE-----"
+
+static int base64_value(char c)
+{
+    if (c >= 'A' && c <= 'Z') return c - 'A';
+    if (c >= 'a' && c <= 'z') return c - 'a' + 26;
+    if (c >= '0' && c <= '9') return c - '0' + 52;
+    if (c == '+') return 62;
+    if (c == '/') return 63;
+    return -1;
+}
+
+/**
+ * @brief Handle a complete "-----" line
+ */
+static pem_decoder_event_t decode_marker(pem_decoder_t* decoder)
+{
+    if (strncmp(decoder->marker, PEM_BEGIN_CERT, strlen(PEM_BEGIN_CERT)) == 0) {
+        if (decoder->in_cert) {
+            return PEM_DECODER_ERROR;
+        }
+        decoder->in_cert = true;
+        decoder->bits = 0;
+        decoder->bit_count = 0;
+        return PEM_DECODER_BEGIN;
+    }
+
+    if (strncmp(decoder->marker, PEM_END_CERT, strlen(PEM_END_CERT)) == 0) {
+        if (!decoder->in_cert) {
+            return PEM_DECODER_ERROR;
+        }
+        decoder->in_cert = false;
+        return PEM_DECODER_END;
+    }
+
+    // Other PEM blocks are skipped, but may not be nested in a certificate
+    return decoder->in_cert ? PEM_DECODER_ERROR : PEM_DECODER_NONE;
+}
+
+void pem_decoder_init(pem_decoder_t* decoder)
+{
+    memset(decoder, 0, sizeof(*decoder));
+    decoder->line_start = true;
+}
+
+pem_decoder_event_t pem_decoder_feed(pem_decoder_t* decoder, char c, uint8_t* byte)
+{
+    if (c == '\n') {
+        pem_decoder_event_t event = decoder->in_marker ? decode_marker(decoder) : PEM_DECODER_NONE;
+        decoder->line_start = true;
+        decoder->in_marker = false;
+        decoder->marker_len = 0;
+        return event;
+    }
+
+    if (decoder->line_start) {
+        decoder->line_start = false;
+        decoder->in_marker = c == '-';
+    }
+    if (decoder->in_marker) {
+        if (decoder->marker_len < PEM_DECODER_MARKER_MAX - 1) {
+            decoder->marker[decoder->marker_len++] = c;
+            decoder->marker[decoder->marker_len] = '\0';
+        }
+        return PEM_DECODER_NONE;
+    }
+    if (!decoder->in_cert) {
+        return PEM_DECODER_NONE;
+    }
+
+    int value = base64_value(c);
+    if (value < 0) {
+        return c == '=' || c == '\r' || c == ' ' || c == '\t' ? PEM_DECODER_NONE : PEM_DECODER_ERROR;
+    }
+    decoder->bits = (decoder->bits << 6) | (uint32_t)value;
+    decoder->bit_count += 6;
+    if (decoder->bit_count < 8) {
+        return PEM_DECODER_NONE;
+    }
+    decoder->bit_count -= 8;
+    *byte = (uint8_t)(decoder->bits >> decoder->bit_count);
+    decoder->bits &= (1U << decoder->bit_count) - 1;
+    return PEM_DECODER_BYTE;
+}
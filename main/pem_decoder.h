@@ -0,0 +1,68 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * @file pem_decoder.h
+ * @brief Streaming decoder for the certificates of a PEM bundle
+ *
+ * Decodes the base64 of every CERTIFICATE block one character at a time, so
+ * a bundle that arrives in chunks is never held in RAM: the caller writes the
+ * DER bytes where they belong (a flash slot or sector) as they come out.
+ * Other PEM blocks are skipped. Marker lines take effect at their line break.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PEM_DECODER_MARKER_MAX  32      /**< "-----BEGIN CERTIFICATE-----" and then some */
+
+/**
+ * @brief Result of feeding one character
+ */
+typedef enum {
+    PEM_DECODER_NONE = 0,           /**< Nothing to do */
+    PEM_DECODER_BYTE,               /**< A DER byte of the current certificate was decoded */
+    PEM_DECODER_BEGIN,              /**< A certificate starts */
+    PEM_DECODER_END,                /**< The current certificate is complete */
+    PEM_DECODER_ERROR,              /**< Malformed PEM (bad character, unbalanced or nested markers) */
+} pem_decoder_event_t;
+
+/**
+ * @brief Decoder state (plain data, may live in a static)
+ */
+typedef struct {
+    bool line_start;
+    bool in_marker;                 /**< Current line is a "-----" marker */
+    char marker[PEM_DECODER_MARKER_MAX];
+    size_t marker_len;
+    bool in_cert;                   /**< Between BEGIN and END CERTIFICATE */
+    uint32_t bits;                  /**< Decoded base64 bits not yet emitted */
+    uint8_t bit_count;
+} pem_decoder_t;
+
+/**
+ * @brief Reset the decoder to the start of a bundle
+ *
+ * @param decoder Decoder state
+ */
+void pem_decoder_init(pem_decoder_t* decoder);
+
+/**
+ * @brief Feed one PEM character
+ *
+ * A bundle whose last line lacks a line break is completed by feeding '\n'.
+ *
+ * @param decoder Decoder state
+ * @param c Next character of the PEM
+ * @param byte Decoded DER byte (output, set for PEM_DECODER_BYTE)
+ * @return pem_decoder_event_t What the character completed
+ */
+pem_decoder_event_t pem_decoder_feed(pem_decoder_t* decoder, char c, uint8_t* byte);
+
+#ifdef __cplusplus
+}
+#endif
@@ -67,7 +67,7 @@ static const char provisioning_html[] = R"rawliteral(
         font-weight: 600;
         margin-bottom: 0.5rem;
     }
-    input[type="text"], input[type="password"] {
+    input[type="text"], input[type="password"], select {
         width: 100%;
         padding: 0.75rem;
         border: 1px solid var(--input-border-color);
@@ -164,6 +164,11 @@ static const char provisioning_html[] = R"rawliteral(
                 <input type="text" id="mqtt_port" name="mqtt_port" value="1883">
                 <label for="device_token">Device Access Token</label>
                 <input type="text" id="device_token" name="device_token" autocomplete="off" value="" required>
+                <label for="payload_format">Telemetry Payload</label>
+                <select id="payload_format" name="payload_format">
+                    <option value="json" selected>JSON</option>
+                    <option value="protobuf">Protobuf</option>
+                </select>
                 <input type="submit" value="Connect">
             </form>
             <div id="status-container" style="display: none;">
@@ -0,0 +1,48 @@
+#include "reconnect_backoff.h"
+
+static void apply_config(reconnect_backoff_t* backoff, const reconnect_backoff_config_t* config)
+{
+    backoff->config = *config;
+    if (backoff->config.base_ms == 0) {
+        backoff->config.base_ms = 1;
+    }
+    if (backoff->config.cap_ms < backoff->config.base_ms) {
+        backoff->config.cap_ms = backoff->config.base_ms;
+    }
+}
+
+void reconnect_backoff_init(reconnect_backoff_t* backoff, const reconnect_backoff_config_t* config)
+{
+    apply_config(backoff, config);
+    reconnect_backoff_reset(backoff);
+}
+
+void reconnect_backoff_set_config(reconnect_backoff_t* backoff, const reconnect_backoff_config_t* config)
+{
+    apply_config(backoff, config);
+}
+
+uint32_t reconnect_backoff_next(reconnect_backoff_t* backoff, uint32_t random)
+{
+    uint32_t base = backoff->config.base_ms;
+    uint32_t cap = backoff->config.cap_ms;
+    uint32_t previous = backoff->delay_ms < base ? base : backoff->delay_ms;
+
+    // Uniform in [base, 3 * previous], computed in 64 bits so a large cap cannot overflow
+    uint64_t upper = (uint64_t)previous * 3;
+    if (upper > cap) {
+        upper = cap;
+    }
+    uint64_t span = upper - base + 1;
+    uint32_t delay = (uint32_t)(base + random % span);
+
+    backoff->delay_ms = delay;
+    backoff->attempts++;
+    return delay;
+}
+
+void reconnect_backoff_reset(reconnect_backoff_t* backoff)
+{
+    backoff->delay_ms = 0;
+    backoff->attempts = 0;
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * @file reconnect_backoff.h
+ * @brief Decorrelated-jitter exponential backoff for reconnect attempts
+ *
+ * Each delay is drawn uniformly from [base_ms, 3 * previous delay], capped
+ * at cap_ms. Devices that lost their AP or broker at the same moment thus
+ * drift apart within a few attempts instead of retrying in lockstep, while
+ * the expected delay still grows exponentially up to the cap.
+ *
+ * The state is plain data with no locking or timers; the random value is
+ * supplied by the caller, so the sequence can be reproduced on the host.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Backoff limits
+ */
+typedef struct {
+    uint32_t base_ms;               /**< Shortest delay, also the first one */
+    uint32_t cap_ms;                /**< Longest delay */
+} reconnect_backoff_config_t;
+
+/**
+ * @brief Default backoff limits
+ */
+#define RECONNECT_BACKOFF_DEFAULT_CONFIG() { \
+    .base_ms = 1000, \
+    .cap_ms = 60000 \
+}
+
+/**
+ * @brief Backoff state of one link
+ */
+typedef struct {
+    reconnect_backoff_config_t config;
+    uint32_t delay_ms;              /**< Last delay handed out, 0 after a reset */
+    uint32_t attempts;              /**< Delays handed out since the last reset */
+} reconnect_backoff_t;
+
+/**
+ * @brief Initialize a backoff in the reset state
+ *
+ * cap_ms is raised to base_ms if it is smaller; a base_ms of 0 is treated as 1.
+ */
+void reconnect_backoff_init(reconnect_backoff_t* backoff, const reconnect_backoff_config_t* config);
+
+/**
+ * @brief Change the limits; the next delay honours them, the attempt count is kept
+ */
+void reconnect_backoff_set_config(reconnect_backoff_t* backoff, const reconnect_backoff_config_t* config);
+
+/**
+ * @brief Delay before the next attempt
+ *
+ * @param backoff Backoff state
+ * @param random Uniformly distributed random value (e.g. esp_random())
+ * @return Delay in milliseconds, within [base_ms, cap_ms]
+ */
+uint32_t reconnect_backoff_next(reconnect_backoff_t* backoff, uint32_t random);
+
+/**
+ * @brief Forget the attempts after a connection that held
+ */
+void reconnect_backoff_reset(reconnect_backoff_t* backoff);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,283 @@
+#include "rpc_handler.h"
+#include "mqtt_outbound.h"
+#include "freertos/FreeRTOS.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+#include <stdio.h>
+#include <string.h>
+
+static const char* TAG = "RPC_HANDLER";
+
+#define RPC_REQUEST_PREFIX      "v1/devices/me/rpc/request/"
+#define RPC_RESPONSE_PREFIX     "v1/devices/me/rpc/response/"
+#define RPC_REQUEST_ID_MAX      16
+#define RPC_RESPONSE_MAX        512
+#define RPC_PENDING_MAX         16      // Responses being timed (CONTROL queue depth plus the one in flight)
+
+typedef struct {
+    const char* method;
+    rpc_method_fn_t fn;
+    void* ctx;
+    uint32_t calls;
+    uint32_t errors;
+    uint32_t max_us;
+    uint32_t samples;                        /**< Latencies recorded (calls whose response was published) */
+    uint32_t latency_us[RPC_LATENCY_WINDOW]; /**< Ring of recent call latencies */
+} rpc_method_t;
+
+/**
+ * @brief A response queued in the outbound CONTROL class, timed until its publish
+ */
+typedef struct {
+    bool in_use;
+    rpc_method_t* method;
+    int64_t received_us;
+    bool failed;                    /**< The handler failed (the response carries the error) */
+} rpc_pending_t;
+
+// Requests are dispatched from the MQTT task, statistics are read by the telemetry task
+static rpc_method_t s_methods[RPC_HANDLER_MAX_METHODS];
+static int s_method_count = 0;
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// Response scratch space, only used from the MQTT task
+static char s_response[RPC_RESPONSE_MAX];
+
+// Claimed by the MQTT task, released by the outbound done callback; guarded by s_lock
+static rpc_pending_t s_pending[RPC_PENDING_MAX];
+
+esp_err_t rpc_handler_register(const char* method, rpc_method_fn_t fn, void* ctx)
+{
+    if (!method || !fn) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_method_count >= RPC_HANDLER_MAX_METHODS) {
+        ESP_LOGE(TAG, "Method table full, cannot register '%s'", method);
+        return ESP_ERR_NO_MEM;
+    }
+
+    portENTER_CRITICAL(&s_lock);
+    rpc_method_t* entry = &s_methods[s_method_count];
+    memset(entry, 0, sizeof(*entry));
+    entry->method = method;
+    entry->fn = fn;
+    entry->ctx = ctx;
+    s_method_count++;
+    portEXIT_CRITICAL(&s_lock);
+    return ESP_OK;
+}
+
+bool rpc_handler_is_request(const char* topic, int topic_len)
+{
+    size_t prefix_len = sizeof(RPC_REQUEST_PREFIX) - 1;
+    return topic && topic_len > (int)prefix_len && memcmp(topic, RPC_REQUEST_PREFIX, prefix_len) == 0;
+}
+
+static rpc_method_t* find_method(const json_span_t* name)
+{
+    for (int i = 0; i < s_method_count; i++) {
+        if (json_span_equals(name, s_methods[i].method)) {
+            return &s_methods[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Count a call and, if its response was published, its latency (called with s_lock held)
+ */
+static void record_call(rpc_method_t* method, bool published, uint32_t latency_us, bool failed)
+{
+    method->calls++;
+    if (failed) {
+        method->errors++;
+    }
+    if (!published) {
+        return;
+    }
+    method->latency_us[method->samples % RPC_LATENCY_WINDOW] = latency_us;
+    method->samples++;
+    if (latency_us > method->max_us) {
+        method->max_us = latency_us;
+    }
+}
+
+static rpc_pending_t* claim_pending(rpc_method_t* method, int64_t received_us, bool failed)
+{
+    rpc_pending_t* pending = NULL;
+    portENTER_CRITICAL(&s_lock);
+    for (int i = 0; i < RPC_PENDING_MAX; i++) {
+        if (!s_pending[i].in_use) {
+            pending = &s_pending[i];
+            pending->in_use = true;
+            pending->method = method;
+            pending->received_us = received_us;
+            pending->failed = failed;
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&s_lock);
+    return pending;
+}
+
+/**
+ * @brief Outbound done callback: the response was published (msg_id >= 0) or dropped (-1)
+ */
+static void response_done(int msg_id, void* ctx)
+{
+    rpc_pending_t* pending = ctx;
+    uint32_t latency_us = (uint32_t)(esp_timer_get_time() - pending->received_us);
+    portENTER_CRITICAL(&s_lock);
+    // A dropped response never reached the caller
+    record_call(pending->method, msg_id >= 0, latency_us, pending->failed || msg_id < 0);
+    const char* method = pending->method->method;
+    pending->in_use = false;
+    portEXIT_CRITICAL(&s_lock);
+
+    if (msg_id >= 0) {
+        ESP_LOGD(TAG, "RPC %s response published %lu us after the request", method, (unsigned long)latency_us);
+    } else {
+        ESP_LOGW(TAG, "RPC %s response dropped from the outbound queue", method);
+    }
+}
+
+esp_err_t rpc_handler_handle(const char* topic, int topic_len, const char* data, int data_len, int64_t received_us)
+{
+    if (!rpc_handler_is_request(topic, topic_len) || !data) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    size_t prefix_len = sizeof(RPC_REQUEST_PREFIX) - 1;
+    size_t id_len = (size_t)topic_len - prefix_len;
+    if (id_len > RPC_REQUEST_ID_MAX) {
+        ESP_LOGE(TAG, "RPC request id too long");
+        return ESP_ERR_INVALID_SIZE;
+    }
+    char response_topic[sizeof(RPC_RESPONSE_PREFIX) + RPC_REQUEST_ID_MAX];
+    snprintf(response_topic, sizeof(response_topic), RPC_RESPONSE_PREFIX "%.*s", (int)id_len, topic + prefix_len);
+
+    json_span_t root;
+    json_span_t name;
+    json_span_t params = { .type = JSON_SPAN_INVALID };
+    rpc_method_t* method = NULL;
+    esp_err_t err = ESP_ERR_INVALID_ARG;
+    size_t result_len = 0;
+    // Leave room for the error wrapper around the handler's result
+    const size_t result_max = sizeof(s_response) - 32;
+
+    if (json_scan_root(data, (size_t)data_len, &root) && json_scan_key(&root, "method", &name) &&
+        name.type == JSON_SPAN_STRING) {
+        json_scan_key(&root, "params", &params);
+        method = find_method(&name);
+        err = method ? method->fn(&params, s_response, result_max, &result_len, method->ctx) : ESP_ERR_NOT_FOUND;
+    }
+
+    int len;
+    if (err == ESP_OK) {
+        len = (int)result_len;
+    } else {
+        len = snprintf(s_response, sizeof(s_response), "{\"error\":\"%s\"}", esp_err_to_name(err));
+        ESP_LOGW(TAG, "RPC %s failed: %s", response_topic + sizeof(RPC_RESPONSE_PREFIX) - 1, esp_err_to_name(err));
+    }
+
+    // The latency is taken when the outbound task has published the response, not when it is queued
+    rpc_pending_t* pending = method ? claim_pending(method, received_us, err != ESP_OK) : NULL;
+    if (method && !pending) {
+        ESP_LOGW(TAG, "RPC %s: too many responses in flight, latency not recorded", method->method);
+    }
+    esp_err_t publish_err = mqtt_outbound_publish(MQTT_OUTBOUND_CONTROL, response_topic, s_response, len,
+                                                  pending ? response_done : NULL, pending);
+    if (method) {
+        ESP_LOGI(TAG, "RPC %s -> %d bytes queued", method->method, len);
+    }
+    // Not queued, or queued untimed: count the call here
+    if (method && (publish_err != ESP_OK || !pending)) {
+        portENTER_CRITICAL(&s_lock);
+        record_call(method, false, 0, err != ESP_OK || publish_err != ESP_OK);
+        if (pending) {
+            pending->in_use = false;
+        }
+        portEXIT_CRITICAL(&s_lock);
+    }
+    return publish_err;
+}
+
+static uint32_t percentile(const uint32_t* sorted, size_t count, uint32_t pct)
+{
+    // Nearest-rank percentile
+    size_t rank = (pct * count + 99) / 100;
+    return sorted[rank > 0 ? rank - 1 : 0];
+}
+
+size_t rpc_handler_get_stats(rpc_method_stats_t* stats, size_t max_count)
+{
+    if (!stats) {
+        return 0;
+    }
+
+    size_t count = 0;
+    for (int i = 0; i < s_method_count && count < max_count; i++) {
+        uint32_t window[RPC_LATENCY_WINDOW];
+        rpc_method_stats_t* out = &stats[count++];
+
+        portENTER_CRITICAL(&s_lock);
+        const rpc_method_t* method = &s_methods[i];
+        size_t samples = method->samples < RPC_LATENCY_WINDOW ? method->samples : RPC_LATENCY_WINDOW;
+        memcpy(window, method->latency_us, samples * sizeof(uint32_t));
+        out->method = method->method;
+        out->calls = method->calls;
+        out->errors = method->errors;
+        out->max_us = method->max_us;
+        portEXIT_CRITICAL(&s_lock);
+
+        out->p50_us = out->p90_us = out->p99_us = 0;
+        if (samples == 0) {
+            continue;
+        }
+        // Insertion sort: the window is small
+        for (size_t a = 1; a < samples; a++) {
+            uint32_t v = window[a];
+            size_t b = a;
+            for (; b > 0 && window[b - 1] > v; b--) {
+                window[b] = window[b - 1];
+            }
+            window[b] = v;
+        }
+        out->p50_us = percentile(window, samples, 50);
+        out->p90_us = percentile(window, samples, 90);
+        out->p99_us = percentile(window, samples, 99);
+    }
+    return count;
+}
+
+size_t rpc_handler_serialize_stats(char* buf, size_t size)
+{
+    rpc_method_stats_t stats[RPC_HANDLER_MAX_METHODS];
+    size_t count = rpc_handler_get_stats(stats, RPC_HANDLER_MAX_METHODS);
+    if (!buf || size < 2) {
+        return 0;
+    }
+
+    size_t len = 0;
+    buf[len++] = '{';
+    for (size_t i = 0; i < count; i++) {
+        if (stats[i].calls == 0) {
+            continue;
+        }
+        int n = snprintf(buf + len, size - len,
+                         "%s\"rpc_%s_p50_us\":%lu,\"rpc_%s_p90_us\":%lu,\"rpc_%s_p99_us\":%lu,\"rpc_%s_calls\":%lu",
+                         len > 1 ? "," : "", stats[i].method, (unsigned long)stats[i].p50_us,
+                         stats[i].method, (unsigned long)stats[i].p90_us, stats[i].method,
+                         (unsigned long)stats[i].p99_us, stats[i].method, (unsigned long)stats[i].calls);
+        if (n < 0 || (size_t)n >= size - len) {
+            return 0;
+        }
+        len += (size_t)n;
+    }
+    if (len == 1 || len + 2 > size) {
+        return 0;
+    }
+    buf[len++] = '}';
+    buf[len] = '\0';
+    return len;
+}
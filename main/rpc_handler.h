@@ -0,0 +1,123 @@
+#pragma once
+
+#include "esp_err.h"
+#include "json_scan.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * @file rpc_handler.h
+ * @brief ThingsBoard server-side RPC dispatcher
+ *
+ * Requests arrive on v1/devices/me/rpc/request/{id} as
+ * {"method":"...","params":...}. The method is looked up in a registered
+ * table, the handler writes a JSON result and the reply is queued for
+ * v1/devices/me/rpc/response/{id} ahead of telemetry. Parsing uses
+ * json_scan, so dispatch makes no heap allocations beyond the queued reply.
+ * Each call is timed from the MQTT data event until the outbound task has
+ * handed the response to the MQTT client (its done callback), so time spent
+ * behind other CONTROL messages counts. Per-method latency percentiles are
+ * kept over a sliding window of recent calls.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Topic to subscribe to for RPC requests
+ */
+#define RPC_REQUEST_SUBSCRIBE_TOPIC "v1/devices/me/rpc/request/+"
+
+/**
+ * @brief Maximum number of registered methods
+ */
+#define RPC_HANDLER_MAX_METHODS 8
+
+/**
+ * @brief Calls kept per method for latency percentiles
+ */
+#define RPC_LATENCY_WINDOW 32
+
+/**
+ * @brief RPC method handler
+ *
+ * @param params "params" value of the request (type JSON_SPAN_INVALID if absent)
+ * @param result Buffer for the JSON result value (object, string, number, ...)
+ * @param result_size Size of the result buffer
+ * @param result_len Length written to result (output)
+ * @param ctx Context pointer given at registration
+ * @return esp_err_t ESP_OK on success; otherwise the reply is {"error":"<name>"}
+ */
+typedef esp_err_t (*rpc_method_fn_t)(const json_span_t* params, char* result, size_t result_size,
+                                     size_t* result_len, void* ctx);
+
+/**
+ * @brief Per-method call statistics
+ */
+typedef struct {
+    const char* method;             /**< Method name */
+    uint32_t calls;                 /**< Total calls */
+    uint32_t errors;                /**< Calls whose handler failed or whose response was not published */
+    uint32_t p50_us;                /**< Median latency over the window (published responses only) */
+    uint32_t p90_us;                /**< 90th percentile latency over the window */
+    uint32_t p99_us;                /**< 99th percentile latency over the window */
+    uint32_t max_us;                /**< Maximum latency since boot */
+} rpc_method_stats_t;
+
+/**
+ * @brief Register an RPC method
+ *
+ * @param method Method name (must stay valid, usually a literal)
+ * @param fn Handler
+ * @param ctx Context pointer passed to the handler
+ * @return esp_err_t ESP_OK on success, ESP_ERR_NO_MEM if the table is full
+ */
+esp_err_t rpc_handler_register(const char* method, rpc_method_fn_t fn, void* ctx);
+
+/**
+ * @brief Check whether an MQTT topic is an RPC request
+ *
+ * @param topic Topic (not NUL-terminated)
+ * @param topic_len Topic length
+ * @return true for v1/devices/me/rpc/request/{id}
+ */
+bool rpc_handler_is_request(const char* topic, int topic_len);
+
+/**
+ * @brief Dispatch one RPC request and queue the response in the outbound CONTROL class
+ *
+ * @param topic Request topic
+ * @param topic_len Topic length
+ * @param data Request payload
+ * @param data_len Payload length
+ * @param received_us esp_timer time when the request was received
+ * @return esp_err_t ESP_OK if a response was queued
+ */
+esp_err_t rpc_handler_handle(const char* topic, int topic_len, const char* data, int data_len, int64_t received_us);
+
+/**
+ * @brief Get statistics for the registered methods
+ *
+ * @param stats Output array
+ * @param max_count Array capacity
+ * @return size_t Number of entries written
+ */
+size_t rpc_handler_get_stats(rpc_method_stats_t* stats, size_t max_count);
+
+/**
+ * @brief Render latency statistics as a flat telemetry object
+ *
+ * Keys are rpc_<method>_p50_us, _p90_us, _p99_us and _calls for every method
+ * that has been called.
+ *
+ * @param buf Output buffer
+ * @param size Size of the output buffer
+ * @return size_t Payload length, 0 if no method was called or the buffer is too small
+ */
+size_t rpc_handler_serialize_stats(char* buf, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,99 @@
+#include "telemetry_aggregator.h"
+#include "freertos/FreeRTOS.h"
+#include "esp_timer.h"
+#include <string.h>
+
+// Windows are written by the sampler and closed by the telemetry task
+static telemetry_window_t s_windows[TELEMETRY_SIGNAL_COUNT];
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+
+void telemetry_window_reset(telemetry_window_t* window)
+{
+    window->sum = 0;
+    window->min = INT32_MAX;
+    window->max = INT32_MIN;
+    window->count = 0;
+}
+
+void telemetry_window_add(telemetry_window_t* window, int32_t value)
+{
+    window->sum += value;
+    if (value < window->min) {
+        window->min = value;
+    }
+    if (value > window->max) {
+        window->max = value;
+    }
+    window->last = value;
+    window->count++;
+}
+
+int32_t telemetry_window_get(const telemetry_window_t* window, telemetry_aggregate_t aggregate)
+{
+    if (aggregate == TELEMETRY_AGG_COUNT) {
+        return (int32_t)window->count;
+    }
+    if (window->count == 0) {
+        return window->last;
+    }
+
+    switch (aggregate) {
+    case TELEMETRY_AGG_MIN:
+        return window->min;
+    case TELEMETRY_AGG_MAX:
+        return window->max;
+    case TELEMETRY_AGG_LAST:
+        return window->last;
+    case TELEMETRY_AGG_MEAN:
+    default: {
+        int64_t half = window->count / 2;
+        int64_t rounded = window->sum >= 0 ? window->sum + half : window->sum - half;
+        return (int32_t)(rounded / (int64_t)window->count);
+    }
+    }
+}
+
+esp_err_t telemetry_aggregator_init(void)
+{
+    portENTER_CRITICAL(&s_lock);
+    memset(s_windows, 0, sizeof(s_windows));
+    for (int signal = 0; signal < TELEMETRY_SIGNAL_COUNT; signal++) {
+        telemetry_window_reset(&s_windows[signal]);
+    }
+    portEXIT_CRITICAL(&s_lock);
+    return ESP_OK;
+}
+
+void telemetry_aggregator_add(telemetry_signal_t signal, int32_t value)
+{
+    if (signal >= TELEMETRY_SIGNAL_COUNT) {
+        return;
+    }
+    portENTER_CRITICAL(&s_lock);
+    telemetry_window_add(&s_windows[signal], value);
+    portEXIT_CRITICAL(&s_lock);
+}
+
+void telemetry_aggregator_close_window(telemetry_sample_t* sample)
+{
+    telemetry_window_t closed[TELEMETRY_SIGNAL_COUNT];
+
+    // Snapshot and reset under the lock, compute aggregates outside of it
+    portENTER_CRITICAL(&s_lock);
+    memcpy(closed, s_windows, sizeof(closed));
+    for (int signal = 0; signal < TELEMETRY_SIGNAL_COUNT; signal++) {
+        telemetry_window_reset(&s_windows[signal]);
+    }
+    portEXIT_CRITICAL(&s_lock);
+
+    sample->captured_us = esp_timer_get_time();
+    sample->present = 0;
+    for (int key = 0; key < TELEMETRY_KEY_COUNT; key++) {
+        const telemetry_field_t* field = &telemetry_schema[key];
+        sample->values[key] = telemetry_window_get(&closed[field->signal], field->aggregate);
+        // A signal without samples this window (sensor read failed) is left out, not repeated
+        if (closed[field->signal].count > 0 || field->aggregate == TELEMETRY_AGG_COUNT) {
+            sample->present |= 1U << key;
+        }
+    }
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include "esp_err.h"
+#include "telemetry_schema.h"
+#include "telemetry_buffer.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * @file telemetry_aggregator.h
+ * @brief Windowed on-device aggregation of sampled signals
+ *
+ * Signals are sampled at their own rates and folded into a per-signal window
+ * that keeps min/max/sum/last/count (O(1) memory per signal). At each upload
+ * interval the window is closed into one telemetry sample holding the
+ * aggregates requested by the schema, so sampling faster does not increase
+ * MQTT traffic.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Aggregation window for one signal
+ */
+typedef struct {
+    int64_t sum;                    /**< Sum of samples in the window */
+    int32_t min;                    /**< Minimum sample in the window */
+    int32_t max;                    /**< Maximum sample in the window */
+    int32_t last;                   /**< Most recent sample (carried across windows) */
+    uint32_t count;                 /**< Number of samples in the window */
+} telemetry_window_t;
+
+/**
+ * @brief Start a new window, keeping the last value
+ *
+ * @param window Window to reset
+ */
+void telemetry_window_reset(telemetry_window_t* window);
+
+/**
+ * @brief Fold one sample into a window
+ *
+ * @param window Window to update
+ * @param value Fixed-point sample value
+ */
+void telemetry_window_add(telemetry_window_t* window, int32_t value);
+
+/**
+ * @brief Read an aggregate from a window
+ *
+ * An empty window reports its last value for every aggregate except COUNT.
+ *
+ * @param window Window to read
+ * @param aggregate Aggregate to compute
+ * @return int32_t Aggregate value (mean is rounded half away from zero)
+ */
+int32_t telemetry_window_get(const telemetry_window_t* window, telemetry_aggregate_t aggregate);
+
+/**
+ * @brief Reset all signal windows
+ *
+ * @return esp_err_t ESP_OK on success
+ */
+esp_err_t telemetry_aggregator_init(void);
+
+/**
+ * @brief Record one sample of a signal (safe to call from any task)
+ *
+ * @param signal Sampled signal
+ * @param value Fixed-point sample value
+ */
+void telemetry_aggregator_add(telemetry_signal_t signal, int32_t value);
+
+/**
+ * @brief Close the current window into a telemetry sample and start a new one
+ *
+ * Keys whose signal had no samples in the window are cleared from present
+ * (COUNT aggregates are always present).
+ *
+ * @param sample Sample to fill with the schema aggregates (captured_us is set to now)
+ */
+void telemetry_aggregator_close_window(telemetry_sample_t* sample);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,249 @@
+#include "telemetry_backpressure.h"
+#include "freertos/FreeRTOS.h"
+#include "esp_log.h"
+#include <string.h>
+
+static const char* TAG = "TELEMETRY_BP";
+
+#define INFLIGHT_MAX        8       // Tracked unacknowledged telemetry publishes
+#define ACK_EWMA_SHIFT      2       // Latency smoothing: new = old + (sample - old) / 4
+#define RECOVERY_MARGIN_PCT 75      // Recovery needs outbox and latency below 75% of a threshold
+#define RECOVERY_MARGIN_DB  5       // ... and RSSI 5 dB above it
+
+/**
+ * @brief Publish stride and window coalescing per level
+ */
+static const struct {
+    uint32_t publish_stride;
+    uint32_t coalesce_factor;
+    const char* name;
+} s_levels[TELEMETRY_BP_LEVEL_COUNT] = {
+    [TELEMETRY_BP_NORMAL]    = { .publish_stride = 1, .coalesce_factor = 1, .name = "normal" },
+    [TELEMETRY_BP_DEGRADED]  = { .publish_stride = 2, .coalesce_factor = 1, .name = "degraded" },
+    [TELEMETRY_BP_CONGESTED] = { .publish_stride = 4, .coalesce_factor = 2, .name = "congested" },
+    [TELEMETRY_BP_BLOCKED]   = { .publish_stride = 0, .coalesce_factor = 4, .name = "blocked" },
+};
+
+typedef struct {
+    int msg_id;
+    int64_t sent_ms;
+} inflight_t;
+
+// Publishes and acks are recorded from the MQTT task, the level is updated by the telemetry task
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static telemetry_bp_config_t s_config;
+static inflight_t s_inflight[INFLIGHT_MAX];
+static int s_inflight_count = 0;
+static uint8_t s_healthy_updates = 0;
+static uint32_t s_losses_seen = 0;
+static telemetry_bp_stats_t s_stats = {0};
+
+static telemetry_bp_level_t level_max(telemetry_bp_level_t a, telemetry_bp_level_t b)
+{
+    return a > b ? a : b;
+}
+
+static void ack_latency_add(uint32_t latency_ms)
+{
+    if (s_stats.ack_latency_ms == 0) {
+        s_stats.ack_latency_ms = latency_ms;
+    } else {
+        int32_t delta = (int32_t)latency_ms - (int32_t)s_stats.ack_latency_ms;
+        s_stats.ack_latency_ms += delta / (1 << ACK_EWMA_SHIFT);
+    }
+}
+
+static void inflight_remove(int index)
+{
+    s_inflight[index] = s_inflight[--s_inflight_count];
+}
+
+/**
+ * @brief Count timed-out publishes as losses with the timeout as their latency
+ */
+static void expire_inflight(int64_t now_ms)
+{
+    for (int i = s_inflight_count - 1; i >= 0; i--) {
+        if (now_ms - s_inflight[i].sent_ms >= s_config.ack_timeout_ms) {
+            ack_latency_add(s_config.ack_timeout_ms);
+            s_stats.losses++;
+            inflight_remove(i);
+        }
+    }
+}
+
+/**
+ * @brief Level demanded by the current signals alone
+ *
+ * With recovering set, thresholds are tightened by the recovery margin so a
+ * signal hovering around a threshold does not make the level flap.
+ */
+static telemetry_bp_level_t target_level(size_t outbox_bytes, int8_t rssi, bool new_losses, bool recovering)
+{
+    telemetry_bp_level_t level = TELEMETRY_BP_NORMAL;
+    uint32_t pct = recovering ? RECOVERY_MARGIN_PCT : 100;
+    int margin_db = recovering ? RECOVERY_MARGIN_DB : 0;
+
+    if (outbox_bytes >= s_config.outbox_blocked * pct / 100) {
+        level = TELEMETRY_BP_BLOCKED;
+    } else if (outbox_bytes >= s_config.outbox_congested * pct / 100) {
+        level = TELEMETRY_BP_CONGESTED;
+    } else if (outbox_bytes >= s_config.outbox_degraded * pct / 100) {
+        level = TELEMETRY_BP_DEGRADED;
+    }
+
+    if (s_stats.ack_latency_ms >= s_config.ack_congested_ms * pct / 100 || new_losses) {
+        level = level_max(level, TELEMETRY_BP_CONGESTED);
+    } else if (s_stats.ack_latency_ms >= s_config.ack_degraded_ms * pct / 100) {
+        level = level_max(level, TELEMETRY_BP_DEGRADED);
+    }
+
+    // 0 means RSSI unknown (not associated)
+    if (rssi != 0 && rssi < s_config.rssi_congested + margin_db) {
+        level = level_max(level, TELEMETRY_BP_CONGESTED);
+    } else if (rssi != 0 && rssi < s_config.rssi_degraded + margin_db) {
+        level = level_max(level, TELEMETRY_BP_DEGRADED);
+    }
+    return level;
+}
+
+esp_err_t telemetry_bp_init(const telemetry_bp_config_t* config)
+{
+    if (!config || config->outbox_ceiling == 0 || config->outbox_degraded > config->outbox_congested ||
+        config->outbox_congested > config->outbox_blocked || config->outbox_blocked > config->outbox_ceiling ||
+        config->ack_degraded_ms > config->ack_congested_ms || config->rssi_congested > config->rssi_degraded) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    portENTER_CRITICAL(&s_lock);
+    s_config = *config;
+    s_inflight_count = 0;
+    s_healthy_updates = 0;
+    s_losses_seen = 0;
+    memset(&s_stats, 0, sizeof(s_stats));
+    s_stats.level = TELEMETRY_BP_NORMAL;
+    portEXIT_CRITICAL(&s_lock);
+
+    ESP_LOGI(TAG, "Backpressure: outbox ceiling %u bytes, ack timeout %lu ms", (unsigned)config->outbox_ceiling,
+             (unsigned long)config->ack_timeout_ms);
+    return ESP_OK;
+}
+
+void telemetry_bp_on_publish(int msg_id, int64_t now_ms)
+{
+    if (msg_id <= 0) {
+        return;
+    }
+
+    portENTER_CRITICAL(&s_lock);
+    if (s_inflight_count == INFLIGHT_MAX) {
+        // Only a sample of publishes is needed for the latency estimate; replace the oldest
+        int oldest = 0;
+        for (int i = 1; i < s_inflight_count; i++) {
+            if (s_inflight[i].sent_ms < s_inflight[oldest].sent_ms) {
+                oldest = i;
+            }
+        }
+        inflight_remove(oldest);
+    }
+    s_inflight[s_inflight_count].msg_id = msg_id;
+    s_inflight[s_inflight_count].sent_ms = now_ms;
+    s_inflight_count++;
+    portEXIT_CRITICAL(&s_lock);
+}
+
+bool telemetry_bp_on_ack(int msg_id, int64_t now_ms)
+{
+    bool tracked = false;
+    portENTER_CRITICAL(&s_lock);
+    for (int i = 0; i < s_inflight_count; i++) {
+        if (s_inflight[i].msg_id == msg_id) {
+            int64_t latency_ms = now_ms - s_inflight[i].sent_ms;
+            ack_latency_add(latency_ms > 0 ? (uint32_t)latency_ms : 0);
+            s_stats.acks++;
+            inflight_remove(i);
+            tracked = true;
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&s_lock);
+    return tracked;
+}
+
+telemetry_bp_level_t telemetry_bp_update(size_t outbox_bytes, int8_t rssi, int64_t now_ms)
+{
+    portENTER_CRITICAL(&s_lock);
+    expire_inflight(now_ms);
+    if (outbox_bytes > s_stats.outbox_peak) {
+        s_stats.outbox_peak = outbox_bytes;
+    }
+
+    bool new_losses = s_stats.losses != s_losses_seen;
+    s_losses_seen = s_stats.losses;
+    telemetry_bp_level_t previous = s_stats.level;
+    telemetry_bp_level_t target = target_level(outbox_bytes, rssi, new_losses, false);
+
+    if (target > s_stats.level) {
+        // Degrade immediately
+        s_stats.level = target;
+        s_healthy_updates = 0;
+    } else if (target_level(outbox_bytes, rssi, new_losses, true) < s_stats.level) {
+        // Recover one level at a time once the link has been better for a while
+        if (++s_healthy_updates >= s_config.recovery_updates) {
+            s_stats.level--;
+            s_healthy_updates = 0;
+        }
+    } else {
+        s_healthy_updates = 0;
+    }
+
+    telemetry_bp_level_t level = s_stats.level;
+    if (level != previous) {
+        s_stats.level_changes++;
+    }
+    uint32_t ack_latency_ms = s_stats.ack_latency_ms;
+    portEXIT_CRITICAL(&s_lock);
+
+    if (level != previous) {
+        ESP_LOGW(TAG, "Backpressure %s -> %s (outbox %u bytes, ack %lu ms, rssi %d)", s_levels[previous].name,
+                 s_levels[level].name, (unsigned)outbox_bytes, (unsigned long)ack_latency_ms, rssi);
+    }
+    return level;
+}
+
+bool telemetry_bp_admit(size_t message_len, size_t outbox_bytes)
+{
+    portENTER_CRITICAL(&s_lock);
+    bool admit = outbox_bytes + message_len <= s_config.outbox_ceiling;
+    if (!admit) {
+        s_stats.rejected++;
+    }
+    portEXIT_CRITICAL(&s_lock);
+    return admit;
+}
+
+uint32_t telemetry_bp_publish_stride(void)
+{
+    portENTER_CRITICAL(&s_lock);
+    telemetry_bp_level_t level = s_stats.level;
+    portEXIT_CRITICAL(&s_lock);
+    return s_levels[level].publish_stride;
+}
+
+uint32_t telemetry_bp_coalesce_factor(void)
+{
+    portENTER_CRITICAL(&s_lock);
+    telemetry_bp_level_t level = s_stats.level;
+    portEXIT_CRITICAL(&s_lock);
+    return s_levels[level].coalesce_factor;
+}
+
+void telemetry_bp_get_stats(telemetry_bp_stats_t* stats)
+{
+    if (!stats) {
+        return;
+    }
+    portENTER_CRITICAL(&s_lock);
+    *stats = s_stats;
+    portEXIT_CRITICAL(&s_lock);
+}
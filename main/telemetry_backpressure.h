@@ -0,0 +1,150 @@
+#pragma once
+
+#include "esp_err.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * @file telemetry_backpressure.h
+ * @brief Adaptive telemetry publish rate driven by outbox depth and link quality
+ *
+ * The controller watches three signals: bytes queued in the MQTT outbox,
+ * PUBACK latency of telemetry publishes (unacknowledged publishes count as
+ * lost after a timeout) and Wi-Fi RSSI. Each maps to a backpressure level;
+ * the worst one wins immediately, while recovery steps down one level at a
+ * time after several healthy updates (hysteresis).
+ *
+ * Higher levels publish less often (larger batches per publish) and coalesce
+ * consecutive upload windows into one sample. Independently of the level, a
+ * publish is only admitted if it keeps the outbox under a hard ceiling, so
+ * the outbox can never exhaust the heap; rejected samples stay in the ring
+ * or go to the flash store.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Backpressure levels
+ */
+typedef enum {
+    TELEMETRY_BP_NORMAL = 0,        /**< Publish every upload window */
+    TELEMETRY_BP_DEGRADED,          /**< Publish every 2nd window */
+    TELEMETRY_BP_CONGESTED,         /**< Publish every 4th window, coalesce windows in pairs */
+    TELEMETRY_BP_BLOCKED,           /**< No live publishing, coalesce windows by 4 */
+    TELEMETRY_BP_LEVEL_COUNT
+} telemetry_bp_level_t;
+
+/**
+ * @brief Controller configuration
+ */
+typedef struct {
+    size_t outbox_ceiling;          /**< Hard limit for outbox bytes after a publish */
+    size_t outbox_degraded;         /**< Outbox bytes for DEGRADED */
+    size_t outbox_congested;        /**< Outbox bytes for CONGESTED */
+    size_t outbox_blocked;          /**< Outbox bytes for BLOCKED */
+    uint32_t ack_degraded_ms;       /**< PUBACK latency for DEGRADED */
+    uint32_t ack_congested_ms;      /**< PUBACK latency for CONGESTED */
+    uint32_t ack_timeout_ms;        /**< Unacknowledged publishes count as lost after this */
+    int8_t rssi_degraded;           /**< RSSI (dBm) below which the link is DEGRADED */
+    int8_t rssi_congested;          /**< RSSI (dBm) below which the link is CONGESTED */
+    uint8_t recovery_updates;       /**< Healthy updates required to step down one level */
+} telemetry_bp_config_t;
+
+/**
+ * @brief Default controller configuration
+ */
+#define TELEMETRY_BP_DEFAULT_CONFIG() { \
+    .outbox_ceiling = 16 * 1024, \
+    .outbox_degraded = 4 * 1024, \
+    .outbox_congested = 8 * 1024, \
+    .outbox_blocked = 12 * 1024, \
+    .ack_degraded_ms = 1000, \
+    .ack_congested_ms = 3000, \
+    .ack_timeout_ms = 10000, \
+    .rssi_degraded = -75, \
+    .rssi_congested = -85, \
+    .recovery_updates = 3 \
+}
+
+/**
+ * @brief Controller statistics
+ */
+typedef struct {
+    telemetry_bp_level_t level;     /**< Current level */
+    uint32_t ack_latency_ms;        /**< Smoothed PUBACK latency (0 until the first ack) */
+    uint32_t acks;                  /**< PUBACKs received for tracked publishes */
+    uint32_t losses;                /**< Tracked publishes that timed out */
+    uint32_t rejected;              /**< Publishes refused by the outbox ceiling */
+    uint32_t level_changes;         /**< Level transitions */
+    size_t outbox_peak;             /**< Highest outbox size observed */
+} telemetry_bp_stats_t;
+
+/**
+ * @brief Initialize the controller at NORMAL
+ *
+ * @param config Controller configuration
+ * @return esp_err_t ESP_OK on success
+ */
+esp_err_t telemetry_bp_init(const telemetry_bp_config_t* config);
+
+/**
+ * @brief Record a telemetry publish whose PUBACK should be timed
+ *
+ * @param msg_id MQTT message id returned by the publish
+ * @param now_ms Current time in ms
+ */
+void telemetry_bp_on_publish(int msg_id, int64_t now_ms);
+
+/**
+ * @brief Record a PUBACK (ignored for untracked message ids)
+ *
+ * @param msg_id Acknowledged message id
+ * @param now_ms Current time in ms
+ * @return true if msg_id was a tracked telemetry publish
+ */
+bool telemetry_bp_on_ack(int msg_id, int64_t now_ms);
+
+/**
+ * @brief Re-evaluate the level, once per upload window
+ *
+ * @param outbox_bytes Current MQTT outbox size
+ * @param rssi Current RSSI in dBm (0 if unknown)
+ * @param now_ms Current time in ms
+ * @return telemetry_bp_level_t New level
+ */
+telemetry_bp_level_t telemetry_bp_update(size_t outbox_bytes, int8_t rssi, int64_t now_ms);
+
+/**
+ * @brief Check whether a publish keeps the outbox under the ceiling
+ *
+ * Counts a rejection when it does not.
+ *
+ * @param message_len Outbox bytes the publish adds (payload, topic and MQTT framing)
+ * @param outbox_bytes Current MQTT outbox size
+ * @return true if the publish may proceed
+ */
+bool telemetry_bp_admit(size_t message_len, size_t outbox_bytes);
+
+/**
+ * @brief Publish every Nth upload window at the current level (0 = do not publish)
+ */
+uint32_t telemetry_bp_publish_stride(void);
+
+/**
+ * @brief Number of upload windows to coalesce into one sample at the current level
+ */
+uint32_t telemetry_bp_coalesce_factor(void);
+
+/**
+ * @brief Get controller statistics
+ *
+ * @param stats Statistics (output)
+ */
+void telemetry_bp_get_stats(telemetry_bp_stats_t* stats);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,134 @@
+#include "telemetry_buffer.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include <string.h>
+
+static const char* TAG = "TELEMETRY_BUF";
+
+// Configuration and state (owned by the telemetry task, no locking required)
+static telemetry_buffer_config_t s_config = {0};
+static bool s_initialized = false;
+
+// Preallocated sample storage
+static telemetry_sample_t s_samples[TELEMETRY_BUFFER_MAX_SAMPLES];
+static size_t s_head = 0;           // Index of the oldest pending sample
+static size_t s_count = 0;          // Number of pending samples
+static int64_t s_last_flush_us = 0;
+
+static telemetry_buffer_stats_t s_stats = {0};
+
+esp_err_t telemetry_buffer_init(const telemetry_buffer_config_t* config)
+{
+    if (!config || config->capacity == 0 || config->capacity > TELEMETRY_BUFFER_MAX_SAMPLES ||
+        config->batch_size == 0) {
+        ESP_LOGE(TAG, "Invalid configuration");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    s_config = *config;
+    if (s_config.batch_size > s_config.capacity) {
+        s_config.batch_size = s_config.capacity;
+    }
+
+    s_head = 0;
+    s_count = 0;
+    s_last_flush_us = esp_timer_get_time();
+    memset(&s_stats, 0, sizeof(s_stats));
+    s_initialized = true;
+
+    ESP_LOGI(TAG, "Telemetry buffer initialized (capacity: %d, batch: %d, interval: %lu ms)",
+             s_config.capacity, s_config.batch_size, (unsigned long)s_config.flush_interval_ms);
+    return ESP_OK;
+}
+
+esp_err_t telemetry_buffer_push(const telemetry_sample_t* sample)
+{
+    if (!s_initialized) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (!sample) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (s_count == s_config.capacity) {
+        // Ring full: drop the oldest sample to keep the most recent data
+        s_head = (s_head + 1) % s_config.capacity;
+        s_count--;
+        s_stats.samples_dropped++;
+        ESP_LOGW(TAG, "Telemetry buffer full, dropped oldest sample");
+    }
+
+    s_samples[(s_head + s_count) % s_config.capacity] = *sample;
+    s_count++;
+    s_stats.samples_captured++;
+    return ESP_OK;
+}
+
+size_t telemetry_buffer_count(void)
+{
+    return s_count;
+}
+
+bool telemetry_buffer_flush_due(int64_t now_us)
+{
+    if (!s_initialized || s_count == 0) {
+        return false;
+    }
+    if (s_count >= s_config.batch_size) {
+        return true;
+    }
+    return (now_us - s_last_flush_us) >= (int64_t)s_config.flush_interval_ms * 1000;
+}
+
+size_t telemetry_buffer_peek(telemetry_sample_t* out, size_t max_samples)
+{
+    if (!s_initialized || !out) {
+        return 0;
+    }
+
+    size_t n = s_count < max_samples ? s_count : max_samples;
+    for (size_t i = 0; i < n; i++) {
+        out[i] = s_samples[(s_head + i) % s_config.capacity];
+    }
+    return n;
+}
+
+void telemetry_buffer_consume(size_t count, size_t payload_bytes)
+{
+    if (!s_initialized) {
+        return;
+    }
+    if (count > s_count) {
+        count = s_count;
+    }
+
+    s_head = (s_head + count) % s_config.capacity;
+    s_count -= count;
+    s_last_flush_us = esp_timer_get_time();
+
+    s_stats.samples_published += count;
+    s_stats.publishes++;
+    s_stats.payload_bytes += payload_bytes;
+}
+
+void telemetry_buffer_spill(size_t count)
+{
+    if (!s_initialized) {
+        return;
+    }
+    if (count > s_count) {
+        count = s_count;
+    }
+
+    s_head = (s_head + count) % s_config.capacity;
+    s_count -= count;
+    s_last_flush_us = esp_timer_get_time();
+    s_stats.samples_spilled += count;
+}
+
+void telemetry_buffer_get_stats(telemetry_buffer_stats_t* stats)
+{
+    if (stats) {
+        *stats = s_stats;
+    }
+}
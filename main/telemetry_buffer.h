@@ -0,0 +1,129 @@
+#pragma once
+
+#include "esp_err.h"
+#include "telemetry_schema.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * @file telemetry_buffer.h
+ * @brief Preallocated telemetry sample ring buffer for batched uploads
+ *
+ * Samples are captured into a fixed-size in-RAM ring and flushed as one
+ * ThingsBoard timestamped array (`[{"ts":...,"values":{...}}, ...]`) once
+ * a batch size or a flush interval is reached, so each sample no longer
+ * pays its own MQTT framing and PUBACK round-trip.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Upper bound for the ring capacity (storage is statically allocated)
+ */
+#define TELEMETRY_BUFFER_MAX_SAMPLES 60
+
+/**
+ * @brief One telemetry sample
+ */
+typedef struct {
+    int64_t captured_us;            /**< esp_timer timestamp when the sample was taken */
+    uint32_t present;               /**< Keys carried by the sample (1 << telemetry_key_t) */
+    int32_t values[TELEMETRY_KEY_COUNT]; /**< Fixed-point values indexed by telemetry_key_t */
+} telemetry_sample_t;
+
+/**
+ * @brief Telemetry buffer configuration
+ */
+typedef struct {
+    size_t capacity;                /**< Ring capacity in samples (<= TELEMETRY_BUFFER_MAX_SAMPLES) */
+    size_t batch_size;              /**< Flush once this many samples are pending */
+    uint32_t flush_interval_ms;     /**< Flush at least this often while samples are pending */
+} telemetry_buffer_config_t;
+
+/**
+ * @brief Default telemetry buffer configuration
+ */
+#define TELEMETRY_BUFFER_DEFAULT_CONFIG() { \
+    .capacity = TELEMETRY_BUFFER_MAX_SAMPLES, \
+    .batch_size = 10, \
+    .flush_interval_ms = 60000 \
+}
+
+/**
+ * @brief Upload statistics (used to quantify batching efficiency)
+ */
+typedef struct {
+    uint32_t samples_captured;      /**< Samples pushed into the ring */
+    uint32_t samples_published;     /**< Samples handed to the MQTT client */
+    uint32_t samples_dropped;       /**< Samples overwritten because the ring was full */
+    uint32_t samples_spilled;       /**< Samples moved to another sink (e.g. the flash store) */
+    uint32_t publishes;             /**< MQTT publish calls made for telemetry */
+    uint64_t payload_bytes;         /**< Total telemetry payload bytes published */
+} telemetry_buffer_stats_t;
+
+/**
+ * @brief Initialize the telemetry ring buffer
+ *
+ * @param config Buffer configuration
+ * @return esp_err_t ESP_OK on success
+ */
+esp_err_t telemetry_buffer_init(const telemetry_buffer_config_t* config);
+
+/**
+ * @brief Append a sample, overwriting the oldest one if the ring is full
+ *
+ * @param sample Sample to copy into the ring
+ * @return esp_err_t ESP_OK on success
+ */
+esp_err_t telemetry_buffer_push(const telemetry_sample_t* sample);
+
+/**
+ * @brief Number of samples waiting to be published
+ */
+size_t telemetry_buffer_count(void);
+
+/**
+ * @brief Check whether the batch size or flush interval has been reached
+ *
+ * @param now_us Current esp_timer time in microseconds
+ * @return true if pending samples should be flushed now
+ */
+bool telemetry_buffer_flush_due(int64_t now_us);
+
+/**
+ * @brief Copy up to max_samples of the oldest pending samples without removing them
+ *
+ * @param out Destination array
+ * @param max_samples Capacity of the destination array
+ * @return size_t Number of samples copied
+ */
+size_t telemetry_buffer_peek(telemetry_sample_t* out, size_t max_samples);
+
+/**
+ * @brief Remove samples after they were successfully published
+ *
+ * @param count Number of oldest samples to release
+ * @param payload_bytes Size of the payload that carried them (for statistics)
+ */
+void telemetry_buffer_consume(size_t count, size_t payload_bytes);
+
+/**
+ * @brief Remove samples that were handed to another sink instead of being published
+ *
+ * @param count Number of oldest samples to release
+ */
+void telemetry_buffer_spill(size_t count);
+
+/**
+ * @brief Get upload statistics
+ *
+ * @param stats Statistics (output)
+ */
+void telemetry_buffer_get_stats(telemetry_buffer_stats_t* stats);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,107 @@
+#include "telemetry_pb.h"
+#include <string.h>
+
+// Protobuf wire types
+#define PB_WT_VARINT    0
+#define PB_WT_LEN       2
+#define PB_WT_FIXED32   5
+
+// Telemetry message field numbers (proto/telemetry.proto)
+#define PB_FIELD_TS     1
+#define PB_FIELD_VALUES 2
+
+/**
+ * @brief Bounded output cursor; with buf == NULL it only counts bytes
+ */
+typedef struct {
+    uint8_t* buf;
+    size_t size;
+    size_t len;
+    bool overflow;
+} pb_writer_t;
+
+static void pb_put(pb_writer_t* w, const uint8_t* data, size_t n)
+{
+    if (w->buf) {
+        if (w->overflow || n > w->size - w->len) {
+            w->overflow = true;
+            return;
+        }
+        memcpy(w->buf + w->len, data, n);
+    }
+    w->len += n;
+}
+
+static void pb_put_varint(pb_writer_t* w, uint64_t value)
+{
+    uint8_t tmp[10];
+    size_t n = 0;
+    do {
+        tmp[n] = (uint8_t)(value & 0x7F);
+        value >>= 7;
+        if (value) {
+            tmp[n] |= 0x80;
+        }
+        n++;
+    } while (value);
+    pb_put(w, tmp, n);
+}
+
+static void pb_put_tag(pb_writer_t* w, uint32_t field, uint32_t wire_type)
+{
+    pb_put_varint(w, ((uint64_t)field << 3) | wire_type);
+}
+
+static void pb_put_fixed32(pb_writer_t* w, uint32_t value)
+{
+    // Protobuf fixed-width fields are little-endian
+    uint8_t tmp[4] = { (uint8_t)value, (uint8_t)(value >> 8), (uint8_t)(value >> 16), (uint8_t)(value >> 24) };
+    pb_put(w, tmp, sizeof(tmp));
+}
+
+static const float s_pow10[] = { 1.0f, 10.0f, 100.0f, 1000.0f, 10000.0f, 100000.0f };
+
+static void pb_put_values(pb_writer_t* w, const telemetry_sample_t* sample)
+{
+    for (int key = 0; key < TELEMETRY_KEY_COUNT; key++) {
+        if (!(sample->present & (1U << key))) {
+            continue;
+        }
+        const telemetry_field_t* field = &telemetry_schema[key];
+        int32_t value = sample->values[key];
+
+        if (field->type == TELEMETRY_TYPE_FIXED) {
+            uint8_t precision = field->precision < sizeof(s_pow10) / sizeof(s_pow10[0]) ? field->precision : 0;
+            float decoded = (float)value / s_pow10[precision];
+            uint32_t bits;
+            memcpy(&bits, &decoded, sizeof(bits));
+            pb_put_tag(w, field->pb_field, PB_WT_FIXED32);
+            pb_put_fixed32(w, bits);
+        } else {
+            // sint32: zigzag so small negative values (e.g. RSSI) stay short
+            uint32_t zigzag = ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+            pb_put_tag(w, field->pb_field, PB_WT_VARINT);
+            pb_put_varint(w, zigzag);
+        }
+    }
+}
+
+size_t telemetry_pb_encode(const telemetry_sample_t* sample, int64_t ts_ms, uint8_t* buf, size_t size)
+{
+    if (!sample || !buf) {
+        return 0;
+    }
+
+    // Sizing pass for the length prefix of the nested message
+    pb_writer_t sizer = {0};
+    pb_put_values(&sizer, sample);
+
+    pb_writer_t w = { .buf = buf, .size = size };
+    pb_put_tag(&w, PB_FIELD_TS, PB_WT_VARINT);
+    pb_put_varint(&w, (uint64_t)ts_ms);
+    pb_put_tag(&w, PB_FIELD_VALUES, PB_WT_LEN);
+    pb_put_varint(&w, sizer.len);
+    pb_put_values(&w, sample);
+
+    return w.overflow ? 0 : w.len;
+}
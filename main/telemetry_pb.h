@@ -0,0 +1,42 @@
+#pragma once
+
+#include "telemetry_buffer.h"
+#include "telemetry_schema.h"
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * @file telemetry_pb.h
+ * @brief Zero-heap protobuf encoder for telemetry samples
+ *
+ * Encodes the Telemetry message from proto/telemetry.proto, for ThingsBoard
+ * device profiles with the PROTOBUF transport payload type. The encoder is
+ * driven by the schema table: FIXED keys are encoded as float, INT keys as
+ * sint32, and keys whose bit is clear in telemetry_sample_t.present are left
+ * out. Like nanopb, the nested values message is sized in a first pass so
+ * that everything is written in place without allocation.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Worst-case encoded size of one sample (field numbers up to 15 use one-byte tags)
+ */
+#define TELEMETRY_PB_MAX_SIZE (1 + 10 + 1 + 2 + TELEMETRY_KEY_COUNT * 6)
+
+/**
+ * @brief Encode one sample as a Telemetry message: { ts, values { ... } }
+ *
+ * @param sample Sample to encode
+ * @param ts_ms Sample timestamp (Unix epoch in ms)
+ * @param buf Output buffer
+ * @param size Size of the output buffer
+ * @return size_t Encoded length, 0 if the buffer is too small
+ */
+size_t telemetry_pb_encode(const telemetry_sample_t* sample, int64_t ts_ms, uint8_t* buf, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,146 @@
+#include "telemetry_policy.h"
+#include "freertos/FreeRTOS.h"
+#include "esp_log.h"
+#include <string.h>
+
+static const char* TAG = "TELEMETRY_POLICY";
+
+#define DEFAULT_MAX_SILENCE_MS  60000   // Every key is refreshed at least once a minute
+
+/**
+ * @brief Default policies (fixed-point units of each key's signal)
+ */
+static const telemetry_key_policy_t s_default_policies[TELEMETRY_KEY_COUNT] = {
+    [TELEMETRY_KEY_TEMPERATURE]     = { .deadband = 20,        .max_silence_ms = DEFAULT_MAX_SILENCE_MS }, // 0.2 °C
+    [TELEMETRY_KEY_TEMPERATURE_MIN] = { .deadband = 20,        .max_silence_ms = DEFAULT_MAX_SILENCE_MS },
+    [TELEMETRY_KEY_TEMPERATURE_MAX] = { .deadband = 20,        .max_silence_ms = DEFAULT_MAX_SILENCE_MS },
+    [TELEMETRY_KEY_RSSI]            = { .deadband = 3,         .max_silence_ms = DEFAULT_MAX_SILENCE_MS }, // 3 dB
+    [TELEMETRY_KEY_HEAP]            = { .deadband = 4096,      .max_silence_ms = DEFAULT_MAX_SILENCE_MS }, // 4 KB
+    [TELEMETRY_KEY_UPTIME]          = { .deadband = INT32_MAX, .max_silence_ms = DEFAULT_MAX_SILENCE_MS }, // heartbeat only
+};
+
+/**
+ * @brief Last value sent per key
+ */
+typedef struct {
+    int32_t value;
+    int64_t sent_us;
+    bool valid;
+} key_state_t;
+
+// Policies may be changed from RPC/attribute handlers while the telemetry task applies them
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static telemetry_key_policy_t s_policies[TELEMETRY_KEY_COUNT];
+static key_state_t s_state[TELEMETRY_KEY_COUNT];
+static bool s_enabled = false;
+static telemetry_policy_stats_t s_stats = {0};
+
+esp_err_t telemetry_policy_init(bool enabled)
+{
+    portENTER_CRITICAL(&s_lock);
+    memcpy(s_policies, s_default_policies, sizeof(s_policies));
+    memset(s_state, 0, sizeof(s_state));
+    memset(&s_stats, 0, sizeof(s_stats));
+    s_enabled = enabled;
+    portEXIT_CRITICAL(&s_lock);
+
+    ESP_LOGI(TAG, "Report-by-exception %s", enabled ? "enabled" : "disabled");
+    return ESP_OK;
+}
+
+void telemetry_policy_set_enabled(bool enabled)
+{
+    portENTER_CRITICAL(&s_lock);
+    s_enabled = enabled;
+    portEXIT_CRITICAL(&s_lock);
+    ESP_LOGI(TAG, "Report-by-exception %s", enabled ? "enabled" : "disabled");
+}
+
+esp_err_t telemetry_policy_set(telemetry_key_t key, const telemetry_key_policy_t* policy)
+{
+    if (key >= TELEMETRY_KEY_COUNT || !policy || policy->deadband < 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    portENTER_CRITICAL(&s_lock);
+    s_policies[key] = *policy;
+    portEXIT_CRITICAL(&s_lock);
+
+    ESP_LOGI(TAG, "Policy for '%s': deadband %ld, max silence %lu ms", telemetry_schema[key].name,
+             (long)policy->deadband, (unsigned long)policy->max_silence_ms);
+    return ESP_OK;
+}
+
+esp_err_t telemetry_policy_get(telemetry_key_t key, telemetry_key_policy_t* policy)
+{
+    if (key >= TELEMETRY_KEY_COUNT || !policy) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    portENTER_CRITICAL(&s_lock);
+    *policy = s_policies[key];
+    portEXIT_CRITICAL(&s_lock);
+    return ESP_OK;
+}
+
+esp_err_t telemetry_policy_get_default(telemetry_key_t key, telemetry_key_policy_t* policy)
+{
+    if (key >= TELEMETRY_KEY_COUNT || !policy) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    *policy = s_default_policies[key];
+    return ESP_OK;
+}
+
+bool telemetry_policy_apply(telemetry_sample_t* sample)
+{
+    if (!sample) {
+        return false;
+    }
+
+    portENTER_CRITICAL(&s_lock);
+    for (int key = 0; key < TELEMETRY_KEY_COUNT; key++) {
+        uint32_t bit = 1U << key;
+        if (!(sample->present & bit)) {
+            continue;
+        }
+
+        const telemetry_key_policy_t* policy = &s_policies[key];
+        key_state_t* state = &s_state[key];
+        bool send = !s_enabled || !state->valid;
+        if (!send) {
+            int64_t delta = (int64_t)sample->values[key] - state->value;
+            if (delta < 0) {
+                delta = -delta;
+            }
+            send = delta > policy->deadband ||
+                   (policy->max_silence_ms > 0 &&
+                    sample->captured_us - state->sent_us >= (int64_t)policy->max_silence_ms * 1000);
+        }
+
+        if (send) {
+            state->value = sample->values[key];
+            state->sent_us = sample->captured_us;
+            state->valid = true;
+            s_stats.sent[key]++;
+            s_stats.sent_total++;
+        } else {
+            sample->present &= ~bit;
+            s_stats.suppressed[key]++;
+            s_stats.suppressed_total++;
+        }
+    }
+    portEXIT_CRITICAL(&s_lock);
+
+    return sample->present != 0;
+}
+
+void telemetry_policy_get_stats(telemetry_policy_stats_t* stats)
+{
+    if (!stats) {
+        return;
+    }
+    portENTER_CRITICAL(&s_lock);
+    *stats = s_stats;
+    portEXIT_CRITICAL(&s_lock);
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include "esp_err.h"
+#include "telemetry_schema.h"
+#include "telemetry_buffer.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * @file telemetry_policy.h
+ * @brief Report-by-exception policy with per-key deadbands and heartbeats
+ *
+ * A key is published only when its value moved beyond its deadband since the
+ * last value sent, or when it has been silent for longer than its maximum
+ * silence interval. Policies can be changed at runtime from any task.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Policy for one telemetry key
+ */
+typedef struct {
+    int32_t deadband;               /**< Fixed-point change that must be exceeded to send (0 = any change) */
+    uint32_t max_silence_ms;        /**< Heartbeat: send at least this often (0 = no heartbeat) */
+} telemetry_key_policy_t;
+
+/**
+ * @brief Per-key send/suppress counters
+ */
+typedef struct {
+    uint32_t sent[TELEMETRY_KEY_COUNT];       /**< Values published */
+    uint32_t suppressed[TELEMETRY_KEY_COUNT]; /**< Values withheld by the policy */
+    uint32_t sent_total;            /**< Sum of sent[] */
+    uint32_t suppressed_total;      /**< Sum of suppressed[] */
+} telemetry_policy_stats_t;
+
+/**
+ * @brief Load the default policies and enable or disable report-by-exception
+ *
+ * @param enabled Start with report-by-exception enabled
+ * @return esp_err_t ESP_OK on success
+ */
+esp_err_t telemetry_policy_init(bool enabled);
+
+/**
+ * @brief Enable or disable report-by-exception (disabled = send every key every window)
+ *
+ * @param enabled New state
+ */
+void telemetry_policy_set_enabled(bool enabled);
+
+/**
+ * @brief Change the policy for one key
+ *
+ * @param key Telemetry key
+ * @param policy New policy
+ * @return esp_err_t ESP_OK on success
+ */
+esp_err_t telemetry_policy_set(telemetry_key_t key, const telemetry_key_policy_t* policy);
+
+/**
+ * @brief Read the policy for one key
+ *
+ * @param key Telemetry key
+ * @param policy Current policy (output)
+ * @return esp_err_t ESP_OK on success
+ */
+esp_err_t telemetry_policy_get(telemetry_key_t key, telemetry_key_policy_t* policy);
+
+/**
+ * @brief Read the firmware default policy for one key
+ *
+ * @param key Telemetry key
+ * @param policy Default policy (output)
+ * @return esp_err_t ESP_OK on success
+ */
+esp_err_t telemetry_policy_get_default(telemetry_key_t key, telemetry_key_policy_t* policy);
+
+/**
+ * @brief Clear the presence bit of every key the policy suppresses
+ *
+ * @param sample Sample to filter in place
+ * @return true if at least one key is still present
+ */
+bool telemetry_policy_apply(telemetry_sample_t* sample);
+
+/**
+ * @brief Get send/suppress counters
+ *
+ * @param stats Statistics (output)
+ */
+void telemetry_policy_get_stats(telemetry_policy_stats_t* stats);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,247 @@
+#include "telemetry_scheduler.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+#include <stdlib.h>
+#include <string.h>
+
+static const char* TAG = "TELEMETRY_SCHED";
+
+typedef struct {
+    telemetry_job_config_t config;
+    int64_t period_us;
+    int64_t next_deadline_us;       /**< Always anchor + k * period_us */
+    int64_t last_deadline_us;       /**< Deadline of the last run, 0 before the first run */
+    telemetry_job_stats_t stats;
+} scheduler_job_t;
+
+struct telemetry_scheduler {
+    telemetry_scheduler_config_t config;
+    scheduler_job_t jobs[TELEMETRY_SCHEDULER_MAX_JOBS];
+    int job_count;
+    TaskHandle_t task;
+    esp_timer_handle_t wakeup_timer;
+    portMUX_TYPE lock;              // Deadlines and stats are read and realigned from other tasks
+};
+
+static void wakeup_timer_cb(void* arg)
+{
+    telemetry_scheduler_handle_t scheduler = (telemetry_scheduler_handle_t)arg;
+    xTaskNotifyGive(scheduler->task);
+}
+
+/**
+ * @brief Move a job to its first deadline after a run that ended at now_us
+ */
+static void advance_job(scheduler_job_t* job, int64_t now_us)
+{
+    job->next_deadline_us += job->period_us;
+    if (job->next_deadline_us <= now_us) {
+        // Late by at least a full period: skip to the next deadline in the future
+        int64_t skipped = (now_us - job->next_deadline_us) / job->period_us + 1;
+        job->next_deadline_us += skipped * job->period_us;
+        job->stats.overruns += (uint32_t)skipped;
+    }
+}
+
+static void scheduler_task(void* pvParameters)
+{
+    telemetry_scheduler_handle_t scheduler = (telemetry_scheduler_handle_t)pvParameters;
+
+    while (1) {
+        int64_t now_us = esp_timer_get_time();
+        scheduler_job_t* due = NULL;
+        int64_t deadline_us = INT64_MAX;
+
+        portENTER_CRITICAL(&scheduler->lock);
+        for (int i = 0; i < scheduler->job_count; i++) {
+            if (scheduler->jobs[i].next_deadline_us < deadline_us) {
+                deadline_us = scheduler->jobs[i].next_deadline_us;
+                due = &scheduler->jobs[i];
+            }
+        }
+        portEXIT_CRITICAL(&scheduler->lock);
+
+        if (due == NULL) {
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            continue;
+        }
+        if (deadline_us > now_us) {
+            // Tick-based delays would quantize deadlines to the tick period
+            esp_timer_stop(scheduler->wakeup_timer);
+            esp_timer_start_once(scheduler->wakeup_timer, deadline_us - now_us);
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            continue;
+        }
+
+        due->config.fn(due->config.arg, deadline_us);
+        int64_t end_us = esp_timer_get_time();
+
+        portENTER_CRITICAL(&scheduler->lock);
+        telemetry_job_stats_t* stats = &due->stats;
+        int64_t jitter_us = now_us - deadline_us;
+        int64_t duration_us = end_us - now_us;
+        stats->runs++;
+        stats->jitter_sum_us += jitter_us;
+        if (jitter_us > stats->jitter_max_us) {
+            stats->jitter_max_us = jitter_us;
+        }
+        if (duration_us > stats->duration_max_us) {
+            stats->duration_max_us = duration_us;
+        }
+        due->last_deadline_us = deadline_us;
+        // A realignment during the run already picked the next deadline
+        if (due->next_deadline_us == deadline_us) {
+            advance_job(due, end_us);
+        }
+        portEXIT_CRITICAL(&scheduler->lock);
+    }
+}
+
+esp_err_t telemetry_scheduler_create(const telemetry_scheduler_config_t* config,
+                                     telemetry_scheduler_handle_t* ret_handle)
+{
+    if (!config || !ret_handle) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    telemetry_scheduler_handle_t scheduler = calloc(1, sizeof(struct telemetry_scheduler));
+    if (!scheduler) {
+        return ESP_ERR_NO_MEM;
+    }
+    scheduler->config = *config;
+    portMUX_INITIALIZE(&scheduler->lock);
+
+    esp_timer_create_args_t timer_args = {
+        .callback = wakeup_timer_cb,
+        .arg = scheduler,
+        .name = config->task_name,
+    };
+    esp_err_t err = esp_timer_create(&timer_args, &scheduler->wakeup_timer);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to create wakeup timer: %s", esp_err_to_name(err));
+        free(scheduler);
+        return err;
+    }
+
+    *ret_handle = scheduler;
+    return ESP_OK;
+}
+
+esp_err_t telemetry_scheduler_add_job(telemetry_scheduler_handle_t scheduler, const telemetry_job_config_t* job,
+                                      int* ret_job_id)
+{
+    if (!scheduler || !job || !job->fn || job->period_ms == 0 || job->phase_ms >= job->period_ms) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (scheduler->task) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (scheduler->job_count >= TELEMETRY_SCHEDULER_MAX_JOBS) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    scheduler_job_t* entry = &scheduler->jobs[scheduler->job_count];
+    memset(entry, 0, sizeof(*entry));
+    entry->config = *job;
+    entry->period_us = (int64_t)job->period_ms * 1000;
+    if (ret_job_id) {
+        *ret_job_id = scheduler->job_count;
+    }
+    scheduler->job_count++;
+    return ESP_OK;
+}
+
+esp_err_t telemetry_scheduler_start(telemetry_scheduler_handle_t scheduler)
+{
+    if (!scheduler) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (scheduler->task) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    int64_t now_us = esp_timer_get_time();
+    for (int i = 0; i < scheduler->job_count; i++) {
+        scheduler->jobs[i].next_deadline_us = now_us + (int64_t)scheduler->jobs[i].config.phase_ms * 1000;
+    }
+
+    if (xTaskCreate(scheduler_task, scheduler->config.task_name, scheduler->config.stack_size, scheduler,
+                    scheduler->config.priority, &scheduler->task) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create %s task", scheduler->config.task_name);
+        return ESP_ERR_NO_MEM;
+    }
+
+    ESP_LOGI(TAG, "%s started with %d jobs", scheduler->config.task_name, scheduler->job_count);
+    return ESP_OK;
+}
+
+esp_err_t telemetry_scheduler_set_period(telemetry_scheduler_handle_t scheduler, int job_id, uint32_t period_ms)
+{
+    if (!scheduler || !scheduler->task || job_id < 0 || job_id >= scheduler->job_count) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    int64_t now_us = esp_timer_get_time();
+    portENTER_CRITICAL(&scheduler->lock);
+    scheduler_job_t* job = &scheduler->jobs[job_id];
+    if (period_ms == 0 || job->config.phase_ms >= period_ms) {
+        portEXIT_CRITICAL(&scheduler->lock);
+        return ESP_ERR_INVALID_ARG;
+    }
+    job->config.period_ms = period_ms;
+    job->period_us = (int64_t)period_ms * 1000;
+    int64_t base_us = job->last_deadline_us != 0 ? job->last_deadline_us : now_us;
+    job->next_deadline_us = base_us + job->period_us;
+    if (job->next_deadline_us <= now_us) {
+        job->next_deadline_us = now_us + job->period_us;
+    }
+    portEXIT_CRITICAL(&scheduler->lock);
+
+    xTaskNotifyGive(scheduler->task);
+    return ESP_OK;
+}
+
+esp_err_t telemetry_scheduler_align(telemetry_scheduler_handle_t scheduler, int64_t epoch_offset_us)
+{
+    if (!scheduler || !scheduler->task) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    int64_t now_us = esp_timer_get_time();
+    portENTER_CRITICAL(&scheduler->lock);
+    for (int i = 0; i < scheduler->job_count; i++) {
+        scheduler_job_t* job = &scheduler->jobs[i];
+        int64_t phase_us = (int64_t)job->config.phase_ms * 1000;
+
+        // First t > now with (t + epoch_offset) % period == phase
+        int64_t rem = (phase_us - epoch_offset_us - now_us) % job->period_us;
+        if (rem <= 0) {
+            rem += job->period_us;
+        }
+        int64_t deadline_us = now_us + rem;
+        // Never run twice within half a period when the correction is small
+        if (job->last_deadline_us != 0 && deadline_us - job->last_deadline_us < job->period_us / 2) {
+            deadline_us += job->period_us;
+        }
+        job->next_deadline_us = deadline_us;
+    }
+    portEXIT_CRITICAL(&scheduler->lock);
+
+    // Let the task re-arm its wakeup timer for the new deadlines
+    xTaskNotifyGive(scheduler->task);
+    return ESP_OK;
+}
+
+esp_err_t telemetry_scheduler_get_stats(telemetry_scheduler_handle_t scheduler, int job_id,
+                                        telemetry_job_stats_t* stats)
+{
+    if (!scheduler || !stats || job_id < 0 || job_id >= scheduler->job_count) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    portENTER_CRITICAL(&scheduler->lock);
+    *stats = scheduler->jobs[job_id].stats;
+    portEXIT_CRITICAL(&scheduler->lock);
+    return ESP_OK;
+}
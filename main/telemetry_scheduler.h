@@ -0,0 +1,153 @@
+#pragma once
+
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * @file telemetry_scheduler.h
+ * @brief Drift-free periodic job scheduler driven by esp_timer
+ *
+ * Each job runs at absolute deadlines anchor + k * period, so execution time
+ * and jitter never accumulate into the period. A scheduler owns one task
+ * that sleeps until the earliest deadline (woken by a one-shot esp_timer for
+ * microsecond resolution) and runs due jobs in deadline order. Jobs that
+ * block should get their own scheduler so they cannot delay faster jobs.
+ *
+ * Deadlines can be aligned to the wall clock, so that a 5 s job fires on
+ * :00, :05, :10, ... whenever SNTP has synced. Missed deadlines are skipped
+ * and counted as overruns rather than run back-to-back.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Maximum number of jobs per scheduler
+ */
+#define TELEMETRY_SCHEDULER_MAX_JOBS 8
+
+/**
+ * @brief Job callback
+ *
+ * @param arg User argument from the job configuration
+ * @param deadline_us Deadline this run was scheduled for (esp_timer time)
+ */
+typedef void (*telemetry_job_fn_t)(void* arg, int64_t deadline_us);
+
+/**
+ * @brief Periodic job definition
+ */
+typedef struct {
+    const char* name;               /**< Name used in logs */
+    uint32_t period_ms;             /**< Run period */
+    uint32_t phase_ms;              /**< Offset of the deadlines within the period (< period_ms) */
+    telemetry_job_fn_t fn;          /**< Job callback */
+    void* arg;                      /**< Argument passed to fn */
+} telemetry_job_config_t;
+
+/**
+ * @brief Timing statistics for one job
+ */
+typedef struct {
+    uint32_t runs;                  /**< Completed runs */
+    uint32_t overruns;              /**< Deadlines skipped because the job was late by a full period */
+    int64_t jitter_max_us;          /**< Worst start latency after the deadline */
+    int64_t jitter_sum_us;          /**< Sum of start latencies (divide by runs for the mean) */
+    int64_t duration_max_us;        /**< Longest run time */
+} telemetry_job_stats_t;
+
+/**
+ * @brief Scheduler task configuration
+ */
+typedef struct {
+    const char* task_name;          /**< FreeRTOS task name */
+    uint32_t stack_size;            /**< Task stack size in bytes */
+    UBaseType_t priority;           /**< Task priority */
+} telemetry_scheduler_config_t;
+
+/**
+ * @brief Default scheduler configuration
+ */
+#define TELEMETRY_SCHEDULER_DEFAULT_CONFIG() { \
+    .task_name = "scheduler", \
+    .stack_size = 4096, \
+    .priority = 5 \
+}
+
+/**
+ * @brief Scheduler handle
+ */
+typedef struct telemetry_scheduler* telemetry_scheduler_handle_t;
+
+/**
+ * @brief Create a scheduler (the task starts with telemetry_scheduler_start)
+ *
+ * @param config Scheduler configuration
+ * @param ret_handle Scheduler handle (output)
+ * @return esp_err_t ESP_OK on success
+ */
+esp_err_t telemetry_scheduler_create(const telemetry_scheduler_config_t* config,
+                                     telemetry_scheduler_handle_t* ret_handle);
+
+/**
+ * @brief Add a periodic job (only before telemetry_scheduler_start)
+ *
+ * @param scheduler Scheduler handle
+ * @param job Job definition
+ * @param ret_job_id Job identifier for telemetry_scheduler_get_stats (output, optional)
+ * @return esp_err_t ESP_OK on success, ESP_ERR_NO_MEM if the job table is full
+ */
+esp_err_t telemetry_scheduler_add_job(telemetry_scheduler_handle_t scheduler, const telemetry_job_config_t* job,
+                                      int* ret_job_id);
+
+/**
+ * @brief Start the scheduler task; the first deadlines are one phase after now
+ *
+ * @param scheduler Scheduler handle
+ * @return esp_err_t ESP_OK on success
+ */
+esp_err_t telemetry_scheduler_start(telemetry_scheduler_handle_t scheduler);
+
+/**
+ * @brief Change a job's period at runtime
+ *
+ * The next deadline becomes one new period after the job's last run (or after
+ * now if it has not run yet). Call telemetry_scheduler_align again afterwards
+ * to restore wall-clock alignment.
+ *
+ * @param scheduler Scheduler handle
+ * @param job_id Job identifier from telemetry_scheduler_add_job
+ * @param period_ms New period (must be greater than the job's phase)
+ * @return esp_err_t ESP_OK on success
+ */
+esp_err_t telemetry_scheduler_set_period(telemetry_scheduler_handle_t scheduler, int job_id, uint32_t period_ms);
+
+/**
+ * @brief Align all job deadlines to the wall clock
+ *
+ * After alignment a job's deadlines satisfy (epoch time) % period == phase.
+ * Call again after every clock correction to absorb oscillator drift.
+ *
+ * @param scheduler Scheduler handle
+ * @param epoch_offset_us Unix epoch time minus esp_timer time, in microseconds
+ * @return esp_err_t ESP_OK on success
+ */
+esp_err_t telemetry_scheduler_align(telemetry_scheduler_handle_t scheduler, int64_t epoch_offset_us);
+
+/**
+ * @brief Get timing statistics for one job
+ *
+ * @param scheduler Scheduler handle
+ * @param job_id Job identifier from telemetry_scheduler_add_job
+ * @param stats Statistics (output)
+ * @return esp_err_t ESP_OK on success
+ */
+esp_err_t telemetry_scheduler_get_stats(telemetry_scheduler_handle_t scheduler, int job_id,
+                                        telemetry_job_stats_t* stats);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,33 @@
+#include "telemetry_schema.h"
+
+// Per-signal type and precision as constants so key entries can inherit them
+enum {
+#define TELEMETRY_SIGNAL_ATTRS(id, signal_type, signal_precision) \
+    TELEMETRY_SIGNAL_TYPE_##id = signal_type, \
+    TELEMETRY_SIGNAL_PRECISION_##id = signal_precision,
+    TELEMETRY_SIGNALS(TELEMETRY_SIGNAL_ATTRS)
+#undef TELEMETRY_SIGNAL_ATTRS
+};
+
+const telemetry_signal_info_t telemetry_signals[TELEMETRY_SIGNAL_COUNT] = {
+#define TELEMETRY_SIGNAL_INFO(id, signal_type, signal_precision) \
+    [TELEMETRY_SIGNAL_##id] = { .type = signal_type, .precision = signal_precision },
+    TELEMETRY_SIGNALS(TELEMETRY_SIGNAL_INFO)
+#undef TELEMETRY_SIGNAL_INFO
+};
+
+const telemetry_field_t telemetry_schema[TELEMETRY_KEY_COUNT] = {
+#define TELEMETRY_SCHEMA_FIELD(id, key_name, source, agg, field_number) \
+    [TELEMETRY_KEY_##id] = { \
+        .name = key_name, \
+        .json_key = "\"" key_name "\":", \
+        .json_key_len = sizeof("\"" key_name "\":") - 1, \
+        .signal = TELEMETRY_SIGNAL_##source, \
+        .aggregate = TELEMETRY_AGG_##agg, \
+        .pb_field = field_number, \
+        .type = (telemetry_type_t)TELEMETRY_SIGNAL_TYPE_##source, \
+        .precision = TELEMETRY_SIGNAL_PRECISION_##source, \
+    },
+    TELEMETRY_SCHEMA(TELEMETRY_SCHEMA_FIELD)
+#undef TELEMETRY_SCHEMA_FIELD
+};
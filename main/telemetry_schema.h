@@ -0,0 +1,125 @@
+#pragma once
+
+#include <stdint.h>
+
+/**
+ * @file telemetry_schema.h
+ * @brief Compile-time telemetry schema (signals, key names, types, precision)
+ *
+ * Signals are the quantities the device samples. Keys are what gets published:
+ * each key is one aggregate (mean, min, max, ...) of one signal over an upload
+ * window. Both lists expand into enums and the tables that drive aggregation
+ * and serialization, so adding a key here is all that is needed to publish it.
+ *
+ * Values are carried as fixed-point integers: a signal with precision N stores
+ * value * 10^N (e.g. 25.61 °C with precision 2 is stored as 2561). Keys inherit
+ * type and precision from their signal.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Telemetry value types
+ */
+typedef enum {
+    TELEMETRY_TYPE_INT = 0,         /**< Integer value (precision must be 0) */
+    TELEMETRY_TYPE_FIXED,           /**< Decimal value with fixed precision */
+} telemetry_type_t;
+
+/**
+ * @brief Window aggregates a published key can report
+ */
+typedef enum {
+    TELEMETRY_AGG_MEAN = 0,         /**< Rounded mean of the window */
+    TELEMETRY_AGG_MIN,              /**< Minimum of the window */
+    TELEMETRY_AGG_MAX,              /**< Maximum of the window */
+    TELEMETRY_AGG_LAST,             /**< Most recent sample */
+    TELEMETRY_AGG_COUNT,            /**< Number of samples in the window */
+} telemetry_aggregate_t;
+
+/**
+ * @brief Sampled signals: X(id, type, precision)
+ */
+#define TELEMETRY_SIGNALS(X) \
+    X(TEMPERATURE, TELEMETRY_TYPE_FIXED, 2) \
+    X(RSSI,        TELEMETRY_TYPE_INT,   0) \
+    X(HEAP,        TELEMETRY_TYPE_INT,   0) \
+    X(UPTIME,      TELEMETRY_TYPE_INT,   0)
+
+/**
+ * @brief Published keys: X(id, key name, signal, aggregate, protobuf field number)
+ *
+ * Field numbers must match TelemetryValues in proto/telemetry.proto.
+ */
+#define TELEMETRY_SCHEMA(X) \
+    X(TEMPERATURE,     "temperature",     TEMPERATURE, MEAN, 1) \
+    X(TEMPERATURE_MIN, "temperature_min", TEMPERATURE, MIN,  2) \
+    X(TEMPERATURE_MAX, "temperature_max", TEMPERATURE, MAX,  3) \
+    X(RSSI,            "rssi",            RSSI,        MEAN, 4) \
+    X(HEAP,            "heap",            HEAP,        MIN,  5) \
+    X(UPTIME,          "uptime",          UPTIME,      LAST, 6)
+
+/**
+ * @brief Signal identifiers (index into the signal table)
+ */
+typedef enum {
+#define TELEMETRY_SIGNAL_ENUM(id, type, precision) TELEMETRY_SIGNAL_##id,
+    TELEMETRY_SIGNALS(TELEMETRY_SIGNAL_ENUM)
+#undef TELEMETRY_SIGNAL_ENUM
+    TELEMETRY_SIGNAL_COUNT
+} telemetry_signal_t;
+
+/**
+ * @brief Telemetry key identifiers (index into the schema table)
+ */
+typedef enum {
+#define TELEMETRY_SCHEMA_ENUM(id, name, signal, aggregate, field) TELEMETRY_KEY_##id,
+    TELEMETRY_SCHEMA(TELEMETRY_SCHEMA_ENUM)
+#undef TELEMETRY_SCHEMA_ENUM
+    TELEMETRY_KEY_COUNT
+} telemetry_key_t;
+
+/**
+ * @brief Bitmask with one bit per telemetry key (1 << telemetry_key_t)
+ */
+#define TELEMETRY_KEY_MASK_ALL ((uint32_t)((1ULL << TELEMETRY_KEY_COUNT) - 1))
+
+_Static_assert(TELEMETRY_KEY_COUNT <= 32, "telemetry key presence mask is 32 bits");
+
+/**
+ * @brief Signal table entry
+ */
+typedef struct {
+    telemetry_type_t type;          /**< Value type */
+    uint8_t precision;              /**< Decimal digits for TELEMETRY_TYPE_FIXED */
+} telemetry_signal_info_t;
+
+/**
+ * @brief Schema entry for one telemetry key
+ */
+typedef struct {
+    const char* name;               /**< ThingsBoard key name */
+    const char* json_key;           /**< Pre-rendered JSON key including quotes and colon */
+    uint8_t json_key_len;           /**< Length of json_key */
+    telemetry_signal_t signal;      /**< Signal the key is derived from */
+    telemetry_aggregate_t aggregate; /**< Aggregate reported for the window */
+    uint8_t pb_field;               /**< Protobuf field number in TelemetryValues */
+    telemetry_type_t type;          /**< Value type (from the signal) */
+    uint8_t precision;              /**< Decimal digits (from the signal) */
+} telemetry_field_t;
+
+/**
+ * @brief Signal table, indexed by telemetry_signal_t
+ */
+extern const telemetry_signal_info_t telemetry_signals[TELEMETRY_SIGNAL_COUNT];
+
+/**
+ * @brief Schema table, indexed by telemetry_key_t
+ */
+extern const telemetry_field_t telemetry_schema[TELEMETRY_KEY_COUNT];
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,198 @@
+#include "telemetry_serializer.h"
+#include <string.h>
+#include <math.h>
+
+// Powers of ten for fixed-point precision (precision is at most 9 for int32 values)
+static const int32_t s_pow10[] = {
+    1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000
+};
+
+/**
+ * @brief Bounded output cursor; once it overflows every further write is a no-op
+ */
+typedef struct {
+    char* pos;
+    char* end;
+    bool overflow;
+} json_writer_t;
+
+static void writer_put(json_writer_t* w, const char* data, size_t len)
+{
+    if (w->overflow || (size_t)(w->end - w->pos) < len) {
+        w->overflow = true;
+        return;
+    }
+    memcpy(w->pos, data, len);
+    w->pos += len;
+}
+
+static void writer_putc(json_writer_t* w, char c)
+{
+    writer_put(w, &c, 1);
+}
+
+static void writer_put_uint(json_writer_t* w, uint64_t value, int min_digits)
+{
+    char digits[20];
+    int n = 0;
+    do {
+        digits[n++] = (char)('0' + value % 10);
+        value /= 10;
+    } while (value != 0 || n < min_digits);
+
+    char out[20];
+    for (int i = 0; i < n; i++) {
+        out[i] = digits[n - 1 - i];
+    }
+    writer_put(w, out, n);
+}
+
+static void writer_put_int(json_writer_t* w, int64_t value)
+{
+    if (value < 0) {
+        writer_putc(w, '-');
+        writer_put_uint(w, (uint64_t)(-(value + 1)) + 1, 1);
+    } else {
+        writer_put_uint(w, (uint64_t)value, 1);
+    }
+}
+
+/**
+ * @brief Render a fixed-point value, dropping trailing fractional zeros (2560 @ 2 -> "25.6")
+ */
+static void writer_put_fixed(json_writer_t* w, int32_t value, uint8_t precision)
+{
+    if (precision == 0) {
+        writer_put_int(w, value);
+        return;
+    }
+
+    uint32_t magnitude = value < 0 ? (uint32_t)(-(int64_t)value) : (uint32_t)value;
+    uint32_t integral = magnitude / (uint32_t)s_pow10[precision];
+    uint32_t fraction = magnitude % (uint32_t)s_pow10[precision];
+
+    if (value < 0) {
+        writer_putc(w, '-');
+    }
+    writer_put_uint(w, integral, 1);
+    if (fraction == 0) {
+        return;
+    }
+
+    int digits = precision;
+    while (fraction % 10 == 0) {
+        fraction /= 10;
+        digits--;
+    }
+    writer_putc(w, '.');
+    writer_put_uint(w, fraction, digits);
+}
+
+static void writer_put_values(json_writer_t* w, const telemetry_sample_t* sample)
+{
+    bool first = true;
+    writer_putc(w, '{');
+    for (int key = 0; key < TELEMETRY_KEY_COUNT; key++) {
+        const telemetry_field_t* field = &telemetry_schema[key];
+        if (!(sample->present & (1U << key))) {
+            continue;
+        }
+        if (!first) {
+            writer_putc(w, ',');
+        }
+        first = false;
+        writer_put(w, field->json_key, field->json_key_len);
+        writer_put_fixed(w, sample->values[key], field->type == TELEMETRY_TYPE_FIXED ? field->precision : 0);
+    }
+    writer_putc(w, '}');
+}
+
+int32_t telemetry_to_fixed(telemetry_signal_t signal, float value)
+{
+    if (signal >= TELEMETRY_SIGNAL_COUNT) {
+        return 0;
+    }
+    const telemetry_signal_info_t* info = &telemetry_signals[signal];
+    if (info->type != TELEMETRY_TYPE_FIXED) {
+        return (int32_t)lroundf(value);
+    }
+    return (int32_t)lroundf(value * (float)s_pow10[info->precision]);
+}
+
+size_t telemetry_serialize_fixed(int32_t value, uint8_t precision, char* buf, size_t size)
+{
+    if (!buf || size == 0 || precision >= sizeof(s_pow10) / sizeof(s_pow10[0])) {
+        return 0;
+    }
+
+    json_writer_t w = { .pos = buf, .end = buf + size - 1, .overflow = false };
+    writer_put_fixed(&w, value, precision);
+    if (w.overflow) {
+        return 0;
+    }
+    *w.pos = '\0';
+    return (size_t)(w.pos - buf);
+}
+
+size_t telemetry_serialize_values(const telemetry_sample_t* sample, char* buf, size_t size)
+{
+    if (!sample || !buf || size == 0) {
+        return 0;
+    }
+
+    // Reserve one byte for the terminator
+    json_writer_t w = { .pos = buf, .end = buf + size - 1, .overflow = false };
+    writer_put_values(&w, sample);
+    if (w.overflow) {
+        return 0;
+    }
+    *w.pos = '\0';
+    return (size_t)(w.pos - buf);
+}
+
+size_t telemetry_serialize_batch(const telemetry_sample_t* samples, size_t count, int64_t epoch_offset_ms,
+                                 char* buf, size_t size, size_t* out_len)
+{
+    if (out_len) {
+        *out_len = 0;
+    }
+    if (!samples || !buf || size < 2 || count == 0) {
+        return 0;
+    }
+
+    // Reserve the closing bracket and the terminator
+    json_writer_t w = { .pos = buf, .end = buf + size - 2, .overflow = false };
+    writer_putc(&w, '[');
+
+    size_t serialized = 0;
+    for (size_t i = 0; i < count; i++) {
+        char* entry_start = w.pos;
+        if (i > 0) {
+            writer_putc(&w, ',');
+        }
+        writer_put(&w, "{\"ts\":", 6);
+        writer_put_int(&w, samples[i].captured_us / 1000 + epoch_offset_ms);
+        writer_put(&w, ",\"values\":", 10);
+        writer_put_values(&w, &samples[i]);
+        writer_putc(&w, '}');
+
+        if (w.overflow) {
+            // Roll back the partial entry and close the array with what fit
+            w.pos = entry_start;
+            w.overflow = false;
+            break;
+        }
+        serialized++;
+    }
+
+    if (serialized == 0) {
+        return 0;
+    }
+
+    *w.pos++ = ']';
+    *w.pos = '\0';
+    if (out_len) {
+        *out_len = (size_t)(w.pos - buf);
+    }
+    return serialized;
+}
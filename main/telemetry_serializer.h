@@ -0,0 +1,78 @@
+#pragma once
+
+#include "telemetry_buffer.h"
+#include "telemetry_schema.h"
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * @file telemetry_serializer.h
+ * @brief Zero-heap, schema-driven telemetry JSON serializer
+ *
+ * Writes compact ThingsBoard JSON straight into a caller-provided buffer.
+ * No malloc and no printf-style float formatting: values are fixed-point
+ * integers (see telemetry_schema.h) rendered with integer arithmetic only.
+ * Keys whose bit is clear in telemetry_sample_t.present are omitted.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Telemetry payload encodings
+ */
+typedef enum {
+    TELEMETRY_FORMAT_JSON = 0,      /**< ThingsBoard JSON (default) */
+    TELEMETRY_FORMAT_PROTOBUF,      /**< proto/telemetry.proto, see telemetry_pb.h */
+} telemetry_format_t;
+
+/**
+ * @brief Convert a floating-point reading to the fixed-point form of a signal
+ *
+ * @param signal Telemetry signal
+ * @param value Reading in natural units
+ * @return int32_t Value scaled by 10^precision and rounded
+ */
+int32_t telemetry_to_fixed(telemetry_signal_t signal, float value);
+
+/**
+ * @brief Render a fixed-point value as a JSON number (2560 @ precision 2 -> "25.6")
+ *
+ * @param value Fixed-point value
+ * @param precision Decimal digits (0-9)
+ * @param buf Output buffer
+ * @param size Size of the output buffer
+ * @return size_t Length written (without terminator), 0 if the buffer is too small
+ */
+size_t telemetry_serialize_fixed(int32_t value, uint8_t precision, char* buf, size_t size);
+
+/**
+ * @brief Serialize one sample as a flat values object: {"temperature":25.6,...}
+ *
+ * @param sample Sample to serialize
+ * @param buf Output buffer
+ * @param size Size of the output buffer
+ * @return size_t Payload length (without terminator), 0 if the buffer is too small
+ */
+size_t telemetry_serialize_values(const telemetry_sample_t* sample, char* buf, size_t size);
+
+/**
+ * @brief Serialize samples as a timestamped array: [{"ts":...,"values":{...}},...]
+ *
+ * Serializes as many samples as fit into the buffer, in order.
+ *
+ * @param samples Samples to serialize
+ * @param count Number of samples
+ * @param epoch_offset_ms Offset added to captured_us / 1000 to get the Unix epoch in ms
+ * @param buf Output buffer
+ * @param size Size of the output buffer
+ * @param out_len Payload length (output, without terminator)
+ * @return size_t Number of samples serialized (0 if not even one fits)
+ */
+size_t telemetry_serialize_batch(const telemetry_sample_t* samples, size_t count, int64_t epoch_offset_ms,
+                                 char* buf, size_t size, size_t* out_len);
+
+#ifdef __cplusplus
+}
+#endif
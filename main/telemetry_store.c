@@ -0,0 +1,520 @@
+#include "telemetry_store.h"
+#include "esp_log.h"
+#include "esp_partition.h"
+#include "esp_crc.h"
+#include <string.h>
+
+static const char* TAG = "TELEMETRY_STORE";
+
+// Flash layout
+#define STORE_SEGMENT_SIZE      4096            // One flash sector per segment
+#define STORE_SEGMENT_MAGIC     0x544C4D53      // "SMLT"
+#define STORE_RECORD_MAGIC      0x5452          // "RT"
+#define STORE_SEQ_FREE          0xFFFFFFFF      // Formatted segment not yet allocated
+#define STORE_RECORD_ERASED     0xFFFF          // Erased flash: end of written records
+#define STORE_ALIGN(x)          (((x) + 3) & ~3U)
+
+/**
+ * @brief Header at the start of every segment
+ *
+ * A formatted segment has seq == STORE_SEQ_FREE. Allocation only clears bits
+ * in the seq word, so it does not require another erase.
+ */
+typedef struct {
+    uint32_t magic;                 /**< STORE_SEGMENT_MAGIC */
+    uint32_t seq;                   /**< Allocation sequence number (oldest = lowest) */
+    uint32_t erase_count;           /**< Times this segment has been erased */
+    uint32_t reserved;
+} segment_header_t;
+
+/**
+ * @brief CRC frame preceding every record payload
+ */
+typedef struct {
+    uint16_t magic;                 /**< STORE_RECORD_MAGIC */
+    uint16_t len;                   /**< Payload length in bytes */
+    uint32_t crc;                   /**< CRC32 of the payload */
+} record_header_t;
+
+#define STORE_RECORD_SIZE       STORE_ALIGN(sizeof(record_header_t) + sizeof(telemetry_sample_t))
+
+typedef struct {
+    int seg;                        /**< Segment index, -1 if none */
+    uint32_t offset;                /**< Byte offset inside the segment */
+} store_cursor_t;
+
+typedef enum {
+    FRAME_END,                      /**< Erased flash: no more records in segment */
+    FRAME_VALID,                    /**< Record passed framing and CRC checks */
+    FRAME_CORRUPT,                  /**< Slot was written but does not hold a usable record */
+} frame_result_t;
+
+// Configuration and state (owned by the telemetry task, no locking required)
+static telemetry_store_config_t s_config = {0};
+static const esp_partition_t* s_partition = NULL;
+static bool s_initialized = false;
+static int s_segment_count = 0;
+
+static store_cursor_t s_read = { .seg = -1, .offset = 0 };
+static store_cursor_t s_write = { .seg = -1, .offset = 0 };
+static int s_last_allocated = -1;
+static uint32_t s_next_seq = 0;
+
+static telemetry_store_stats_t s_stats = {0};
+
+static inline uint32_t segment_address(int seg)
+{
+    return (uint32_t)seg * STORE_SEGMENT_SIZE;
+}
+
+static inline int next_segment(int seg)
+{
+    return (seg + 1) % s_segment_count;
+}
+
+static esp_err_t read_segment_header(int seg, segment_header_t* header)
+{
+    return esp_partition_read(s_partition, segment_address(seg), header, sizeof(*header));
+}
+
+/**
+ * @brief Erase a segment and write a free header carrying its erase count
+ */
+static esp_err_t format_segment(int seg)
+{
+    segment_header_t header;
+    uint32_t erase_count = 0;
+    if (read_segment_header(seg, &header) == ESP_OK && header.magic == STORE_SEGMENT_MAGIC) {
+        erase_count = header.erase_count;
+    }
+
+    esp_err_t err = esp_partition_erase_range(s_partition, segment_address(seg), STORE_SEGMENT_SIZE);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to erase segment %d: %s", seg, esp_err_to_name(err));
+        return err;
+    }
+    s_stats.flash_erases++;
+
+    header = (segment_header_t) {
+        .magic = STORE_SEGMENT_MAGIC,
+        .seq = STORE_SEQ_FREE,
+        .erase_count = erase_count + 1,
+        .reserved = 0xFFFFFFFF,
+    };
+    if (header.erase_count > s_stats.max_erase_count) {
+        s_stats.max_erase_count = header.erase_count;
+    }
+
+    err = esp_partition_write(s_partition, segment_address(seg), &header, sizeof(header));
+    s_stats.flash_writes++;
+    return err;
+}
+
+/**
+ * @brief Inspect the record frame at a cursor, optionally reading its payload
+ */
+static frame_result_t read_frame(const store_cursor_t* cursor, telemetry_sample_t* sample)
+{
+    if (cursor->offset + STORE_RECORD_SIZE > STORE_SEGMENT_SIZE) {
+        return FRAME_END;
+    }
+
+    record_header_t header;
+    if (esp_partition_read(s_partition, segment_address(cursor->seg) + cursor->offset,
+                           &header, sizeof(header)) != ESP_OK) {
+        return FRAME_END;
+    }
+    if (header.magic == STORE_RECORD_ERASED) {
+        return FRAME_END;
+    }
+    if (header.magic != STORE_RECORD_MAGIC || header.len != sizeof(telemetry_sample_t)) {
+        // Torn header or a record from an incompatible schema: skip the slot
+        return FRAME_CORRUPT;
+    }
+    if (!sample) {
+        return FRAME_VALID;
+    }
+
+    if (esp_partition_read(s_partition, segment_address(cursor->seg) + cursor->offset + sizeof(header),
+                           sample, sizeof(*sample)) != ESP_OK) {
+        return FRAME_CORRUPT;
+    }
+    if (esp_crc32_le(0, (const uint8_t*)sample, sizeof(*sample)) != header.crc) {
+        return FRAME_CORRUPT;
+    }
+    return FRAME_VALID;
+}
+
+/**
+ * @brief Count written record slots from a cursor to the end of its segment
+ */
+static uint32_t count_segment_records(store_cursor_t cursor)
+{
+    uint32_t count = 0;
+    while (read_frame(&cursor, NULL) != FRAME_END) {
+        count++;
+        cursor.offset += STORE_RECORD_SIZE;
+    }
+    return count;
+}
+
+/**
+ * @brief Release all records and return to an empty log
+ *
+ * The write segment is formatted too, so a reboot does not replay records
+ * that were already drained.
+ */
+static void reset_to_empty(void)
+{
+    if (s_write.seg >= 0) {
+        format_segment(s_write.seg);
+    }
+    s_read.seg = -1;
+    s_write.seg = -1;
+    s_stats.records_pending = 0;
+}
+
+/**
+ * @brief Allocate the next segment in rotation for writing, dropping the oldest data if full
+ */
+static esp_err_t allocate_segment(void)
+{
+    int seg = next_segment(s_last_allocated < 0 ? s_segment_count - 1 : s_last_allocated);
+
+    if (seg == s_read.seg) {
+        // Log is full: drop the oldest segment
+        uint32_t dropped = count_segment_records(s_read);
+        s_stats.records_dropped += dropped;
+        s_stats.records_pending -= dropped < s_stats.records_pending ? dropped : s_stats.records_pending;
+        ESP_LOGW(TAG, "Store full, dropped %lu oldest records", (unsigned long)dropped);
+
+        s_read.seg = next_segment(seg);
+        s_read.offset = sizeof(segment_header_t);
+    }
+
+    segment_header_t header;
+    esp_err_t err = read_segment_header(seg, &header);
+    if (err != ESP_OK || header.magic != STORE_SEGMENT_MAGIC || header.seq != STORE_SEQ_FREE) {
+        err = format_segment(seg);
+        if (err != ESP_OK) {
+            return err;
+        }
+    }
+
+    // Claim the segment by programming the seq word of the free header
+    uint32_t seq = s_next_seq++;
+    err = esp_partition_write(s_partition, segment_address(seg) + offsetof(segment_header_t, seq),
+                              &seq, sizeof(seq));
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to allocate segment %d: %s", seg, esp_err_to_name(err));
+        return err;
+    }
+    s_stats.flash_writes++;
+
+    s_last_allocated = seg;
+    s_write.seg = seg;
+    s_write.offset = sizeof(segment_header_t);
+    if (s_read.seg < 0) {
+        s_read = s_write;
+    }
+    return ESP_OK;
+}
+
+/**
+ * @brief Walk valid records from a cursor
+ *
+ * Copies up to max records into out (if not NULL) and leaves the cursor after
+ * the last record returned. When erase_drained is set, segments the cursor
+ * leaves are formatted, which is how drained data is released.
+ */
+static size_t walk_records(store_cursor_t* cursor, telemetry_sample_t* out, size_t max, bool erase_drained)
+{
+    size_t n = 0;
+    telemetry_sample_t sample;
+
+    while (n < max && cursor->seg >= 0) {
+        bool at_write_position = (cursor->seg == s_write.seg && cursor->offset >= s_write.offset);
+        frame_result_t frame = at_write_position ? FRAME_END : read_frame(cursor, &sample);
+
+        if (frame == FRAME_END) {
+            if (cursor->seg == s_write.seg || s_write.seg < 0) {
+                break;
+            }
+            int drained = cursor->seg;
+            cursor->seg = next_segment(cursor->seg);
+            cursor->offset = sizeof(segment_header_t);
+            if (erase_drained) {
+                format_segment(drained);
+            }
+            continue;
+        }
+
+        cursor->offset += STORE_RECORD_SIZE;
+        if (frame == FRAME_CORRUPT) {
+            if (erase_drained) {
+                s_stats.records_corrupt++;
+                s_stats.records_pending--;
+            }
+            continue;
+        }
+
+        if (out) {
+            out[n] = sample;
+        }
+        n++;
+    }
+    return n;
+}
+
+esp_err_t telemetry_store_init(const telemetry_store_config_t* config)
+{
+    if (s_initialized) {
+        ESP_LOGW(TAG, "Telemetry store already initialized");
+        return ESP_OK;
+    }
+
+    if (!config || !config->partition_label) {
+        ESP_LOGE(TAG, "Invalid configuration");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    s_partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY,
+                                           config->partition_label);
+    if (!s_partition) {
+        ESP_LOGW(TAG, "Partition '%s' not found, store-and-forward disabled", config->partition_label);
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    s_config = *config;
+    s_segment_count = s_partition->size / STORE_SEGMENT_SIZE;
+    if (s_segment_count < 2) {
+        ESP_LOGE(TAG, "Partition too small (%lu bytes)", (unsigned long)s_partition->size);
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    // Recover the oldest and newest allocated segments
+    uint32_t oldest_seq = STORE_SEQ_FREE;
+    uint32_t newest_seq = 0;
+    int oldest = -1;
+    int newest = -1;
+    for (int seg = 0; seg < s_segment_count; seg++) {
+        segment_header_t header;
+        if (read_segment_header(seg, &header) != ESP_OK || header.magic != STORE_SEGMENT_MAGIC) {
+            continue;
+        }
+        if (header.erase_count > s_stats.max_erase_count) {
+            s_stats.max_erase_count = header.erase_count;
+        }
+        if (header.seq == STORE_SEQ_FREE) {
+            continue;
+        }
+        if (header.seq < oldest_seq) {
+            oldest_seq = header.seq;
+            oldest = seg;
+        }
+        if (newest < 0 || header.seq > newest_seq) {
+            newest_seq = header.seq;
+            newest = seg;
+        }
+        store_cursor_t start = { .seg = seg, .offset = sizeof(segment_header_t) };
+        s_stats.records_pending += count_segment_records(start);
+    }
+
+    if (newest >= 0) {
+        s_next_seq = newest_seq + 1;
+        s_last_allocated = newest;
+        s_read.seg = oldest;
+        s_read.offset = sizeof(segment_header_t);
+        s_write.seg = newest;
+        s_write.offset = sizeof(segment_header_t);
+        s_write.offset += count_segment_records(s_write) * STORE_RECORD_SIZE;
+    }
+
+    s_initialized = true;
+
+    ESP_LOGI(TAG, "Telemetry store mounted (%d segments, %lu records pending, drain: %lu rec/s)",
+             s_segment_count, (unsigned long)s_stats.records_pending, (unsigned long)s_config.drain_rate);
+    return ESP_OK;
+}
+
+esp_err_t telemetry_store_append(const telemetry_sample_t* sample)
+{
+    if (!s_initialized) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (!sample) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (s_write.seg < 0 || s_write.offset + STORE_RECORD_SIZE > STORE_SEGMENT_SIZE) {
+        esp_err_t err = allocate_segment();
+        if (err != ESP_OK) {
+            return err;
+        }
+    }
+
+    // Frame and payload go out in a single flash write
+    uint32_t record[STORE_RECORD_SIZE / sizeof(uint32_t)];
+    memset(record, 0xFF, sizeof(record));
+    record_header_t header = {
+        .magic = STORE_RECORD_MAGIC,
+        .len = sizeof(*sample),
+        .crc = esp_crc32_le(0, (const uint8_t*)sample, sizeof(*sample)),
+    };
+    memcpy(record, &header, sizeof(header));
+    memcpy((uint8_t*)record + sizeof(header), sample, sizeof(*sample));
+
+    esp_err_t err = esp_partition_write(s_partition, segment_address(s_write.seg) + s_write.offset,
+                                        record, sizeof(record));
+    s_stats.flash_writes++;
+    // Advance even on failure: a partially programmed slot must not be rewritten
+    s_write.offset += STORE_RECORD_SIZE;
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to append record: %s", esp_err_to_name(err));
+        return err;
+    }
+
+    s_stats.records_written++;
+    s_stats.records_pending++;
+    return ESP_OK;
+}
+
+size_t telemetry_store_peek(size_t skip, telemetry_sample_t* out, size_t max_samples)
+{
+    if (!s_initialized || !out || s_stats.records_pending <= skip) {
+        return 0;
+    }
+    store_cursor_t cursor = s_read;
+    if (walk_records(&cursor, NULL, skip, false) < skip) {
+        return 0;
+    }
+    return walk_records(&cursor, out, max_samples, false);
+}
+
+void telemetry_store_consume(size_t count)
+{
+    if (!s_initialized || count == 0) {
+        return;
+    }
+
+    size_t consumed = walk_records(&s_read, NULL, count, true);
+    s_stats.records_drained += consumed;
+    s_stats.records_pending -= consumed < s_stats.records_pending ? consumed : s_stats.records_pending;
+
+    if (s_stats.records_pending == 0) {
+        reset_to_empty();
+    }
+}
+
+uint32_t telemetry_store_pending(void)
+{
+    return s_initialized ? s_stats.records_pending : 0;
+}
+
+uint32_t telemetry_store_drain_rate(void)
+{
+    return s_config.drain_rate;
+}
+
+void telemetry_store_get_stats(telemetry_store_stats_t* stats)
+{
+    if (stats) {
+        *stats = s_stats;
+    }
+}
+
+static telemetry_store_chunk_t* drain_slot(telemetry_store_drain_t* drain, size_t index)
+{
+    return &drain->chunks[(drain->head + index) % TELEMETRY_STORE_MAX_IN_FLIGHT];
+}
+
+/**
+ * @brief Committed publishes plus the reserved one, whose callbacks may run before its commit
+ */
+static size_t drain_slots_in_use(const telemetry_store_drain_t* drain)
+{
+    return drain->count < TELEMETRY_STORE_MAX_IN_FLIGHT ? drain->count + 1 : TELEMETRY_STORE_MAX_IN_FLIGHT;
+}
+
+void telemetry_store_drain_reset(telemetry_store_drain_t* drain)
+{
+    // Sequence numbers keep counting so late callbacks of forgotten publishes match nothing
+    uint32_t next_seq = drain->next_seq;
+    memset(drain, 0, sizeof(*drain));
+    drain->next_seq = next_seq;
+}
+
+uint32_t telemetry_store_drain_reserve(telemetry_store_drain_t* drain)
+{
+    if (drain->count == TELEMETRY_STORE_MAX_IN_FLIGHT) {
+        return 0;
+    }
+    telemetry_store_chunk_t* chunk = drain_slot(drain, drain->count);
+    memset(chunk, 0, sizeof(*chunk));
+    if (++drain->next_seq == 0) {
+        drain->next_seq = 1;
+    }
+    chunk->seq = drain->next_seq;
+    return chunk->seq;
+}
+
+void telemetry_store_drain_commit(telemetry_store_drain_t* drain, uint16_t records, bool acked)
+{
+    if (drain->count == TELEMETRY_STORE_MAX_IN_FLIGHT) {
+        return;
+    }
+    telemetry_store_chunk_t* chunk = drain_slot(drain, drain->count);
+    chunk->records = records;
+    chunk->acked = chunk->acked || acked;
+    drain->count++;
+    drain->records += records;
+}
+
+void telemetry_store_drain_sent(telemetry_store_drain_t* drain, uint32_t seq, int msg_id)
+{
+    if (seq == 0) {
+        return;
+    }
+    for (size_t i = 0; i < drain_slots_in_use(drain); i++) {
+        telemetry_store_chunk_t* chunk = drain_slot(drain, i);
+        if (chunk->seq == seq) {
+            chunk->msg_id = msg_id > 0 ? msg_id : -1;
+            return;
+        }
+    }
+}
+
+bool telemetry_store_drain_ack(telemetry_store_drain_t* drain, int msg_id)
+{
+    if (msg_id <= 0) {
+        return false;
+    }
+    for (size_t i = 0; i < drain_slots_in_use(drain); i++) {
+        telemetry_store_chunk_t* chunk = drain_slot(drain, i);
+        if (chunk->msg_id == msg_id) {
+            chunk->acked = true;
+            return true;
+        }
+    }
+    return false;
+}
+
+size_t telemetry_store_drain_take_acked(telemetry_store_drain_t* drain)
+{
+    size_t records = 0;
+    while (drain->count > 0) {
+        telemetry_store_chunk_t* chunk = drain_slot(drain, 0);
+        if (!chunk->acked) {
+            if (chunk->msg_id < 0) {
+                // Never reached the broker: send it and everything after it again
+                telemetry_store_drain_reset(drain);
+            }
+            break;
+        }
+        records += chunk->records;
+        drain->records -= chunk->records;
+        drain->head = (drain->head + 1) % TELEMETRY_STORE_MAX_IN_FLIGHT;
+        drain->count--;
+    }
+    return records;
+}
@@ -0,0 +1,197 @@
+#pragma once
+
+#include "esp_err.h"
+#include "telemetry_buffer.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * @file telemetry_store.h
+ * @brief Flash-backed store-and-forward log for telemetry during MQTT outages
+ *
+ * Samples that cannot be published are appended to a dedicated data
+ * partition organised as a ring of 4 KB segments. Each record is CRC-framed
+ * so torn writes are detected after a power loss, and segments are reused in
+ * strict rotation so erase cycles are spread evenly across the partition.
+ *
+ * Stored samples carry the Unix epoch in microseconds in captured_us (0 when
+ * the wall clock was not synced at capture time), so they remain meaningful
+ * across reboots.
+ *
+ * Replay is ordered and gap-free. Records are consumed only once the broker
+ * acknowledged them (telemetry_store_drain_t), and a segment is erased only
+ * after all of its records were consumed. A reboot mid-drain can re-send
+ * records from the current segment, which ThingsBoard treats idempotently
+ * (same ts, same key).
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Store configuration
+ */
+typedef struct {
+    const char* partition_label;    /**< Data partition holding the log */
+    uint32_t drain_rate;            /**< Records per second replayed while online */
+} telemetry_store_config_t;
+
+/**
+ * @brief Default store configuration
+ */
+#define TELEMETRY_STORE_DEFAULT_CONFIG() { \
+    .partition_label = "tlm_store", \
+    .drain_rate = 20 \
+}
+
+/**
+ * @brief Store statistics
+ */
+typedef struct {
+    uint32_t records_written;       /**< Records appended */
+    uint32_t records_drained;       /**< Records consumed after replay */
+    uint32_t records_dropped;       /**< Records lost because the log wrapped */
+    uint32_t records_corrupt;       /**< Records skipped due to CRC/format errors */
+    uint32_t records_pending;       /**< Records waiting to be drained */
+    uint32_t flash_writes;          /**< Flash write operations */
+    uint32_t flash_erases;          /**< Segment erase operations */
+    uint32_t max_erase_count;       /**< Highest per-segment erase count seen */
+} telemetry_store_stats_t;
+
+/**
+ * @brief Mount the store, recovering the read and write positions from flash
+ *
+ * @param config Store configuration
+ * @return esp_err_t ESP_OK on success, ESP_ERR_NOT_FOUND if the partition is missing
+ */
+esp_err_t telemetry_store_init(const telemetry_store_config_t* config);
+
+/**
+ * @brief Append a sample to the log (captured_us must hold epoch microseconds)
+ *
+ * When the log is full the oldest segment is dropped.
+ *
+ * @param sample Sample to append
+ * @return esp_err_t ESP_OK on success
+ */
+esp_err_t telemetry_store_append(const telemetry_sample_t* sample);
+
+/**
+ * @brief Read up to max_samples of the oldest records without consuming them
+ *
+ * @param skip Leading records to pass over (those already in flight)
+ * @param out Destination array
+ * @param max_samples Capacity of the destination array
+ * @return size_t Number of samples read
+ */
+size_t telemetry_store_peek(size_t skip, telemetry_sample_t* out, size_t max_samples);
+
+/**
+ * @brief Consume the oldest records once the broker acknowledged them
+ *
+ * @param count Number of records to release
+ */
+void telemetry_store_consume(size_t count);
+
+/**
+ * @brief Number of records waiting to be drained
+ */
+uint32_t telemetry_store_pending(void);
+
+/**
+ * @brief Configured drain rate in records per second
+ */
+uint32_t telemetry_store_drain_rate(void);
+
+/**
+ * @brief Get store statistics
+ *
+ * @param stats Statistics (output)
+ */
+void telemetry_store_get_stats(telemetry_store_stats_t* stats);
+
+#define TELEMETRY_STORE_MAX_IN_FLIGHT   16      /**< Drain publishes awaiting their PUBACK */
+
+/**
+ * @brief One drain publish
+ */
+typedef struct {
+    uint32_t seq;                   /**< Publish sequence number, the publish context (never 0) */
+    int msg_id;                     /**< MQTT message id, 0 while queued, -1 if the publish was dropped */
+    uint16_t records;               /**< Records carried by the publish */
+    bool acked;                     /**< PUBACK received (or nothing to acknowledge) */
+} telemetry_store_chunk_t;
+
+/**
+ * @brief Drain publishes in flight, oldest records first
+ *
+ * Records leave the store only when every publish before them was
+ * acknowledged, so a reboot or a power loss with publishes still in the
+ * outbound queue or the esp-mqtt outbox never loses them. Plain data: the
+ * caller serializes access when message ids and PUBACKs are recorded from
+ * other tasks, and consumes the released records from the task that owns
+ * the store.
+ */
+typedef struct {
+    telemetry_store_chunk_t chunks[TELEMETRY_STORE_MAX_IN_FLIGHT]; /**< Ring of committed publishes */
+    size_t head;                    /**< Oldest committed publish */
+    size_t count;                   /**< Committed publishes */
+    uint32_t records;               /**< Records in flight (peek skips them) */
+    uint32_t next_seq;
+} telemetry_store_drain_t;
+
+/**
+ * @brief Forget the publishes in flight; their records are peeked and sent again
+ */
+void telemetry_store_drain_reset(telemetry_store_drain_t* drain);
+
+/**
+ * @brief Clear the slot for the next publish and return its sequence number
+ *
+ * The sequence number is passed to the publish as its context, so the
+ * message id can be recorded as soon as the publish goes out. Reserving
+ * again without a commit reuses the slot.
+ *
+ * @return Sequence number, 0 when every slot is in flight
+ */
+uint32_t telemetry_store_drain_reserve(telemetry_store_drain_t* drain);
+
+/**
+ * @brief Commit the reserved slot once its publish was queued
+ *
+ * @param drain Drain tracking
+ * @param records Records carried by the publish
+ * @param acked true if there is nothing to acknowledge (unserializable records)
+ */
+void telemetry_store_drain_commit(telemetry_store_drain_t* drain, uint16_t records, bool acked);
+
+/**
+ * @brief Record the message id of a publish (its outbound done callback)
+ *
+ * Unknown sequence numbers (publishes from before a reset) are ignored.
+ */
+void telemetry_store_drain_sent(telemetry_store_drain_t* drain, uint32_t seq, int msg_id);
+
+/**
+ * @brief Record a PUBACK
+ *
+ * @return true if msg_id belongs to a drain publish in flight
+ */
+bool telemetry_store_drain_ack(telemetry_store_drain_t* drain, int msg_id);
+
+/**
+ * @brief Release the records of the leading acknowledged publishes
+ *
+ * Counting stops at the first publish without a PUBACK, so later
+ * acknowledged publishes are sent again rather than leaving a gap. A
+ * leading publish that was dropped resets the tracking.
+ *
+ * @return Records to pass to telemetry_store_consume()
+ */
+size_t telemetry_store_drain_take_acked(telemetry_store_drain_t* drain);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,316 @@
+#include "tls_session.h"
+#include "esp_tls.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "mbedtls/ssl.h"
+#include "mbedtls/sha256.h"
+#include <stdlib.h>
+#include <string.h>
+#include <sys/select.h>
+
+static const char* TAG = "TLS_SESSION";
+
+#define MQTTS_DEFAULT_PORT 8883
+#define SESSION_DIGEST_LEN 32
+
+/**
+ * @brief Per-transport connection state
+ */
+typedef struct {
+    tls_session_config_t config;
+    esp_tls_t* tls;
+} tls_transport_t;
+
+// The cached session is taken by the MQTT task on connect and may be cleared from any task
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static esp_tls_client_session_t* s_session = NULL;
+static uint8_t s_session_digest[SESSION_DIGEST_LEN];   // Master secret digest of s_session
+static tls_session_stats_t s_stats = {0};
+
+/**
+ * @brief Digest of the connection's TLS 1.2 master secret
+ *
+ * A resumed handshake reuses the master secret of the session it resumed,
+ * whether it was offered by session ID or by ticket; a full handshake derives
+ * a new one. Only the SHA-256 is kept, so no second copy of the secret stays
+ * in RAM.
+ *
+ * @return false if the connection did not negotiate TLS 1.2
+ */
+static bool session_digest(esp_tls_t* tls, uint8_t digest[SESSION_DIGEST_LEN])
+{
+    mbedtls_ssl_context* ssl = esp_tls_get_ssl_context(tls);
+    if (!ssl || mbedtls_ssl_get_version_number(ssl) != MBEDTLS_SSL_VERSION_TLS1_2) {
+        return false;
+    }
+    // mbedtls_ssl_get_session() exports a TLS 1.2 session only once, and esp-tls does that for the cache
+    const mbedtls_ssl_session* session = ssl->MBEDTLS_PRIVATE(session);
+    if (!session) {
+        return false;
+    }
+    mbedtls_sha256(session->MBEDTLS_PRIVATE(master), sizeof(session->MBEDTLS_PRIVATE(master)), digest, 0);
+    return true;
+}
+
+/**
+ * @brief Take ownership of the cached session (NULL if none) and copy its digest
+ */
+static esp_tls_client_session_t* session_take(uint8_t digest[SESSION_DIGEST_LEN])
+{
+    portENTER_CRITICAL(&s_lock);
+    esp_tls_client_session_t* session = s_session;
+    s_session = NULL;
+    if (digest) {
+        memcpy(digest, s_session_digest, SESSION_DIGEST_LEN);
+    }
+    portEXIT_CRITICAL(&s_lock);
+    return session;
+}
+
+/**
+ * @brief Cache the connection's session for the next connect
+ */
+static void session_store(esp_tls_t* tls)
+{
+    uint8_t digest[SESSION_DIGEST_LEN] = {0};
+    // Without a TLS 1.2 master secret a resumption could not be recognized, so nothing is offered
+    esp_tls_client_session_t* session = session_digest(tls, digest) ? esp_tls_get_client_session(tls) : NULL;
+
+    portENTER_CRITICAL(&s_lock);
+    esp_tls_client_session_t* old = s_session;
+    s_session = session;
+    memcpy(s_session_digest, digest, SESSION_DIGEST_LEN);
+    portEXIT_CRITICAL(&s_lock);
+
+    if (old) {
+        esp_tls_free_client_session(old);
+    }
+}
+
+static void record_handshake(tls_handshake_stats_t* stats, uint32_t elapsed_ms)
+{
+    portENTER_CRITICAL(&s_lock);
+    stats->count++;
+    stats->last_ms = elapsed_ms;
+    stats->sum_ms += elapsed_ms;
+    if (elapsed_ms > stats->max_ms) {
+        stats->max_ms = elapsed_ms;
+    }
+    portEXIT_CRITICAL(&s_lock);
+}
+
+/**
+ * @brief Wait for the socket to become readable or writable
+ *
+ * @return 1 if ready, 0 on timeout, -1 on error
+ */
+static int socket_poll(esp_tls_t* tls, int timeout_ms, bool write)
+{
+    int fd;
+    if (!tls || esp_tls_get_conn_sockfd(tls, &fd) != ESP_OK || fd < 0) {
+        return -1;
+    }
+
+    fd_set ready;
+    fd_set errors;
+    FD_ZERO(&ready);
+    FD_ZERO(&errors);
+    FD_SET(fd, &ready);
+    FD_SET(fd, &errors);
+    struct timeval timeout = {
+        .tv_sec = timeout_ms / 1000,
+        .tv_usec = (timeout_ms % 1000) * 1000,
+    };
+    int ret = select(fd + 1, write ? NULL : &ready, write ? &ready : NULL, &errors, timeout_ms < 0 ? NULL : &timeout);
+    if (ret > 0 && FD_ISSET(fd, &errors)) {
+        return -1;
+    }
+    return ret > 0 ? 1 : ret;
+}
+
+static int tls_connect(esp_transport_handle_t t, const char* host, int port, int timeout_ms)
+{
+    tls_transport_t* ctx = esp_transport_get_context_data(t);
+    if (ctx->tls) {
+        esp_tls_conn_destroy(ctx->tls);
+        ctx->tls = NULL;
+    }
+
+    ctx->tls = esp_tls_init();
+    if (!ctx->tls) {
+        return -1;
+    }
+
+    // A session that fails to resume is not offered again
+    uint8_t offered_digest[SESSION_DIGEST_LEN];
+    esp_tls_client_session_t* offered = session_take(offered_digest);
+    esp_tls_cfg_t cfg = {
+        .timeout_ms = timeout_ms,
+        .skip_common_name = ctx->config.skip_common_name,
+        .client_session = offered,
+    };
+    if (ctx->config.ca_attach) {
+        cfg.crt_bundle_attach = ctx->config.ca_attach;
+    } else {
+        cfg.cacert_buf = (const unsigned char*)ctx->config.ca_pem;
+        cfg.cacert_bytes = strlen(ctx->config.ca_pem) + 1;
+    }
+
+    // Connect to the cached address; SNI and the certificate check still use the broker name
+    char addr[16];
+    const char* connect_host = host;
+    if (ctx->config.resolve && ctx->config.resolve(host, addr, sizeof(addr))) {
+        cfg.common_name = host;
+        connect_host = addr;
+    }
+
+    int64_t start_us = esp_timer_get_time();
+    int ret = esp_tls_conn_new_sync(connect_host, strlen(connect_host), port, &cfg, ctx->tls);
+    uint32_t elapsed_ms = (uint32_t)((esp_timer_get_time() - start_us) / 1000);
+    // esp-tls copies the session into the connection
+    if (offered) {
+        esp_tls_free_client_session(offered);
+    }
+
+    if (ret != 1) {
+        esp_tls_conn_destroy(ctx->tls);
+        ctx->tls = NULL;
+        portENTER_CRITICAL(&s_lock);
+        s_stats.failures++;
+        portEXIT_CRITICAL(&s_lock);
+        ESP_LOGW(TAG, "TLS connect to %s:%d failed after %lu ms", connect_host, port, (unsigned long)elapsed_ms);
+        // The cached address may be stale; the next attempt resolves the name again
+        if (connect_host != host && ctx->config.resolve_failed) {
+            ctx->config.resolve_failed(host);
+        }
+        return -1;
+    }
+
+    // The broker decides: an offered session it did not accept still costs a full handshake
+    uint8_t digest[SESSION_DIGEST_LEN];
+    bool resumed = offered && session_digest(ctx->tls, digest) &&
+                   memcmp(digest, offered_digest, SESSION_DIGEST_LEN) == 0;
+    if (offered && !resumed) {
+        portENTER_CRITICAL(&s_lock);
+        s_stats.refused++;
+        portEXIT_CRITICAL(&s_lock);
+    }
+    record_handshake(resumed ? &s_stats.resumed : &s_stats.full, elapsed_ms);
+    session_store(ctx->tls);
+    ESP_LOGI(TAG, "TLS connect to %s:%d in %lu ms (%s%s)", host, port, (unsigned long)elapsed_ms,
+             resumed ? "session resumed" : offered ? "session refused, full handshake" : "full handshake",
+             connect_host != host ? ", cached address" : "");
+    return 0;
+}
+
+static int tls_poll_read(esp_transport_handle_t t, int timeout_ms)
+{
+    tls_transport_t* ctx = esp_transport_get_context_data(t);
+    // Records already decrypted by mbedTLS are not visible on the socket
+    if (ctx->tls && esp_tls_get_bytes_avail(ctx->tls) > 0) {
+        return 1;
+    }
+    return socket_poll(ctx->tls, timeout_ms, false);
+}
+
+static int tls_poll_write(esp_transport_handle_t t, int timeout_ms)
+{
+    tls_transport_t* ctx = esp_transport_get_context_data(t);
+    return socket_poll(ctx->tls, timeout_ms, true);
+}
+
+static int tls_read(esp_transport_handle_t t, char* buffer, int len, int timeout_ms)
+{
+    tls_transport_t* ctx = esp_transport_get_context_data(t);
+    int poll = tls_poll_read(t, timeout_ms);
+    if (poll <= 0) {
+        return poll < 0 ? -1 : ERR_TCP_TRANSPORT_CONNECTION_TIMEOUT;
+    }
+
+    ssize_t ret = esp_tls_conn_read(ctx->tls, buffer, len);
+    if (ret == ESP_TLS_ERR_SSL_WANT_READ || ret == ESP_TLS_ERR_SSL_WANT_WRITE) {
+        return ERR_TCP_TRANSPORT_CONNECTION_TIMEOUT;
+    }
+    if (ret == 0) {
+        return ERR_TCP_TRANSPORT_CONNECTION_CLOSED_BY_FIN;
+    }
+    return ret < 0 ? -1 : (int)ret;
+}
+
+static int tls_write(esp_transport_handle_t t, const char* buffer, int len, int timeout_ms)
+{
+    tls_transport_t* ctx = esp_transport_get_context_data(t);
+    int poll = tls_poll_write(t, timeout_ms);
+    if (poll <= 0) {
+        return poll < 0 ? -1 : ERR_TCP_TRANSPORT_CONNECTION_TIMEOUT;
+    }
+
+    ssize_t ret = esp_tls_conn_write(ctx->tls, buffer, len);
+    if (ret == ESP_TLS_ERR_SSL_WANT_READ || ret == ESP_TLS_ERR_SSL_WANT_WRITE) {
+        return ERR_TCP_TRANSPORT_CONNECTION_TIMEOUT;
+    }
+    return ret < 0 ? -1 : (int)ret;
+}
+
+static int tls_close(esp_transport_handle_t t)
+{
+    tls_transport_t* ctx = esp_transport_get_context_data(t);
+    if (ctx->tls) {
+        esp_tls_conn_destroy(ctx->tls);
+        ctx->tls = NULL;
+    }
+    return 0;
+}
+
+static int tls_destroy(esp_transport_handle_t t)
+{
+    tls_close(t);
+    free(esp_transport_get_context_data(t));
+    return 0;
+}
+
+esp_err_t tls_session_transport_create(const tls_session_config_t* config, esp_transport_handle_t* ret_transport)
+{
+    if (!config || (!config->ca_pem && !config->ca_attach) || !ret_transport) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    tls_transport_t* ctx = calloc(1, sizeof(tls_transport_t));
+    if (!ctx) {
+        return ESP_ERR_NO_MEM;
+    }
+    ctx->config = *config;
+
+    esp_transport_handle_t transport = esp_transport_init();
+    if (!transport) {
+        free(ctx);
+        return ESP_ERR_NO_MEM;
+    }
+    esp_transport_set_context_data(transport, ctx);
+    esp_transport_set_func(transport, tls_connect, tls_read, tls_write, tls_close, tls_poll_read, tls_poll_write,
+                           tls_destroy);
+    esp_transport_set_default_port(transport, MQTTS_DEFAULT_PORT);
+
+    *ret_transport = transport;
+    return ESP_OK;
+}
+
+void tls_session_clear(void)
+{
+    esp_tls_client_session_t* session = session_take(NULL);
+    if (session) {
+        esp_tls_free_client_session(session);
+        ESP_LOGI(TAG, "Cached TLS session cleared");
+    }
+}
+
+void tls_session_get_stats(tls_session_stats_t* stats)
+{
+    if (!stats) {
+        return;
+    }
+    portENTER_CRITICAL(&s_lock);
+    *stats = s_stats;
+    portEXIT_CRITICAL(&s_lock);
+}
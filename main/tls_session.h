@@ -0,0 +1,93 @@
+#pragma once
+
+#include "esp_err.h"
+#include "esp_transport.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * @file tls_session.h
+ * @brief MQTTS transport with TLS session resumption
+ *
+ * esp-mqtt's built-in SSL transport starts every connection with a full
+ * handshake. This transport wraps esp-tls instead and keeps the client
+ * session (session ID and, if the broker issues one, the session ticket) of
+ * the last successful handshake in RAM. The next connection offers it, so a
+ * broker that accepts it skips certificate verification and the key
+ * exchange, which saves most of the handshake time and CPU on both ends.
+ *
+ * The session cache is module-wide, so it survives MQTT client re-creation.
+ * Every connect is timed, split into full and resumed handshakes. Whether the
+ * broker resumed is read from the new session: a resumed TLS 1.2 handshake
+ * keeps the master secret of the offered session, a full one derives a new
+ * one. An offered session the broker refused counts as a full handshake (and
+ * in refused). Only TLS 1.2 sessions are cached and offered.
+ *
+ * Requires CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Transport configuration (buffers must stay valid for the transport's lifetime)
+ */
+typedef struct {
+    const char* ca_pem;             /**< CA certificate (PEM, NUL-terminated), parsed on every connect */
+    esp_err_t (*ca_attach)(void* ssl_conf); /**< Installs a pre-parsed CA chain instead of ca_pem (needs CONFIG_MBEDTLS_CERTIFICATE_BUNDLE) */
+    bool skip_common_name;          /**< Skip the server certificate common name check */
+    bool (*resolve)(const char* host, char* addr, size_t size); /**< Optional cached address of host; connects to it skip DNS */
+    void (*resolve_failed)(const char* host); /**< Optional, called when connecting to the cached address failed */
+} tls_session_config_t;
+
+/**
+ * @brief Handshake timing for one handshake kind
+ */
+typedef struct {
+    uint32_t count;                 /**< Successful connects */
+    uint32_t last_ms;               /**< Most recent connect time */
+    uint32_t max_ms;                /**< Longest connect time */
+    uint64_t sum_ms;                /**< Sum of connect times (divide by count for the mean) */
+} tls_handshake_stats_t;
+
+/**
+ * @brief Session resumption statistics
+ *
+ * Times cover DNS lookup (skipped when a cached address is used), TCP connect
+ * and the TLS handshake.
+ */
+typedef struct {
+    tls_handshake_stats_t full;     /**< Connects with a full handshake, refused resumptions included */
+    tls_handshake_stats_t resumed;  /**< Connects the broker resumed from the cached session */
+    uint32_t refused;               /**< Connects that offered a session the broker did not resume */
+    uint32_t failures;              /**< Failed connects */
+} tls_session_stats_t;
+
+/**
+ * @brief Create a transport for esp_mqtt_client_config_t.network.transport
+ *
+ * The MQTT client takes ownership and destroys the transport with itself.
+ *
+ * @param config Transport configuration
+ * @param ret_transport Transport handle (output)
+ * @return esp_err_t ESP_OK on success
+ */
+esp_err_t tls_session_transport_create(const tls_session_config_t* config, esp_transport_handle_t* ret_transport);
+
+/**
+ * @brief Drop the cached session, e.g. after the trusted CA changed
+ */
+void tls_session_clear(void);
+
+/**
+ * @brief Get handshake statistics
+ *
+ * @param stats Statistics (output)
+ */
+void tls_session_get_stats(tls_session_stats_t* stats);
+
+#ifdef __cplusplus
+}
+#endif
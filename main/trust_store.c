@@ -0,0 +1,698 @@
+#include "trust_store.h"
+#include "esp_log.h"
+#include "esp_crc.h"
+#include "esp_partition.h"
+#include "freertos/FreeRTOS.h"
+#include "pem_decoder.h"
+#include "mbedtls/sha256.h"
+#include <stddef.h>
+#include <string.h>
+
+static const char* TAG = "TRUST_STORE";
+
+#define ANCHOR_MAGIC            0x54525354      // "TSRT"
+#define ANCHOR_LIVE             0xFFFFFFFF      // Erased value of the live word
+#define ANCHOR_NONE             0xFF
+#define UPLOAD_FLUSH_SIZE       64              // DER bytes buffered per flash write
+
+/**
+ * @brief Header at the start of every anchor sector, followed by the DER certificate
+ *
+ * Removal clears the live word in place, so it does not require an erase.
+ */
+typedef struct {
+    uint32_t magic;                 /**< ANCHOR_MAGIC */
+    uint32_t der_len;               /**< DER bytes following the header */
+    uint32_t der_crc;               /**< CRC32 of the DER bytes */
+    uint8_t fingerprint[TRUST_STORE_FINGERPRINT_SIZE]; /**< SHA-256 of the DER bytes */
+    uint32_t header_crc;            /**< CRC32 of the fields above */
+    uint32_t live;                  /**< ANCHOR_LIVE until removed, then 0 */
+} anchor_header_t;
+
+/**
+ * @brief Lookup keys of one sector
+ */
+typedef struct {
+    bool live;
+    uint32_t subject_hash;          /**< CRC32 of the raw subject name */
+    uint8_t key_id_len;             /**< 0 if the certificate has no usable subject key identifier */
+    uint8_t key_id[TRUST_STORE_KEY_ID_MAX];
+} anchor_entry_t;
+
+/**
+ * @brief Streaming add state; each certificate of the PEM is decoded straight into a free sector
+ *
+ * A decoded certificate gets its header without the magic word, which stays
+ * erased until trust_store_add_finish() writes it, so a bundle is committed
+ * as a whole and a reboot mid-upload leaves only free sectors behind.
+ */
+typedef struct {
+    bool active;
+    size_t pem_len;                 /**< Announced PEM length */
+    size_t received;                /**< PEM bytes received */
+    pem_decoder_t pem;
+    uint8_t sector;                 /**< Sector of the certificate being decoded, ANCHOR_NONE between certificates */
+    uint32_t staged;                /**< Sectors holding a decoded certificate, committed by finish */
+    uint16_t cert_count;            /**< Certificates decoded, duplicates included */
+    uint8_t pending[UPLOAD_FLUSH_SIZE];
+    size_t pending_len;
+    uint32_t der_len;               /**< DER bytes written to the sector */
+} anchor_upload_t;
+
+static const esp_partition_t* s_partition = NULL;
+static esp_partition_mmap_handle_t s_mmap_handle;
+static const uint8_t* s_mapped = NULL;
+static size_t s_sector_size = 0;
+static size_t s_sector_count = 0;
+static bool s_initialized = false;
+
+// Sectors removed this boot; chains built before the removal may still point into them
+static uint32_t s_removed_sectors = 0;
+
+// Index, rebuilt by add and remove (called from one task) and read from any task
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static anchor_entry_t s_entries[TRUST_STORE_MAX_ANCHORS];
+static uint8_t s_by_subject[TRUST_STORE_MAX_ANCHORS];      // Live sectors sorted by subject_hash
+static uint8_t s_by_key_id[TRUST_STORE_MAX_ANCHORS];       // Live sectors with a key ID, sorted by it
+static size_t s_count = 0;
+static size_t s_key_id_count = 0;
+static uint32_t s_generation = 0;
+
+static anchor_upload_t s_upload;
+
+static const anchor_header_t* sector_header(size_t sector)
+{
+    return (const anchor_header_t*)(s_mapped + sector * s_sector_size);
+}
+
+static const uint8_t* sector_der(size_t sector)
+{
+    return s_mapped + sector * s_sector_size + sizeof(anchor_header_t);
+}
+
+static bool sector_header_valid(const anchor_header_t* header)
+{
+    return header->magic == ANCHOR_MAGIC &&
+           header->header_crc == esp_crc32_le(0, (const uint8_t*)header, offsetof(anchor_header_t, header_crc)) &&
+           header->der_len > 0 && header->der_len <= s_sector_size - sizeof(anchor_header_t);
+}
+
+static int compare_key_id(const anchor_entry_t* entry, const uint8_t* key_id, size_t len)
+{
+    if (entry->key_id_len != len) {
+        return entry->key_id_len < len ? -1 : 1;
+    }
+    return memcmp(entry->key_id, key_id, len);
+}
+
+/**
+ * @brief Fill in the lookup keys of a parsed certificate
+ */
+static void fill_entry(const mbedtls_x509_crt* crt, anchor_entry_t* entry)
+{
+    entry->live = true;
+    entry->subject_hash = esp_crc32_le(0, crt->subject_raw.p, crt->subject_raw.len);
+    entry->key_id_len = 0;
+    if (crt->subject_key_id.len > 0 && crt->subject_key_id.len <= TRUST_STORE_KEY_ID_MAX) {
+        entry->key_id_len = (uint8_t)crt->subject_key_id.len;
+        memcpy(entry->key_id, crt->subject_key_id.p, crt->subject_key_id.len);
+    }
+}
+
+/**
+ * @brief Rebuild the sorted lookup arrays from the sector entries and publish them
+ */
+static void rebuild_index(void)
+{
+    uint8_t by_subject[TRUST_STORE_MAX_ANCHORS];
+    uint8_t by_key_id[TRUST_STORE_MAX_ANCHORS];
+    size_t count = 0;
+    size_t key_id_count = 0;
+
+    // Insertion sort, there are at most TRUST_STORE_MAX_ANCHORS entries
+    for (size_t sector = 0; sector < s_sector_count; sector++) {
+        const anchor_entry_t* entry = &s_entries[sector];
+        if (!entry->live) {
+            continue;
+        }
+        size_t i = count++;
+        while (i > 0 && s_entries[by_subject[i - 1]].subject_hash > entry->subject_hash) {
+            by_subject[i] = by_subject[i - 1];
+            i--;
+        }
+        by_subject[i] = (uint8_t)sector;
+
+        if (entry->key_id_len > 0) {
+            i = key_id_count++;
+            while (i > 0 && compare_key_id(&s_entries[by_key_id[i - 1]], entry->key_id, entry->key_id_len) > 0) {
+                by_key_id[i] = by_key_id[i - 1];
+                i--;
+            }
+            by_key_id[i] = (uint8_t)sector;
+        }
+    }
+
+    portENTER_CRITICAL(&s_lock);
+    memcpy(s_by_subject, by_subject, count);
+    memcpy(s_by_key_id, by_key_id, key_id_count);
+    s_count = count;
+    s_key_id_count = key_id_count;
+    s_generation++;
+    portEXIT_CRITICAL(&s_lock);
+}
+
+/**
+ * @brief Look up a subject key identifier (called with s_lock held)
+ */
+static uint8_t find_by_key_id(const uint8_t* key_id, size_t len)
+{
+    size_t lo = 0;
+    size_t hi = s_key_id_count;
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        int cmp = compare_key_id(&s_entries[s_by_key_id[mid]], key_id, len);
+        if (cmp == 0) {
+            return s_by_key_id[mid];
+        }
+        if (cmp < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return ANCHOR_NONE;
+}
+
+/**
+ * @brief Position in s_by_subject of the first entry not below subject_hash (called with s_lock held)
+ */
+static size_t subject_lower_bound(uint32_t subject_hash)
+{
+    size_t lo = 0;
+    size_t hi = s_count;
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        if (s_entries[s_by_subject[mid]].subject_hash < subject_hash) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+/**
+ * @brief Look up a subject name hash (called with s_lock held)
+ */
+static uint8_t find_by_subject(uint32_t subject_hash)
+{
+    size_t i = subject_lower_bound(subject_hash);
+    return i < s_count && s_entries[s_by_subject[i]].subject_hash == subject_hash ? s_by_subject[i] : ANCHOR_NONE;
+}
+
+/**
+ * @brief Find the live sector holding a certificate, ANCHOR_NONE if none
+ */
+static uint8_t find_by_fingerprint(const uint8_t* fingerprint)
+{
+    for (size_t sector = 0; sector < s_sector_count; sector++) {
+        if (s_entries[sector].live &&
+            memcmp(sector_header(sector)->fingerprint, fingerprint, TRUST_STORE_FINGERPRINT_SIZE) == 0) {
+            return (uint8_t)sector;
+        }
+    }
+    return ANCHOR_NONE;
+}
+
+/**
+ * @brief Pick a sector for a new anchor
+ *
+ * Erased sectors come first. Sectors removed this boot are not reused, since
+ * a CA chain built before the removal may still reference them.
+ */
+static uint8_t find_free_sector(void)
+{
+    uint8_t reusable = ANCHOR_NONE;
+    for (size_t sector = 0; sector < s_sector_count; sector++) {
+        if (s_entries[sector].live || ((s_removed_sectors | s_upload.staged) & (1U << sector))) {
+            continue;
+        }
+        if (sector_header(sector)->magic == 0xFFFFFFFF) {
+            return (uint8_t)sector;
+        }
+        if (reusable == ANCHOR_NONE) {
+            reusable = (uint8_t)sector;
+        }
+    }
+    return reusable;
+}
+
+/**
+ * @brief Write the buffered DER bytes of the upload to its sector
+ */
+static esp_err_t upload_flush(void)
+{
+    anchor_upload_t* u = &s_upload;
+    if (u->pending_len == 0) {
+        return ESP_OK;
+    }
+    if (u->der_len + u->pending_len > s_sector_size - sizeof(anchor_header_t)) {
+        ESP_LOGE(TAG, "Certificate exceeds a sector (%u bytes)", (unsigned)(s_sector_size - sizeof(anchor_header_t)));
+        return ESP_ERR_INVALID_SIZE;
+    }
+    esp_err_t err = esp_partition_write(s_partition, u->sector * s_sector_size + sizeof(anchor_header_t) + u->der_len,
+                                        u->pending, u->pending_len);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to write anchor to sector %u: %s", (unsigned)u->sector, esp_err_to_name(err));
+        return err;
+    }
+    u->der_len += u->pending_len;
+    u->pending_len = 0;
+    return ESP_OK;
+}
+
+/**
+ * @brief Start decoding a certificate into a free sector
+ */
+static esp_err_t upload_cert_begin(void)
+{
+    anchor_upload_t* u = &s_upload;
+    uint8_t sector = find_free_sector();
+    if (sector == ANCHOR_NONE) {
+        ESP_LOGE(TAG, "Trust store full (%u anchors)", (unsigned)s_sector_count);
+        return ESP_ERR_NO_MEM;
+    }
+    esp_err_t err = esp_partition_erase_range(s_partition, sector * s_sector_size, s_sector_size);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to erase sector %u: %s", (unsigned)sector, esp_err_to_name(err));
+        return err;
+    }
+    u->sector = sector;
+    u->der_len = 0;
+    return ESP_OK;
+}
+
+/**
+ * @brief Check the certificate just decoded and stage it, or drop it if already stored
+ */
+static esp_err_t upload_cert_end(void)
+{
+    anchor_upload_t* u = &s_upload;
+    esp_err_t err = upload_flush();
+    if (err != ESP_OK) {
+        return err;
+    }
+    uint8_t sector = u->sector;
+    u->sector = ANCHOR_NONE;
+    u->cert_count++;
+
+    // Parsed in place; the decoded block must be exactly one certificate
+    mbedtls_x509_crt crt;
+    mbedtls_x509_crt_init(&crt);
+    int ret = u->der_len > 0 ? mbedtls_x509_crt_parse_der_nocopy(&crt, sector_der(sector), u->der_len) : -1;
+    bool usable = ret == 0 && crt.raw.len == u->der_len &&
+                  mbedtls_x509_crt_check_key_usage(&crt, MBEDTLS_X509_KU_KEY_CERT_SIGN) == 0;
+    mbedtls_x509_crt_free(&crt);
+    if (!usable) {
+        ESP_LOGE(TAG, "Certificate %u is not a usable CA certificate (-0x%04x)", u->cert_count, ret < 0 ? -ret : 0);
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    anchor_header_t header = {
+        .magic = ANCHOR_MAGIC,
+        .der_len = u->der_len,
+        .der_crc = esp_crc32_le(0, sector_der(sector), u->der_len),
+        .live = ANCHOR_LIVE,
+    };
+    mbedtls_sha256(sector_der(sector), u->der_len, header.fingerprint, 0);
+    if (find_by_fingerprint(header.fingerprint) != ANCHOR_NONE) {
+        return ESP_OK;
+    }
+    for (size_t staged = 0; staged < s_sector_count; staged++) {
+        if ((u->staged & (1U << staged)) &&
+            memcmp(sector_header(staged)->fingerprint, header.fingerprint, TRUST_STORE_FINGERPRINT_SIZE) == 0) {
+            return ESP_OK;
+        }
+    }
+
+    // Everything but the magic word, which is the commit point
+    header.header_crc = esp_crc32_le(0, (const uint8_t*)&header, offsetof(anchor_header_t, header_crc));
+    err = esp_partition_write(s_partition, sector * s_sector_size + sizeof(header.magic),
+                              (const uint8_t*)&header + sizeof(header.magic), sizeof(header) - sizeof(header.magic));
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to write anchor header to sector %u: %s", (unsigned)sector, esp_err_to_name(err));
+        return err;
+    }
+    u->staged |= 1U << sector;
+    return ESP_OK;
+}
+
+/**
+ * @brief Feed one PEM character of the upload to the decoder
+ */
+static esp_err_t upload_decode(char c)
+{
+    anchor_upload_t* u = &s_upload;
+    uint8_t byte;
+    switch (pem_decoder_feed(&u->pem, c, &byte)) {
+    case PEM_DECODER_BYTE:
+        u->pending[u->pending_len++] = byte;
+        return u->pending_len == sizeof(u->pending) ? upload_flush() : ESP_OK;
+    case PEM_DECODER_BEGIN:
+        return upload_cert_begin();
+    case PEM_DECODER_END:
+        return upload_cert_end();
+    case PEM_DECODER_ERROR:
+        return ESP_ERR_INVALID_ARG;
+    default:
+        return ESP_OK;
+    }
+}
+
+esp_err_t trust_store_init(const trust_store_config_t* config)
+{
+    if (s_initialized) {
+        ESP_LOGW(TAG, "Trust store already initialized");
+        return ESP_OK;
+    }
+
+    if (!config || !config->partition_label) {
+        ESP_LOGE(TAG, "Invalid configuration");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    s_partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY,
+                                           config->partition_label);
+    if (!s_partition) {
+        ESP_LOGE(TAG, "Partition '%s' not found", config->partition_label);
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    s_sector_size = s_partition->erase_size;
+    s_sector_count = s_partition->size / s_sector_size;
+    if (s_sector_count > TRUST_STORE_MAX_ANCHORS) {
+        s_sector_count = TRUST_STORE_MAX_ANCHORS;
+    }
+
+    const void* mapped = NULL;
+    esp_err_t err = esp_partition_mmap(s_partition, 0, s_sector_count * s_sector_size, ESP_PARTITION_MMAP_DATA,
+                                       &mapped, &s_mmap_handle);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to map partition '%s': %s", config->partition_label, esp_err_to_name(err));
+        return err;
+    }
+    s_mapped = mapped;
+
+    // Index the live anchors; the DER checksum is verified once here
+    memset(s_entries, 0, sizeof(s_entries));
+    s_removed_sectors = 0;
+    for (size_t sector = 0; sector < s_sector_count; sector++) {
+        const anchor_header_t* header = sector_header(sector);
+        if (!sector_header_valid(header) || header->live != ANCHOR_LIVE) {
+            continue;
+        }
+        if (esp_crc32_le(0, sector_der(sector), header->der_len) != header->der_crc) {
+            ESP_LOGW(TAG, "Anchor in sector %u failed the integrity check", (unsigned)sector);
+            continue;
+        }
+
+        mbedtls_x509_crt crt;
+        mbedtls_x509_crt_init(&crt);
+        int ret = mbedtls_x509_crt_parse_der_nocopy(&crt, sector_der(sector), header->der_len);
+        if (ret == 0) {
+            fill_entry(&crt, &s_entries[sector]);
+        } else {
+            ESP_LOGW(TAG, "Anchor in sector %u could not be parsed: -0x%04x", (unsigned)sector, -ret);
+        }
+        mbedtls_x509_crt_free(&crt);
+    }
+    rebuild_index();
+    s_initialized = true;
+
+    ESP_LOGI(TAG, "Trust store initialized: %u of %u anchors in use ('%s')", (unsigned)s_count,
+             (unsigned)s_sector_count, config->partition_label);
+    return ESP_OK;
+}
+
+esp_err_t trust_store_add_begin(size_t pem_len)
+{
+    if (!s_initialized) {
+        ESP_LOGE(TAG, "Trust store not initialized");
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    if (pem_len == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    trust_store_add_abort();
+    memset(&s_upload, 0, sizeof(s_upload));
+    s_upload.active = true;
+    s_upload.pem_len = pem_len;
+    s_upload.sector = ANCHOR_NONE;
+    pem_decoder_init(&s_upload.pem);
+    return ESP_OK;
+}
+
+esp_err_t trust_store_add_write(const char* data, size_t len)
+{
+    if (!s_upload.active) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    if (!data) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    esp_err_t err = ESP_OK;
+    if (s_upload.received + len > s_upload.pem_len) {
+        ESP_LOGE(TAG, "PEM exceeds the announced %u bytes", (unsigned)s_upload.pem_len);
+        err = ESP_ERR_INVALID_SIZE;
+    } else {
+        for (size_t i = 0; i < len && err == ESP_OK; i++) {
+            err = upload_decode(data[i]);
+        }
+        s_upload.received += len;
+    }
+
+    if (err != ESP_OK) {
+        trust_store_add_abort();
+    }
+    return err;
+}
+
+esp_err_t trust_store_add_finish(size_t* ret_added)
+{
+    if (ret_added) {
+        *ret_added = 0;
+    }
+    if (!s_upload.active) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    // The last line may lack a line break
+    esp_err_t err = upload_decode('\n');
+    if (err != ESP_OK || s_upload.pem.in_cert || s_upload.cert_count == 0 || s_upload.received != s_upload.pem_len) {
+        ESP_LOGE(TAG, "Not a complete PEM bundle (%u of %u bytes)", (unsigned)s_upload.received,
+                 (unsigned)s_upload.pem_len);
+        trust_store_add_abort();
+        return err != ESP_OK ? err : ESP_ERR_INVALID_ARG;
+    }
+
+    size_t added = 0;
+    uint32_t magic = ANCHOR_MAGIC;
+    for (size_t sector = 0; sector < s_sector_count && err == ESP_OK; sector++) {
+        if (!(s_upload.staged & (1U << sector))) {
+            continue;
+        }
+        err = esp_partition_write(s_partition, sector * s_sector_size, &magic, sizeof(magic));
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to commit anchor in sector %u: %s", (unsigned)sector, esp_err_to_name(err));
+            break;
+        }
+        mbedtls_x509_crt crt;
+        mbedtls_x509_crt_init(&crt);
+        mbedtls_x509_crt_parse_der_nocopy(&crt, sector_der(sector), sector_header(sector)->der_len);
+        fill_entry(&crt, &s_entries[sector]);
+        mbedtls_x509_crt_free(&crt);
+        added++;
+    }
+    s_upload.staged = 0;
+    s_upload.active = false;
+
+    if (added > 0) {
+        rebuild_index();
+    }
+    ESP_LOGI(TAG, "%u of %u certificate(s) added, %u anchors in use", (unsigned)added,
+             (unsigned)s_upload.cert_count, (unsigned)s_count);
+    if (ret_added) {
+        *ret_added = added;
+    }
+    return err;
+}
+
+void trust_store_add_abort(void)
+{
+    if (!s_upload.active) {
+        return;
+    }
+    // Staged sectors keep an erased magic word and are reused like free ones
+    s_upload.staged = 0;
+    s_upload.active = false;
+    ESP_LOGW(TAG, "Trust anchor upload aborted after %u PEM bytes", (unsigned)s_upload.received);
+}
+
+esp_err_t trust_store_add(const char* pem, size_t* ret_added)
+{
+    if (ret_added) {
+        *ret_added = 0;
+    }
+    if (!pem) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    size_t len = strlen(pem);
+    esp_err_t err = trust_store_add_begin(len);
+    if (err == ESP_OK) {
+        err = trust_store_add_write(pem, len);
+    }
+    return err == ESP_OK ? trust_store_add_finish(ret_added) : err;
+}
+
+esp_err_t trust_store_remove(const uint8_t fingerprint[TRUST_STORE_FINGERPRINT_SIZE])
+{
+    if (!s_initialized) {
+        ESP_LOGE(TAG, "Trust store not initialized");
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    if (!fingerprint) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    uint8_t sector = find_by_fingerprint(fingerprint);
+    if (sector == ANCHOR_NONE) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    uint32_t removed = 0;
+    esp_err_t err = esp_partition_write(s_partition, sector * s_sector_size + offsetof(anchor_header_t, live),
+                                        &removed, sizeof(removed));
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to remove anchor in sector %u: %s", (unsigned)sector, esp_err_to_name(err));
+        return err;
+    }
+    s_entries[sector].live = false;
+    s_removed_sectors |= 1U << sector;
+    rebuild_index();
+
+    ESP_LOGI(TAG, "Anchor in sector %u removed, %u in use", (unsigned)sector, (unsigned)s_count);
+    return ESP_OK;
+}
+
+esp_err_t trust_store_find_issuer(const mbedtls_x509_crt* child, trust_store_anchor_t* anchor)
+{
+    if (!child || !anchor) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!s_initialized) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    const mbedtls_x509_buf* key_id = &child->authority_key_id.keyIdentifier;
+    uint32_t issuer_hash = esp_crc32_le(0, child->issuer_raw.p, child->issuer_raw.len);
+
+    portENTER_CRITICAL(&s_lock);
+    uint8_t sector = ANCHOR_NONE;
+    if (key_id->len > 0 && key_id->len <= TRUST_STORE_KEY_ID_MAX) {
+        sector = find_by_key_id(key_id->p, key_id->len);
+    }
+    if (sector == ANCHOR_NONE) {
+        sector = find_by_subject(issuer_hash);
+    }
+    portEXIT_CRITICAL(&s_lock);
+
+    if (sector == ANCHOR_NONE) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    const anchor_header_t* header = sector_header(sector);
+    anchor->der = sector_der(sector);
+    anchor->der_len = header->der_len;
+    memcpy(anchor->fingerprint, header->fingerprint, TRUST_STORE_FINGERPRINT_SIZE);
+    return ESP_OK;
+}
+
+size_t trust_store_append_issuers(const mbedtls_x509_crt* child, mbedtls_x509_crt* chain)
+{
+    if (!s_initialized || !child || !chain) {
+        return 0;
+    }
+
+    const mbedtls_x509_buf* key_id = &child->authority_key_id.keyIdentifier;
+    uint32_t issuer_hash = esp_crc32_le(0, child->issuer_raw.p, child->issuer_raw.len);
+
+    // A key ID names one key; a name can be shared by the old and new key of a re-keyed CA
+    uint8_t sectors[TRUST_STORE_MAX_ANCHORS];
+    size_t count = 0;
+    portENTER_CRITICAL(&s_lock);
+    uint8_t sector = ANCHOR_NONE;
+    if (key_id->len > 0 && key_id->len <= TRUST_STORE_KEY_ID_MAX) {
+        sector = find_by_key_id(key_id->p, key_id->len);
+    }
+    if (sector != ANCHOR_NONE) {
+        sectors[count++] = sector;
+    } else {
+        for (size_t i = subject_lower_bound(issuer_hash);
+             i < s_count && s_entries[s_by_subject[i]].subject_hash == issuer_hash; i++) {
+            sectors[count++] = s_by_subject[i];
+        }
+    }
+    portEXIT_CRITICAL(&s_lock);
+
+    size_t appended = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (mbedtls_x509_crt_parse_der_nocopy(chain, sector_der(sectors[i]), sector_header(sectors[i])->der_len) == 0) {
+            appended++;
+        }
+    }
+    return appended;
+}
+
+size_t trust_store_append_anchors(mbedtls_x509_crt* chain)
+{
+    if (!s_initialized || !chain) {
+        return 0;
+    }
+
+    uint8_t sectors[TRUST_STORE_MAX_ANCHORS];
+    portENTER_CRITICAL(&s_lock);
+    size_t count = s_count;
+    memcpy(sectors, s_by_subject, count);
+    portEXIT_CRITICAL(&s_lock);
+
+    size_t appended = 0;
+    for (size_t i = 0; i < count; i++) {
+        int ret = mbedtls_x509_crt_parse_der_nocopy(chain, sector_der(sectors[i]), sector_header(sectors[i])->der_len);
+        if (ret != 0) {
+            ESP_LOGW(TAG, "Anchor in sector %u could not be parsed: -0x%04x", (unsigned)sectors[i], -ret);
+            continue;
+        }
+        appended++;
+    }
+    return appended;
+}
+
+size_t trust_store_count(void)
+{
+    portENTER_CRITICAL(&s_lock);
+    size_t count = s_count;
+    portEXIT_CRITICAL(&s_lock);
+    return count;
+}
+
+uint32_t trust_store_generation(void)
+{
+    portENTER_CRITICAL(&s_lock);
+    uint32_t generation = s_generation;
+    portEXIT_CRITICAL(&s_lock);
+    return generation;
+}
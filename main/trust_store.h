@@ -0,0 +1,177 @@
+#pragma once
+
+#include "esp_err.h"
+#include "mbedtls/x509_crt.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * @file trust_store.h
+ * @brief Multi-CA trust store for broker failover and CA migrations
+ *
+ * Holds additional trust anchors next to the certificate manager's primary
+ * certificate, one CA per 4 KB sector of the "trust" data partition, so
+ * adding or removing an anchor never rewrites the others. Removal only
+ * clears a flag in the sector header; the sector is erased when it is
+ * reused.
+ *
+ * The partition is memory-mapped. Anchors are indexed in RAM by the hash of
+ * their subject name and by subject key identifier, so the issuer of a
+ * certificate is found by binary search. TLS verification asks the index for
+ * the issuers of each certificate (trust_store_append_issuers() behind the
+ * certificate manager's mbedTLS CA callback); without the callback the
+ * certificate manager appends all anchors, parsed in place, to the CA chain.
+ * Old and new broker CAs are therefore trusted side by side, and a change
+ * takes effect on the next handshake without dropping the current
+ * connection. Anchors are added and removed at runtime with the
+ * addTrustAnchor and removeTrustAnchor RPC methods, keyed by SHA-256
+ * fingerprint.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TRUST_STORE_MAX_ANCHORS     16      /**< Anchors indexed (also limited by partition size / 4 KB) */
+#define TRUST_STORE_KEY_ID_MAX      20      /**< Longest indexed key identifier (SHA-1 based IDs) */
+#define TRUST_STORE_FINGERPRINT_SIZE 32     /**< SHA-256 fingerprint size */
+
+/**
+ * @brief Trust store configuration
+ */
+typedef struct {
+    const char* partition_label;    /**< Data partition holding the anchors */
+} trust_store_config_t;
+
+/**
+ * @brief Default trust store configuration
+ */
+#define TRUST_STORE_DEFAULT_CONFIG() { \
+    .partition_label = "trust" \
+}
+
+/**
+ * @brief A stored trust anchor
+ */
+typedef struct {
+    const uint8_t* der;             /**< DER certificate in mapped flash */
+    size_t der_len;                 /**< DER length in bytes */
+    uint8_t fingerprint[TRUST_STORE_FINGERPRINT_SIZE]; /**< SHA-256 of the DER certificate */
+} trust_store_anchor_t;
+
+/**
+ * @brief Map the partition and index the stored anchors
+ *
+ * @param config Trust store configuration
+ * @return esp_err_t ESP_OK on success, ESP_ERR_NOT_FOUND if the partition is missing
+ */
+esp_err_t trust_store_init(const trust_store_config_t* config);
+
+/**
+ * @brief Start adding the CA certificates of a PEM bundle streamed in chunks
+ *
+ * Each certificate is decoded straight into a free sector by
+ * trust_store_add_write(), so the bundle is never held in RAM. Nothing is
+ * trusted until trust_store_add_finish() commits the whole bundle; a new
+ * begin aborts an add in progress.
+ *
+ * @param pem_len Total PEM length in bytes
+ * @return esp_err_t ESP_OK on success
+ */
+esp_err_t trust_store_add_begin(size_t pem_len);
+
+/**
+ * @brief Feed the next chunk of the PEM
+ *
+ * @param data PEM bytes
+ * @param len Number of bytes
+ * @return esp_err_t ESP_OK on success, ESP_ERR_NO_MEM if the store is full,
+ *         ESP_ERR_INVALID_ARG if the PEM is malformed or holds a certificate that may not sign certificates,
+ *         ESP_ERR_INVALID_SIZE if it exceeds pem_len or a certificate exceeds a sector;
+ *         any error aborts the add
+ */
+esp_err_t trust_store_add_write(const char* data, size_t len);
+
+/**
+ * @brief Commit the streamed bundle
+ *
+ * Certificates already in the store are skipped.
+ *
+ * @param ret_added Number of anchors added (output, may be NULL)
+ * @return esp_err_t ESP_OK on success, ESP_ERR_INVALID_ARG if the PEM was incomplete
+ */
+esp_err_t trust_store_add_finish(size_t* ret_added);
+
+/**
+ * @brief Abort a streamed add in progress
+ */
+void trust_store_add_abort(void);
+
+/**
+ * @brief Add every CA certificate of a PEM bundle held in memory
+ *
+ * Same as begin, one write and finish.
+ *
+ * @param pem PEM certificate(s), NUL-terminated
+ * @param ret_added Number of anchors added (output, may be NULL)
+ * @return esp_err_t As trust_store_add_write() and trust_store_add_finish()
+ */
+esp_err_t trust_store_add(const char* pem, size_t* ret_added);
+
+/**
+ * @brief Remove an anchor
+ *
+ * @param fingerprint SHA-256 fingerprint of the anchor
+ * @return esp_err_t ESP_OK on success, ESP_ERR_NOT_FOUND if no anchor matches
+ */
+esp_err_t trust_store_remove(const uint8_t fingerprint[TRUST_STORE_FINGERPRINT_SIZE]);
+
+/**
+ * @brief Find the anchor that issued a certificate
+ *
+ * Looks up the authority key identifier first, then the issuer name.
+ *
+ * @param child Certificate whose issuer is wanted
+ * @param anchor Matching anchor (output)
+ * @return esp_err_t ESP_OK on success, ESP_ERR_NOT_FOUND if no anchor matches
+ */
+esp_err_t trust_store_find_issuer(const mbedtls_x509_crt* child, trust_store_anchor_t* anchor);
+
+/**
+ * @brief Parse the possible issuers of a certificate in place and append them to a chain
+ *
+ * The anchor matching the authority key identifier if there is one,
+ * otherwise every anchor with the issuer's name (the old and new key of a
+ * re-keyed CA share it). Meant for mbedTLS's trusted CA callback.
+ *
+ * @param child Certificate whose issuer is wanted
+ * @param chain Initialized chain (may be empty)
+ * @return size_t Number of anchors appended
+ */
+size_t trust_store_append_issuers(const mbedtls_x509_crt* child, mbedtls_x509_crt* chain);
+
+/**
+ * @brief Parse all anchors in place and append them to a chain
+ *
+ * @param chain Initialized chain (may be empty)
+ * @return size_t Number of anchors appended
+ */
+size_t trust_store_append_anchors(mbedtls_x509_crt* chain);
+
+/**
+ * @brief Number of stored anchors
+ */
+size_t trust_store_count(void);
+
+/**
+ * @brief Change counter, incremented by every add and remove
+ *
+ * Lets holders of a chain built with trust_store_append_anchors() notice
+ * that it is stale.
+ */
+uint32_t trust_store_generation(void);
+
+#ifdef __cplusplus
+}
+#endif
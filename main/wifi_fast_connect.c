@@ -0,0 +1,241 @@
+#include "wifi_fast_connect.h"
+#include "esp_log.h"
+#include "esp_crc.h"
+#include "esp_timer.h"
+#include "esp_attr.h"
+#include "nvs.h"
+#include "freertos/FreeRTOS.h"
+#include <stddef.h>
+#include <string.h>
+
+static const char* TAG = "WIFI_FAST";
+
+#define CACHE_MAGIC             0x57464331      // "WFC1"
+#define NVS_KEY_CACHE           "cache"
+
+/**
+ * @brief Cached connection parameters of the last AP
+ */
+typedef struct {
+    uint32_t magic;                 /**< CACHE_MAGIC */
+    uint32_t ssid_crc;              /**< CRC32 of the SSID the entry belongs to */
+    uint8_t bssid[6];
+    uint8_t channel;
+    uint8_t reserved;
+    esp_netif_ip_info_t ip_info;    /**< Last lease */
+    esp_ip4_addr_t dns;             /**< Main DNS server of the last lease */
+    uint32_t crc;                   /**< CRC32 of the fields above */
+} fast_connect_cache_t;
+
+// Kept across deep sleep and software resets; random after power-on, hence the CRC
+static RTC_NOINIT_ATTR fast_connect_cache_t s_rtc_cache;
+
+static wifi_fast_connect_config_t s_config;
+static esp_netif_t* s_netif = NULL;
+static bool s_initialized = false;
+
+// Event loop task only (apply runs before Wi-Fi starts)
+static fast_connect_cache_t s_cache;            // Entry used for connecting
+static bool s_cache_valid = false;
+static fast_connect_cache_t s_nvs_cache;        // Entry last read from or written to NVS
+static uint32_t s_ssid_crc = 0;
+static bool s_attempt_fast = false;             // Station is configured for the cached AP
+static bool s_connected = false;                // GOT_IP since the last disconnect
+static int64_t s_attempt_start_us = 0;
+
+static portMUX_TYPE s_stats_lock = portMUX_INITIALIZER_UNLOCKED;
+static wifi_fast_connect_stats_t s_stats = {0};
+
+static uint32_t cache_crc(const fast_connect_cache_t* cache)
+{
+    return esp_crc32_le(0, (const uint8_t*)cache, offsetof(fast_connect_cache_t, crc));
+}
+
+static bool cache_entry_valid(const fast_connect_cache_t* cache)
+{
+    return cache->magic == CACHE_MAGIC && cache->crc == cache_crc(cache) && cache->channel > 0;
+}
+
+/**
+ * @brief Target the cached AP; with static_ip also apply the cached lease
+ */
+static void use_cache(wifi_config_t* wifi_config)
+{
+    memcpy(wifi_config->sta.bssid, s_cache.bssid, sizeof(wifi_config->sta.bssid));
+    wifi_config->sta.bssid_set = true;
+    wifi_config->sta.channel = s_cache.channel;
+    s_attempt_fast = true;
+
+    if (s_config.static_ip) {
+        esp_netif_dhcpc_stop(s_netif);
+        esp_netif_set_ip_info(s_netif, &s_cache.ip_info);
+        esp_netif_dns_info_t dns = { .ip.type = ESP_IPADDR_TYPE_V4, .ip.u_addr.ip4 = s_cache.dns };
+        esp_netif_set_dns_info(s_netif, ESP_NETIF_DNS_MAIN, &dns);
+    }
+
+    ESP_LOGI(TAG, "Connecting to cached AP %02x:%02x:%02x:%02x:%02x:%02x on channel %u%s",
+             s_cache.bssid[0], s_cache.bssid[1], s_cache.bssid[2], s_cache.bssid[3], s_cache.bssid[4],
+             s_cache.bssid[5], s_cache.channel, s_config.static_ip ? " with the cached IP" : "");
+}
+
+/**
+ * @brief Drop the cache and reconfigure the station for a full scan and DHCP
+ */
+static void fall_back(uint8_t reason)
+{
+    ESP_LOGW(TAG, "Cached AP not joined (reason %u), falling back to a full scan", reason);
+    s_attempt_fast = false;
+    s_cache_valid = false;
+    s_rtc_cache.magic = 0;
+
+    wifi_config_t wifi_config;
+    if (esp_wifi_get_config(WIFI_IF_STA, &wifi_config) == ESP_OK) {
+        wifi_config.sta.bssid_set = false;
+        memset(wifi_config.sta.bssid, 0, sizeof(wifi_config.sta.bssid));
+        wifi_config.sta.channel = 0;
+        esp_wifi_set_config(WIFI_IF_STA, &wifi_config);
+    }
+    if (s_config.static_ip) {
+        esp_netif_dhcpc_start(s_netif);
+    }
+
+    portENTER_CRITICAL(&s_stats_lock);
+    s_stats.fallbacks++;
+    portEXIT_CRITICAL(&s_stats_lock);
+}
+
+esp_err_t wifi_fast_connect_init(const wifi_fast_connect_config_t* config, esp_netif_t* netif)
+{
+    if (!config || !config->nvs_namespace || !netif) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    s_config = *config;
+    s_netif = netif;
+    s_cache_valid = false;
+    s_attempt_fast = false;
+    s_connected = false;
+
+    // NVS is read once; it only matters when RTC memory was lost (power-on)
+    memset(&s_nvs_cache, 0, sizeof(s_nvs_cache));
+    nvs_handle_t nvs_handle;
+    if (nvs_open(s_config.nvs_namespace, NVS_READONLY, &nvs_handle) == ESP_OK) {
+        size_t size = sizeof(s_nvs_cache);
+        if (nvs_get_blob(nvs_handle, NVS_KEY_CACHE, &s_nvs_cache, &size) != ESP_OK || size != sizeof(s_nvs_cache)) {
+            memset(&s_nvs_cache, 0, sizeof(s_nvs_cache));
+        }
+        nvs_close(nvs_handle);
+    }
+
+    if (cache_entry_valid(&s_rtc_cache)) {
+        s_cache = s_rtc_cache;
+        s_cache_valid = true;
+    } else if (cache_entry_valid(&s_nvs_cache)) {
+        s_cache = s_nvs_cache;
+        s_cache_valid = true;
+    }
+    s_initialized = true;
+
+    ESP_LOGI(TAG, "Fast connect cache: %s", !s_cache_valid ? "empty" :
+             cache_entry_valid(&s_rtc_cache) ? "RTC memory" : "NVS");
+    return ESP_OK;
+}
+
+bool wifi_fast_connect_apply(wifi_config_t* wifi_config)
+{
+    if (!s_initialized || !wifi_config) {
+        return false;
+    }
+
+    const char* ssid = (const char*)wifi_config->sta.ssid;
+    s_ssid_crc = esp_crc32_le(0, (const uint8_t*)ssid, strnlen(ssid, sizeof(wifi_config->sta.ssid)));
+    s_attempt_start_us = esp_timer_get_time();
+    s_attempt_fast = false;
+    if (!s_cache_valid || s_cache.ssid_crc != s_ssid_crc) {
+        return false;
+    }
+    use_cache(wifi_config);
+    return true;
+}
+
+void wifi_fast_connect_on_disconnected(uint8_t reason)
+{
+    if (!s_initialized) {
+        return;
+    }
+
+    bool failed = !s_connected;
+    s_connected = false;
+    if (s_attempt_fast && failed) {
+        fall_back(reason);
+    } else if (!s_attempt_fast && s_cache_valid && s_cache.ssid_crc == s_ssid_crc) {
+        // Joined by a full scan: reconnects go straight to the AP found
+        wifi_config_t wifi_config;
+        if (esp_wifi_get_config(WIFI_IF_STA, &wifi_config) == ESP_OK) {
+            use_cache(&wifi_config);
+            esp_wifi_set_config(WIFI_IF_STA, &wifi_config);
+        }
+    }
+    s_attempt_start_us = esp_timer_get_time();
+}
+
+void wifi_fast_connect_on_got_ip(const esp_netif_ip_info_t* ip_info)
+{
+    if (!s_initialized || !ip_info) {
+        return;
+    }
+
+    uint32_t elapsed_ms = (uint32_t)((esp_timer_get_time() - s_attempt_start_us) / 1000);
+    portENTER_CRITICAL(&s_stats_lock);
+    s_stats.connects++;
+    if (s_attempt_fast) {
+        s_stats.fast_connects++;
+    }
+    s_stats.last_time_to_ip_ms = elapsed_ms;
+    s_stats.last_fast = s_attempt_fast;
+    portEXIT_CRITICAL(&s_stats_lock);
+    s_connected = true;
+    ESP_LOGI(TAG, "Time to IP: %lu ms (%s)", (unsigned long)elapsed_ms, s_attempt_fast ? "cached AP" : "full scan");
+
+    wifi_ap_record_t ap_info;
+    if (esp_wifi_sta_get_ap_info(&ap_info) != ESP_OK) {
+        return;
+    }
+    fast_connect_cache_t entry = {
+        .magic = CACHE_MAGIC,
+        .ssid_crc = s_ssid_crc,
+        .channel = ap_info.primary,
+        .ip_info = *ip_info,
+    };
+    memcpy(entry.bssid, ap_info.bssid, sizeof(entry.bssid));
+    esp_netif_dns_info_t dns;
+    if (esp_netif_get_dns_info(s_netif, ESP_NETIF_DNS_MAIN, &dns) == ESP_OK && dns.ip.type == ESP_IPADDR_TYPE_V4) {
+        entry.dns = dns.ip.u_addr.ip4;
+    }
+    entry.crc = cache_crc(&entry);
+    s_rtc_cache = entry;
+    s_cache = entry;
+    s_cache_valid = true;
+
+    // Same AP and lease as last time: no flash write
+    if (memcmp(&entry, &s_nvs_cache, sizeof(entry)) == 0) {
+        return;
+    }
+    nvs_handle_t nvs_handle;
+    if (nvs_open(s_config.nvs_namespace, NVS_READWRITE, &nvs_handle) != ESP_OK) {
+        return;
+    }
+    if (nvs_set_blob(nvs_handle, NVS_KEY_CACHE, &entry, sizeof(entry)) == ESP_OK && nvs_commit(nvs_handle) == ESP_OK) {
+        s_nvs_cache = entry;
+    }
+    nvs_close(nvs_handle);
+}
+
+void wifi_fast_connect_get_stats(wifi_fast_connect_stats_t* stats)
+{
+    if (!stats) {
+        return;
+    }
+    portENTER_CRITICAL(&s_stats_lock);
+    *stats = s_stats;
+    portEXIT_CRITICAL(&s_stats_lock);
+}
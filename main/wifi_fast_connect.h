@@ -0,0 +1,100 @@
+#pragma once
+
+#include "esp_err.h"
+#include "esp_netif.h"
+#include "esp_wifi.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * @file wifi_fast_connect.h
+ * @brief Wi-Fi fast reconnect from a cached BSSID, channel and IP lease
+ *
+ * After every successful connection the access point's BSSID and channel
+ * and the DHCP lease are cached in RTC memory (kept across deep sleep and
+ * software resets) and in NVS (kept across power cycles, written only when
+ * the entry changes). The next connection targets the cached AP on its
+ * channel instead of scanning all channels. With static_ip the cached lease
+ * is also applied directly; otherwise lwIP requests the previous address
+ * (CONFIG_LWIP_DHCP_RESTORE_LAST_IP).
+ *
+ * If a connection to the cached AP fails, the cache is dropped and the
+ * station falls back to a full scan and DHCP.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Fast connect configuration
+ */
+typedef struct {
+    const char* nvs_namespace;      /**< NVS namespace of the cache entry */
+    bool static_ip;                 /**< Apply the cached lease as a static IP (skips DHCP) */
+} wifi_fast_connect_config_t;
+
+/**
+ * @brief Default fast connect configuration
+ */
+#define WIFI_FAST_CONNECT_DEFAULT_CONFIG() { \
+    .nvs_namespace = "wifi_fast", \
+    .static_ip = false \
+}
+
+/**
+ * @brief Connection statistics since boot
+ */
+typedef struct {
+    uint32_t connects;              /**< Connections that reached GOT_IP */
+    uint32_t fast_connects;         /**< ... of which used the cache */
+    uint32_t fallbacks;             /**< Cached AP unreachable, fell back to a full scan */
+    uint32_t last_time_to_ip_ms;    /**< Connect attempt to GOT_IP, last connection */
+    bool last_fast;                 /**< Last connection used the cache */
+} wifi_fast_connect_stats_t;
+
+/**
+ * @brief Load the cache (RTC memory first, then NVS)
+ *
+ * @param config Fast connect configuration
+ * @param netif Station interface
+ * @return esp_err_t ESP_OK on success
+ */
+esp_err_t wifi_fast_connect_init(const wifi_fast_connect_config_t* config, esp_netif_t* netif);
+
+/**
+ * @brief Add the cached AP to a station configuration before esp_wifi_set_config()
+ *
+ * Also applies the cached lease when static_ip is set. Starts the
+ * time-to-IP measurement.
+ *
+ * @param wifi_config Station configuration with SSID and password filled in
+ * @return true if the cache matched the SSID and was applied
+ */
+bool wifi_fast_connect_apply(wifi_config_t* wifi_config);
+
+/**
+ * @brief Handle WIFI_EVENT_STA_DISCONNECTED (before reconnecting)
+ *
+ * If the cached AP could not be joined, the station is reconfigured for a
+ * full scan. Starts the time-to-IP measurement for the reconnect.
+ *
+ * @param reason Disconnect reason (wifi_err_reason_t)
+ */
+void wifi_fast_connect_on_disconnected(uint8_t reason);
+
+/**
+ * @brief Handle IP_EVENT_STA_GOT_IP: record the time to IP and update the cache
+ *
+ * @param ip_info Lease from the event
+ */
+void wifi_fast_connect_on_got_ip(const esp_netif_ip_info_t* ip_info);
+
+/**
+ * @brief Get connection statistics
+ */
+void wifi_fast_connect_get_stats(wifi_fast_connect_stats_t* stats);
+
+#ifdef __cplusplus
+}
+#endif
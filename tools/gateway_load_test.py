@@ -0,0 +1,144 @@
+#!/usr/bin/env python3
+"""Gateway load test against a local MQTT broker.
+
+Watches a board running gateway mode (the gwChildren shared attribute) and
+reports messages/s, records/s and bytes on the wire of v1/gateway/telemetry,
+how many children were announced on v1/gateway/connect, and the RAM per
+child and free heap the board publishes as gw_* telemetry.
+
+The board reads gwChildren at boot. Against a plain broker (e.g. Mosquitto)
+there is no ThingsBoard to push the attribute, so --set-children publishes
+the shared attribute update itself; reboot the board afterwards.
+
+    pip install paho-mqtt
+    python3 tools/gateway_load_test.py --host 192.168.1.10 --set-children 150
+    # reboot the board, then:
+    python3 tools/gateway_load_test.py --host 192.168.1.10 --duration 300
+"""
+
+import argparse
+import json
+import sys
+import time
+
+try:
+    import paho.mqtt.client as mqtt
+except ImportError:
+    sys.exit("paho-mqtt is required: pip install paho-mqtt")
+
+GATEWAY_TELEMETRY_TOPIC = "v1/gateway/telemetry"
+GATEWAY_CONNECT_TOPIC = "v1/gateway/connect"
+DEVICE_TELEMETRY_TOPIC = "v1/devices/me/telemetry"
+DEVICE_ATTRIBUTES_TOPIC = "v1/devices/me/attributes"
+
+
+class LoadStats:
+    def __init__(self):
+        self.started = None
+        self.messages = 0
+        self.payload_bytes = 0
+        self.records = 0
+        self.children = set()
+        self.connected = set()
+        self.invalid = 0
+        self.board = {}
+
+    def on_gateway_telemetry(self, payload):
+        if self.started is None:
+            self.started = time.monotonic()
+        self.messages += 1
+        self.payload_bytes += len(payload)
+        try:
+            devices = json.loads(payload)
+        except ValueError:
+            self.invalid += 1
+            return
+        for name, records in devices.items():
+            self.children.add(name)
+            self.records += len(records)
+
+    def on_gateway_connect(self, payload):
+        try:
+            self.connected.add(json.loads(payload)["device"])
+        except (ValueError, KeyError):
+            self.invalid += 1
+
+    def on_board_telemetry(self, payload):
+        try:
+            values = json.loads(payload)
+        except ValueError:
+            return
+        if isinstance(values, dict):
+            self.board.update({k: v for k, v in values.items() if k.startswith("gw_")})
+
+    def report(self):
+        elapsed = time.monotonic() - self.started if self.started else 0.0
+        rate = (lambda n: n / elapsed) if elapsed > 0 else (lambda n: 0.0)
+        print(f"window: {elapsed:.0f} s")
+        print(f"children: {len(self.children)} publishing, {len(self.connected)} announced")
+        print(f"telemetry messages: {self.messages} ({rate(self.messages):.2f} msg/s)")
+        print(f"records: {self.records} ({rate(self.records):.1f} records/s, "
+              f"{self.records / self.messages if self.messages else 0:.1f} per message)")
+        print(f"bytes on the wire (payload): {self.payload_bytes} ({rate(self.payload_bytes):.0f} B/s, "
+              f"{self.payload_bytes / self.records if self.records else 0:.1f} B per record)")
+        if self.invalid:
+            print(f"invalid payloads: {self.invalid}")
+        if self.board:
+            print(f"board: {self.board.get('gw_children')} children, "
+                  f"{self.board.get('gw_ram_per_child')} B RAM per child, "
+                  f"{self.board.get('gw_free_heap')} B free heap, "
+                  f"{self.board.get('gw_dropped')} records dropped")
+        else:
+            print("board: no gw_* telemetry seen yet (published once a minute)")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--host", default="localhost")
+    parser.add_argument("--port", type=int, default=1883)
+    parser.add_argument("--username")
+    parser.add_argument("--password")
+    parser.add_argument("--duration", type=int, default=120, help="seconds to measure")
+    parser.add_argument("--set-children", type=int, metavar="N",
+                        help="publish the gwChildren shared attribute and exit")
+    args = parser.parse_args()
+
+    stats = LoadStats()
+    handlers = {
+        GATEWAY_TELEMETRY_TOPIC: stats.on_gateway_telemetry,
+        GATEWAY_CONNECT_TOPIC: stats.on_gateway_connect,
+        DEVICE_TELEMETRY_TOPIC: stats.on_board_telemetry,
+    }
+
+    try:
+        client = mqtt.Client(mqtt.CallbackAPIVersion.VERSION2)
+    except AttributeError:  # paho-mqtt 1.x
+        client = mqtt.Client()
+    if args.username:
+        client.username_pw_set(args.username, args.password)
+    client.on_message = lambda _client, _userdata, msg: handlers[msg.topic](msg.payload)
+    client.connect(args.host, args.port)
+
+    if args.set_children is not None:
+        info = client.publish(DEVICE_ATTRIBUTES_TOPIC, json.dumps({"gwChildren": args.set_children}), qos=1)
+        client.loop_start()
+        info.wait_for_publish()
+        client.loop_stop()
+        client.disconnect()
+        print(f"gwChildren={args.set_children} published; reboot the board to apply it")
+        return
+
+    for topic in handlers:
+        client.subscribe(topic, qos=0)
+    client.loop_start()
+    try:
+        time.sleep(args.duration)
+    except KeyboardInterrupt:
+        pass
+    client.loop_stop()
+    client.disconnect()
+    stats.report()
+
+
+if __name__ == "__main__":
+    main()